@@ -19,6 +19,8 @@
 #else
 #include <unistd.h>
 #include <sys/vfs.h>
+
+#include "calibrationstore.hpp"
 #endif
 
 
@@ -4098,37 +4100,31 @@ static inline std::string getHiddenDir() {
     return filename;
 }
 
+/*!
+ * \brief Get the calibration file of a camera from the local calibration store: the ZED settings folder, and the
+ *        directories and tar archives listed in the `ZED_OC_CALIB_PATH` environment variable, separated by ':'.
+ *        On Linux the file is not downloaded: if it is not available locally, the download URL is printed and the
+ *        function returns false. On Windows it is downloaded from the Stereolabs server to the ZED settings folder.
+ */
 bool downloadCalibrationFile(unsigned int serial_number, std::string &calibration_file) {
 #ifndef _WIN32
-    std::string path = getHiddenDir();
-    char specific_name[128];
-    sprintf(specific_name, "SN%d.conf", serial_number);
-    calibration_file = path + specific_name;
-    if (!checkFile(calibration_file)) {
-        std::string cmd;
-        int res;
-
-        // Create download folder
-        cmd = "mkdir -p " + path;
-        res = system(cmd.c_str());
-
-        // Download the file
-        std::string url("'https://calib.stereolabs.com/?SN=");
-
-        cmd = "wget " + url + std::to_string(serial_number) + "' -O " + calibration_file;
-        std::cout << cmd << std::endl;
-        res = system(cmd.c_str());
-
-        if( res == EXIT_FAILURE )
-        {
-            std::cerr << "Error downloading the calibration file" << std::endl;
-            return false;
+    sl_oc::video::CalibrationStore store;
+
+    const char *search_path = getenv("ZED_OC_CALIB_PATH");
+    if (search_path) {
+        for (const std::string &path : split(search_path, ':')) {
+            if (path.size() > 4 && path.compare(path.size() - 4, 4, ".tar") == 0)
+                store.addArchive(path);
+            else if (!path.empty())
+                store.addDirectory(path);
         }
+    }
 
-        if (!checkFile(calibration_file)) {
-            std::cerr << "Invalid calibration file" << std::endl;
-            return false;
-        }
+    if (!store.getFile(serial_number, calibration_file)) {
+        std::cerr << "Calibration file SN" << serial_number << ".conf not found. Download it from" << std::endl;
+        std::cerr << "  https://calib.stereolabs.com/?SN=" << serial_number << std::endl;
+        std::cerr << "to " << getHiddenDir() << " or to a folder listed in ZED_OC_CALIB_PATH" << std::endl;
+        return false;
     }
 #else
     std::string path = getHiddenDir();
@@ -4169,6 +4165,9 @@ bool downloadCalibrationFile(unsigned int serial_number, std::string &calibratio
 // OpenCV includes
 #include <opencv2/opencv.hpp>
 
+#include "rectmapcache.hpp"
+#include "stereocalibration.hpp"
+
 bool initCalibration(std::string calibration_file, cv::Size2i image_size, cv::Mat &map_left_x, cv::Mat &map_left_y,
         cv::Mat &map_right_x, cv::Mat &map_right_y, cv::Mat &cameraMatrix_left, cv::Mat &cameraMatrix_right, double *baseline=nullptr) {
 
@@ -4177,78 +4176,47 @@ bool initCalibration(std::string calibration_file, cv::Size2i image_size, cv::Ma
         return 0;
     }
 
-    // Open camera configuration file
-    ConfManager camerareader(calibration_file.c_str());
-    if (!camerareader.isOpened())
-        return 0;
+    // Parse the camera configuration file
+    sl_oc::video::StereoCalibration calib;
+    std::string error;
+    if (!calib.load(calibration_file, &error)) {
+        // The file is kept: it can be a user copy that cannot be downloaded again
+        std::cout << "ZED File invalid: " << calibration_file << ": " << error << std::endl;
+        return false;
+    }
 
-    std::string resolution_str;
+    sl_oc::video::RESOLUTION res;
     switch ((int) image_size.width) {
         case 2208:
-            resolution_str = "2k";
+            res = sl_oc::video::RESOLUTION::HD2K;
             break;
         case 1920:
-            resolution_str = "fhd";
+            res = sl_oc::video::RESOLUTION::HD1080;
             break;
         case 1280:
-            resolution_str = "hd";
+            res = sl_oc::video::RESOLUTION::HD720;
             break;
         case 672:
-            resolution_str = "vga";
+            res = sl_oc::video::RESOLUTION::VGA;
             break;
         default:
-            resolution_str = "hd";
+            res = sl_oc::video::RESOLUTION::HD720;
             break;
     }
 
-    // Get translations
-    float T_[3];
-    T_[0] = camerareader.getValue("stereo:baseline", 0.0f);
-    T_[1] = camerareader.getValue("stereo:ty_" + resolution_str, 0.f);
-    T_[2] = camerareader.getValue("stereo:tz_" + resolution_str, 0.f);
-
-    if(baseline) *baseline=T_[0];
-
-    // Get left parameters
-    float left_cam_cx = camerareader.getValue("left_cam_" + resolution_str + ":cx", 0.0f);
-    float left_cam_cy = camerareader.getValue("left_cam_" + resolution_str + ":cy", 0.0f);
-    float left_cam_fx = camerareader.getValue("left_cam_" + resolution_str + ":fx", 0.0f);
-    float left_cam_fy = camerareader.getValue("left_cam_" + resolution_str + ":fy", 0.0f);
-    float left_cam_k1 = camerareader.getValue("left_cam_" + resolution_str + ":k1", 0.0f);
-    float left_cam_k2 = camerareader.getValue("left_cam_" + resolution_str + ":k2", 0.0f);
-    float left_cam_p1 = camerareader.getValue("left_cam_" + resolution_str + ":p1", 0.0f);
-    float left_cam_p2 = camerareader.getValue("left_cam_" + resolution_str + ":p2", 0.0f);
-    float left_cam_k3 = camerareader.getValue("left_cam_" + resolution_str + ":k3", 0.0f);
-
-    // Get right parameters
-    float right_cam_cx = camerareader.getValue("right_cam_" + resolution_str + ":cx", 0.0f);
-    float right_cam_cy = camerareader.getValue("right_cam_" + resolution_str + ":cy", 0.0f);
-    float right_cam_fx = camerareader.getValue("right_cam_" + resolution_str + ":fx", 0.0f);
-    float right_cam_fy = camerareader.getValue("right_cam_" + resolution_str + ":fy", 0.0f);
-    float right_cam_k1 = camerareader.getValue("right_cam_" + resolution_str + ":k1", 0.0f);
-    float right_cam_k2 = camerareader.getValue("right_cam_" + resolution_str + ":k2", 0.0f);
-    float right_cam_p1 = camerareader.getValue("right_cam_" + resolution_str + ":p1", 0.0f);
-    float right_cam_p2 = camerareader.getValue("right_cam_" + resolution_str + ":p2", 0.0f);
-    float right_cam_k3 = camerareader.getValue("right_cam_" + resolution_str + ":k3", 0.0f);
-
-    // (Linux only) Safety check A: Wrong "." or "," reading in file conf.
-#ifndef _WIN32
-    if (right_cam_k1 == 0 && left_cam_k1 == 0 && left_cam_k2 == 0 && right_cam_k2 == 0) {
-        std::cout << "ZED File invalid" << std::endl;
-
-        std::string cmd = "rm " + calibration_file;
-        int res = system(cmd.c_str());
-        if( res == EXIT_FAILURE )
-        {
-            exit(1);
-        }
-
-        exit(1);
+    if (!calib.isValid(res)) {
+        std::cout << "ZED File invalid for the current resolution: " << error << std::endl;
+        return false;
     }
-#endif
+
+    const sl_oc::video::StereoCameraParams& params = calib.getParams(res);
+    const sl_oc::video::CameraIntrinsics& left = params.left;
+    const sl_oc::video::CameraIntrinsics& right = params.right;
+
+    if(baseline) *baseline=params.baseline;
 
     // Get rotations
-    cv::Mat R_zed = (cv::Mat_<double>(1, 3) << camerareader.getValue("stereo:rx_" + resolution_str, 0.f), camerareader.getValue("stereo:cv_" + resolution_str, 0.f), camerareader.getValue("stereo:rz_" + resolution_str, 0.f));
+    cv::Mat R_zed = (cv::Mat_<double>(1, 3) << params.rx, params.ry, params.rz);
     cv::Mat R;
 
     cv::Rodrigues(R_zed /*in*/, R /*out*/);
@@ -4256,15 +4224,15 @@ bool initCalibration(std::string calibration_file, cv::Size2i image_size, cv::Ma
     cv::Mat distCoeffs_left, distCoeffs_right;
 
     // Left
-    cameraMatrix_left = (cv::Mat_<double>(3, 3) << left_cam_fx, 0, left_cam_cx, 0, left_cam_fy, left_cam_cy, 0, 0, 1);
-    distCoeffs_left = (cv::Mat_<double>(5, 1) << left_cam_k1, left_cam_k2, left_cam_p1, left_cam_p2, left_cam_k3);
+    cameraMatrix_left = (cv::Mat_<double>(3, 3) << left.fx, 0, left.cx, 0, left.fy, left.cy, 0, 0, 1);
+    distCoeffs_left = (cv::Mat_<double>(5, 1) << left.k1, left.k2, left.p1, left.p2, left.k3);
 
     // Right
-    cameraMatrix_right = (cv::Mat_<double>(3, 3) << right_cam_fx, 0, right_cam_cx, 0, right_cam_fy, right_cam_cy, 0, 0, 1);
-    distCoeffs_right = (cv::Mat_<double>(5, 1) << right_cam_k1, right_cam_k2, right_cam_p1, right_cam_p2, right_cam_k3);
+    cameraMatrix_right = (cv::Mat_<double>(3, 3) << right.fx, 0, right.cx, 0, right.fy, right.cy, 0, 0, 1);
+    distCoeffs_right = (cv::Mat_<double>(5, 1) << right.k1, right.k2, right.p1, right.p2, right.k3);
 
     // Stereo
-    cv::Mat T = (cv::Mat_<double>(3, 1) << T_[0], T_[1], T_[2]);
+    cv::Mat T = (cv::Mat_<double>(3, 1) << params.baseline, params.ty, params.tz);
     std::cout << " Camera Matrix L: \n" << cameraMatrix_left << std::endl << std::endl;
     std::cout << " Camera Matrix R: \n" << cameraMatrix_right << std::endl << std::endl;
 
@@ -4282,6 +4250,67 @@ bool initCalibration(std::string calibration_file, cv::Size2i image_size, cv::Ma
     return 1;
 }
 
+/*!
+ * \brief Same as `initCalibration`, but the rectification maps are loaded from the binary cache in the ZED settings
+ *        folder if it matches the camera serial number, the image size and the calibration file. Otherwise the maps
+ *        are computed and the cache is updated.
+ * \param cache the cache object. When the maps are loaded from the cache they point to its read-only memory mapping,
+ *        so it must not be destroyed or closed while the maps are used.
+ */
+bool initCalibrationCached(std::string calibration_file, int serial_number, cv::Size2i image_size, sl_oc::video::RectMapCache &cache,
+        cv::Mat &map_left_x, cv::Mat &map_left_y, cv::Mat &map_right_x, cv::Mat &map_right_y,
+        cv::Mat &cameraMatrix_left, cv::Mat &cameraMatrix_right, double *baseline=nullptr) {
+
+    uint64_t calib_hash = sl_oc::video::RectMapCache::hashFile(calibration_file);
+    std::string cache_file = sl_oc::video::RectMapCache::getCacheFilename(getHiddenDir(), serial_number,
+                                                                          image_size.width, image_size.height);
+
+    // ----> Cached maps
+    if (calib_hash!=0 && cache.open(cache_file, serial_number, image_size.width, image_size.height, calib_hash)) {
+        const sl_oc::video::RectMapInfo& info = cache.getInfo();
+        using sl_oc::video::CAM_SENS_POS;
+
+        map_left_x = cv::Mat(image_size, CV_32FC1, const_cast<float*>(cache.getMapX(CAM_SENS_POS::LEFT)));
+        map_left_y = cv::Mat(image_size, CV_32FC1, const_cast<float*>(cache.getMapY(CAM_SENS_POS::LEFT)));
+        map_right_x = cv::Mat(image_size, CV_32FC1, const_cast<float*>(cache.getMapX(CAM_SENS_POS::RIGHT)));
+        map_right_y = cv::Mat(image_size, CV_32FC1, const_cast<float*>(cache.getMapY(CAM_SENS_POS::RIGHT)));
+
+        cameraMatrix_left = cv::Mat(3, 4, CV_64FC1, const_cast<double*>(info.P_left)).clone();
+        cameraMatrix_right = cv::Mat(3, 4, CV_64FC1, const_cast<double*>(info.P_right)).clone();
+        if(baseline) *baseline=info.baseline;
+
+        std::cout << "Rectification maps loaded from " << cache_file << std::endl;
+        return 1;
+    }
+    // <---- Cached maps
+
+    double bl;
+    if (!initCalibration(calibration_file, image_size, map_left_x, map_left_y, map_right_x, map_right_y,
+                         cameraMatrix_left, cameraMatrix_right, &bl))
+        return 0;
+    if(baseline) *baseline=bl;
+
+    // ----> Cache update
+    sl_oc::video::RectMapInfo info;
+    info.serial = serial_number;
+    info.width = image_size.width;
+    info.height = image_size.height;
+    info.calib_hash = calib_hash;
+    info.baseline = bl;
+    for (int i = 0; i < 12; i++) {
+        info.P_left[i] = cameraMatrix_left.at<double>(i/4, i%4);
+        info.P_right[i] = cameraMatrix_right.at<double>(i/4, i%4);
+    }
+
+    if (calib_hash==0 || !map_left_x.isContinuous() ||
+            !sl_oc::video::RectMapCache::save(cache_file, info, map_left_x.ptr<float>(), map_left_y.ptr<float>(),
+                                              map_right_x.ptr<float>(), map_right_y.ptr<float>()))
+        std::cerr << "Cannot write the rectification cache " << cache_file << std::endl;
+    // <---- Cache update
+
+    return 1;
+}
+
 } // namespace oc_tools
 } // namespace sl_oc
 
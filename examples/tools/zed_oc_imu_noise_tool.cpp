@@ -0,0 +1,197 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ----> Includes
+#include "sensorcapture.hpp"
+#include "allanvariance.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <vector>
+// <---- Includes
+
+// ----> Defines
+#define DEFAULT_DURATION_SEC    (3*3600)                // Default acquisition length: 3 hours
+#define DEFAULT_OUTPUT_FILE     "zed_oc_imu_noise.csv"  // Default result file
+#define SAVE_INTERVAL_SEC       600                     // Intermediate results are saved every 10 minutes
+#define NOMINAL_PERIOD_NSEC     2500000ULL              // Nominal IMU sampling period: 400 Hz
+// <---- Defines
+
+// The main function
+int main(int argc, char *argv[])
+{
+    // ----> Command line arguments
+    uint64_t duration_sec = DEFAULT_DURATION_SEC;
+    std::string out_file = DEFAULT_OUTPUT_FILE;
+
+    if(argc>1)
+        duration_sec = std::stoull(argv[1]);
+    if(argc>2)
+        out_file = argv[2];
+
+    std::cout << "Usage: " << argv[0] << " [duration_sec] [output_file]" << std::endl;
+    std::cout << "Keep the camera perfectly still during the whole acquisition." << std::endl;
+    // <---- Command line arguments
+
+    // Set the verbose level
+    sl_oc::VERBOSITY verbose = sl_oc::VERBOSITY::ERROR;
+
+    // Samples received by the IMU callback. Declared before the SensorCapture object, so that they are destroyed
+    // after the sensor thread is stopped.
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::vector<sl_oc::sensors::data::Imu> queue;
+
+    // Create a SensorCapture object
+    sl_oc::sensors::SensorCapture sens(verbose);
+
+    // ----> Inizialize the sensors
+    std::vector<int> devs = sens.getDeviceList();
+
+    if( devs.size()==0 )
+    {
+        std::cerr << "No available ZED Mini or ZED2 cameras" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if( !sens.initializeSensors( devs[0] ) )
+    {
+        std::cerr << "Connection failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Sensor Capture connected to camera sn: " << sens.getSerialNumber() << std::endl;
+    // <---- Inizialize the sensors
+
+    // ----> Allan variance accumulators
+    const std::vector<std::string> names = {"gX[deg/s]","gY[deg/s]","gZ[deg/s]","aX[m/s2]","aY[m/s2]","aZ[m/s2]"};
+    sl_oc::sensors::AllanVariance avar(6, 1.0/400.0);
+    // <---- Allan variance accumulators
+
+    // ----> IMU data collection
+    // Every sample is received by the callback: polling getLastIMUData could skip or repeat samples
+    sens.setImuCallback([&](const sl_oc::sensors::data::Imu& imu){
+        {
+            const std::lock_guard<std::mutex> lock(queue_mutex);
+            queue.push_back(imu);
+        }
+        queue_cv.notify_one();
+    });
+    // <---- IMU data collection
+
+    uint64_t first_ts = 0;
+    uint64_t last_ts = 0;
+    uint64_t restarts = 0;
+    uint64_t next_save_sec = SAVE_INTERVAL_SEC;
+    bool done = false;
+
+    std::cout << "Acquiring IMU data for " << duration_sec << " seconds. Results will be saved to '" << out_file << "'" << std::endl;
+
+    std::vector<sl_oc::sensors::data::Imu> samples;
+    while(!done)
+    {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            if( !queue_cv.wait_for(lock, std::chrono::seconds(5), [&]{return !queue.empty();}) )
+            {
+                std::cerr << "No IMU data received" << std::endl;
+                return EXIT_FAILURE;
+            }
+            samples.swap(queue);
+        }
+
+        for( const sl_oc::sensors::data::Imu& imuData : samples )
+        {
+            // ----> Contiguity check
+            // The Allan variance requires a contiguous series: the accumulation restarts after lost or invalid
+            // samples and after irregular timestamps
+            const bool valid = imuData.valid == sl_oc::sensors::data::Imu::NEW_VAL;
+            const uint64_t dt = imuData.timestamp-last_ts;
+            if( last_ts!=0 && (!valid || imuData.gap || dt < NOMINAL_PERIOD_NSEC/2 || dt > NOMINAL_PERIOD_NSEC*3/2) )
+            {
+                restarts++;
+                std::cout << " * IMU data not contiguous after " << (last_ts-first_ts)/1000000000ULL
+                          << " sec: the acquisition restarts" << std::endl;
+
+                avar.reset();
+                first_ts = 0;
+                last_ts = 0;
+                next_save_sec = SAVE_INTERVAL_SEC;
+            }
+
+            if( !valid )
+                continue;
+
+            if(first_ts==0)
+                first_ts = imuData.timestamp;
+            last_ts = imuData.timestamp;
+            // <---- Contiguity check
+
+            double values[6] = {imuData.gX, imuData.gY, imuData.gZ, imuData.aX, imuData.aY, imuData.aZ};
+            avar.addSample(values);
+
+            uint64_t elapsed_sec = (last_ts-first_ts)/1000000000ULL;
+
+            // ----> Save intermediate results
+            if( elapsed_sec >= next_save_sec )
+            {
+                next_save_sec += SAVE_INTERVAL_SEC;
+                avar.saveToFile(out_file, names);
+
+                std::cout << " * " << elapsed_sec << "/" << duration_sec << " sec - samples: " << avar.getSampleCount()
+                          << " - restarts: " << restarts << std::endl;
+            }
+            // <---- Save intermediate results
+
+            if( elapsed_sec >= duration_sec )
+            {
+                done = true;
+                break;
+            }
+        }
+        samples.clear();
+    }
+
+    sens.setImuCallback(nullptr);
+
+    // ----> Final results
+    if( !avar.saveToFile(out_file, names) )
+    {
+        std::cerr << "Error writing the result file " << out_file << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::endl << "Noise parameters [" << avar.getSampleCount() << " contiguous samples, " << restarts << " restarts]:" << std::endl;
+    for( int c=0; c<6; c++ )
+    {
+        sl_oc::sensors::NoiseParams par = avar.fitNoiseParams(c);
+        std::cout << " * " << std::setw(10) << names[c]
+                  << " - White noise: " << par.white_noise << " [unit/sqrt(s)]"
+                  << " - Bias instability: " << par.bias_instability << " [unit] @ " << par.bias_tau << " s"
+                  << " - Random walk: " << par.random_walk << " [unit*sqrt(s)]" << std::endl;
+    }
+    // <---- Final results
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,292 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// ----> Includes
+#include "videocapture_def.hpp"
+#include "rectifier.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+// <---- Includes
+
+// ----> Defines
+#define DEFAULT_ITERATIONS  50  // Rectified frames for each measure
+#define DEFAULT_TILE_WIDTH  64  // Default width of the tiles
+#define DEFAULT_TILE_HEIGHT 32  // Default height of the tiles
+#define DEFAULT_GRID_STEP   16  // Default spacing of the map grid nodes
+// <---- Defines
+
+/*!
+ * \brief Hardware cache miss counter of the calling thread and of the threads it creates after the counter
+ */
+class CacheMissCounter
+{
+public:
+    CacheMissCounter( uint32_t type, uint64_t config )
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1; // Count the threads of the worker pool
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        mFd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    ~CacheMissCounter()
+    {
+        if( mFd>=0 )
+            close(mFd);
+    }
+
+    bool isValid() const {return mFd>=0;}
+
+    void start()
+    {
+        if( mFd<0 )
+            return;
+        ioctl(mFd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(mFd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    void stop()
+    {
+        if( mFd>=0 )
+            ioctl(mFd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    // Call after the counted threads exited
+    uint64_t read() const
+    {
+        uint64_t value = 0;
+        if( mFd<0 || ::read(mFd, &value, sizeof(value))!=sizeof(value) )
+            return 0;
+        return value;
+    }
+
+private:
+    int mFd = -1;
+};
+
+/*!
+ * \brief Create a rectification map with a typical wide angle lens distortion and a small rotation
+ */
+void createMap( int width, int height, double distortion_scale, std::vector<float>& map_x, std::vector<float>& map_y )
+{
+    const double f = 0.55*width;
+    const double cx = 0.5*width;
+    const double cy = 0.5*height;
+    const double k1 = -0.17*distortion_scale;
+    const double k2 = 0.025*distortion_scale;
+    const double p1 = 0.0005*distortion_scale;
+    const double p2 = -0.0003*distortion_scale;
+
+    // Rotation of the rectification: roll of 0.5 deg and tilt of 0.3 deg
+    const double roll = 0.5*M_PI/180.;
+    const double tilt = 0.3*M_PI/180.;
+    const double R[9] = { cos(roll), -sin(roll)*cos(tilt),  sin(roll)*sin(tilt),
+                          sin(roll),  cos(roll)*cos(tilt), -cos(roll)*sin(tilt),
+                          0.,         sin(tilt),            cos(tilt) };
+
+    map_x.resize(static_cast<size_t>(width)*height);
+    map_y.resize(static_cast<size_t>(width)*height);
+
+    for( int v=0; v<height; v++ )
+    {
+        for( int u=0; u<width; u++ )
+        {
+            const double xn = (u-cx)/f;
+            const double yn = (v-cy)/f;
+            const double X = R[0]*xn + R[1]*yn + R[2];
+            const double Y = R[3]*xn + R[4]*yn + R[5];
+            const double Z = R[6]*xn + R[7]*yn + R[8];
+            const double x = X/Z;
+            const double y = Y/Z;
+
+            const double r2 = x*x + y*y;
+            const double radial = 1. + k1*r2 + k2*r2*r2;
+            const double xd = x*radial + 2.*p1*x*y + p2*(r2+2.*x*x);
+            const double yd = y*radial + p1*(r2+2.*y*y) + 2.*p2*x*y;
+
+            map_x[static_cast<size_t>(v)*width+u] = static_cast<float>(f*xd + cx);
+            map_y[static_cast<size_t>(v)*width+u] = static_cast<float>(f*yd + cy);
+        }
+    }
+}
+
+// The main function
+int main(int argc, char *argv[])
+{
+    // ----> Command line arguments
+    int iterations = DEFAULT_ITERATIONS;
+    int tile_width = DEFAULT_TILE_WIDTH;
+    int tile_height = DEFAULT_TILE_HEIGHT;
+    size_t threads = 0;
+    double distortion_scale = 1.0;
+    int grid_step = DEFAULT_GRID_STEP;
+
+    if(argc>1)
+        iterations = std::max(1, std::stoi(argv[1]));
+    if(argc>2)
+        tile_width = std::stoi(argv[2]);
+    if(argc>3)
+        tile_height = std::stoi(argv[3]);
+    if(argc>4)
+        threads = std::stoul(argv[4]);
+    if(argc>5)
+        distortion_scale = std::stod(argv[5]);
+    if(argc>6)
+        grid_step = std::stoi(argv[6]);
+
+    std::cout << "Usage: " << argv[0] << " [iterations] [tile_width] [tile_height] [threads] [distortion_scale] [grid_step]" << std::endl;
+    std::cout << "Rectification of synthetic side-by-side frames, " << iterations << " frames for each measure" << std::endl;
+    // <---- Command line arguments
+
+    const char* res_names[] = {"HD2K", "HD1080", "HD720", "VGA"};
+    const sl_oc::video::RECT_FORMAT formats[] = {sl_oc::video::RECT_FORMAT::GRAY,
+                                                 sl_oc::video::RECT_FORMAT::YUYV,
+                                                 sl_oc::video::RECT_FORMAT::YUYV_TO_GRAY_HALF};
+    const char* format_names[] = {"GRAY", "YUYV", "YUYV_TO_GRAY_HALF"};
+
+    const char* mode_names[] = {"rows", "tiles", "grid"};
+
+    bool counters_ok = true;
+    std::vector<std::string> map_reports;
+
+    std::cout << std::endl;
+    std::cout << std::left << std::setw(8) << "Res." << std::setw(19) << "Format" << std::setw(10) << "Mode"
+              << std::right << std::setw(10) << "ms/frame" << std::setw(14) << "L1D miss/fr" << std::setw(14) << "LLC miss/fr"
+              << std::endl;
+
+    for( size_t r=0; r<sl_oc::video::cameraResolution.size(); r++ )
+    {
+        const int w = static_cast<int>(sl_oc::video::cameraResolution[r].width);
+        const int h = static_cast<int>(sl_oc::video::cameraResolution[r].height);
+
+        // ----> Synthetic maps and YUV 4:2:2 side-by-side frame
+        std::vector<float> map_x, map_y;
+        createMap(w, h, distortion_scale, map_x, map_y);
+
+        sl_oc::video::Rectifier rectifier;
+        rectifier.setMaps(sl_oc::video::CAM_SENS_POS::LEFT, map_x.data(), map_y.data(), w, h, w, h);
+        rectifier.setMaps(sl_oc::video::CAM_SENS_POS::RIGHT, map_x.data(), map_y.data(), w, h, w, h);
+
+        // Same maps stored on a coarse grid
+        sl_oc::video::Rectifier grid_rectifier;
+        grid_rectifier.setMapGridStep(grid_step);
+        grid_rectifier.setMaps(sl_oc::video::CAM_SENS_POS::LEFT, map_x.data(), map_y.data(), w, h, w, h);
+        grid_rectifier.setMaps(sl_oc::video::CAM_SENS_POS::RIGHT, map_x.data(), map_y.data(), w, h, w, h);
+
+        float max_error = 0.f, mean_error = 0.f;
+        grid_rectifier.getMapError(sl_oc::video::CAM_SENS_POS::LEFT, max_error, mean_error);
+        std::ostringstream report;
+        report << std::left << std::setw(8) << res_names[r] << std::right << std::fixed << std::setprecision(1)
+               << std::setw(12) << rectifier.getMapMemory()/1024. << std::setw(12) << grid_rectifier.getMapMemory()/1024.
+               << std::setprecision(3) << std::setw(12) << max_error << std::setw(12) << mean_error;
+        map_reports.push_back(report.str());
+
+        const size_t src_step = static_cast<size_t>(w)*2*2;
+        std::vector<uint8_t> frame(src_step*h);
+        std::mt19937 rng(42);
+        for( uint8_t& px : frame )
+            px = static_cast<uint8_t>(rng());
+
+        const size_t dst_step = static_cast<size_t>(w)*2;
+        std::vector<uint8_t> dst_left(dst_step*h), dst_right(dst_step*h);
+        // <---- Synthetic maps and YUV 4:2:2 side-by-side frame
+
+        for( size_t f=0; f<sizeof(formats)/sizeof(formats[0]); f++ )
+        {
+            for( int mode=0; mode<3; mode++ )
+            {
+                sl_oc::video::Rectifier& rect = (mode==2)?grid_rectifier:rectifier;
+                if( mode==1 )
+                    rectifier.setTileSize(tile_width, tile_height);
+                else
+                    rectifier.setTileSize(0, 0);
+
+                CacheMissCounter l1_misses(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                                           (PERF_COUNT_HW_CACHE_OP_READ<<8) | (PERF_COUNT_HW_CACHE_RESULT_MISS<<16));
+                CacheMissCounter llc_misses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+                counters_ok &= l1_misses.isValid() && llc_misses.isValid();
+
+                double elapsed_ms = 0.;
+                {
+                    // The pool is created after the counters to count its threads
+                    sl_oc::video::WorkerPool pool(threads);
+                    rect.setWorkerPool(&pool);
+
+                    // Warm up
+                    rect.rectifyStereo(formats[f], frame.data(), src_step, dst_left.data(), dst_right.data(), dst_step);
+
+                    l1_misses.start();
+                    llc_misses.start();
+                    auto start = std::chrono::steady_clock::now();
+                    for( int i=0; i<iterations; i++ )
+                        rect.rectifyStereo(formats[f], frame.data(), src_step, dst_left.data(), dst_right.data(), dst_step);
+                    elapsed_ms = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+                    l1_misses.stop();
+                    llc_misses.stop();
+
+                    rect.setWorkerPool(nullptr);
+                }
+
+                std::cout << std::left << std::setw(8) << res_names[r] << std::setw(19) << format_names[f]
+                          << std::setw(10) << mode_names[mode] << std::right << std::fixed << std::setprecision(3)
+                          << std::setw(10) << elapsed_ms/iterations;
+                if( l1_misses.isValid() && llc_misses.isValid() )
+                    std::cout << std::setw(14) << l1_misses.read()/iterations << std::setw(14) << llc_misses.read()/iterations;
+                else
+                    std::cout << std::setw(14) << "n/a" << std::setw(14) << "n/a";
+                std::cout << std::endl;
+            }
+        }
+    }
+
+    std::cout << std::endl << "Rectification maps, grid of " << grid_step << " pixels" << std::endl;
+    std::cout << std::left << std::setw(8) << "Res." << std::right << std::setw(12) << "Full KB" << std::setw(12) << "Grid KB"
+              << std::setw(12) << "Max err px" << std::setw(12) << "Mean err px" << std::endl;
+    for( const std::string& report : map_reports )
+        std::cout << report << std::endl;
+
+    if( !counters_ok )
+    {
+        std::cout << std::endl << "Hardware cache counters not available: check '/proc/sys/kernel/perf_event_paranoid'"
+                  << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
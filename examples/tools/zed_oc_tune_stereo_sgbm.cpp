@@ -122,8 +122,10 @@ int main(int argc, char *argv[])
     cv::Mat map_left_x, map_left_y;
     cv::Mat map_right_x, map_right_y;
     cv::Mat cameraMatrix_left, cameraMatrix_right;
-    sl_oc::tools::initCalibration(calibration_file, cv::Size(w/2,h), map_left_x, map_left_y, map_right_x, map_right_y,
-                                  cameraMatrix_left, cameraMatrix_right);
+    sl_oc::video::RectMapCache rect_cache; // Keeps the cached maps mapped in memory
+    sl_oc::tools::initCalibrationCached(calibration_file, sn, cv::Size(w/2,h), rect_cache,
+                                        map_left_x, map_left_y, map_right_x, map_right_y,
+                                        cameraMatrix_left, cameraMatrix_right);
 
     std::cout << " Camera Matrix L: \n" << cameraMatrix_left << std::endl << std::endl;
     std::cout << " Camera Matrix R: \n" << cameraMatrix_right << std::endl << std::endl;
@@ -24,6 +24,7 @@
 #include <string>
 
 #include "videocapture.hpp"
+#include "rectificationmanager.hpp"
 
 // OpenCV includes
 #include <opencv2/opencv.hpp>
@@ -90,43 +91,54 @@ int main(int argc, char *argv[])
     }
     std::cout << "Calibration file found. Loading..." << std::endl;
 
-    // ----> Frame size
-    int w,h;
-    cap.getFrameSize(w,h);
-    // <---- Frame size
-
     // ----> Initialize calibration
-    cv::Mat map_left_x, map_left_y;
-    cv::Mat map_right_x, map_right_y;
-    cv::Mat cameraMatrix_left, cameraMatrix_right;
-    double baseline=0;
-    sl_oc::tools::initCalibration(calibration_file, cv::Size(w/2,h), map_left_x, map_left_y, map_right_x, map_right_y,
-                                  cameraMatrix_left, cameraMatrix_right, &baseline);
-
-    double fx = cameraMatrix_left.at<double>(0,0);
-    double fy = cameraMatrix_left.at<double>(1,1);
-    double cx = cameraMatrix_left.at<double>(0,2);
-    double cy = cameraMatrix_left.at<double>(1,2);
-
-    std::cout << " Camera Matrix L: \n" << cameraMatrix_left << std::endl << std::endl;
-    std::cout << " Camera Matrix R: \n" << cameraMatrix_right << std::endl << std::endl;
+    sl_oc::video::StereoCalibration calibration;
+    std::string calib_error;
+    if( !calibration.load(calibration_file, &calib_error) || !calibration.isValid(params.res) )
+    {
+        std::cerr << "Invalid calibration file: " << calib_error << std::endl;
+        return EXIT_FAILURE;
+    }
 
-#ifdef USE_OCV_TAPI
-    cv::UMat map_left_x_gpu = map_left_x.getUMat(cv::ACCESS_READ,cv::USAGE_ALLOCATE_DEVICE_MEMORY);
-    cv::UMat map_left_y_gpu = map_left_y.getUMat(cv::ACCESS_READ,cv::USAGE_ALLOCATE_DEVICE_MEMORY);
-    cv::UMat map_right_x_gpu = map_right_x.getUMat(cv::ACCESS_READ,cv::USAGE_ALLOCATE_DEVICE_MEMORY);
-    cv::UMat map_right_y_gpu = map_right_y.getUMat(cv::ACCESS_READ,cv::USAGE_ALLOCATE_DEVICE_MEMORY);
+    // The depth is computed at the camera resolution: the disparity of the half size images is upscaled
+    sl_oc::video::RectificationParams full_rect;
+    sl_oc::video::StereoRectify::compute(calibration.getParams(params.res), full_rect);
+    double baseline = calibration.getParams(params.res).baseline;
+
+    double fx = full_rect.P_left[0];
+    double fy = full_rect.P_left[5];
+    double cx = full_rect.P_left[2];
+    double cy = full_rect.P_left[6];
+
+    std::cout << " Camera Matrix L: \n" << cv::Mat(3, 4, CV_64F, full_rect.P_left) << std::endl << std::endl;
+    std::cout << " Camera Matrix R: \n" << cv::Mat(3, 4, CV_64F, full_rect.P_right) << std::endl << std::endl;
+    // <---- Initialize calibration
+
+    // ----> Initialize the rectifier
+    // The luma of the YUV 4:2:2 frame is rectified in a single pass for each image. For half size matching the maps
+    // are built directly at half resolution, rectifying a quarter of the pixels.
+    sl_oc::video::WorkerPool pool;
+    sl_oc::video::RectificationManager rect_manager(&pool);
+#ifdef USE_HALF_SIZE_DISP
+    rect_manager.setOutputScale(0.5);
 #endif
-    // ----> Initialize calibration
+    if( !rect_manager.setCalibration(calibration, params.res) )
+    {
+        std::cerr << "Cannot create the rectification maps" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::shared_ptr<sl_oc::video::Rectifier> rectifier = rect_manager.getRectifier();
+
+    const sl_oc::video::RECT_FORMAT rect_format = sl_oc::video::RECT_FORMAT::YUYV_TO_GRAY;
+    int rect_w, rect_h;
+    rectifier->getSize(sl_oc::video::CAM_SENS_POS::LEFT, rect_w, rect_h, rect_format);
+    cv::Mat left_rect_gray(rect_h, rect_w, CV_8UC1);  // Left rectified luma image
+    cv::Mat right_rect_gray(rect_h, rect_w, CV_8UC1); // Right rectified luma image
+    // <---- Initialize the rectifier
 
     // ----> Declare OpenCV images
 #ifdef USE_OCV_TAPI
-    cv::UMat frameYUV;  // Full frame side-by-side in YUV 4:2:2 format
-    cv::UMat frameBGR(cv::USAGE_ALLOCATE_DEVICE_MEMORY); // Full frame side-by-side in BGR format
-    cv::UMat left_raw(cv::USAGE_ALLOCATE_DEVICE_MEMORY); // Left unrectified image
-    cv::UMat right_raw(cv::USAGE_ALLOCATE_DEVICE_MEMORY); // Right unrectified image
-    cv::UMat left_rect(cv::USAGE_ALLOCATE_DEVICE_MEMORY); // Left rectified image
-    cv::UMat right_rect(cv::USAGE_ALLOCATE_DEVICE_MEMORY); // Right rectified image
+    cv::UMat left_rect(cv::USAGE_ALLOCATE_DEVICE_MEMORY); // Left rectified image used to color the point cloud
     cv::UMat left_for_matcher(cv::USAGE_ALLOCATE_DEVICE_MEMORY); // Left image for the stereo matcher
     cv::UMat right_for_matcher(cv::USAGE_ALLOCATE_DEVICE_MEMORY); // Right image for the stereo matcher
     cv::UMat left_disp_half(cv::USAGE_ALLOCATE_DEVICE_MEMORY); // Half sized disparity map
@@ -135,7 +147,7 @@ int main(int argc, char *argv[])
     cv::UMat left_disp_image(cv::USAGE_ALLOCATE_DEVICE_MEMORY); // Normalized and color remapped disparity map to be displayed
     cv::UMat left_depth_map(cv::USAGE_ALLOCATE_DEVICE_MEMORY); // Depth map in float32
 #else
-    cv::Mat frameBGR, left_raw, left_rect, right_raw, right_rect, frameYUV, left_for_matcher, right_for_matcher, left_disp_half,left_disp,left_disp_float, left_disp_vis;
+    cv::Mat left_rect, left_for_matcher, right_for_matcher, left_disp_half,left_disp,left_disp_float, left_disp_vis;
 #endif
     // <---- Declare OpenCV images
 
@@ -187,29 +199,16 @@ int main(int argc, char *argv[])
         {
             last_ts = frame.timestamp;
 
-            // ----> Conversion from YUV 4:2:2 to BGR for visualization
-#ifdef USE_OCV_TAPI
-            cv::Mat frameYUV_cpu = cv::Mat( frame.height, frame.width, CV_8UC2, frame.data );
-            frameYUV = frameYUV_cpu.getUMat(cv::ACCESS_READ,cv::USAGE_ALLOCATE_HOST_MEMORY);
-#else
-            frameYUV = cv::Mat( frame.height, frame.width, CV_8UC2, frame.data );
-#endif
-            cv::cvtColor(frameYUV,frameBGR,cv::COLOR_YUV2BGR_YUYV);
-            // <---- Conversion from YUV 4:2:2 to BGR for visualization
-
-            // ----> Extract left and right images from side-by-side
-            left_raw = frameBGR(cv::Rect(0, 0, frameBGR.cols / 2, frameBGR.rows));
-            right_raw = frameBGR(cv::Rect(frameBGR.cols / 2, 0, frameBGR.cols / 2, frameBGR.rows));
-            // <---- Extract left and right images from side-by-side
-
-            // ----> Apply rectification
+            // ----> Apply rectification to the luma of the side-by-side YUV 4:2:2 frame
             sl_oc::tools::StopWatch remap_clock;
+            rectifier->rectifyStereo(rect_format, frame.data, frame.width*2,
+                                     left_rect_gray.data, right_rect_gray.data, left_rect_gray.step);
 #ifdef USE_OCV_TAPI
-            cv::remap(left_raw, left_rect, map_left_x_gpu, map_left_y_gpu, cv::INTER_AREA );
-            cv::remap(right_raw, right_rect, map_right_x_gpu, map_right_y_gpu, cv::INTER_AREA );
+            left_rect_gray.copyTo(left_for_matcher);
+            right_rect_gray.copyTo(right_for_matcher);
 #else
-            cv::remap(left_raw, left_rect, map_left_x, map_left_y, cv::INTER_AREA );
-            cv::remap(right_raw, right_rect, map_right_x, map_right_y, cv::INTER_AREA );
+            left_for_matcher = left_rect_gray; // No data copy
+            right_for_matcher = right_rect_gray; // No data copy
 #endif
             double remap_elapsed = remap_clock.toc();
             std::stringstream remapElabInfo;
@@ -220,13 +219,7 @@ int main(int argc, char *argv[])
             sl_oc::tools::StopWatch stereo_clock;
             double resize_fact = 1.0;
 #ifdef USE_HALF_SIZE_DISP
-            resize_fact = 0.5;
-            // Resize the original images to improve performances
-            cv::resize(left_rect,  left_for_matcher,  cv::Size(), resize_fact, resize_fact, cv::INTER_AREA);
-            cv::resize(right_rect, right_for_matcher, cv::Size(), resize_fact, resize_fact, cv::INTER_AREA);
-#else
-            left_for_matcher = left_rect; // No data copy
-            right_for_matcher = right_rect; // No data copy
+            resize_fact = 0.5; // The images have been downscaled by the rectifier to improve performances
 #endif
             // Apply stereo matching
             left_matcher->compute(left_for_matcher, right_for_matcher,left_disp_half);
@@ -249,8 +242,8 @@ int main(int argc, char *argv[])
             // <---- Stereo matching
 
             // ----> Show frames
-            sl_oc::tools::showImage("Right rect.", right_rect, params.res,true, remapElabInfo.str());
-            sl_oc::tools::showImage("Left rect.", left_rect, params.res,true, remapElabInfo.str());
+            sl_oc::tools::showImage("Right rect.", right_rect_gray, params.res,true, remapElabInfo.str());
+            sl_oc::tools::showImage("Left rect.", left_rect_gray, params.res,true, remapElabInfo.str());
             // <---- Show frames
 
             // ----> Show disparity image
@@ -298,6 +291,12 @@ int main(int argc, char *argv[])
 
             cloudMat = cv::Mat( left_depth_map.rows, left_depth_map.cols, CV_64FC3, &buffer[0] ).clone();
 
+#ifdef HAVE_OPENCV_VIZ
+            // Point colors at the size of the depth map
+            cv::resize(left_for_matcher, left_rect, left_depth_map.size(), 0, 0, cv::INTER_LINEAR);
+            cv::cvtColor(left_rect, left_rect, cv::COLOR_GRAY2BGR);
+#endif
+
             double pc_elapsed = stereo_clock.toc();
             std::stringstream pcElabInfo;
 //            pcElabInfo << "Point cloud processing: " << pc_elapsed << " sec - Freq: " << 1./pc_elapsed;
@@ -24,6 +24,7 @@
 #include <string>
 
 #include "videocapture.hpp"
+#include "rectifier.hpp"
 
 // OpenCV includes
 #include <opencv2/opencv.hpp>
@@ -84,14 +85,27 @@ int main(int argc, char *argv[])
     cv::Mat map_left_x, map_left_y;
     cv::Mat map_right_x, map_right_y;
     cv::Mat cameraMatrix_left, cameraMatrix_right;
-    sl_oc::tools::initCalibration(calibration_file, cv::Size(w/2,h), map_left_x, map_left_y, map_right_x, map_right_y,
-                    cameraMatrix_left, cameraMatrix_right);
+    sl_oc::video::RectMapCache rect_cache; // Keeps the cached maps mapped in memory
+    sl_oc::tools::initCalibrationCached(calibration_file, sn, cv::Size(w/2,h), rect_cache,
+                                        map_left_x, map_left_y, map_right_x, map_right_y,
+                                        cameraMatrix_left, cameraMatrix_right);
 
     std::cout << " Camera Matrix L: \n" << cameraMatrix_left << std::endl << std::endl;
     std::cout << " Camera Matrix R: \n" << cameraMatrix_right << std::endl << std::endl;
     // ----> Initialize calibration
 
+    // ----> Initialize the fixed-point rectifier
+    sl_oc::video::WorkerPool pool;
+    sl_oc::video::Rectifier rectifier(&pool);
+    rectifier.setMaps(sl_oc::video::CAM_SENS_POS::LEFT, map_left_x.ptr<float>(), map_left_y.ptr<float>(),
+                      map_left_x.cols, map_left_x.rows, w/2, h);
+    rectifier.setMaps(sl_oc::video::CAM_SENS_POS::RIGHT, map_right_x.ptr<float>(), map_right_y.ptr<float>(),
+                      map_right_x.cols, map_right_x.rows, w/2, h);
+    // <---- Initialize the fixed-point rectifier
+
     cv::Mat frameBGR, left_raw, left_rect, right_raw, right_rect;
+    cv::Mat left_rect_yuv(map_left_x.rows, map_left_x.cols, CV_8UC2);
+    cv::Mat right_rect_yuv(map_right_x.rows, map_right_x.cols, CV_8UC2);
 
     uint64_t last_ts=0;
 
@@ -119,9 +133,11 @@ int main(int argc, char *argv[])
             sl_oc::tools::showImage("right RAW", right_raw, params.res);
             // <---- Extract left and right images from side-by-side
 
-            // ----> Apply rectification
-            cv::remap(left_raw, left_rect, map_left_x, map_left_y, cv::INTER_LINEAR );
-            cv::remap(right_raw, right_rect, map_right_x, map_right_y, cv::INTER_LINEAR );
+            // ----> Apply rectification to the YUV 4:2:2 frame, then convert to BGR for visualization
+            rectifier.rectifyStereo(sl_oc::video::RECT_FORMAT::YUYV, frame.data, frameYUV.step,
+                                    left_rect_yuv.data, right_rect_yuv.data, left_rect_yuv.step);
+            cv::cvtColor(left_rect_yuv,left_rect,cv::COLOR_YUV2BGR_YUYV);
+            cv::cvtColor(right_rect_yuv,right_rect,cv::COLOR_YUV2BGR_YUYV);
 
             sl_oc::tools::showImage("right RECT", right_rect, params.res);
             sl_oc::tools::showImage("left RECT", left_rect, params.res);
@@ -108,6 +108,8 @@ int main(int argc, char *argv[])
             }
             last_mag_ts = magData.timestamp;
             std::cout << " * Magnetic field [uT]: " << magData.mX << " " << magData.mY << " " << magData.mZ << std::endl;
+            if( magData.calibrated )
+                std::cout << " * Calibrated magnetic field [uT]: " << magData.mX_cal << " " << magData.mY_cal << " " << magData.mZ_cal << std::endl;
         }
         // <---- Get Magnetometer data with a timeout of 100 microseconds to not slow down fastest data (IMU)
 
@@ -145,5 +147,17 @@ int main(int argc, char *argv[])
         // <---- Get Temperature data with a timeout of 100 microseconds to not slow down fastest data (IMU)
     }
 
+    // ----> Sensor path latency statistics
+    const sl_oc::sensors::data::SensorLatencyStats stats = sens.getLatencyStats();
+    std::cout << "**** Sensor path latency ****" << std::endl;
+    std::cout << " * Transport: " << stats.transport.toString() << std::endl;
+    std::cout << " * Jitter: " << stats.jitter.toString() << std::endl;
+    std::cout << " * Processing: " << stats.processing.toString() << std::endl;
+
+    const sl_oc::sensors::data::SensorPacketStats packets = sens.getPacketStats();
+    std::cout << " * Packets: " << packets.received << " received, " << packets.lost << " lost in " << packets.gaps
+              << " gaps, " << packets.duplicated << " duplicated, " << packets.out_of_order << " out of order" << std::endl;
+    // <---- Sensor path latency statistics
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ALLANVARIANCE_HPP
+#define ALLANVARIANCE_HPP
+
+#include "defines.hpp"
+
+#include <vector>
+#include <string>
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace sensors {
+
+/*!
+ * \brief A point of an Allan deviation curve
+ */
+struct SL_OC_EXPORT AllanPoint
+{
+    double tau = 0.0;           //!< Cluster time in seconds
+    double adev = 0.0;          //!< Allan deviation, in the same unit of the input data
+    uint64_t clusters = 0;      //!< Number of cluster differences accumulated for this point
+};
+
+/*!
+ * \brief Noise parameters fitted on an Allan deviation curve
+ */
+struct SL_OC_EXPORT NoiseParams
+{
+    double white_noise = 0.0;       //!< White noise density (ARW/VRW) [unit/√s], value of the -1/2 slope line at τ=1 s
+    double bias_instability = 0.0;  //!< Bias instability [unit], minimum of the curve divided by 0.664
+    double bias_tau = 0.0;          //!< Cluster time of the bias instability point [s]
+    double random_walk = 0.0;       //!< Rate random walk [unit·√s], value of the +1/2 slope line at τ=3 s (0 if not observed)
+};
+
+/*!
+ * \brief The AllanVariance class computes the overlapping Allan variance of a multi-channel stream with bounded memory
+ *
+ * Cluster times are octave spaced (τ = 2^k·τ0). For each octave the integrated signal is sampled every
+ * `m/overlap` input samples in a small ring buffer, so each octave uses `2·overlap+1` values per channel whatever
+ * the cluster size, and the per-sample cost does not depend on the acquisition length.
+ * The estimator is fully overlapping for the octaves with `m <= overlap`.
+ */
+class SL_OC_EXPORT AllanVariance
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param channels number of channels of the input stream
+     * \param sample_period the nominal sampling period τ0 of the stream in seconds
+     * \param octaves number of octave spaced cluster times to be evaluated
+     * \param overlap number of overlapping clusters for each cluster length (power of 2)
+     */
+    AllanVariance( int channels=6, double sample_period=1.0/400.0, int octaves=20, int overlap=8 );
+
+    /*!
+     * \brief Add a new sample to the accumulators
+     * \param values pointer to an array containing a value for each channel
+     */
+    void addSample( const double* values );
+
+    /*!
+     * \brief Reset all the accumulators
+     */
+    void reset();
+
+    /*!
+     * \brief Get the Allan deviation curve of a channel. Only the cluster times with at least one accumulated
+     *        cluster difference are returned.
+     * \param channel the channel index
+     * \return the Allan deviation curve
+     */
+    std::vector<AllanPoint> getCurve( int channel ) const;
+
+    /*!
+     * \brief Fit the noise parameters on the Allan deviation curve of a channel
+     * \param channel the channel index
+     * \return the fitted noise parameters
+     */
+    NoiseParams fitNoiseParams( int channel ) const;
+
+    /*!
+     * \brief Save the Allan deviation curves and the fitted noise parameters to a text file
+     * \param filename the path of the destination file
+     * \param names the names of the channels, used as column headers
+     * \return true if the file has been correctly written
+     */
+    bool saveToFile( const std::string& filename, const std::vector<std::string>& names ) const;
+
+    inline uint64_t getSampleCount() const {return mSampleCount;}  //!< Number of samples added since the last reset
+    inline int getChannelCount() const {return mChannels;}         //!< Number of channels
+
+private:
+    struct Octave
+    {
+        uint64_t stride_mask = 0;       //!< Sampling stride of the integrated signal minus 1 (stride is a power of 2)
+        size_t lag = 0;                 //!< Cluster length expressed in ring buffer entries
+        size_t ring_size = 0;           //!< Number of entries of the ring buffer
+        size_t head = 0;                //!< Index of the next ring buffer entry to be written
+        size_t filled = 0;              //!< Number of valid entries in the ring buffer
+        std::vector<double> ring;       //!< Integrated signal samples [ring_size x channels]
+        std::vector<double> sum;        //!< Sum of the squared second differences for each channel
+        uint64_t count = 0;             //!< Number of accumulated second differences
+    };
+
+    int mChannels;                      //!< Number of channels
+    double mSamplePeriod;               //!< Nominal sampling period [s]
+    uint64_t mSampleCount = 0;          //!< Number of samples added
+    std::vector<double> mIntegral;      //!< Integrated signal (sum of the input values) for each channel
+    std::vector<Octave> mOctaves;       //!< Accumulators for each octave
+};
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+/** \example zed_oc_imu_noise_tool.cpp
+ * Tool to characterize the noise of the IMU sensors of a still camera using the AllanVariance class.
+ */
+
+#endif // ALLANVARIANCE_HPP
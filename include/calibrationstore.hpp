@@ -0,0 +1,212 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef CALIBRATIONSTORE_HPP
+#define CALIBRATIONSTORE_HPP
+
+#include "defines.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief The CalibrationStore class resolves the factory calibration files of the cameras (`SN<serial>.conf`) without
+ *        network access
+ *
+ * The files are searched in a list of local directories and in bundled archives (uncompressed tar files, for example
+ * created with `tar cf calib.tar SN*.conf`), in the order in which they are added. The sources are scanned once and
+ * indexed in memory by serial number.
+ *
+ * A missing calibration can be requested to a user provided fetcher, run on a single background thread of the store:
+ * the caller is never blocked and no process is created by the library. The fetched file is saved in the writable directory and
+ * added to the index.
+ */
+class SL_OC_EXPORT CalibrationStore
+{
+public:
+    /*!
+     * \brief Function retrieving the content of the calibration file of a camera, for example from a server
+     * \param serial_number the camera serial number
+     * \param data the content of the calibration file
+     * \return true if the calibration file has been retrieved
+     */
+    typedef std::function<bool(unsigned int serial_number, std::string& data)> Fetcher;
+
+    /*!
+     * \brief The default constructor. The default directory (see \ref getDefaultDirectory) is the first search
+     *        directory and the writable directory.
+     */
+    CalibrationStore();
+
+    /*!
+     * \brief The class destructor, waits for the pending fetches
+     */
+    ~CalibrationStore();
+
+    CalibrationStore( const CalibrationStore& ) = delete;
+    CalibrationStore& operator=( const CalibrationStore& ) = delete;
+
+    /*!
+     * \brief Get the default calibration directory
+     * \return `$HOME/zed/settings/`
+     */
+    static std::string getDefaultDirectory();
+
+    /*!
+     * \brief Get the name of the calibration file of a camera
+     * \param serial_number the camera serial number
+     * \return `SN<serial>.conf`
+     */
+    static std::string getCalibrationFilename( unsigned int serial_number );
+
+    /*!
+     * \brief Add a directory to the search list and index its calibration files
+     * \param path the directory path
+     * \return false if the directory cannot be read
+     */
+    bool addDirectory( const std::string& path );
+
+    /*!
+     * \brief Add an uncompressed tar archive to the search list and index its calibration files
+     * \param path the archive path
+     * \return false if the archive cannot be read or it is not a valid tar file
+     */
+    bool addArchive( const std::string& path );
+
+    /*!
+     * \brief Remove all the directories and the archives from the search list
+     */
+    void clear();
+
+    /*!
+     * \brief Scan again the directories and the archives of the search list
+     */
+    void rebuildIndex();
+
+    /*!
+     * \brief Set the directory where the fetched files and the files extracted from the archives are saved
+     * \param path the directory path, created if it does not exist
+     */
+    void setWritableDirectory( const std::string& path );
+
+    /*!
+     * \brief Check if the calibration of a camera is available
+     * \param serial_number the camera serial number
+     * \return true if the calibration file has been found
+     */
+    bool contains( unsigned int serial_number );
+
+    /*!
+     * \brief Get the serial numbers of the cameras with an available calibration
+     * \return the indexed serial numbers, in increasing order
+     */
+    std::vector<unsigned int> getSerialNumbers();
+
+    /*!
+     * \brief Get the content of the calibration file of a camera
+     * \param serial_number the camera serial number
+     * \param data the content of the calibration file
+     * \return false if the calibration file is not available
+     */
+    bool getData( unsigned int serial_number, std::string& data );
+
+    /*!
+     * \brief Get the path of the calibration file of a camera. Files found in an archive are extracted to the writable
+     *        directory.
+     * \param serial_number the camera serial number
+     * \param filename the path of the calibration file
+     * \return false if the calibration file is not available
+     */
+    bool getFile( unsigned int serial_number, std::string& filename );
+
+    /*!
+     * \brief Set the function used by \ref fetch to retrieve the missing calibration files
+     * \param fetcher the fetcher function. It is called by the fetch thread of the store, one request at a time. An
+     *        exception thrown by the fetcher fails the request.
+     */
+    void setFetcher( Fetcher fetcher );
+
+    /*!
+     * \brief Retrieve the calibration file of a camera with the fetcher in the background. Concurrent requests for the
+     *        same camera share the same fetch.
+     * \param serial_number the camera serial number
+     * \return the result of the fetch, true when the calibration is available. It is immediately ready if the
+     *         calibration is already available or no fetcher is set.
+     * \note The requests are queued and run in order. The requests still queued when the store is destroyed fail.
+     */
+    std::shared_future<bool> fetch( unsigned int serial_number );
+
+private:
+    struct Source
+    {
+        std::string path;               //!< Path of the directory or of the archive
+        bool archive = false;           //!< Indicates that the source is a tar archive
+    };
+
+    struct Entry
+    {
+        std::string path;               //!< Path of the calibration file or of the archive containing it
+        bool archived = false;          //!< Indicates that the file is stored in a tar archive
+        uint64_t offset = 0;            //!< Offset of the file content in the archive
+        uint64_t size = 0;              //!< Size of the file content in the archive
+    };
+
+    static bool parseFilename( const std::string& name, unsigned int& serial_number );
+
+    bool indexDirectory( const std::string& path );     //!< Add the files of a directory to the index
+    bool indexArchive( const std::string& path );       //!< Add the files of a tar archive to the index
+    bool findEntry( unsigned int serial_number, Entry& entry ); //!< Look for a camera in the index and in the directories
+    bool saveFile( unsigned int serial_number, const std::string& data, std::string& filename ); //!< Save to the writable directory
+    void fetchFunc();                   //!< Fetch thread function, running the queued requests
+
+    std::mutex mMutex;                  //!< Protects the search list, the index and the fetcher
+    std::vector<Source> mSources;       //!< Search directories and archives, in order of priority
+    std::map<unsigned int, Entry> mIndex;   //!< Calibration files indexed by serial number
+    std::string mWritableDir;           //!< Destination of the fetched and extracted files
+
+    Fetcher mFetcher;                   //!< The user fetcher function
+    std::map<unsigned int, std::shared_future<bool>> mPending;  //!< Queued and running fetches
+    std::deque<std::pair<unsigned int, std::shared_ptr<std::promise<bool>>>> mFetchQueue; //!< Queued fetches
+    std::condition_variable mFetchCond; //!< Signals new requests to the fetch thread
+    bool mStop = false;                 //!< Requests the fetch thread to stop
+    std::thread mFetchThread;           //!< Fetch thread, started at the first request
+};
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
+
+#endif // CALIBRATIONSTORE_HPP
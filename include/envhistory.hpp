@@ -0,0 +1,176 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ENVHISTORY_HPP
+#define ENVHISTORY_HPP
+
+#include "defines.hpp"
+
+#include <vector>
+#include <string>
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace sensors {
+
+namespace data {
+
+/*!
+ * \brief Contains the statistics of a sensor value over a time interval
+ */
+struct SL_OC_EXPORT EnvRollup
+{
+    uint64_t timestamp = 0; //!< Start of the interval in nanoseconds
+    uint64_t duration = 0;  //!< Length of the interval in nanoseconds
+    uint32_t count = 0;     //!< Number of samples received in the interval
+    float min = 0.0f;       //!< Minimum value
+    float mean = 0.0f;      //!< Mean value
+    float max = 0.0f;       //!< Maximum value
+};
+
+}
+
+/*!
+ * \brief The EnvHistory class stores the history of the environmental sensors and of the camera temperatures as
+ *        min/mean/max rollups at three resolutions, with fixed memory
+ *
+ * Each resolution is a ring buffer of closed intervals: by default one hour of 1 second rollups, one day of 1 minute
+ * rollups and 30 days of 1 hour rollups. Intervals are aligned to the timestamp epoch, so histories saved by
+ * different sessions can be compared.
+ */
+class SL_OC_EXPORT EnvHistory
+{
+public:
+    //! Resolution of the rollups
+    enum class RESOLUTION {
+        SECOND = 0,     //!< 1 second rollups
+        MINUTE = 1,     //!< 1 minute rollups
+        HOUR = 2,       //!< 1 hour rollups
+        LAST = 3
+    };
+
+    //! Stored sensor values
+    enum class CHANNEL {
+        ENV_TEMP = 0,       //!< Environmental sensor temperature [°C]
+        ENV_PRESS = 1,      //!< Atmospheric pressure [hPa]
+        ENV_HUMID = 2,      //!< Humidity [%rH]
+        CAM_TEMP_LEFT = 3,  //!< Temperature of the left CMOS sensor [°C]
+        CAM_TEMP_RIGHT = 4, //!< Temperature of the right CMOS sensor [°C]
+        LAST = 5
+    };
+
+    /*!
+     * \brief The default constructor
+     * \param sec_capacity number of 1 second rollups kept
+     * \param min_capacity number of 1 minute rollups kept
+     * \param hour_capacity number of 1 hour rollups kept
+     */
+    EnvHistory( size_t sec_capacity=3600, size_t min_capacity=1440, size_t hour_capacity=720 );
+
+    /*!
+     * \brief Add a new environmental sensor sample
+     * \param timestamp the timestamp of the sample in nanoseconds
+     * \param temp the temperature [°C]
+     * \param press the atmospheric pressure [hPa]
+     * \param humid the humidity [%rH]
+     */
+    void addEnvironment( uint64_t timestamp, float temp, float press, float humid );
+
+    /*!
+     * \brief Add a new camera sensors temperature sample
+     * \param timestamp the timestamp of the sample in nanoseconds
+     * \param temp_left the temperature of the left CMOS sensor [°C]
+     * \param temp_right the temperature of the right CMOS sensor [°C]
+     */
+    void addCameraTemperature( uint64_t timestamp, float temp_left, float temp_right );
+
+    /*!
+     * \brief Get the closed rollups of a channel overlapping a time range, sorted by timestamp
+     * \param res the requested resolution
+     * \param channel the requested channel
+     * \param from_ts start of the time range in nanoseconds
+     * \param to_ts end of the time range in nanoseconds
+     * \return the rollups containing at least one sample of the channel
+     */
+    std::vector<data::EnvRollup> query( RESOLUTION res, CHANNEL channel, uint64_t from_ts=0,
+                                        uint64_t to_ts=static_cast<uint64_t>(-1) ) const;
+
+    /*!
+     * \brief Remove all the stored data
+     */
+    void clear();
+
+    /*!
+     * \brief Save the history to a binary file, including the intervals not yet closed
+     * \param filename the path of the destination file
+     * \return true if the file has been correctly written
+     */
+    bool saveToFile( const std::string& filename ) const;
+
+    /*!
+     * \brief Load a history saved by \ref saveToFile, replacing the stored data. If the file contains more rollups
+     *        than the capacity of a resolution, the newest ones are kept.
+     * \param filename the path of the history file
+     * \return true if the file has been correctly loaded
+     */
+    bool loadFromFile( const std::string& filename );
+
+private:
+    static const int CH_COUNT = static_cast<int>(CHANNEL::LAST);
+    static const int RES_COUNT = static_cast<int>(RESOLUTION::LAST);
+
+    struct Bucket
+    {
+        uint64_t start = 0;             //!< Start of the interval [nsec]
+        uint32_t count[CH_COUNT] = {};  //!< Number of samples for each channel
+        float min[CH_COUNT] = {};       //!< Minimum values
+        float max[CH_COUNT] = {};       //!< Maximum values
+        double sum[CH_COUNT] = {};      //!< Sum of the values
+
+        void reset( uint64_t start_ts );
+        void merge( const Bucket& other );
+    };
+
+    struct Level
+    {
+        uint64_t interval = 0;          //!< Length of the intervals [nsec]
+        std::vector<Bucket> ring;       //!< Closed intervals
+        size_t head = 0;                //!< Index of the next ring entry to be written
+        size_t size = 0;                //!< Number of valid ring entries
+        bool open = false;              //!< Indicates if the current interval contains data
+        Bucket current;                 //!< The interval being accumulated
+    };
+
+    void addSample( uint64_t timestamp, const float* values, int first_ch, int count ); //!< Accumulate values of consecutive channels
+    void closeBucket( int level );      //!< Store the current interval of a level and propagate it to the next level
+    void pushBucket( int level, const Bucket& bucket ); //!< Store a closed interval in the ring of a level
+
+    Level mLevels[RES_COUNT];           //!< The stored resolutions
+};
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+#endif // ENVHISTORY_HPP
@@ -0,0 +1,173 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef FAKEMCU_HPP
+#define FAKEMCU_HPP
+
+#include "defines.hpp"
+#include "hidtransport.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+#include "sensorcapture_def.hpp"
+
+namespace sl_oc {
+
+namespace sensors {
+
+/*!
+ * \brief A motion or free-fall interrupt raised by the emulated IMU
+ *
+ * The interrupt counter is incremented by the packet `start` and the flag is set in the `length` packets starting
+ * there, so an interrupt with `length` 0 is only visible in the counter. Packet indices include the lost packets.
+ */
+struct SL_OC_EXPORT FakeMcuInterrupt
+{
+    bool free_fall = false;             //!< Free-fall interrupt if true, motion interrupt otherwise
+    uint64_t start = 0;                 //!< Index of the first packet reporting the interrupt
+    uint64_t length = 1;                //!< Number of packets with the interrupt flag set
+};
+
+/*!
+ * \brief Parameters of the fake camera MCU
+ */
+struct SL_OC_EXPORT FakeMcuParams
+{
+    uint16_t product_id = SL_USB_PROD_MCU_ZED2_REVA; //!< USB Product ID of the emulated MCU
+    int serial_number = 10000001;       //!< Serial number of the emulated camera
+    uint16_t release_number = static_cast<uint16_t>(ZED_2_FW::FW_3_9); //!< Emulated firmware version
+
+    double rate = 400.0;                //!< Sensor data rate [Hz], measured with the host clock
+    double drift_ppm = 0.0;             //!< Drift of the MCU clock respect to the host clock [ppm]
+    double jitter_usec = 0.0;           //!< Standard deviation of the packet delivery delay [usec]
+    double drop_prob = 0.0;             //!< Probability of a dropout for each packet
+    int drop_burst = 1;                 //!< Number of consecutive packets lost for each dropout
+    double sync_rate = 0.0;             //!< Rate of the camera frame sync pulses [Hz], 0 to disable the synchronization
+    bool realtime = true;               //!< Deliver each packet at its host time. If false the packets are delivered as fast as possible.
+    uint32_t seed = 42;                 //!< Seed of the random generator, the packet sequence is deterministic
+    uint64_t packet_count = 0;          //!< Number of packets of the stream, lost ones included, 0 for an endless stream
+
+    float acc[3] = {0.0f, -9.81f, 0.0f};//!< Measured acceleration [m/s²]
+    float gyro[3] = {0.0f, 0.0f, 0.0f}; //!< Measured angular velocity [°/s]
+    float acc_noise = 0.02f;            //!< Standard deviation of the accelerometer noise [m/s²]
+    float gyro_noise = 0.05f;           //!< Standard deviation of the gyroscope noise [°/s]
+    float imu_temp = 35.0f;             //!< IMU temperature [°C]
+    float mag[3] = {20.0f, 5.0f, -40.0f}; //!< Magnetic field [uT], sampled at 1/8 of the sensor data rate
+    float env_temp = 30.0f;             //!< Environmental sensor temperature [°C], sampled at 1/16 of the sensor data rate
+    float press = 1013.25f;             //!< Atmospheric pressure [hPa]
+    float humid = 40.0f;                //!< Humidity [%rH]
+    float cam_temp = 45.0f;             //!< Temperature of the CMOS sensors [°C]
+
+    std::vector<FakeMcuInterrupt> interrupts; //!< Motion and free-fall interrupts raised by the emulated IMU
+};
+
+/*!
+ * \brief The FakeMcuTransport class emulates the camera MCU in memory, to run the sensor data path without a camera
+ *
+ * The MCU timestamps are generated from the packet index with the configured clock drift, the delivery time adds a
+ * gaussian jitter and packets are lost in bursts. The first and the last packet of the stream are never lost, so that
+ * every dropout can be detected by the receiver. The stream is enabled and disabled with the same feature reports of
+ * the real MCU, so the emulator can be passed to \ref SensorCapture in place of \ref HidApiTransport. All the random
+ * values come from a seeded generator, so two runs with the same parameters generate the same packets.
+ */
+class SL_OC_EXPORT FakeMcuTransport : public HidTransport
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param params the emulation parameters
+     */
+    FakeMcuTransport( const FakeMcuParams& params = FakeMcuParams() );
+
+    std::vector<HidDeviceInfo> enumerate( uint16_t vendor_id ) override;
+    bool open( uint16_t vendor_id, uint16_t product_id, int serial_number ) override;
+    void close() override;
+    inline bool isOpen() const override {return mOpen;}
+    int read( unsigned char* data, size_t length, int timeout_msec ) override;
+    int setNonBlocking( bool nonblock ) override;
+    int sendFeatureReport( const unsigned char* data, size_t length ) override;
+    int getFeatureReport( unsigned char* data, size_t length ) override;
+    std::string getLastError() override;
+
+    /*!
+     * \brief Generate the next delivered packet, without waiting. It can be called directly, instead of \ref read, to
+     *        benchmark the processing of the packets.
+     * \param packet the generated packet
+     * \return the delivery time of the packet in nanoseconds from the start of the stream, host clock. The packet is
+     *         not valid if the time is `UINT64_MAX`, at the end of a stream of \ref FakeMcuParams::packet_count packets.
+     */
+    uint64_t generatePacket( usb::RawData& packet );
+
+    /*!
+     * \brief Get the number of packets delivered
+     * \return the number of delivered packets
+     */
+    inline uint64_t getDeliveredCount() const {return mDelivered;}
+
+    /*!
+     * \brief Get the number of packets lost by the emulated dropouts
+     * \return the number of lost packets
+     */
+    inline uint64_t getDroppedCount() const {return mDropped;}
+
+    /*!
+     * \brief Get the number of ping requests received
+     * \return the number of pings
+     */
+    inline uint64_t getPingCount() const {return mPings;}
+
+private:
+    void restart();                     //!< Restart the packet sequence and the MCU clock
+    uint64_t nextPacket( usb::RawData& packet ); //!< Generate the next delivered packet, the generator mutex must be locked
+
+    FakeMcuParams mParams;              //!< The emulation parameters
+    std::atomic<bool> mOpen{false};     //!< Indicates if the device is open
+    std::atomic<bool> mStreaming{false}; //!< Indicates if the data stream is enabled
+
+    std::mutex mGenMutex;               //!< Mutex for safe access to the packet generator
+    std::mt19937 mRng;                  //!< Random generator
+    uint64_t mIndex = 0;                //!< Index of the next generated packet, lost ones included
+    int mBurstLeft = 0;                 //!< Packets still to be lost in the current dropout
+    uint32_t mFrameCount = 0;           //!< Number of frame sync pulses generated
+    uint64_t mLastDeliveryNs = 0;       //!< Delivery time of the last packet [nsec]
+    std::chrono::steady_clock::time_point mStartTime; //!< Host time of the first packet
+
+    bool mPending = false;              //!< Indicates that a packet generated by \ref read is waiting for its delivery time
+    usb::RawData mPendingPacket;        //!< Packet waiting for its delivery time
+    uint64_t mPendingNs = 0;            //!< Delivery time of the waiting packet [nsec]
+
+    std::atomic<uint64_t> mDelivered{0}; //!< Number of delivered packets
+    std::atomic<uint64_t> mDropped{0};  //!< Number of lost packets
+    std::atomic<uint64_t> mPings{0};    //!< Number of ping requests
+};
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+#endif // FAKEMCU_HPP
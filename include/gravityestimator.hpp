@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef GRAVITYESTIMATOR_HPP
+#define GRAVITYESTIMATOR_HPP
+
+#include "defines.hpp"
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace sensors {
+
+namespace data {
+
+/*!
+ * \brief Contains the gravity direction estimated from the accelerometer data
+ */
+struct SL_OC_EXPORT Gravity
+{
+    bool valid = false;     //!< Indicates if the gravity direction has been estimated
+    uint64_t timestamp = 0; //!< Timestamp in nanoseconds, same time reference of the IMU data
+    float dX = 0.0f;        //!< X component of the gravity direction (unit vector pointing down) in the IMU frame
+    float dY = 1.0f;        //!< Y component of the gravity direction
+    float dZ = 0.0f;        //!< Z component of the gravity direction
+    float norm = 0.0f;      //!< Low-pass filtered acceleration magnitude [m/s²]
+};
+
+}
+
+/*!
+ * \brief Parameters of the gravity estimator
+ */
+struct SL_OC_EXPORT GravityParams
+{
+    float time_const = 0.5f;    //!< Time constant of the low-pass filter [sec]
+    float acc_tolerance = 0.1f; //!< Samples are skipped if the acceleration norm differs from the gravity more than this ratio
+};
+
+/*!
+ * \brief The GravityEstimator class estimates the gravity direction with a first order low-pass filter of the
+ *        accelerometer data, and provides the rotation of point clouds to a gravity aligned frame
+ *
+ * The gravity aligned frame has the Z axis pointing up and the X axis given by the X axis of the source frame
+ * projected on the horizontal plane: with a camera frame (X right, Y down, Z forward) the aligned frame is X right,
+ * Y forward, Z up, and the Z coordinate of a point is its height with respect to the camera.
+ */
+class SL_OC_EXPORT GravityEstimator
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param params the estimator parameters
+     */
+    GravityEstimator( const GravityParams& params = GravityParams() );
+
+    /*!
+     * \brief Set the estimator parameters. The estimator state is not modified.
+     * \param params the estimator parameters
+     */
+    void setParams( const GravityParams& params );
+
+    /*!
+     * \brief Reset the estimator state. The gravity is initialized by the next valid sample.
+     */
+    void reset();
+
+    /*!
+     * \brief Update the estimator with a new accelerometer sample
+     * \param timestamp the timestamp of the sample in nanoseconds
+     * \param aX,aY,aZ the acceleration in m/s²
+     * \return true if the gravity direction has been updated
+     */
+    bool update( uint64_t timestamp, float aX, float aY, float aZ );
+
+    /*!
+     * \brief Get the current gravity estimation
+     * \return the gravity estimation, not valid if the estimator is not initialized
+     */
+    data::Gravity getGravity() const;
+
+    /*!
+     * \brief Interpolate two gravity samples, normalizing the linear interpolation of the directions
+     * \param before the sample preceding the requested timestamp
+     * \param after the sample following the requested timestamp
+     * \param timestamp the requested timestamp in nanoseconds
+     * \return the interpolated gravity
+     */
+    static data::Gravity interpolate( const data::Gravity& before, const data::Gravity& after, uint64_t timestamp );
+
+    /*!
+     * \brief Compute the rotation from a source frame to the gravity aligned frame
+     * \param gravity the gravity direction in the IMU frame
+     * \param R the output 3x3 row-major rotation matrix, `p_aligned = R*p_source`
+     * \param imu_from_src optional 3x3 row-major rotation from the source frame to the IMU frame. If null the source
+     *        frame is the IMU frame.
+     * \return false if the gravity is not valid
+     */
+    static bool getAlignment( const data::Gravity& gravity, float* R, const float* imu_from_src=nullptr );
+
+    /*!
+     * \brief Rotate an interleaved point cloud, using SIMD instructions when available
+     * \param R the 3x3 row-major rotation matrix, for example computed by \ref getAlignment
+     * \param in the input points, each one made of `stride` floats starting with X,Y,Z
+     * \param out the output points, with the same layout. It can be equal to `in` to rotate the points in place,
+     *        elements other than X,Y,Z are copied.
+     * \param count the number of points
+     * \param stride the number of floats of each point, at least 3 (e.g. 3 for `CV_32FC3`, 4 for `CV_32FC4`)
+     * \note Invalid points (NaN coordinates) stay invalid
+     */
+    static void rotatePoints( const float* R, const float* in, float* out, size_t count, size_t stride=3 );
+
+private:
+    GravityParams mParams;              //!< The estimator parameters
+
+    bool mInitialized = false;          //!< Indicates if the gravity has been initialized
+    uint64_t mLastTs = 0;               //!< Timestamp of the last processed sample [nsec]
+    float mAcc[3] = {0.0f,0.0f,0.0f};   //!< Low-pass filtered acceleration [m/s²]
+};
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+#endif // GRAVITYESTIMATOR_HPP
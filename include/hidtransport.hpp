@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef HIDTRANSPORT_HPP
+#define HIDTRANSPORT_HPP
+
+#include "defines.hpp"
+
+#include <string>
+#include <vector>
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+struct hid_device_;
+
+namespace sl_oc {
+
+namespace sensors {
+
+/*!
+ * \brief Contains the description of a USB HID device
+ */
+struct SL_OC_EXPORT HidDeviceInfo
+{
+    uint16_t vendor_id = 0;         //!< USB Vendor ID
+    uint16_t product_id = 0;        //!< USB Product ID
+    uint16_t release_number = 0;    //!< Device release number, the MCU firmware version in form `major<<8|minor`
+    int serial_number = -1;         //!< Serial number of the camera
+    std::string path;               //!< Platform specific device path
+    std::string manufacturer;       //!< Manufacturer string
+    std::string product;            //!< Product string
+};
+
+/*!
+ * \brief The HidTransport class is the interface of the USB HID communication with the camera MCU
+ *
+ * The return values follow the hidapi conventions: the number of bytes transferred, 0 on timeout and -1 on error.
+ */
+class SL_OC_EXPORT HidTransport
+{
+public:
+    virtual ~HidTransport() = default;
+
+    /*!
+     * \brief Get the list of the available devices of a vendor
+     * \param vendor_id the USB Vendor ID
+     * \return the available devices with a valid serial number
+     */
+    virtual std::vector<HidDeviceInfo> enumerate( uint16_t vendor_id ) = 0;
+
+    /*!
+     * \brief Open a device
+     * \param vendor_id the USB Vendor ID
+     * \param product_id the USB Product ID
+     * \param serial_number the serial number of the camera
+     * \return true if the device has been opened
+     */
+    virtual bool open( uint16_t vendor_id, uint16_t product_id, int serial_number ) = 0;
+
+    /*!
+     * \brief Close the device
+     */
+    virtual void close() = 0;
+
+    /*!
+     * \brief Check if a device is open
+     * \return true if a device is open
+     */
+    virtual bool isOpen() const = 0;
+
+    /*!
+     * \brief Read an input report
+     * \param data the destination buffer
+     * \param length the size of the destination buffer
+     * \param timeout_msec the maximum waiting time in milliseconds, -1 for a blocking wait
+     * \return the number of bytes read, 0 on timeout, -1 on error
+     */
+    virtual int read( unsigned char* data, size_t length, int timeout_msec ) = 0;
+
+    /*!
+     * \brief Set the blocking mode of \ref read when called without timeout
+     * \param nonblock true to enable the non-blocking mode
+     * \return 0 on success, -1 on error
+     */
+    virtual int setNonBlocking( bool nonblock ) = 0;
+
+    /*!
+     * \brief Send a feature report. The first byte of the data is the report ID.
+     * \param data the report data
+     * \param length the size of the report
+     * \return the number of bytes written, -1 on error
+     */
+    virtual int sendFeatureReport( const unsigned char* data, size_t length ) = 0;
+
+    /*!
+     * \brief Get a feature report. The first byte of the buffer must contain the requested report ID.
+     * \param data the destination buffer
+     * \param length the size of the destination buffer
+     * \return the number of bytes read, -1 on error
+     */
+    virtual int getFeatureReport( unsigned char* data, size_t length ) = 0;
+
+    /*!
+     * \brief Get the description of the last error
+     * \return the error string
+     */
+    virtual std::string getLastError() = 0;
+};
+
+/*!
+ * \brief The HidApiTransport class implements the USB HID communication with the hidapi library
+ */
+class SL_OC_EXPORT HidApiTransport : public HidTransport
+{
+public:
+    HidApiTransport() = default;
+    virtual ~HidApiTransport();
+
+    HidApiTransport( const HidApiTransport& ) = delete;
+    HidApiTransport& operator=( const HidApiTransport& ) = delete;
+
+    std::vector<HidDeviceInfo> enumerate( uint16_t vendor_id ) override;
+    bool open( uint16_t vendor_id, uint16_t product_id, int serial_number ) override;
+    void close() override;
+    inline bool isOpen() const override {return mDevHandle!=nullptr;}
+    int read( unsigned char* data, size_t length, int timeout_msec ) override;
+    int setNonBlocking( bool nonblock ) override;
+    int sendFeatureReport( const unsigned char* data, size_t length ) override;
+    int getFeatureReport( unsigned char* data, size_t length ) override;
+    std::string getLastError() override;
+
+private:
+    hid_device_* mDevHandle = nullptr;  //!< Hidapi device handler
+};
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+#endif // HIDTRANSPORT_HPP
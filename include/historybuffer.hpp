@@ -0,0 +1,188 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef HISTORYBUFFER_HPP
+#define HISTORYBUFFER_HPP
+
+#include "defines.hpp"
+
+#include <atomic>
+
+namespace sl_oc {
+
+/*!
+ * \brief The HistoryBuffer class is a lock-free ring buffer of timestamped data with a single writer and multiple readers
+ *
+ * Each slot is protected by a sequence number (seqlock) identifying the element it contains: the writer never waits and
+ * a read fails if the slot has been overwritten or cleared before the end of the copy. The data type `T` must be
+ * trivially copyable and must have a `uint64_t timestamp` field. Data must be pushed with increasing timestamps.
+ */
+template<typename T, size_t N>
+class HistoryBuffer
+{
+public:
+    /*!
+     * \brief Push a new element, overwriting the oldest one if the buffer is full. Must be called by a single thread.
+     * \param val the element to be pushed
+     */
+    void push(const T& val)
+    {
+        uint64_t count = mCount.load(std::memory_order_relaxed);
+        Slot& slot = mSlots[count%N];
+
+        slot.seq.store(2*count+1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.data = val;
+        slot.seq.store(2*count+2, std::memory_order_release);
+
+        mCount.store(count+1, std::memory_order_release);
+    }
+
+    /*!
+     * \brief Remove all the elements. Must not be called concurrently with \ref push.
+     */
+    void clear()
+    {
+        // The element indexes are not reused and all the slots are invalidated: a read started before the clear
+        // cannot return an element pushed before it
+        for( Slot& slot : mSlots )
+            slot.seq.store(EMPTY_SEQ, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        mStart.store(mCount.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+
+    /*!
+     * \brief Get the most recent element
+     * \param val the returned element
+     * \return false if the buffer is empty
+     */
+    bool getLast(T& val) const
+    {
+        uint64_t start = mStart.load(std::memory_order_acquire);
+        uint64_t count = mCount.load(std::memory_order_acquire);
+        if( count<=start )
+            return false;
+
+        return read(count-1, val);
+    }
+
+    /*!
+     * \brief Get the two elements bracketing the given timestamp
+     * \param timestamp the requested timestamp
+     * \param before the newest element with timestamp lower or equal to the requested one
+     * \param after the oldest element with timestamp greater or equal to the requested one
+     * \return false if the timestamp is not covered by the elements in the buffer
+     */
+    bool getBracket(uint64_t timestamp, T& before, T& after) const
+    {
+        uint64_t start = mStart.load(std::memory_order_acquire);
+        uint64_t count = mCount.load(std::memory_order_acquire);
+        if( count<=start )
+            return false;
+
+        // Keep a margin from the oldest elements that can be overwritten while searching
+        uint64_t avail = count-start<N?count-start:N-MARGIN;
+        uint64_t lo = count-avail;
+        uint64_t hi = count-1;
+
+        T val;
+        if( !read(hi, val) || val.timestamp < timestamp )
+            return false;
+        after = val;
+        if( val.timestamp == timestamp )
+        {
+            before = val;
+            return true;
+        }
+
+        if( !read(lo, val) || val.timestamp > timestamp )
+            return false;
+        before = val;
+
+        // ----> Binary search of the bracketing elements
+        while( hi-lo > 1 )
+        {
+            uint64_t mid = lo+(hi-lo)/2;
+            if( !read(mid, val) )
+                return false;
+
+            if( val.timestamp <= timestamp )
+            {
+                lo = mid;
+                before = val;
+            }
+            else
+            {
+                hi = mid;
+                after = val;
+            }
+        }
+        // <---- Binary search of the bracketing elements
+
+        return before.timestamp <= timestamp && after.timestamp >= timestamp;
+    }
+
+    /*!
+     * \brief Get the number of elements pushed since the creation or the last \ref clear
+     * \return the number of pushed elements
+     */
+    inline uint64_t getPushCount() const
+    {
+        uint64_t start = mStart.load(std::memory_order_acquire);
+        return mCount.load(std::memory_order_acquire)-start;
+    }
+
+private:
+    static const uint64_t MARGIN = N>16?8:1;  //!< Number of the oldest elements not used for searching
+    static const uint64_t EMPTY_SEQ = 0;      //!< Sequence number of a slot without element
+
+    /*!
+     * \brief Read the element with the given absolute index
+     * \return false if the slot has been overwritten by a newer element or cleared
+     */
+    bool read(uint64_t index, T& val) const
+    {
+        const Slot& slot = mSlots[index%N];
+        const uint64_t seq = 2*index+2;
+
+        if( slot.seq.load(std::memory_order_acquire)!=seq )
+            return false;
+
+        val = slot.data;
+
+        // The copy must be completed before checking again the sequence
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed)==seq;
+    }
+
+    struct Slot
+    {
+        std::atomic<uint64_t> seq{EMPTY_SEQ}; //!< `2*index+2` for the element `index`, odd while it is written
+        T data;                         //!< The stored element
+    };
+
+    Slot mSlots[N];                     //!< The ring buffer slots
+    std::atomic<uint64_t> mCount{0};    //!< Number of pushed elements, index of the next element
+    std::atomic<uint64_t> mStart{0};    //!< Index of the first element pushed after the last clear
+};
+
+}
+
+#endif // HISTORYBUFFER_HPP
@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef IMULOG_HPP
+#define IMULOG_HPP
+
+#include "defines.hpp"
+#include "sensorconversion.hpp"
+
+#include <fstream>
+#include <vector>
+#include <string>
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace sensors {
+
+/*!
+ * \brief Parameters of a binary IMU log, stored in the file header
+ *
+ * The IMU values are stored as 16-bit integers: the logged value is `raw*scale`. The default scales are the native
+ * resolutions of the IMU, so the quantization does not lose information.
+ */
+struct SL_OC_EXPORT ImuLogParams
+{
+    uint32_t keyframe_interval = 400;   //!< Number of samples between two keyframes (random access points)
+    float acc_scale = ACC_SCALE;        //!< Accelerometer resolution [m/s²]
+    float gyro_scale = GYRO_SCALE;      //!< Gyroscope resolution [°/s]
+    float temp_scale = TEMP_SCALE;      //!< Temperature resolution [°C]
+    int32_t serial = -1;                //!< Serial number of the camera, -1 if unknown
+};
+
+/*!
+ * \brief Random access point of a binary IMU log
+ */
+struct SL_OC_EXPORT ImuLogKeyFrame
+{
+    uint64_t timestamp = 0;     //!< Timestamp of the keyframe [nsec]
+    uint64_t offset = 0;        //!< File offset of the keyframe record
+    uint64_t sample = 0;        //!< Sample number of the keyframe
+};
+
+/*!
+ * \brief The ImuLogWriter class writes IMU data to a compact binary log
+ *
+ * File layout (all the values are little endian, whatever the host byte order):
+ * - header: magic `ZOCIMUL`, version, \ref ImuLogParams
+ * - records: a flag byte, the timestamp and seven 16-bit values (aX, aY, aZ, gX, gY, gZ, temp). Keyframe records
+ *   store the absolute timestamp, the other records store the zig-zag varint of the difference between the current
+ *   and the previous timestamp interval, usually one or two bytes. A record is 17 bytes on average.
+ * - index: written by \ref close, the timestamp, the file offset and the sample number of each keyframe.
+ *
+ * The records are accumulated in memory and written in large blocks, so the writer can run on the sensor thread.
+ * A file not closed correctly can still be read: the reader rebuilds the index scanning the records.
+ */
+class SL_OC_EXPORT ImuLogWriter
+{
+public:
+    ImuLogWriter() = default;
+    ~ImuLogWriter();
+
+    ImuLogWriter( const ImuLogWriter& ) = delete;
+    ImuLogWriter& operator=( const ImuLogWriter& ) = delete;
+
+    /*!
+     * \brief Create a new log file, replacing an existing one
+     * \param filename the path of the log file
+     * \param params the log parameters
+     * \return true if the file has been created
+     */
+    bool open( const std::string& filename, const ImuLogParams& params = ImuLogParams() );
+
+    /*!
+     * \brief Write the buffered records and the index, then close the file
+     * \return true if all the data have been correctly written
+     */
+    bool close();
+
+    /*!
+     * \brief Check if a log file is open
+     * \return true if the file is open
+     */
+    inline bool isOpen() const {return mFile.is_open();}
+
+    /*!
+     * \brief Append an IMU sample to the log. Timestamps must be increasing.
+     * \param timestamp the timestamp of the sample in nanoseconds
+     * \param aX,aY,aZ the accelerations [m/s²]
+     * \param gX,gY,gZ the angular velocities [°/s]
+     * \param temp the IMU temperature [°C]
+     * \param sync true if the sample is synchronized with a video frame
+     * \param gap true if sensor packets have been lost before the sample
+     * \return false if the sample has been rejected or if the file cannot be written
+     */
+    bool write( uint64_t timestamp, float aX, float aY, float aZ, float gX, float gY, float gZ, float temp,
+                bool sync=false, bool gap=false );
+
+    /*!
+     * \brief Get the number of samples written
+     * \return the number of samples
+     */
+    inline uint64_t getSampleCount() const {return mCount;}
+
+private:
+    bool flush();                       //!< Write the buffered data to the file
+
+    std::ofstream mFile;                //!< The log file
+    ImuLogParams mParams;               //!< The log parameters
+    float mInvScale[3] = {};            //!< Inverse of the acc, gyro and temperature scales
+
+    std::vector<uint8_t> mBuffer;       //!< Records not yet written
+    uint64_t mFileOffset = 0;           //!< File offset of the first byte of the buffer
+    bool mError = false;                //!< Indicates that a write failed
+
+    std::vector<ImuLogKeyFrame> mIndex; //!< Keyframes written
+    uint64_t mCount = 0;                //!< Number of samples written
+    uint64_t mLastTs = 0;               //!< Timestamp of the previous sample
+    int64_t mLastDelta = 0;             //!< Previous timestamp interval
+};
+
+/*!
+ * \brief The ImuLogReader class decodes a binary IMU log written by \ref ImuLogWriter
+ *
+ * The file is read in large blocks and decoded in batches, so the decoding is limited by the storage throughput.
+ */
+class SL_OC_EXPORT ImuLogReader
+{
+public:
+    /*!
+     * \brief Open a log file and load its index
+     * \param filename the path of the log file
+     * \return false if the file cannot be read or is not a valid log
+     */
+    bool open( const std::string& filename );
+
+    /*!
+     * \brief Close the log file
+     */
+    void close();
+
+    /*!
+     * \brief Get the parameters of the log
+     * \return the parameters stored in the file header
+     */
+    inline const ImuLogParams& getParams() const {return mParams;}
+
+    /*!
+     * \brief Get the number of samples of the log
+     * \return the number of samples
+     */
+    inline uint64_t getSampleCount() const {return mCount;}
+
+    /*!
+     * \brief Move the read position to the last keyframe not newer than a timestamp
+     * \param timestamp the requested timestamp in nanoseconds
+     * \return false if the log is empty
+     */
+    bool seek( uint64_t timestamp );
+
+    /*!
+     * \brief Decode the next samples
+     * \param batch the decoded samples. The batch is resized to the number of decoded samples.
+     * \param max_count the maximum number of samples to be decoded
+     * \return the number of decoded samples, 0 at the end of the log
+     */
+    size_t read( data::ImuBatch& batch, size_t max_count=4096 );
+
+private:
+    bool loadIndex();                   //!< Read the index written at the end of the file
+    bool scanIndex();                   //!< Rebuild the index decoding all the records
+    bool moveTo( uint64_t offset, uint64_t sample ); //!< Move the read position to a record
+    bool fill();                        //!< Make sure that a complete record is available in the buffer, if not at the end of the records
+
+    std::ifstream mFile;                //!< The log file
+    ImuLogParams mParams;               //!< The log parameters
+    uint64_t mDataStart = 0;            //!< File offset of the first record
+    uint64_t mDataEnd = 0;              //!< File offset of the end of the records
+    uint64_t mCount = 0;                //!< Number of samples
+    std::vector<ImuLogKeyFrame> mIndex; //!< Keyframes of the log
+
+    std::vector<uint8_t> mBuffer;       //!< Read buffer
+    size_t mBufPos = 0;                 //!< Read position in the buffer
+    size_t mBufSize = 0;                //!< Number of valid bytes in the buffer
+    uint64_t mBufOffset = 0;            //!< File offset of the first byte of the buffer
+    uint64_t mSample = 0;               //!< Number of the next sample to be decoded
+    uint64_t mLastTs = 0;               //!< Timestamp of the previous decoded sample
+    int64_t mLastDelta = 0;             //!< Previous timestamp interval
+};
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+#endif // IMULOG_HPP
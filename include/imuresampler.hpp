@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef IMURESAMPLER_HPP
+#define IMURESAMPLER_HPP
+
+#include "defines.hpp"
+#include "sensorconversion.hpp"
+
+#include <vector>
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace sensors {
+
+/*!
+ * \brief Parameters of the IMU resampler
+ */
+struct SL_OC_EXPORT ImuResamplerParams
+{
+    int rate = 200;             //!< Output rate [Hz]. The output timestamps are the multiples of the output period.
+    float cutoff = 0.8f;        //!< Maximum cutoff of the anti-aliasing filter, relative to the output Nyquist frequency
+    int taps = 63;              //!< Number of taps of the anti-aliasing FIR filter (forced odd, raised for large decimations)
+};
+
+/*!
+ * \brief The ImuResampler class resamples the IMU data on an exact time grid at a user selected rate
+ *
+ * The input samples are filtered by a linear phase FIR low-pass filter (Blackman windowed sinc) designed for the
+ * input rate, measured on the first received samples. The cutoff frequency is lowered so that the stopband of the
+ * filter starts at the output Nyquist frequency. Each filtered sample is timestamped with the timestamp of the
+ * central tap, so the filter delay is compensated, and the output samples are linearly interpolated between the two
+ * filtered samples around each grid timestamp. If the output rate is not lower than the input rate the filter is
+ * bypassed and the data are only interpolated. No data are output while the input rate is measured.
+ *
+ * The output data are available `taps/2` input samples after their timestamp. A missing input sample resets the
+ * filter state and the `gap` flag is set on the first output sample after the restart.
+ */
+class SL_OC_EXPORT ImuResampler
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param params the resampler parameters
+     */
+    ImuResampler( const ImuResamplerParams& params = ImuResamplerParams() );
+
+    /*!
+     * \brief Set new parameters and reset the resampler
+     * \param params the resampler parameters
+     */
+    void setParams( const ImuResamplerParams& params );
+
+    /*!
+     * \brief Get the resampler parameters
+     * \return the parameters applied
+     */
+    inline const ImuResamplerParams& getParams() const {return mParams;}
+
+    /*!
+     * \brief Reset the filter state and the measured input rate
+     */
+    void reset();
+
+    /*!
+     * \brief Add a new IMU sample
+     * \param timestamp the timestamp of the sample in nanoseconds
+     * \param aX,aY,aZ the accelerations [m/s²]
+     * \param gX,gY,gZ the angular velocities [°/s]
+     * \param temp the IMU temperature [°C]. It is not filtered.
+     * \param gap true if input samples have been lost before this one
+     * \param out the batch filled with the output samples generated by the new input sample. Its previous content is
+     *        removed, the allocated memory is reused.
+     * \return the number of output samples
+     */
+    size_t addSample( uint64_t timestamp, float aX, float aY, float aZ, float gX, float gY, float gZ, float temp,
+                      bool gap, data::ImuBatch& out );
+
+    /*!
+     * \brief Get the measured input rate
+     * \return the input rate [Hz], 0 if not yet measured
+     */
+    inline double getInputRate() const {return mInputRate;}
+
+private:
+    static const int CH_COUNT = 6;      //!< Filtered channels: aX, aY, aZ, gX, gY, gZ
+    static const int LANES = 8;         //!< Channels padded to a SIMD friendly size
+    static const int RATE_EST_COUNT = 64; //!< Number of input intervals used to measure the input rate
+
+    void designFilter();                //!< Compute the FIR coefficients for the measured input rate
+    void restartFilter();               //!< Empty the filter delay line
+
+    ImuResamplerParams mParams;         //!< The resampler parameters
+    uint64_t mPeriod = 0;               //!< Output period [nsec]
+
+    // ----> Input rate measurement
+    double mInputRate = 0.0;            //!< Measured input rate [Hz]
+    uint64_t mEstStartTs = 0;           //!< Timestamp of the first sample of the measurement
+    int mEstCount = 0;                  //!< Number of measured intervals
+    // <---- Input rate measurement
+
+    // ----> FIR filter
+    std::vector<float> mCoeffs;         //!< FIR coefficients
+    int mTaps = 0;                      //!< Number of FIR coefficients
+    std::vector<float> mLine;           //!< Mirrored delay line: each sample is stored twice, `LANES` values per sample
+    std::vector<uint64_t> mLineTs;      //!< Mirrored timestamps of the delay line
+    int mPos = 0;                       //!< Index of the oldest sample of the delay line
+    int mFill = 0;                      //!< Number of samples in the delay line
+    uint64_t mLastInTs = 0;             //!< Timestamp of the last input sample
+    bool mGapPending = false;           //!< Indicates that the next output sample follows a filter restart
+    // <---- FIR filter
+
+    // ----> Interpolation
+    bool mPrevValid = false;            //!< Indicates if a previous filtered sample is available
+    uint64_t mPrevTs = 0;               //!< Timestamp of the previous filtered sample
+    float mPrev[LANES];                 //!< Previous filtered sample
+    uint64_t mNextTs = 0;               //!< Next output timestamp
+    // <---- Interpolation
+};
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+#endif // IMURESAMPLER_HPP
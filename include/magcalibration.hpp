@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef MAGCALIBRATION_HPP
+#define MAGCALIBRATION_HPP
+
+#include "defines.hpp"
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace sensors {
+
+namespace data {
+
+/*!
+ * \brief Contains the hard-iron and soft-iron calibration of the magnetometer
+ *
+ * The calibrated field is `soft_iron*(m - hard_iron)`, with `m` the raw magnetic field.
+ */
+struct SL_OC_EXPORT MagCalibration
+{
+    bool valid = false;         //!< Indicates if the calibration can be applied
+    float hard_iron[3] = {0.f,0.f,0.f};                             //!< Hard-iron offset [uT]
+    float soft_iron[9] = {1.f,0.f,0.f, 0.f,1.f,0.f, 0.f,0.f,1.f};   //!< Soft-iron correction, row-major symmetric matrix
+    float field = 0.0f;         //!< Estimated magnitude of the local magnetic field [uT]
+    float fit_error = 0.0f;     //!< Normalized RMS algebraic residual of the ellipsoid fit
+    uint64_t samples = 0;       //!< Number of samples used for the fit
+};
+
+}
+
+/*!
+ * \brief Parameters of the streaming magnetometer calibration
+ */
+struct SL_OC_EXPORT MagCalibrationParams
+{
+    int update_interval = 100;      //!< Number of new samples between two ellipsoid fits
+    int min_samples = 500;          //!< Minimum number of samples before the first fit
+    double forgetting = 0.9999;     //!< Forgetting factor applied for each sample to follow slow changes (1 to disable)
+    float min_field = 15.0f;        //!< Minimum plausible magnitude of the local magnetic field [uT]
+    float max_field = 100.0f;       //!< Maximum plausible magnitude of the local magnetic field [uT]
+    float max_axis_ratio = 2.0f;    //!< Maximum ratio between the largest and the smallest ellipsoid radius
+    float min_coverage = 0.3f;      //!< Minimum standard deviation of the samples along each direction, relative to the field
+};
+
+/*!
+ * \brief The MagCalibrator class estimates the hard-iron and soft-iron magnetometer calibration with a streaming
+ *        ellipsoid fit
+ *
+ * Each sample updates the normal equations of the algebraic least squares fit of the quadric
+ * `ax²+by²+cz²+2fyz+2gxz+2hxy+2px+2qy+2rz = 1`, so the memory does not depend on the number of samples.
+ * The fit is solved every `update_interval` samples and the calibration is replaced only if the resulting
+ * ellipsoid is plausible and the samples cover all the directions.
+ */
+class SL_OC_EXPORT MagCalibrator
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param params the calibration parameters
+     */
+    MagCalibrator( const MagCalibrationParams& params = MagCalibrationParams() );
+
+    /*!
+     * \brief Remove all the accumulated samples. The current calibration is kept.
+     */
+    void reset();
+
+    /*!
+     * \brief Add a new raw magnetometer sample
+     * \param mX,mY,mZ the raw magnetic field [uT]
+     * \return true if the calibration has been updated
+     */
+    bool addSample( float mX, float mY, float mZ );
+
+    /*!
+     * \brief Get the current calibration
+     * \return the current calibration
+     */
+    inline const data::MagCalibration& getCalibration() const {return mCalib;}
+
+    /*!
+     * \brief Set the current calibration, for example a calibration saved by a previous session
+     * \param calib the calibration to be applied
+     */
+    inline void setCalibration( const data::MagCalibration& calib ) {mCalib = calib;}
+
+    /*!
+     * \brief Apply a calibration to a raw magnetometer sample
+     * \param calib the calibration
+     * \param raw the raw magnetic field [uT]
+     * \param out the calibrated magnetic field [uT]
+     */
+    static void apply( const data::MagCalibration& calib, const float* raw, float* out );
+
+private:
+    bool fit();                         //!< Solve the ellipsoid fit and update the calibration if plausible
+
+    MagCalibrationParams mParams;       //!< The calibration parameters
+    data::MagCalibration mCalib;        //!< The current calibration
+
+    double mS[9*9];                     //!< Normal matrix of the quadric fit
+    double mB[9];                       //!< Right hand side of the normal equations (sum of the regressors)
+    double mW = 0.0;                    //!< Sum of the sample weights
+    uint64_t mCount = 0;                //!< Number of accumulated samples
+    int mSinceFit = 0;                  //!< Number of samples since the last fit
+};
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+#endif // MAGCALIBRATION_HPP
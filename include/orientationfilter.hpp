@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef ORIENTATIONFILTER_HPP
+#define ORIENTATIONFILTER_HPP
+
+#include "defines.hpp"
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace sensors {
+
+namespace data {
+
+/*!
+ * \brief Contains the orientation estimated from the IMU data
+ */
+struct SL_OC_EXPORT Orientation
+{
+    // Validity of the orientation data
+    typedef enum _orient_status {
+        NOT_PRESENT = 0,
+        OLD_VAL = 1,
+        NEW_VAL = 2
+    } OrientStatus;
+
+    OrientStatus valid = NOT_PRESENT;  //!< Indicates if orientation data are valid
+    uint64_t timestamp = 0; //!< Timestamp in nanoseconds, same time reference of the IMU data
+    float qW = 1.0f;        //!< Quaternion W component. The quaternion rotates the IMU frame to a gravity aligned frame (Z up)
+    float qX = 0.0f;        //!< Quaternion X component
+    float qY = 0.0f;        //!< Quaternion Y component
+    float qZ = 0.0f;        //!< Quaternion Z component
+    float bX = 0.0f;        //!< Estimated gyroscope bias around X axis in °/s
+    float bY = 0.0f;        //!< Estimated gyroscope bias around Y axis in °/s
+    float bZ = 0.0f;        //!< Estimated gyroscope bias around Z axis in °/s
+};
+
+}
+
+/*!
+ * \brief Parameters of the orientation filter
+ */
+struct SL_OC_EXPORT OrientationFilterParams
+{
+    float kp = 1.0f;            //!< Proportional gain of the accelerometer correction [1/s]
+    float ki = 0.02f;           //!< Integral gain of the accelerometer correction, drives the gyroscope bias estimation [1/s²]
+    float acc_tolerance = 0.1f; //!< The accelerometer correction is skipped if the acceleration norm differs from the gravity more than this ratio
+    float max_bias = 5.0f;      //!< Maximum absolute value of the estimated gyroscope bias for each axis [°/s]
+};
+
+/*!
+ * \brief The OrientationFilter class estimates the IMU orientation with a Mahony complementary filter
+ *
+ * The gyroscope rates are integrated and the drift of the roll and pitch angles is corrected using the gravity
+ * direction measured by the accelerometer. The integral term of the correction estimates the gyroscope bias.
+ * The yaw angle is not observable and drifts with the residual bias around the gravity axis.
+ */
+class SL_OC_EXPORT OrientationFilter
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param params the filter parameters
+     */
+    OrientationFilter( const OrientationFilterParams& params = OrientationFilterParams() );
+
+    /*!
+     * \brief Set the filter parameters. The filter state is not modified.
+     * \param params the filter parameters
+     */
+    void setParams( const OrientationFilterParams& params );
+
+    /*!
+     * \brief Get the filter parameters
+     * \return the filter parameters
+     */
+    inline const OrientationFilterParams& getParams() const {return mParams;}
+
+    /*!
+     * \brief Reset the filter state. The orientation is initialized by the next IMU sample.
+     */
+    void reset();
+
+    /*!
+     * \brief Update the filter with a new IMU sample
+     * \param timestamp the timestamp of the sample in nanoseconds
+     * \param gX,gY,gZ the angular velocity in °/s
+     * \param aX,aY,aZ the acceleration in m/s²
+     * \return true if the orientation has been updated
+     */
+    bool update( uint64_t timestamp, float gX, float gY, float gZ, float aX, float aY, float aZ );
+
+    /*!
+     * \brief Get the current orientation estimation
+     * \return the orientation estimation, `NOT_PRESENT` if the filter is not initialized
+     */
+    data::Orientation getOrientation() const;
+
+    /*!
+     * \brief Interpolate two orientation samples using the spherical linear interpolation of the quaternions
+     * \param before the sample preceding the requested timestamp
+     * \param after the sample following the requested timestamp
+     * \param timestamp the requested timestamp in nanoseconds
+     * \return the interpolated orientation
+     */
+    static data::Orientation interpolate( const data::Orientation& before, const data::Orientation& after, uint64_t timestamp );
+
+private:
+    void initFromAcc( float aX, float aY, float aZ ); //!< Initialize the orientation aligning the measured gravity to the Z axis
+
+    OrientationFilterParams mParams;    //!< The filter parameters
+
+    bool mInitialized = false;          //!< Indicates if the orientation has been initialized
+    uint64_t mLastTs = 0;               //!< Timestamp of the last processed sample [nsec]
+
+    float mQ[4] = {1.0f,0.0f,0.0f,0.0f}; //!< Orientation quaternion [w,x,y,z]
+    float mIntegral[3] = {0.0f,0.0f,0.0f}; //!< Integral feedback term, opposite of the gyroscope bias [rad/s]
+};
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+#endif // ORIENTATIONFILTER_HPP
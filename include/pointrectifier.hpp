@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef POINTRECTIFIER_HPP
+#define POINTRECTIFIER_HPP
+
+#include "defines.hpp"
+
+#include <vector>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+#include "stereorectify.hpp"
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief The PointRectifier class maps arrays of pixel coordinates between the source images and the rectified
+ *        images, without computing the dense rectification maps
+ *
+ * It uses the same calibration and rectification of the maps built by \ref StereoRectify, so that feature based
+ * pipelines can detect the keypoints on the source images and rectify only them.
+ *
+ * - \ref unrectifyPoints is analytic: it evaluates the distortion model as the dense maps do, so a rectified point
+ *   maps to the same source coordinates of the map.
+ * - \ref rectifyPoints inverts the distortion. The inverse is computed once, with converged iterations, on a coarse
+ *   grid of the source image. Each point is bilinearly interpolated from the grid, then refined with a single Newton
+ *   step of the analytic model, using the derivatives of the interpolation as inverse Jacobian, with no iterations
+ *   per point. With the lens distortion of a ZED camera and the default 16 pixels grid, the maximum round-trip error
+ *   is below 0.001 pixels from HD720 up, and about 0.003 pixels at VGA, where each cell covers a wider field of
+ *   view: an 8 pixels grid brings it below 0.0005 pixels.
+ *
+ * Both mappings process two points per iteration with SSE2 or AArch64 NEON, in double precision, giving the same
+ * results of the scalar code.
+ *
+ * The points are arrays of interleaved `x,y` float coordinates, the layout of `std::vector<cv::Point2f>`. The
+ * source and the destination arrays can be the same.
+ */
+class SL_OC_EXPORT PointRectifier
+{
+public:
+    static const int DEFAULT_GRID_STEP = 16; //!< Default spacing of the inverse distortion grid, in pixels
+
+    /*!
+     * \brief Initialize the rectifier
+     * \param calib the calibration of the camera at the image resolution
+     * \param rect the rectification computed by \ref StereoRectify::compute
+     * \param grid_step the spacing of the inverse distortion grid, in pixels. Smaller steps are more accurate and
+     *        use more memory.
+     * \return false if the parameters are not valid
+     */
+    bool init( const StereoCameraParams& calib, const RectificationParams& rect, int grid_step = DEFAULT_GRID_STEP );
+
+    /*!
+     * \brief Initialize the rectifier, computing the rectification from the calibration
+     * \param calib the calibration of the camera at the image resolution
+     * \param grid_step the spacing of the inverse distortion grid, in pixels
+     * \return false if the calibration is not valid
+     */
+    bool init( const StereoCameraParams& calib, int grid_step = DEFAULT_GRID_STEP );
+
+    /*!
+     * \brief Check if the rectifier has been initialized
+     * \return true if the rectifier is ready
+     */
+    inline bool isReady() const {return !mSides[0].lut.empty();}
+
+    /*!
+     * \brief Get the rectification used by the rectifier
+     * \return the rectification, with the projection matrices of the rectified cameras
+     */
+    inline const RectificationParams& getRectification() const {return mRect;}
+
+    /*!
+     * \brief Map points of a source image to the rectified image
+     * \param side the camera sensor
+     * \param src the source coordinates, `2*count` interleaved `x,y` values
+     * \param dst the rectified coordinates, `2*count` interleaved `x,y` values
+     * \param count the number of points
+     * \note Points outside the source image are extrapolated from the border of the grid
+     */
+    void rectifyPoints( CAM_SENS_POS side, const float* src, float* dst, size_t count ) const;
+
+    /*!
+     * \brief Map points of the rectified image to a source image
+     * \param side the camera sensor
+     * \param src the rectified coordinates, `2*count` interleaved `x,y` values
+     * \param dst the source coordinates, `2*count` interleaved `x,y` values
+     * \param count the number of points
+     */
+    void unrectifyPoints( CAM_SENS_POS side, const float* src, float* dst, size_t count ) const;
+
+    /*!
+     * \brief Get the memory used by the inverse distortion grids
+     * \return the size of the grids in bytes
+     */
+    size_t getLutMemory() const;
+
+private:
+    struct Side
+    {
+        CameraIntrinsics cam;           //!< Intrinsic parameters of the source camera
+        double iKR[9];                  //!< Inverse of the rectified camera matrix by the rectification rotation
+        std::vector<float> lut;         //!< Rectified coordinates of the grid nodes, interleaved `x,y`
+    };
+
+    RectificationParams mRect;          //!< The rectification
+    Side mSides[2];                     //!< Left and right cameras
+    int mGridStep = DEFAULT_GRID_STEP;  //!< Spacing of the grid nodes, in pixels
+    int mGridCols = 0;                  //!< Number of grid nodes of each row
+    int mGridRows = 0;                  //!< Number of grid rows
+};
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
+
+#endif // POINTRECTIFIER_HPP
@@ -0,0 +1,202 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef RECTIFICATIONMANAGER_HPP
+#define RECTIFICATIONMANAGER_HPP
+
+#include "defines.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+#include "rectifier.hpp"
+#include "stereocalibration.hpp"
+#include "stereorectify.hpp"
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief The RectificationManager class provides the rectification maps of all the camera resolutions from a single
+ *        parsed calibration
+ *
+ * The maps of the current resolution are built when the calibration is set. The maps of the other resolutions are
+ * built on demand by a background thread, so that a resolution switch never waits for the map generation: until
+ * the maps are ready \ref getRectifier returns null and the frames can be dropped or shown unrectified.
+ *
+ * The maps of the resolutions used before are kept while their total size is below the memory budget, the least
+ * recently used are released first. The maps of the current resolution are always kept.
+ */
+class SL_OC_EXPORT RectificationManager
+{
+public:
+    static const size_t DEFAULT_MEMORY_BUDGET = 64*1024*1024; //!< Default memory budget of the maps, in bytes
+
+    /*!
+     * \brief The default constructor
+     * \param pool the worker pool running the rectification and building the maps of the current resolution. If
+     *        null they run on the calling thread. It must live longer than the manager.
+     */
+    explicit RectificationManager( WorkerPool* pool = nullptr );
+
+    /*!
+     * \brief The class destructor, stops the background thread
+     */
+    ~RectificationManager();
+
+    RectificationManager( const RectificationManager& ) = delete;
+    RectificationManager& operator=( const RectificationManager& ) = delete;
+
+    /*!
+     * \brief Set the calibration and build the maps of the current resolution. The maps of the previous calibration
+     *        are released.
+     * \param calib the parsed calibration
+     * \param res the current resolution
+     * \return false if the calibration of the current resolution is not valid
+     */
+    bool setCalibration( const StereoCalibration& calib, RESOLUTION res );
+
+    /*!
+     * \brief Change the current resolution. If its maps are not available they are built in background.
+     * \param res the new resolution
+     * \return true if the maps of the resolution are ready
+     */
+    bool setResolution( RESOLUTION res );
+
+    /*!
+     * \brief Get the current resolution
+     * \return the current resolution
+     */
+    RESOLUTION getResolution() const;
+
+    /*!
+     * \brief Request to build the maps of a resolution in background, for example the next resolution that will be
+     *        used
+     * \param res the resolution
+     */
+    void prefetch( RESOLUTION res );
+
+    /*!
+     * \brief Check if the maps of a resolution are ready
+     * \param res the resolution
+     * \return true if \ref getRectifier returns a valid rectifier
+     */
+    bool isReady( RESOLUTION res ) const;
+
+    /*!
+     * \brief Get the rectifier of the current resolution
+     * \return the rectifier, null if its maps are not ready yet
+     */
+    std::shared_ptr<Rectifier> getRectifier();
+
+    /*!
+     * \brief Get the rectifier of a resolution. If its maps are not available they are built in background.
+     * \param res the resolution
+     * \return the rectifier, null if its maps are not ready yet. It stays valid while it is referenced, even if the
+     *         manager releases it.
+     */
+    std::shared_ptr<Rectifier> getRectifier( RESOLUTION res );
+
+    /*!
+     * \brief Get the rectification of a resolution. It is computed when the calibration is set, without waiting for
+     *        the maps.
+     * \param res the resolution
+     * \param rect the rectification, with the projection matrices of the rectified cameras
+     * \return false if the calibration of the resolution is not valid
+     */
+    bool getRectification( RESOLUTION res, RectificationParams& rect ) const;
+
+    /*!
+     * \brief Set the memory budget of the maps
+     * \param bytes the maximum size of the maps kept in memory, in bytes
+     */
+    void setMemoryBudget( size_t bytes );
+
+    /*!
+     * \brief Get the memory used by the maps
+     * \return the size of the maps kept in memory, in bytes
+     */
+    size_t getMemoryUsage() const;
+
+    /*!
+     * \brief Store the maps on a coarse grid to reduce their memory, see \ref Rectifier::setMapGridStep
+     * \param grid_step the spacing of the grid nodes in pixels, 0 for full size maps
+     * \note Applies to the maps built after the call: call it before \ref setCalibration.
+     */
+    void setMapGridStep( int grid_step );
+
+    /*!
+     * \brief Set the scale of the rectified images, e.g. 0.5 for stereo matching at half resolution. The maps are
+     *        built directly at the scaled size, see \ref StereoRectify::scale
+     * \param scale the scale factor of the rectified images, 1 for the resolution of the camera
+     * \return false if the scale factor is not valid
+     * \note Applies to the calibrations set after the call: call it before \ref setCalibration. The rectification
+     *       returned by \ref getRectification is scaled too.
+     */
+    bool setOutputScale( double scale );
+
+private:
+    struct Entry
+    {
+        bool valid = false;                     //!< Indicates that the calibration of the resolution is valid
+        StereoCameraParams calib;               //!< Calibration of the resolution
+        RectificationParams rect;               //!< Rectification of the resolution
+        std::shared_ptr<Rectifier> rectifier;   //!< Rectifier with the maps, null if not built
+        uint64_t last_use = 0;                  //!< Tick of the last use, for the LRU policy
+        bool pending = false;                   //!< Indicates that the maps are queued to be built in background
+    };
+
+    static std::shared_ptr<Rectifier> buildRectifier( const StereoCameraParams& calib,
+                                                      const RectificationParams& rect, int grid_step,
+                                                      WorkerPool* pool );
+
+    void request( int r );              //!< Queue the build of the maps of a resolution, with the lock held
+    void evict();                       //!< Release the maps over the memory budget, with the lock held
+    void builderFunc();                 //!< Background thread building the queued maps
+
+    WorkerPool* mPool = nullptr;        //!< The worker pool
+
+    mutable std::mutex mMutex;          //!< Mutex protecting all the members below
+    std::condition_variable mCond;      //!< Signals new requests to the background thread
+    Entry mEntries[StereoCalibration::RESOLUTION_COUNT];  //!< Entries indexed by \ref RESOLUTION
+    std::deque<int> mQueue;             //!< Resolutions waiting to be built
+    int mCurrent = static_cast<int>(RESOLUTION::HD720);   //!< The current resolution
+    uint64_t mGeneration = 0;           //!< Incremented at each calibration change to discard stale builds
+    uint64_t mTick = 0;                 //!< Use counter for the LRU policy
+    size_t mBudget = DEFAULT_MEMORY_BUDGET; //!< Memory budget of the maps
+    int mGridStep = 0;                  //!< Spacing of the map grid nodes, 0 for full size maps
+    double mScale = 1.0;                //!< Scale factor of the rectified images
+    bool mStop = false;                 //!< Requests the background thread to stop
+    std::thread mBuilder;               //!< The background thread, started at the first request
+};
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
+
+#endif // RECTIFICATIONMANAGER_HPP
@@ -0,0 +1,274 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef RECTIFIER_HPP
+#define RECTIFIER_HPP
+
+#include "defines.hpp"
+
+#include <vector>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+#include "videocapture_def.hpp"
+#include "workerpool.hpp"
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief Pixel formats of the images processed by the \ref Rectifier
+ */
+enum class RECT_FORMAT {
+    GRAY = 0,               //!< 8 bit luma, 1 byte per pixel
+    YUYV = 1,               //!< YUV 4:2:2 as received from the camera, 2 bytes per pixel
+    YUYV_TO_GRAY = 2,       //!< YUV 4:2:2 source, 8 bit luma rectified image
+    YUYV_TO_GRAY_HALF = 3   //!< YUV 4:2:2 source, 8 bit luma rectified image at half resolution. Each pixel is the
+                            //!< average of the 2x2 rectified pixels it replaces, floor(width/2) x floor(height/2)
+};
+
+/*!
+ * \brief The Rectifier class rectifies the stereo images with fixed-point maps, without OpenCV
+ *
+ * The float maps used by `cv::remap` are converted to source coordinates in unsigned Q12.4 fixed-point format: each
+ * coordinate is stored in 16 bits, half the memory of the float maps, and gives the source pixel offset and the
+ * bilinear interpolation weights with 1/16 pixel resolution. Rectified pixels mapped outside the source image are
+ * set to black.
+ *
+ * The images are processed in bands of rows, or in 2D tiles (see \ref setTileSize), distributed to a \ref WorkerPool.
+ * The interpolation is computed with SSE2 or NEON instructions when available.
+ *
+ * With strong lens distortion the rows of the rectified image follow curved paths in the source image, so a band of
+ * rows reads many source rows far apart. A tile reads a compact source area instead: its bounding box is computed
+ * when the maps are set, and it is prefetched while the previous tile is processed.
+ *
+ * The `YUYV_TO_GRAY` formats sample the luma directly from the YUV 4:2:2 frame received from the camera, so that stereo
+ * matching pipelines rectify, convert and optionally downscale each image with a single read of the source frame.
+ *
+ * On embedded targets the maps can be stored on a coarse grid (see \ref setMapGridStep): the source coordinates are
+ * bilinearly interpolated from the grid nodes while each row is rectified, instead of being read from full size maps.
+ * The error introduced by the grid is measured when the maps are set, see \ref getMapError.
+ *
+ * The rectified images can be smaller than the source images: maps built for the target size from scaled camera
+ * matrices (see \ref StereoRectify::scale) produce downscaled images directly, at a fraction of the cost of full size
+ * rectification. When the maps downscale by 2 or more the luma formats sample a 2x2 box-filtered source, interpolated
+ * bilinearly from 3x3 source pixels, to avoid aliasing. The `YUYV` format always uses plain bilinear interpolation.
+ */
+class SL_OC_EXPORT Rectifier
+{
+public:
+    static const int MAP_FRAC_BITS = 4;         //!< Fractional bits of the fixed-point map coordinates
+    static const uint16_t MAP_INVALID = 0xFFFF; //!< Map value of the pixels outside the source image
+    static const int MAX_SRC_SIZE = 4096;       //!< Maximum width and height of the source images
+    static const int MAX_GRID_STEP = 64;        //!< Maximum spacing of the map grid nodes
+
+    /*!
+     * \brief The default constructor
+     * \param pool the worker pool running the rectification. If null the rectification runs on the calling thread.
+     */
+    Rectifier( WorkerPool* pool = nullptr );
+
+    /*!
+     * \brief Set the worker pool running the rectification
+     * \param pool the worker pool, null to run on the calling thread. It must live longer than the rectifier.
+     */
+    inline void setWorkerPool( WorkerPool* pool ) {mPool = pool;}
+
+    /*!
+     * \brief Set the rectification map of one camera sensor, converting it to the fixed-point format
+     * \param side the camera sensor
+     * \param map_x,map_y X and Y coordinates of the source pixel for each rectified pixel, as computed by
+     *        `cv::initUndistortRectifyMap` with type `CV_32FC1`, row-major with `width*height` values
+     * \param width the width of the rectified image
+     * \param height the height of the rectified image
+     * \param src_width the width of the source image, at most \ref MAX_SRC_SIZE
+     * \param src_height the height of the source image, at most \ref MAX_SRC_SIZE
+     * \return false if the parameters are not valid
+     */
+    bool setMaps( CAM_SENS_POS side, const float* map_x, const float* map_y, int width, int height,
+                  int src_width, int src_height );
+
+    /*!
+     * \brief Set the size of the tiles processed by each parallel task
+     * \param tile_width the width of the tiles, rounded up to a multiple of 16
+     * \param tile_height the height of the tiles, rounded up to a multiple of 2
+     * \note Set a size of 0 to process bands of full rows, the default. The tiles reduce the cache misses with small
+     *       caches and strong distortion, but break the sequential access to the maps: use the
+     *       `zed_open_capture_rectify_benchmark` tool to choose the best setting for a platform.
+     */
+    void setTileSize( int tile_width, int tile_height );
+
+    /*!
+     * \brief Store the maps set by the following calls to \ref setMaps on a coarse grid
+     * \param grid_step the spacing of the grid nodes in pixels, rounded up to a power of 2 up to \ref MAX_GRID_STEP.
+     *        Set 0 to store full size maps, the default.
+     * \note A grid of 16 pixels uses more than 100 times less memory than the full size maps. The interpolation error
+     *       depends on the lens distortion: check it with \ref getMapError.
+     */
+    void setMapGridStep( int grid_step );
+
+    /*!
+     * \brief Get the spacing of the grid nodes used by the following calls to \ref setMaps
+     * \return the spacing of the grid nodes in pixels, 0 for full size maps
+     */
+    inline int getMapGridStep() const {return mGridStep;}
+
+    /*!
+     * \brief Get the error of the stored map compared to the map given to \ref setMaps
+     * \param side the camera sensor
+     * \param max_error the maximum distance between the source coordinates, in pixels
+     * \param mean_error the mean distance between the source coordinates, in pixels
+     * \return false if the map is not available
+     * \note The error includes the 1/16 pixel quantization of the fixed-point coordinates, that is the only error of
+     *       full size maps (up to 0.045 pixels). The clamping of the coordinates to the border of the source image is
+     *       not counted, nor the pixels that are valid in only one of the maps.
+     */
+    bool getMapError( CAM_SENS_POS side, float& max_error, float& mean_error ) const;
+
+    /*!
+     * \brief Get the size of the tiles processed by each parallel task
+     * \param tile_width the width of the tiles, 0 if the images are processed in bands of full rows
+     * \param tile_height the height of the tiles, 0 if the images are processed in bands of full rows
+     */
+    inline void getTileSize( int& tile_width, int& tile_height ) const {tile_width=mTileWidth; tile_height=mTileHeight;}
+
+    /*!
+     * \brief Check if the map of a camera sensor is available
+     * \param side the camera sensor
+     * \return true if the map has been set
+     */
+    bool isReady( CAM_SENS_POS side ) const;
+
+    /*!
+     * \brief Get the size of the rectified images
+     * \param side the camera sensor
+     * \param width the width of the rectified image
+     * \param height the height of the rectified image
+     * \param format the pixel format. The size is halved for \ref RECT_FORMAT::YUYV_TO_GRAY_HALF
+     */
+    void getSize( CAM_SENS_POS side, int& width, int& height, RECT_FORMAT format = RECT_FORMAT::GRAY ) const;
+
+    /*!
+     * \brief Get the memory used by the fixed-point maps
+     * \return the size of the maps in bytes
+     */
+    size_t getMapMemory() const;
+
+    /*!
+     * \brief Rectify the image of a camera sensor
+     * \param side the camera sensor
+     * \param format the pixel format of the source and of the rectified images
+     * \param src the source image, of the size given to \ref setMaps
+     * \param src_step the size of a source row in bytes
+     * \param dst the rectified image
+     * \param dst_step the size of a rectified row in bytes
+     * \return false if the map is not available
+     */
+    bool rectify( CAM_SENS_POS side, RECT_FORMAT format, const uint8_t* src, size_t src_step,
+                  uint8_t* dst, size_t dst_step );
+
+    /*!
+     * \brief Rectify the left and right images of a side-by-side frame, as received by \ref VideoCapture, in a single
+     *        parallel job
+     * \param format the pixel format of the source and of the rectified images
+     * \param src the side-by-side source frame
+     * \param src_step the size of a source row in bytes
+     * \param dst_left the rectified left image
+     * \param dst_right the rectified right image
+     * \param dst_step the size of a rectified row in bytes
+     * \return false if the maps are not available
+     */
+    bool rectifyStereo( RECT_FORMAT format, const uint8_t* src, size_t src_step,
+                        uint8_t* dst_left, uint8_t* dst_right, size_t dst_step );
+
+private:
+    static const int BAND_ROWS = 16;    //!< Number of rows of each parallel task when the tiling is disabled
+
+    struct Tile
+    {
+        int x, y;                       //!< Top left corner in the rectified image
+        int width, height;              //!< Size in the rectified image
+        int src_x, src_y;               //!< Top left corner of the source area read by the tile
+        int src_width, src_height;      //!< Size of the source area read by the tile, 0 if outside the source image
+    };
+
+    struct FixedMap
+    {
+        int width = 0;                  //!< Width of the rectified image
+        int height = 0;                 //!< Height of the rectified image
+        int src_width = 0;              //!< Width of the source image
+        int src_height = 0;             //!< Height of the source image
+        std::vector<uint16_t> x;        //!< Q12.4 X coordinates of the source pixels, empty with a grid
+        std::vector<uint16_t> y;        //!< Q12.4 Y coordinates of the source pixels, empty with a grid
+        int grid_shift = 0;             //!< Log2 of the spacing of the grid nodes
+        int grid_cols = 0;              //!< Number of grid nodes of each row, 0 for full size maps
+        int grid_rows = 0;              //!< Number of grid rows, 0 for full size maps
+        std::vector<float> grid_x;      //!< X coordinates of the source pixels at the grid nodes
+        std::vector<float> grid_y;      //!< Y coordinates of the source pixels at the grid nodes
+        float max_error = 0.f;          //!< Maximum error compared to the map given to setMaps, in pixels
+        float mean_error = 0.f;         //!< Mean error compared to the map given to setMaps, in pixels
+        bool box_filter = false;        //!< The map downscales by 2 or more: the luma is 2x2 box filtered
+        std::vector<Tile> tiles;        //!< Parallel tasks, in row-major order
+
+        inline bool isSet() const {return !x.empty() || !grid_x.empty();}
+    };
+
+    struct Job
+    {
+        const FixedMap* map;
+        RECT_FORMAT format;
+        const uint8_t* src;
+        size_t src_step;
+        uint8_t* dst;
+        size_t dst_step;
+    };
+
+    /*!
+     * \brief Get the map of the columns `[col_begin,col_end)` of a row. With a grid the coordinates are interpolated in
+     *        `buf_x` and `buf_y`, of \ref MAX_SRC_SIZE values.
+     */
+    static void getMapRow( const FixedMap& map, int row, int col_begin, int col_end, uint16_t* buf_x, uint16_t* buf_y,
+                           const uint16_t*& mx, const uint16_t*& my );
+
+    void updateTiles( FixedMap& map ) const;        //!< Split the map in tiles and compute their source areas
+    void run( const Job* jobs, size_t job_count );  //!< Run the tiles of the jobs on the worker pool
+
+    template<int bpp>
+    static void rectifyLuma( const Job& job, int col_begin, int col_end, int row_begin, int row_end );
+    template<int bpp>
+    static void rectifyLumaBox( const Job& job, int col_begin, int col_end, int row_begin, int row_end );
+    static void rectifyLumaHalf( const Job& job, int col_begin, int col_end, int row_begin, int row_end );
+    static void rectifyYuyv( const Job& job, int col_begin, int col_end, int row_begin, int row_end );
+
+    WorkerPool* mPool = nullptr;        //!< The worker pool
+    FixedMap mMaps[2];                  //!< Left and right maps
+    int mTileWidth = 0;                 //!< Width of the tiles, 0 for bands of rows
+    int mTileHeight = 0;                //!< Height of the tiles, 0 for bands of rows
+    int mGridStep = 0;                  //!< Spacing of the map grid nodes, 0 for full size maps
+};
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
+
+#endif // RECTIFIER_HPP
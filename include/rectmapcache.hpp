@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef RECTMAPCACHE_HPP
+#define RECTMAPCACHE_HPP
+
+#include "defines.hpp"
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+#include "videocapture_def.hpp"
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief Rectification parameters of a stereo camera at a given resolution, stored with the rectification maps
+ */
+struct SL_OC_EXPORT RectMapInfo
+{
+    int serial = 0;             //!< Camera serial number
+    int width = 0;              //!< Width of each image in pixels
+    int height = 0;             //!< Height of each image in pixels
+    uint64_t calib_hash = 0;    //!< Hash of the content of the calibration file used to compute the maps
+    double P_left[12] = {};     //!< Projection matrix of the rectified left camera (3x4 row-major)
+    double P_right[12] = {};    //!< Projection matrix of the rectified right camera (3x4 row-major)
+    double baseline = 0.0;      //!< Stereo baseline, in the units of the calibration file
+};
+
+/*!
+ * \brief The RectMapCache class stores the rectification maps of a stereo camera in a binary file and maps it in memory
+ *
+ * A cache file contains the four `float` maps used by `cv::remap` (X and Y coordinates of the source pixel for each
+ * pixel of the left and right rectified images) and the rectified projection matrices. It is identified by the
+ * camera serial number, the image size and the hash of the calibration file, so a new calibration invalidates it.
+ * The file is mapped read-only: opening it takes a few milliseconds and its pages are shared by all the processes
+ * using the same camera.
+ */
+class SL_OC_EXPORT RectMapCache
+{
+public:
+    /*!
+     * \brief The default constructor
+     */
+    RectMapCache() = default;
+
+    /*!
+     * \brief The class destructor, unmaps the cache file
+     */
+    ~RectMapCache();
+
+    RectMapCache( const RectMapCache& ) = delete;
+    RectMapCache& operator=( const RectMapCache& ) = delete;
+
+    /*!
+     * \brief Compute the 64 bit FNV-1a hash of a file content
+     * \param filename the path of the file
+     * \return the hash value, 0 if the file cannot be read
+     */
+    static uint64_t hashFile( const std::string& filename );
+
+    /*!
+     * \brief Get the standard name of a cache file
+     * \param folder the folder of the cache file, with the trailing separator
+     * \param serial the camera serial number
+     * \param width the width of each image in pixels
+     * \param height the height of each image in pixels
+     * \return the path of the cache file (`<folder>SN<serial>_<width>x<height>.rectmap`)
+     */
+    static std::string getCacheFilename( const std::string& folder, int serial, int width, int height );
+
+    /*!
+     * \brief Write a cache file. The file is written to a temporary file and renamed, so a process can never map a
+     *        partially written cache.
+     * \param filename the path of the cache file
+     * \param info the rectification parameters
+     * \param left_x,left_y the maps of the left image, `width*height` values each
+     * \param right_x,right_y the maps of the right image, `width*height` values each
+     * \return true if the cache file has been correctly written
+     */
+    static bool save( const std::string& filename, const RectMapInfo& info,
+                      const float* left_x, const float* left_y, const float* right_x, const float* right_y );
+
+    /*!
+     * \brief Map a cache file in memory, checking that it matches the requested camera, size and calibration
+     * \param filename the path of the cache file
+     * \param serial the camera serial number
+     * \param width the width of each image in pixels
+     * \param height the height of each image in pixels
+     * \param calib_hash the hash of the calibration file (see \ref hashFile)
+     * \return false if the file does not exist, is not valid or does not match
+     */
+    bool open( const std::string& filename, int serial, int width, int height, uint64_t calib_hash );
+
+    /*!
+     * \brief Unmap the cache file. The map pointers are not valid anymore.
+     */
+    void close();
+
+    /*!
+     * \brief Check if a cache file is mapped
+     * \return true if a cache file is mapped
+     */
+    inline bool isOpen() const {return mData!=nullptr;}
+
+    /*!
+     * \brief Get the rectification parameters of the mapped cache
+     * \return the rectification parameters
+     */
+    inline const RectMapInfo& getInfo() const {return mInfo;}
+
+    /*!
+     * \brief Get the map of the X coordinates of the source pixels
+     * \param side the camera sensor
+     * \return pointer to `width*height` read-only values, valid until the cache is closed. `nullptr` if not open.
+     */
+    const float* getMapX( CAM_SENS_POS side ) const;
+
+    /*!
+     * \brief Get the map of the Y coordinates of the source pixels
+     * \param side the camera sensor
+     * \return pointer to `width*height` read-only values, valid until the cache is closed. `nullptr` if not open.
+     */
+    const float* getMapY( CAM_SENS_POS side ) const;
+
+private:
+    static const int MAP_COUNT = 4;     //!< Left X, left Y, right X, right Y
+
+    void* mData = nullptr;              //!< The mapped file
+    size_t mSize = 0;                   //!< Size of the mapped file [bytes]
+    RectMapInfo mInfo;                  //!< Rectification parameters of the mapped file
+    const float* mMaps[MAP_COUNT] = {}; //!< The maps in the mapped file
+};
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
+
+#endif // RECTMAPCACHE_HPP
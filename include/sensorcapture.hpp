@@ -27,11 +27,25 @@
 #include <vector>
 #include <map>
 #include <mutex>
+#include <atomic>
+#include <functional>
+#include <memory>
 
 #ifdef SENSORS_MOD_AVAILABLE
 
 #include "sensorcapture_def.hpp"
-#include "hidapi.h"
+#include "sensorconversion.hpp"
+#include "orientationfilter.hpp"
+#include "historybuffer.hpp"
+#include "sensorstats.hpp"
+#include "thermalbiasmodel.hpp"
+#include "magcalibration.hpp"
+#include "envhistory.hpp"
+#include "imuresampler.hpp"
+#include "imulog.hpp"
+#include "hidtransport.hpp"
+#include "standstilldetector.hpp"
+#include "gravityestimator.hpp"
 
 namespace sl_oc {
 
@@ -67,6 +81,7 @@ struct SL_OC_EXPORT Imu
     float gZ;               //!< Angular velocity around > axis in °/s
     float temp;             //!< Sensor temperature in °C
     bool sync;              //!< Indicates in IMU data are synchronized with a video frame
+    bool gap = false;       //!< Indicates that sensor packets have been lost before this sample (kept until the data are read)
 };
 
 /*!
@@ -86,6 +101,10 @@ struct SL_OC_EXPORT Magnetometer
     float mX;               //!< Acceleration along X axis in uT
     float mY;               //!< Acceleration along Y axis in uT
     float mZ;               //!< Acceleration along Z axis in uT
+    bool calibrated = false;//!< Indicates if the hard-iron and soft-iron calibration has been applied to the `*_cal` values
+    float mX_cal;           //!< Calibrated magnetic field along X axis in uT (equal to `mX` if not calibrated)
+    float mY_cal;           //!< Calibrated magnetic field along Y axis in uT (equal to `mY` if not calibrated)
+    float mZ_cal;           //!< Calibrated magnetic field along Z axis in uT (equal to `mZ` if not calibrated)
 };
 
 /*!
@@ -124,8 +143,36 @@ struct SL_OC_EXPORT Temperature
     float temp_right;       //!< Temperature of the right CMOS camera sensor
 };
 
+/*!
+ * \brief Contains a motion event detected by the IMU hardware
+ */
+struct SL_OC_EXPORT MotionEvent
+{
+    typedef enum _motion_event_type {
+        MOTION_START = 0,       //!< The camera started to move
+        MOTION_STOP = 1,        //!< The camera stopped moving
+        FREE_FALL_START = 2,    //!< The camera started to fall
+        FREE_FALL_STOP = 3      //!< The camera stopped falling
+    } MotionEventType;
+
+    MotionEventType type = MOTION_START; //!< Type of the event
+    uint64_t timestamp = 0; //!< Timestamp of the sensor data reporting the event, in nanoseconds
+    uint32_t count = 0;     //!< Value of the MCU interrupt counter of the event type
+};
+
 }
 
+/*!
+ * \brief Callback function called by the sensor thread when a motion event is detected
+ */
+typedef std::function<void(const data::MotionEvent&)> MotionEventCallback;
+
+/*!
+ * \brief Callback function called by the sensor thread for each IMU sample (see \ref SensorCapture::setImuCallback)
+ *        or for each resampled IMU sample (see \ref SensorCapture::setResampledImuCallback)
+ */
+typedef std::function<void(const data::Imu&)> ImuCallback;
+
 /*!
  * \brief The SensorCapture class provides sensor grabbing functions for the Stereolabs ZED Mini and ZED2 camera models
  */
@@ -140,6 +187,14 @@ public:
      */
     SensorCapture( sl_oc::VERBOSITY verbose_lvl=sl_oc::VERBOSITY::ERROR );
 
+    /*!
+     * \brief Constructor with a custom USB HID transport, for example a \ref FakeMcuTransport to run the sensor data
+     *        path without a camera
+     * \param transport the HID transport, owned by the object
+     * \param verbose_lvl enable useful information to debug the class behaviours while running
+     */
+    SensorCapture( std::unique_ptr<HidTransport> transport, sl_oc::VERBOSITY verbose_lvl=sl_oc::VERBOSITY::ERROR );
+
     /*!
      * \brief The class destructor
      */
@@ -180,6 +235,16 @@ public:
      */
     const data::Imu& getLastIMUData(uint64_t timeout_usec=1500);
 
+    /*!
+     * \brief Set the function to be called for each received IMU sample. Unlike \ref getLastIMUData no sample is
+     *        skipped: the `gap` flag of a sample is set only if sensor packets have been lost just before it, and the
+     *        samples not valid are passed with `valid` set to `data::Imu::OLD_VAL`.
+     * \param callback the callback function, an empty function to disable it
+     * \note The callback is called directly by the sensor thread: it must return quickly to not delay the data
+     *       acquisition.
+     */
+    void setImuCallback( ImuCallback callback );
+
     /*!
      * \brief Get the last received Magnetometer data
      * \param timeout_usec data grabbing timeout in milliseconds.
@@ -201,6 +266,295 @@ public:
      */
     const data::Temperature& getLastCameraTemperatureData(uint64_t timeout_usec=100);
 
+    /*!
+     * \brief Set the IMU intrinsic calibration model. The correction is applied by the sensor thread, so the IMU data
+     *        returned by \ref getLastIMUData are already corrected.
+     * \param calib the IMU calibration model
+     */
+    void setImuCalibration( const data::ImuCalibration& calib );
+
+    /*!
+     * \brief Load the IMU intrinsic calibration model from file and apply it (see \ref loadImuCalibration for the
+     *        file format)
+     * \param filename the path of the calibration file
+     * \return true if the calibration file has been correctly loaded
+     */
+    bool loadImuCalibration( const std::string& filename );
+
+    /*!
+     * \brief Get the IMU intrinsic calibration model currently applied
+     * \return the IMU calibration model
+     */
+    data::ImuCalibration getImuCalibration();
+
+    /*!
+     * \brief Enable/disable the orientation filter. When enabled the filter is updated by the sensor thread for each
+     *        new IMU sample, before the IMU data are published.
+     * \param enable true to enable the filter
+     * \param params the filter parameters
+     * \note Enabling the filter resets its state
+     */
+    void enableOrientationFilter( bool enable, const OrientationFilterParams& params = OrientationFilterParams() );
+
+    /*!
+     * \brief Check if the orientation filter is enabled
+     * \return true if the filter is enabled
+     */
+    inline bool isOrientationFilterEnabled() const {return mOrientEnabled;}
+
+    /*!
+     * \brief Get the last orientation estimated by the filter. The function does not wait and does not lock the
+     *        sensor thread.
+     * \return the last orientation, `NOT_PRESENT` if the filter is disabled or not initialized
+     */
+    data::Orientation getLastOrientationData();
+
+    /*!
+     * \brief Get the orientation at the given timestamp, interpolating the samples stored in the orientation history
+     * \param timestamp the requested timestamp in nanoseconds, in the same time reference of the IMU data
+     * \param orientation the interpolated orientation
+     * \return false if the filter is disabled or the timestamp is not covered by the orientation history, which is
+     *         cleared when the filter is enabled or its parameters change
+     */
+    bool getOrientationAt( uint64_t timestamp, data::Orientation& orientation );
+
+    /*!
+     * \brief Enable/disable the gravity estimator. When enabled the low-pass filtered gravity direction is updated by
+     *        the sensor thread for each new IMU sample and stored in a history for timestamp queries.
+     * \param enable true to enable the estimator
+     * \param params the estimator parameters
+     * \note Enabling the estimator resets its state
+     */
+    void enableGravityEstimator( bool enable, const GravityParams& params = GravityParams() );
+
+    /*!
+     * \brief Check if the gravity estimator is enabled
+     * \return true if the estimator is enabled
+     */
+    inline bool isGravityEstimatorEnabled() const {return mGravityEnabled;}
+
+    /*!
+     * \brief Get the last gravity direction estimated. The function does not wait and does not lock the sensor thread.
+     * \return the last gravity direction, not valid if the estimator is disabled or not initialized
+     */
+    data::Gravity getLastGravityData();
+
+    /*!
+     * \brief Get the gravity direction at the given timestamp, interpolating the samples stored in the gravity history.
+     *        Use the timestamp of a synchronized video frame to get the gravity direction associated to the frame,
+     *        and \ref GravityEstimator::getAlignment to rotate its point cloud to a gravity aligned frame.
+     * \param timestamp the requested timestamp in nanoseconds, in the same time reference of the IMU data
+     * \param gravity the interpolated gravity direction
+     * \return false if the estimator is disabled or the timestamp is not covered by the gravity history, which is
+     *         cleared when the estimator is enabled or its parameters change
+     */
+    bool getGravityAt( uint64_t timestamp, data::Gravity& gravity );
+
+    /*!
+     * \brief Get the latency statistics of the sensor data path: transport latency, inter-arrival jitter and
+     *        processing time of each received packet
+     * \return a copy of the current latency statistics
+     */
+    data::SensorLatencyStats getLatencyStats();
+
+    /*!
+     * \brief Reset the latency statistics
+     */
+    void resetLatencyStats();
+
+    /*!
+     * \brief Get the counters of the received, lost, duplicated and out-of-order sensor packets
+     * \return a copy of the current packet counters
+     */
+    data::SensorPacketStats getPacketStats();
+
+    /*!
+     * \brief Reset the sensor packet counters
+     */
+    void resetPacketStats();
+
+    /*!
+     * \brief Set the function to be called when a motion or a free-fall event is detected by the IMU hardware
+     * \param callback the callback function, an empty function to disable it
+     * \note The callback is called directly by the sensor thread: it must return quickly to not delay the data
+     *       acquisition. Events are edge triggered: a short interrupt received between two packets generates both the
+     *       start and the stop events, a new interrupt counted while the flag stays set generates a stop and a start.
+     */
+    void setMotionEventCallback( MotionEventCallback callback );
+
+    /*!
+     * \brief Indicates if the IMU hardware reports that the camera is moving
+     * \return true if the camera is moving
+     */
+    inline bool isCameraMoving() const {return mCameraMoving;}
+
+    /*!
+     * \brief Indicates if the IMU hardware reports that the camera is free falling
+     * \return true if the camera is falling
+     */
+    inline bool isCameraFalling() const {return mCameraFalling;}
+
+    /*!
+     * \brief Enable/disable the temperature dependent IMU bias compensation. The model is learned online while the
+     *        camera is still and the compensation is applied by the sensor thread in the IMU conversion path.
+     * \param enable true to enable the compensation
+     * \param model_folder folder where the learned model of each camera is persisted (`SN<serial>_imu_thermal.conf`).
+     *        If empty the ZED settings folder is used (`$HOME/zed/settings/`).
+     * \param params the model parameters
+     * \return false if the sensors are not initialized
+     * \note The model previously learned for the connected camera is loaded when the compensation is enabled, and it
+     *       is saved when the compensation is disabled and when the connection is closed.
+     */
+    bool enableThermalBiasCompensation( bool enable, const std::string& model_folder=std::string(),
+                                        const ThermalBiasParams& params=ThermalBiasParams() );
+
+    /*!
+     * \brief Save the learned temperature dependent bias model of the connected camera
+     * \return true if the model has been correctly saved
+     */
+    bool saveThermalBiasModel();
+
+    /*!
+     * \brief Get the coefficients of the temperature dependent bias model
+     * \return the model coefficients
+     */
+    data::ImuThermalCoeffs getThermalBiasCoefficients();
+
+    /*!
+     * \brief Enable/disable the standstill detection. When enabled the sensor thread detects when the camera is still
+     *        and meanwhile estimates the gyroscope bias (see \ref StandstillDetector).
+     * \param enable true to enable the detection
+     * \param params the detector parameters
+     * \param auto_subtract true to subtract the estimated bias from the published angular velocities
+     * \note When enabled, the standstill status is also used to learn the temperature dependent bias model in place of
+     *       the IMU hardware motion flag. The current bias estimate is kept when the detection is enabled again.
+     */
+    void enableStandstillDetection( bool enable, const StandstillParams& params = StandstillParams(),
+                                    bool auto_subtract = false );
+
+    /*!
+     * \brief Check if the standstill detection is enabled
+     * \return true if the detection is enabled
+     */
+    inline bool isStandstillDetectionEnabled() const {return mStillEnabled;}
+
+    /*!
+     * \brief Indicates if the standstill detector reports that the camera is still
+     * \return true if the camera is still, false if it is moving or if the detection is disabled
+     */
+    inline bool isCameraStill() const {return mStillEnabled && mCameraStill;}
+
+    /*!
+     * \brief Get the gyroscope bias estimated while the camera is still
+     * \return the bias estimate, not valid if the camera has never been detected still
+     */
+    data::GyroBias getGyroBias();
+
+    /*!
+     * \brief Set the gyroscope bias estimate, for example an estimate saved by a previous session
+     * \param bias the bias estimate
+     */
+    void setGyroBias( const data::GyroBias& bias );
+
+    /*!
+     * \brief Enable/disable the streaming hard-iron and soft-iron magnetometer calibration. When enabled each new
+     *        magnetometer sample updates the ellipsoid fit, and the calibrated values are published in the `*_cal`
+     *        fields of \ref data::Magnetometer.
+     * \param enable true to enable the calibration
+     * \param params the calibration parameters
+     * \note Enabling the calibration restarts the fit, but the current calibration is kept until a new one is available
+     */
+    void enableMagCalibration( bool enable, const MagCalibrationParams& params = MagCalibrationParams() );
+
+    /*!
+     * \brief Set the magnetometer calibration, for example a calibration saved by a previous session
+     * \param calib the magnetometer calibration
+     */
+    void setMagCalibration( const data::MagCalibration& calib );
+
+    /*!
+     * \brief Get the current magnetometer calibration
+     * \return the magnetometer calibration
+     */
+    data::MagCalibration getMagCalibration();
+
+    /*!
+     * \brief Get the history of an environmental sensor or of a camera sensor temperature
+     * \param res the requested resolution (1 second, 1 minute or 1 hour rollups)
+     * \param channel the requested sensor value
+     * \param from_ts start of the requested time range in nanoseconds
+     * \param to_ts end of the requested time range in nanoseconds
+     * \return the min/mean/max rollups overlapping the time range, sorted by timestamp
+     */
+    std::vector<data::EnvRollup> getEnvironmentHistory( EnvHistory::RESOLUTION res, EnvHistory::CHANNEL channel,
+                                                        uint64_t from_ts=0, uint64_t to_ts=static_cast<uint64_t>(-1) );
+
+    /*!
+     * \brief Save the environmental history to a binary file
+     * \param filename the path of the destination file
+     * \return true if the file has been correctly written
+     */
+    bool saveEnvironmentHistory( const std::string& filename );
+
+    /*!
+     * \brief Load an environmental history saved by \ref saveEnvironmentHistory, replacing the current one. New data
+     *        are appended to the loaded history.
+     * \param filename the path of the history file
+     * \return true if the file has been correctly loaded
+     */
+    bool loadEnvironmentHistory( const std::string& filename );
+
+    /*!
+     * \brief Enable/disable the IMU resampler. When enabled the sensor thread low-pass filters the IMU data and
+     *        resamples them on an exact time grid at the requested rate (see \ref ImuResampler).
+     * \param enable true to enable the resampler
+     * \param params the resampler parameters
+     * \note Enabling the resampler resets its state
+     */
+    void enableImuResampler( bool enable, const ImuResamplerParams& params = ImuResamplerParams() );
+
+    /*!
+     * \brief Check if the IMU resampler is enabled
+     * \return true if the resampler is enabled
+     */
+    inline bool isImuResamplerEnabled() const {return mResampEnabled;}
+
+    /*!
+     * \brief Get the last resampled IMU data
+     * \param timeout_usec data grabbing timeout in microseconds.
+     * \return returns a reference to the last resampled data.
+     */
+    const data::Imu& getLastResampledIMUData(uint64_t timeout_usec=10000);
+
+    /*!
+     * \brief Set the function to be called for each resampled IMU sample
+     * \param callback the callback function, an empty function to disable it
+     * \note The callback is called directly by the sensor thread: it must return quickly to not delay the data
+     *       acquisition.
+     */
+    void setResampledImuCallback( ImuCallback callback );
+
+    /*!
+     * \brief Start logging the IMU data to a compact binary file (see \ref ImuLogWriter). The sensor thread writes the
+     *        published IMU data, with the IMU calibration and the bias compensation already applied.
+     * \param filename the path of the log file. An existing file is replaced.
+     * \param params the log parameters. If the serial number is not set, the serial number of the camera is used.
+     * \return true if the log file has been created
+     */
+    bool startImuLog( const std::string& filename, const ImuLogParams& params = ImuLogParams() );
+
+    /*!
+     * \brief Stop logging the IMU data and close the log file
+     * \return true if all the data have been correctly written
+     */
+    bool stopImuLog();
+
+    /*!
+     * \brief Check if the IMU data are being logged
+     * \return true if a log file is open
+     */
+    bool isImuLogging();
+
     /*!
      * \brief Perform a SW reset of the Sensors Module. To be called in case one of the sensors stops to work correctly.
      *
@@ -235,6 +589,11 @@ private:
 
     void grabThreadFunc();              //!< The sensor data grabbing thread function
 
+    void updateLatencyStats(uint64_t rx_steady_ts, uint64_t mcu_rel_ts); //!< Update the latency statistics with a new packet
+    bool checkPacketSequence(uint64_t mcu_ts, bool& gap); //!< Update the packet counters, returns false if the packet must be discarded
+    void processMotionEvents(const usb::RawData* data, uint64_t data_ts); //!< Detect the motion event edges and call the callback
+    void fireMotionEvent(data::MotionEvent::MotionEventType type, uint64_t data_ts, uint32_t count); //!< Call the motion event callback
+
     bool startCapture();                //!< Start data capture thread
 
     bool open(uint16_t pid, int serial_number); //!< Open the USB connection
@@ -263,7 +622,7 @@ private:
     std::map<int,uint16_t> mSlDevPid;   //!< All the available Stereolabs MCU (ZED-M and ZED2) product IDs associated to their serial number
     std::map<int,uint16_t> mSlDevFwVer; //!< All the available Stereolabs MCU (ZED-M and ZED2) product IDs associated to their firmware version
 
-    hid_device* mDevHandle = nullptr;   //!< Hidapi device handler
+    std::unique_ptr<HidTransport> mTransport; //!< USB HID transport to the MCU
     int mDevSerial = -1;                //!< Serial number of the connected device
     int mDevFwVer = -1;                 //!< FW version of the connected device
     unsigned short mDevPid = 0;         //!< Product ID of the connected device
@@ -273,12 +632,105 @@ private:
     data::Environment mLastEnvData;     //!< Contains the last received Environmental data
     data::Temperature mLastCamTempData; //!< Contains the last received camera sensors temperature data
 
+    SensorConverter mConverter;         //!< Converts RAW data to physical units with scale factors resolved for the connected device
+    data::ImuBatch mImuBatch;           //!< Conversion buffer for the IMU data
+    std::shared_ptr<ImuCallback> mImuCallback; //!< IMU data callback
+
+    data::ImuCalibration mImuCalib;     //!< IMU calibration model to be applied by the grabbing thread
+    std::atomic<bool> mImuCalibChanged{false}; //!< Indicates that the grabbing thread must update the IMU calibration
+
+    // ----> Orientation filter
+    OrientationFilter mOrientFilter;    //!< Orientation filter, updated by the grabbing thread
+    OrientationFilterParams mOrientParams; //!< Orientation filter parameters to be applied by the grabbing thread
+    std::atomic<bool> mOrientEnabled{false}; //!< Indicates if the orientation filter is enabled
+    std::atomic<bool> mOrientParamsChanged{false}; //!< Indicates that the grabbing thread must reset the orientation filter
+    HistoryBuffer<data::Orientation,ORIENT_HISTORY_SIZE> mOrientHistory; //!< Lock-free history of the estimated orientations
+    // <---- Orientation filter
+
+    // ----> Gravity estimator
+    GravityEstimator mGravityEstimator; //!< Gravity estimator, updated by the grabbing thread
+    GravityParams mGravityParams;       //!< Gravity estimator parameters to be applied by the grabbing thread
+    std::atomic<bool> mGravityEnabled{false}; //!< Indicates if the gravity estimator is enabled
+    std::atomic<bool> mGravityParamsChanged{false}; //!< Indicates that the grabbing thread must reset the gravity estimator
+    HistoryBuffer<data::Gravity,GRAVITY_HISTORY_SIZE> mGravityHistory; //!< Lock-free history of the estimated gravity directions
+    // <---- Gravity estimator
+
+    // ----> Latency statistics
+    data::SensorLatencyStats mLatencyStats; //!< Latency statistics of the sensor data path
+    LatencyReference mLatencyRef;       //!< Reference of the transport latency, following the MCU clock drift
+    uint64_t mLatencyLastRxTs = 0;      //!< Steady host receive time of the previous packet [nsec]
+    uint64_t mLatencyLastDataTs = 0;    //!< Relative MCU time of the previous packet [nsec]
+    // <---- Latency statistics
+
+    data::SensorPacketStats mPacketStats; //!< Counters of the received sensor packets
+
+    // ----> Motion events
+    std::atomic<bool> mCameraMoving{false}; //!< Camera moving status reported by the IMU hardware
+    std::atomic<bool> mCameraFalling{false}; //!< Camera falling status reported by the IMU hardware
+    bool mMotionInitialized = false;    //!< Indicates if the interrupt counters have been initialized
+    uint32_t mMovingCount = 0;          //!< Last received camera moving interrupt counter
+    uint32_t mFallingCount = 0;         //!< Last received camera falling interrupt counter
+    std::shared_ptr<MotionEventCallback> mMotionCallback; //!< Motion event callback
+    // <---- Motion events
+
+    // ----> Temperature dependent bias compensation
+    ThermalBiasModel mThermalModel;     //!< Temperature dependent bias model, updated by the grabbing thread
+    std::string mThermalFile;           //!< File where the bias model of the connected camera is persisted
+    std::atomic<bool> mThermalEnabled{false}; //!< Indicates if the temperature dependent bias compensation is enabled
+    std::atomic<bool> mThermalChanged{false}; //!< Indicates that the grabbing thread must update the compensation
+    // <---- Temperature dependent bias compensation
+
+    // ----> Standstill detection
+    StandstillDetector mStillDetector;  //!< Standstill detector, updated by the grabbing thread
+    StandstillParams mStillParams;      //!< Standstill detector parameters to be applied by the grabbing thread
+    data::GyroBias mGyroBias;           //!< Last published gyroscope bias estimate
+    std::atomic<bool> mStillEnabled{false}; //!< Indicates if the standstill detection is enabled
+    std::atomic<bool> mStillParamsChanged{false}; //!< Indicates that the grabbing thread must apply new parameters
+    std::atomic<bool> mGyroBiasChanged{false}; //!< Indicates that the grabbing thread must apply a new bias estimate
+    std::atomic<bool> mStillAutoSubtract{false}; //!< Indicates if the estimated bias is subtracted from the published data
+    std::atomic<bool> mCameraStill{false}; //!< Camera still status reported by the standstill detector
+    // <---- Standstill detection
+
+    // ----> Magnetometer calibration
+    MagCalibrator mMagCalibrator;       //!< Streaming magnetometer calibration, updated by the grabbing thread
+    bool mMagCalibEnabled = false;      //!< Indicates if the streaming magnetometer calibration is enabled
+    // <---- Magnetometer calibration
+
+    EnvHistory mEnvHistory;             //!< Multi-resolution history of the environmental data and of the camera temperatures
+
+    // ----> IMU resampler
+    ImuResampler mResampler;            //!< IMU resampler, updated by the grabbing thread
+    ImuResamplerParams mResampParams;   //!< IMU resampler parameters to be applied by the grabbing thread
+    std::atomic<bool> mResampEnabled{false}; //!< Indicates if the IMU resampler is enabled
+    std::atomic<bool> mResampParamsChanged{false}; //!< Indicates that the grabbing thread must reset the resampler
+    data::ImuBatch mResampBatch;        //!< Output buffer of the IMU resampler
+    bool mResampSkipped = false;        //!< Indicates that an invalid IMU sample has not been passed to the resampler
+    data::Imu mLastResampIMUData;       //!< Contains the last resampled IMU data
+    bool mNewResampIMUData = false;     //!< Indicates if new resampled IMU data are available
+    std::shared_ptr<ImuCallback> mResampCallback; //!< Resampled IMU data callback
+    // <---- IMU resampler
+
+    ImuLogWriter mImuLog;               //!< Binary IMU log, written by the grabbing thread
+
     std::thread mGrabThread;            //!< The grabbing thread
 
     std::mutex mIMUMutex;               //!< Mutex for safe access to IMU data buffer
+    std::mutex mImuCallbackMutex;       //!< Mutex for safe access to the IMU data callback
     std::mutex mMagMutex;               //!< Mutex for safe access to MAG data buffer
     std::mutex mEnvMutex;               //!< Mutex for safe access to ENV data buffer
     std::mutex mCamTempMutex;           //!< Mutex for safe access to CAM_TEMP data buffer
+    std::mutex mCalibMutex;             //!< Mutex for safe access to the IMU calibration model
+    std::mutex mOrientMutex;            //!< Mutex for safe access to the orientation filter parameters
+    std::mutex mGravityMutex;           //!< Mutex for safe access to the gravity estimator parameters
+    std::mutex mStatsMutex;             //!< Mutex for safe access to the latency statistics
+    std::mutex mEventMutex;             //!< Mutex for safe access to the motion event callback
+    std::mutex mThermalMutex;           //!< Mutex for safe access to the temperature dependent bias model
+    std::mutex mStillMutex;             //!< Mutex for safe access to the standstill parameters and the gyroscope bias
+    std::mutex mMagCalibMutex;          //!< Mutex for safe access to the magnetometer calibration
+    std::mutex mEnvHistMutex;           //!< Mutex for safe access to the environmental history
+    std::mutex mResampMutex;            //!< Mutex for safe access to the IMU resampler parameters and callback
+    std::mutex mResampDataMutex;        //!< Mutex for safe access to the resampled IMU data buffer
+    std::mutex mImuLogMutex;            //!< Mutex for safe access to the binary IMU log
 
     uint64_t mStartSysTs=0;             //!< Initial System Timestamp, to calculate differences [nsec]
     uint64_t mLastMcuTs=0;              //!< MCU Timestamp of the previous data, to calculate relative timestamps [nsec]
@@ -169,6 +169,10 @@ inline bool atLeast(const int &version_current, const ZED_M_FW &version_required
 
 #define NTP_ADJUST_CT 1
 const size_t TS_SHIFT_VAL_COUNT = 50; //!< Number of sensor data to use to update timestamp scaling
+const size_t ORIENT_HISTORY_SIZE = 1024; //!< Number of orientation samples kept for timestamp queries (~2.5 sec @ 400 Hz)
+const size_t GRAVITY_HISTORY_SIZE = 1024; //!< Number of gravity samples kept for timestamp queries (~2.5 sec @ 400 Hz)
+const uint64_t SENS_DATA_PERIOD_NSEC = 2500000; //!< Expected spacing of the MCU sensor data timestamps (400 Hz) [nsec]
+const uint64_t SENS_TS_RESTART_NSEC = 1000000000; //!< Backward MCU timestamp jump considered a timestamp restart instead of a reordered packet [nsec]
 
 }
 
@@ -0,0 +1,224 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef SENSORCONVERSION_HPP
+#define SENSORCONVERSION_HPP
+
+#include "defines.hpp"
+
+#include <vector>
+#include <string>
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+#include "sensorcapture_def.hpp"
+
+namespace sl_oc {
+
+namespace sensors {
+
+namespace data {
+
+/*!
+ * \brief Contains a batch of converted IMU data in struct-of-arrays layout
+ */
+struct SL_OC_EXPORT ImuBatch
+{
+    std::vector<uint64_t> timestamp;    //!< MCU timestamps in nanoseconds (not drift corrected)
+    std::vector<float> aX;              //!< Accelerations along X axis in m/s²
+    std::vector<float> aY;              //!< Accelerations along Y axis in m/s²
+    std::vector<float> aZ;              //!< Accelerations along Z axis in m/s²
+    std::vector<float> gX;              //!< Angular velocities around X axis in °/s
+    std::vector<float> gY;              //!< Angular velocities around Y axis in °/s
+    std::vector<float> gZ;              //!< Angular velocities around Z axis in °/s
+    std::vector<float> temp;            //!< Sensor temperatures in °C
+    std::vector<uint8_t> valid;         //!< 1 if the IMU sample is valid
+    std::vector<uint8_t> sync;          //!< 1 if the IMU sample is synchronized with a video frame
+    std::vector<uint8_t> gap;           //!< 1 if sensor packets have been lost before the IMU sample
+
+    /*!
+     * \brief Resize all the buffers of the batch
+     * \param count the new number of samples
+     */
+    void resize(size_t count);
+
+    /*!
+     * \brief Get the number of samples in the batch
+     * \return the number of samples
+     */
+    inline size_t size() const {return timestamp.size();}
+};
+
+/*!
+ * \brief Contains the intrinsic calibration model of the IMU
+ *
+ * Each sensor is corrected as `M*(v - bias)`, where `v` is the value converted with the fixed datasheet scale and
+ * `M` is a row-major 3x3 matrix compensating scale errors and axes misalignment.
+ */
+struct SL_OC_EXPORT ImuCalibration
+{
+    float acc_M[9] = {1.f,0.f,0.f, 0.f,1.f,0.f, 0.f,0.f,1.f};   //!< Accelerometer scale and misalignment matrix
+    float acc_bias[3] = {0.f,0.f,0.f};                          //!< Accelerometer bias in m/s²
+    float gyro_M[9] = {1.f,0.f,0.f, 0.f,1.f,0.f, 0.f,0.f,1.f};  //!< Gyroscope scale and misalignment matrix
+    float gyro_bias[3] = {0.f,0.f,0.f};                         //!< Gyroscope bias in °/s
+};
+
+/*!
+ * \brief Contains the polynomial model of the IMU biases as function of the IMU temperature
+ *
+ * The bias of each axis is `sum_k c[k]*t^k`, with `t = (T - ref_temp)/temp_scale` and `T` the IMU temperature in °C.
+ * The biases are subtracted from the calibrated IMU data.
+ */
+struct SL_OC_EXPORT ImuThermalCoeffs
+{
+    static const int MAX_ORDER = 3;         //!< Maximum order of the polynomials
+
+    bool enabled = false;                   //!< Indicates if the compensation must be applied
+    int order = 0;                          //!< Order of the polynomials
+    float ref_temp = 25.0f;                 //!< Reference temperature [°C]
+    float temp_scale = 10.0f;               //!< Temperature normalization factor [°C]
+    float temp_min = -100.0f;               //!< Lower bound of the validity range, colder temperatures are clamped [°C]
+    float temp_max = 200.0f;                //!< Upper bound of the validity range, warmer temperatures are clamped [°C]
+    float gyro[3][MAX_ORDER+1] = {};        //!< Gyroscope bias coefficients for each axis [°/s]
+    float acc[3][MAX_ORDER+1] = {};         //!< Accelerometer bias coefficients for each axis [m/s²]
+};
+
+}
+
+/*!
+ * \brief Load an IMU calibration model from file
+ *
+ * The file contains an `[accelerometer]` and a `[gyroscope]` section, each with the keys `M` (9 values, row-major)
+ * and `bias` (3 values). Missing keys keep their identity/zero default value.
+ *
+ * \param filename the path of the calibration file
+ * \param calib the loaded calibration model
+ * \return true if the file has been correctly parsed
+ */
+SL_OC_EXPORT bool loadImuCalibration( const std::string& filename, data::ImuCalibration& calib );
+
+/*!
+ * \brief Save an IMU calibration model to file, in the format read by \ref loadImuCalibration
+ * \param filename the path of the calibration file
+ * \param calib the calibration model to be saved
+ * \return true if the file has been correctly written
+ */
+SL_OC_EXPORT bool saveImuCalibration( const std::string& filename, const data::ImuCalibration& calib );
+
+/*!
+ * \brief The SensorConverter class converts RAW MCU sensor packets to physical units
+ *
+ * Scale factors depending on the firmware version are resolved once when the firmware version is set, so the
+ * conversion loops are free of per-sample branches. IMU packets are converted in batches to struct-of-arrays
+ * buffers using SIMD instructions when available (SSE2 on x86, NEON on ARM).
+ *
+ * The optional IMU calibration model is folded into the same affine transform as the datasheet scale, so calibrated
+ * data are produced at no extra cost.
+ */
+class SL_OC_EXPORT SensorConverter
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param fw_version the firmware version of the MCU, as returned by the USB descriptor. Use `-1` if unknown.
+     */
+    SensorConverter( int fw_version=-1 );
+
+    /*!
+     * \brief Resolve the scale factors for the given firmware version
+     * \param fw_version the firmware version of the MCU, as returned by the USB descriptor
+     */
+    void setFirmwareVersion( int fw_version );
+
+    /*!
+     * \brief Set the IMU calibration model applied to the converted IMU data
+     * \param calib the calibration model
+     */
+    void setImuCalibration( const data::ImuCalibration& calib );
+
+    /*!
+     * \brief Get the IMU calibration model applied to the converted IMU data
+     * \return the current calibration model
+     */
+    inline const data::ImuCalibration& getImuCalibration() const {return mImuCalib;}
+
+    /*!
+     * \brief Set the temperature dependent bias model applied by \ref compensateThermalBias
+     * \param coeffs the bias model coefficients
+     */
+    void setThermalCompensation( const data::ImuThermalCoeffs& coeffs );
+
+    /*!
+     * \brief Get the temperature dependent bias model
+     * \return the bias model coefficients
+     */
+    inline const data::ImuThermalCoeffs& getThermalCompensation() const {return mThermal;}
+
+    /*!
+     * \brief Subtract in place the temperature dependent biases from converted IMU data
+     * \param batch the batch of converted IMU data
+     * \param offset index of the first sample to be compensated
+     * \param count number of samples to be compensated
+     * \return the number of compensated samples, 0 if the compensation is disabled
+     */
+    size_t compensateThermalBias( data::ImuBatch& batch, size_t offset, size_t count ) const;
+
+    /*!
+     * \brief Convert an array of RAW sensor packets to IMU data
+     * \param raw pointer to the first RAW packet
+     * \param count number of RAW packets to be converted
+     * \param out the destination batch. It is resized to contain `offset+count` samples.
+     * \param offset index of the first sample to be written in the destination batch
+     * \return the number of converted samples
+     */
+    size_t convertImu( const usb::RawData* raw, size_t count, data::ImuBatch& out, size_t offset=0 ) const;
+
+    /*!
+     * \brief Convert a RAW MCU timestamp to nanoseconds
+     * \param raw_ts the RAW timestamp [usec/39]
+     * \return the timestamp in nanoseconds
+     */
+    static uint64_t convertTimestamp( uint64_t raw_ts );
+
+    inline float getPressureScale() const {return mPressScale;}    //!< Pressure scale for the current firmware
+    inline float getHumidityScale() const {return mHumidScale;}    //!< Humidity scale for the current firmware
+
+private:
+    void updateImuAffine();         //!< Compose datasheet scale and calibration model into the affine transforms
+
+private:
+    data::ImuCalibration mImuCalib; //!< IMU calibration model
+
+    float mAccAffine[12];           //!< Accelerometer conversion as row-major 3x4 affine matrix
+    float mGyroAffine[12];          //!< Gyroscope conversion as row-major 3x4 affine matrix
+
+    data::ImuThermalCoeffs mThermal;    //!< Temperature dependent bias model
+
+    float mPressScale = PRESS_SCALE_OLD;    //!< Pressure scale resolved from the firmware version
+    float mHumidScale = HUMID_SCALE_OLD;    //!< Humidity scale resolved from the firmware version
+};
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+#endif // SENSORCONVERSION_HPP
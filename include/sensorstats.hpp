@@ -0,0 +1,222 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef SENSORSTATS_HPP
+#define SENSORSTATS_HPP
+
+#include "defines.hpp"
+
+#include <vector>
+#include <string>
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace sensors {
+
+/*!
+ * \brief The LatencyHistogram class accumulates time values in fixed width bins
+ *
+ * Values outside the histogram range are counted in the underflow/overflow counters. Minimum, maximum and mean
+ * values are exact, percentiles are resolved to the bin width.
+ */
+class SL_OC_EXPORT LatencyHistogram
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param lower_bound lower bound of the first bin [usec]
+     * \param bin_width width of each bin [usec]
+     * \param bin_count number of bins
+     */
+    LatencyHistogram( int64_t lower_bound=0, int64_t bin_width=50, size_t bin_count=200 );
+
+    /*!
+     * \brief Add a value to the histogram
+     * \param value the value to be added [usec]
+     */
+    void add( int64_t value );
+
+    /*!
+     * \brief Remove all the accumulated values
+     */
+    void reset();
+
+    /*!
+     * \brief Get the value below which the given percentage of the accumulated values falls
+     * \param percent the requested percentage [0,100]
+     * \return the upper edge of the bin containing the percentile [usec]. The exact minimum or maximum value is
+     *         returned if the percentile falls in the underflow or overflow counters.
+     */
+    int64_t getPercentile( double percent ) const;
+
+    /*!
+     * \brief Get a printable summary of the histogram
+     * \return count, min, mean, max and the main percentiles
+     */
+    std::string toString() const;
+
+    inline uint64_t getCount() const {return mCount;}                   //!< Number of accumulated values
+    inline int64_t getMin() const {return mMin;}                        //!< Minimum accumulated value [usec]
+    inline int64_t getMax() const {return mMax;}                        //!< Maximum accumulated value [usec]
+    inline double getMean() const {return mCount?mSum/mCount:0.0;}      //!< Mean of the accumulated values [usec]
+    inline int64_t getLowerBound() const {return mLowerBound;}          //!< Lower bound of the first bin [usec]
+    inline int64_t getBinWidth() const {return mBinWidth;}              //!< Width of each bin [usec]
+    inline const std::vector<uint64_t>& getBins() const {return mBins;} //!< Counters of the bins
+    inline uint64_t getUnderflow() const {return mUnderflow;}           //!< Number of values below the first bin
+    inline uint64_t getOverflow() const {return mOverflow;}             //!< Number of values above the last bin
+
+private:
+    int64_t mLowerBound;                //!< Lower bound of the first bin [usec]
+    int64_t mBinWidth;                  //!< Width of each bin [usec]
+    std::vector<uint64_t> mBins;        //!< Counters of the bins
+
+    uint64_t mCount = 0;                //!< Number of accumulated values
+    uint64_t mUnderflow = 0;            //!< Number of values below the first bin
+    uint64_t mOverflow = 0;             //!< Number of values above the last bin
+    int64_t mMin = 0;                   //!< Minimum accumulated value
+    int64_t mMax = 0;                   //!< Maximum accumulated value
+    double mSum = 0.0;                  //!< Sum of the accumulated values
+};
+
+/*!
+ * \brief The LatencyReference class estimates the reference of the transport latency of the sensor packets, following
+ *        the drift of the MCU clock
+ *
+ * The offset between the host receive time and the MCU time of a packet is the transport time plus a constant, plus
+ * the drift of the MCU clock accumulated since the first packet. The minimum offset of each time window is a sample
+ * of the minimum transport time: the reference is the line fitted to the last window minima, lowered to pass below
+ * all of them, and extrapolated to each new packet. Until two windows are complete the reference is the minimum
+ * offset received.
+ */
+class SL_OC_EXPORT LatencyReference
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param window_nsec length of the windows [nsec]
+     * \param window_count number of window minima used to fit the drift, at least 2
+     */
+    LatencyReference( int64_t window_nsec = 1000000000, size_t window_count = 8 );
+
+    /*!
+     * \brief Forget the offsets received, e.g. when the MCU timestamp restarts
+     */
+    void reset();
+
+    /*!
+     * \brief Add the offset of a new packet
+     * \param host_ts the host receive time of the packet [nsec]
+     * \param offset the host receive time minus the MCU time of the packet [nsec]
+     * \return the latency of the packet respect to the reference [nsec], 0 if the packet is faster than the reference
+     */
+    int64_t update( int64_t host_ts, int64_t offset );
+
+    /*!
+     * \brief Get the estimated drift of the offsets
+     * \return the slope of the reference [ppm], 0 until two windows are complete
+     */
+    inline double getDriftPpm() const {return mSlope*1e6;}
+
+private:
+    struct Minimum
+    {
+        int64_t ts;                     //!< Host receive time of the packet with the minimum offset [nsec]
+        int64_t offset;                 //!< Minimum offset of the window [nsec]
+    };
+
+    void fit();                         //!< Fit the reference to the window minima
+
+    int64_t mWindow;                    //!< Length of the windows [nsec]
+    std::vector<Minimum> mMinima;       //!< Minima of the last complete windows, circular buffer
+    size_t mMinPos = 0;                 //!< Index of the next minimum to be written
+    size_t mMinFill = 0;                //!< Number of valid minima
+
+    bool mValid = false;                //!< Indicates that the current window has been started
+    int64_t mWinStart = 0;              //!< Host time of the first packet of the current window [nsec]
+    Minimum mWinMin = {0,0};            //!< Minimum offset of the current window
+    int64_t mRunMin = 0;                //!< Minimum offset received, used until the drift is fitted [nsec]
+
+    int64_t mFitTs = 0;                 //!< Host time of the fitted reference point [nsec]
+    double mFitOffset = 0.0;            //!< Reference offset at `mFitTs` [nsec]
+    double mSlope = 0.0;                //!< Drift of the reference [nsec/nsec]
+};
+
+namespace data {
+
+/*!
+ * \brief Contains the latency statistics of the sensor data path
+ */
+struct SL_OC_EXPORT SensorLatencyStats
+{
+    /*!
+     * \brief Transport latency: steady host receive time minus the MCU time [usec]
+     *
+     * The MCU clock has no absolute host reference (the MCU timestamps are aligned to the host clock when the first
+     * packet is received), so the latency is measured relative to the minimum transport time, estimated by a
+     * \ref LatencyReference since the last reset or the last MCU timestamp restart. The histogram describes the
+     * latency added to the minimum transport time, which is the value needed to size the buffers of a fusion algorithm.
+     *
+     * The MCU time is corrected for the clock drift only while the sensors are synchronized to the video. Without
+     * video the drift of the MCU crystal (tens of ppm) moves the offset between the two clocks by tens of microseconds
+     * per second: the reference follows it, so the drift does not accumulate in the histogram. The offsets applied to
+     * synchronize the sensors to the video do not affect it.
+     */
+    LatencyHistogram transport = LatencyHistogram(0,50,200);
+
+    /*!
+     * \brief Inter-arrival jitter: host inter-arrival time minus the MCU sampling interval [usec]. The MCU clock drift
+     *        adds less than 1 usec to each value.
+     */
+    LatencyHistogram jitter = LatencyHistogram(-5000,50,200);
+
+    /*!
+     * \brief Processing time: time elapsed from the `hid_read_timeout` return to the IMU data publication [usec]
+     */
+    LatencyHistogram processing = LatencyHistogram(0,1,200);
+};
+
+/*!
+ * \brief Contains the counters of the sensor packets received from the MCU
+ *
+ * Lost packets are detected from the MCU timestamp spacing, so packets lost while the data stream is stopped are
+ * not counted.
+ */
+struct SL_OC_EXPORT SensorPacketStats
+{
+    uint64_t received = 0;      //!< Number of valid packets processed
+    uint64_t lost = 0;          //!< Number of packets missing in the MCU timestamp sequence
+    uint64_t gaps = 0;          //!< Number of sequence gaps, each one containing one or more lost packets
+    uint64_t duplicated = 0;    //!< Number of packets discarded because received twice
+    uint64_t out_of_order = 0;  //!< Number of packets discarded because older than the previous one
+    uint64_t short_reads = 0;   //!< Number of incomplete USB reports
+    uint64_t invalid = 0;       //!< Number of USB reports with a wrong report ID
+};
+
+}
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+#endif // SENSORSTATS_HPP
@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef STANDSTILLDETECTOR_HPP
+#define STANDSTILLDETECTOR_HPP
+
+#include "defines.hpp"
+
+#include <vector>
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace sensors {
+
+namespace data {
+
+/*!
+ * \brief Contains the gyroscope bias estimated while the camera is still
+ */
+struct SL_OC_EXPORT GyroBias
+{
+    bool valid = false;         //!< Indicates if the bias has been estimated
+    uint64_t timestamp = 0;     //!< Timestamp of the last update in nanoseconds
+    float bX = 0.0f;            //!< Bias around X axis in °/s
+    float bY = 0.0f;            //!< Bias around Y axis in °/s
+    float bZ = 0.0f;            //!< Bias around Z axis in °/s
+    uint64_t samples = 0;       //!< Number of still samples used for the estimation
+};
+
+}
+
+/*!
+ * \brief Parameters of the standstill detector
+ */
+struct SL_OC_EXPORT StandstillParams
+{
+    int window = 100;               //!< Length of the sliding window [samples], 0.25 sec @ 400 Hz
+    float acc_std_max = 0.05f;      //!< Maximum standard deviation of each accelerometer axis in the window [m/s²]
+    float gyro_max = 1.0f;          //!< Maximum angular velocity magnitude in the window, bias removed [°/s]. Increased by `max_bias` until the first bias estimate.
+    bool use_motion_flag = true;    //!< The camera is not still when the IMU hardware reports motion
+    float bias_time_const = 60.0f;  //!< Time constant of the running bias average [sec], to follow the thermal drift
+    float max_bias = 5.0f;          //!< Maximum absolute value of the estimated bias for each axis [°/s]
+};
+
+/*!
+ * \brief The StandstillDetector class detects when the camera is still and estimates the gyroscope bias meanwhile
+ *
+ * The camera is still when, over the whole sliding window, the standard deviation of each accelerometer axis and
+ * the angular velocity magnitude are below their thresholds and the IMU hardware does not report motion.
+ * While still, the angular velocity measures the gyroscope bias: the estimate is the cumulative average of the still
+ * samples, turning into an exponential average with the configured time constant.
+ */
+class SL_OC_EXPORT StandstillDetector
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param params the detector parameters
+     */
+    StandstillDetector( const StandstillParams& params = StandstillParams() );
+
+    /*!
+     * \brief Set new parameters and reset the detector. The bias estimate is kept.
+     * \param params the detector parameters
+     */
+    void setParams( const StandstillParams& params );
+
+    /*!
+     * \brief Empty the sliding window. The bias estimate is kept.
+     */
+    void reset();
+
+    /*!
+     * \brief Add a new IMU sample
+     * \param timestamp the timestamp of the sample in nanoseconds
+     * \param aX,aY,aZ the accelerations [m/s²]
+     * \param gX,gY,gZ the angular velocities [°/s], bias not removed
+     * \param hw_moving the camera moving flag reported by the IMU hardware
+     * \return true if the camera is still
+     */
+    bool update( uint64_t timestamp, float aX, float aY, float aZ, float gX, float gY, float gZ, bool hw_moving );
+
+    /*!
+     * \brief Check if the camera is still
+     * \return true if the camera was still at the last update
+     */
+    inline bool isStill() const {return mStill;}
+
+    /*!
+     * \brief Get the current gyroscope bias estimate
+     * \return the bias estimate
+     */
+    inline const data::GyroBias& getBias() const {return mBias;}
+
+    /*!
+     * \brief Set the gyroscope bias estimate, for example an estimate saved by a previous session
+     * \param bias the bias estimate
+     */
+    inline void setBias( const data::GyroBias& bias ) {mBias = bias;}
+
+private:
+    struct Sample
+    {
+        float acc[3];                   //!< Accelerations [m/s²]
+        bool moving;                    //!< Angular velocity above threshold or hardware motion flag
+    };
+
+    StandstillParams mParams;           //!< The detector parameters
+
+    std::vector<Sample> mWindow;        //!< Sliding window
+    int mPos = 0;                       //!< Index of the oldest sample in the window
+    int mFill = 0;                      //!< Number of samples in the window
+    double mAccSum[3] = {0.0,0.0,0.0};  //!< Sum of the accelerations in the window
+    double mAccSumSq[3] = {0.0,0.0,0.0}; //!< Sum of the squared accelerations in the window
+    int mMovingCount = 0;               //!< Number of moving samples in the window
+    uint64_t mLastTs = 0;               //!< Timestamp of the previous sample
+
+    bool mStill = false;                //!< Current standstill status
+    data::GyroBias mBias;               //!< Gyroscope bias estimate
+};
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+#endif // STANDSTILLDETECTOR_HPP
@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef STEREOCALIBRATION_HPP
+#define STEREOCALIBRATION_HPP
+
+#include "defines.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+#include "videocapture_def.hpp"
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief Intrinsic parameters of a camera sensor, with the coefficients of the radial-tangential distortion model
+ */
+struct SL_OC_EXPORT CameraIntrinsics
+{
+    double fx = 0.0;    //!< Focal length along X, in pixels
+    double fy = 0.0;    //!< Focal length along Y, in pixels
+    double cx = 0.0;    //!< Principal point X coordinate, in pixels
+    double cy = 0.0;    //!< Principal point Y coordinate, in pixels
+    double k1 = 0.0;    //!< First radial distortion coefficient
+    double k2 = 0.0;    //!< Second radial distortion coefficient
+    double p1 = 0.0;    //!< First tangential distortion coefficient
+    double p2 = 0.0;    //!< Second tangential distortion coefficient
+    double k3 = 0.0;    //!< Third radial distortion coefficient
+};
+
+/*!
+ * \brief Calibration of a stereo camera at a given resolution
+ */
+struct SL_OC_EXPORT StereoCameraParams
+{
+    bool valid = false;         //!< Indicates that the parameters have been read and validated
+    int width = 0;              //!< Width of each image, in pixels
+    int height = 0;             //!< Height of each image, in pixels
+    CameraIntrinsics left;      //!< Left camera intrinsics
+    CameraIntrinsics right;     //!< Right camera intrinsics
+    double baseline = 0.0;      //!< Translation of the right camera along X, in millimeters
+    double ty = 0.0;            //!< Translation of the right camera along Y, in millimeters
+    double tz = 0.0;            //!< Translation of the right camera along Z, in millimeters
+    double rx = 0.0;            //!< Rotation vector of the right camera, X component (radians)
+    double ry = 0.0;            //!< Rotation vector of the right camera, Y component (radians), `CV` in the file
+    double rz = 0.0;            //!< Rotation vector of the right camera, Z component (radians)
+};
+
+/*!
+ * \brief The StereoCalibration class parses the factory calibration file of a stereo camera (`SN<serial>.conf`)
+ *
+ * The file is parsed once, in a single pass, for all the resolutions. Numbers are read independently of the C locale.
+ * The parameters of each resolution are validated: missing or out of range values mark the resolution as not valid
+ * instead of stopping the application.
+ *
+ * The parsed calibration can be serialized in a compact binary format, to be loaded in a few microseconds.
+ */
+class SL_OC_EXPORT StereoCalibration
+{
+public:
+    static const int RESOLUTION_COUNT = 4;  //!< Number of \ref RESOLUTION values
+
+    /*!
+     * \brief Parse the content of a calibration file
+     * \param data the content of the calibration file
+     * \param error if not null, the description of the invalid resolutions
+     * \return true if at least one resolution is valid
+     */
+    bool parse( const std::string& data, std::string* error = nullptr );
+
+    /*!
+     * \brief Read and parse a calibration file
+     * \param filename the path of the calibration file
+     * \param error if not null, the description of the error
+     * \return true if at least one resolution is valid
+     */
+    bool load( const std::string& filename, std::string* error = nullptr );
+
+    /*!
+     * \brief Serialize the calibration in binary format
+     * \param buffer the destination buffer
+     */
+    void toBinary( std::vector<uint8_t>& buffer ) const;
+
+    /*!
+     * \brief Load a calibration serialized with \ref toBinary
+     * \param data the binary data
+     * \param size the size of the data in bytes
+     * \return false if the data is not a valid serialized calibration
+     */
+    bool fromBinary( const uint8_t* data, size_t size );
+
+    /*!
+     * \brief Save the calibration in binary format
+     * \param filename the path of the binary file
+     * \return false if the file cannot be written
+     */
+    bool saveBinary( const std::string& filename ) const;
+
+    /*!
+     * \brief Load a calibration saved with \ref saveBinary
+     * \param filename the path of the binary file
+     * \return false if the file cannot be read or it is not valid
+     */
+    bool loadBinary( const std::string& filename );
+
+    /*!
+     * \brief Check if the calibration of a resolution is available
+     * \param res the camera resolution
+     * \return true if the parameters of the resolution are valid
+     */
+    bool isValid( RESOLUTION res ) const;
+
+    /*!
+     * \brief Get the calibration of a resolution
+     * \param res the camera resolution
+     * \return the parameters of the resolution. Check `valid` before using them.
+     */
+    const StereoCameraParams& getParams( RESOLUTION res ) const;
+
+    /*!
+     * \brief Get the hash of the parsed calibration file
+     * \return the 64 bit FNV-1a hash of the file content, the same value of \ref RectMapCache::hashFile
+     */
+    inline uint64_t getHash() const {return mHash;}
+
+private:
+    static bool validate( StereoCameraParams& params, std::string& error );
+
+    StereoCameraParams mParams[RESOLUTION_COUNT];   //!< Parameters indexed by \ref RESOLUTION
+    uint64_t mHash = 0;                             //!< Hash of the calibration file content
+};
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
+
+#endif // STEREOCALIBRATION_HPP
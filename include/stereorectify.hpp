@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef STEREORECTIFY_HPP
+#define STEREORECTIFY_HPP
+
+#include "defines.hpp"
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+#include "stereocalibration.hpp"
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief Rectification of a stereo camera, as computed by `cv::stereoRectify` with `cv::CALIB_ZERO_DISPARITY` and
+ *        `alpha=0`
+ */
+struct SL_OC_EXPORT RectificationParams
+{
+    int width = 0;          //!< Width of the rectified images, in pixels
+    int height = 0;         //!< Height of the rectified images, in pixels
+    double R_left[9];       //!< Rectification rotation of the left camera, row-major 3x3
+    double R_right[9];      //!< Rectification rotation of the right camera, row-major 3x3
+    double P_left[12];      //!< Projection matrix of the left rectified camera, row-major 3x4
+    double P_right[12];     //!< Projection matrix of the right rectified camera, row-major 3x4
+};
+
+/*!
+ * \brief The StereoRectify class computes the rectification of a stereo camera and its undistortion maps without
+ *        OpenCV
+ *
+ * The computation follows `cv::stereoRectify` and `cv::initUndistortRectifyMap` with the 5 coefficients
+ * radial-tangential distortion model, so that the rectified images and the projection matrices are the same of the
+ * OpenCV examples. The results have been checked against OpenCV 5.0: older OpenCV releases compute a slightly
+ * different focal length and principal point for the rectified cameras.
+ */
+class SL_OC_EXPORT StereoRectify
+{
+public:
+    /*!
+     * \brief Compute the rectification of a stereo camera, keeping only valid pixels in the rectified images
+     * \param calib the calibration of the camera at the image resolution
+     * \param rect the rectification, for rectified images of the same size of the source images
+     * \return false if the calibration is not valid
+     */
+    static bool compute( const StereoCameraParams& calib, RectificationParams& rect );
+
+    /*!
+     * \brief Scale a rectification to produce rectified images of a different size, e.g. at half resolution for
+     *        stereo matching, with the maps computed by \ref computeMap directly at the target size
+     * \param rect the rectification to scale
+     * \param scale the scale factor of the rectified images, the size is rounded to the nearest pixel
+     * \param scaled the scaled rectification, it can be `rect`
+     * \return false if the scale factor is not valid
+     * \note The pixel centers are aligned: at half resolution each rectified pixel covers 2x2 pixels of the full size
+     *       rectified image.
+     */
+    static bool scale( const RectificationParams& rect, double scale, RectificationParams& scaled );
+
+    /*!
+     * \brief Compute the undistortion and rectification map of a camera, as `cv::initUndistortRectifyMap` with
+     *        `CV_32FC1` maps
+     * \param cam the intrinsic parameters of the camera
+     * \param R the rectification rotation, row-major 3x3
+     * \param P the projection matrix of the rectified camera, row-major 3x4
+     * \param width the width of the rectified image
+     * \param row_begin the first row to compute
+     * \param row_end the row after the last row to compute
+     * \param map_x,map_y the maps of the whole image, `width` values per row. Only the rows in
+     *        `[row_begin,row_end)` are written, so that the map can be computed by parallel tasks.
+     */
+    static void computeMap( const CameraIntrinsics& cam, const double R[9], const double P[12], int width,
+                            int row_begin, int row_end, float* map_x, float* map_y );
+
+    /*!
+     * \brief Compute the transformation from the rectified pixels to the normalized coordinates of the source camera
+     * \param R the rectification rotation, row-major 3x3
+     * \param P the projection matrix of the rectified camera, row-major 3x4
+     * \param iKR the inverse of the 3x3 left block of `P` multiplied by `R`, row-major 3x3
+     * \return false if the matrix is singular
+     */
+    static bool invertProjection( const double R[9], const double P[12], double iKR[9] );
+
+    /*!
+     * \brief Remove the distortion of a point and project it on a rectified camera, as `cv::undistortPoints`
+     * \param cam the intrinsic parameters of the camera
+     * \param R the rectification rotation, row-major 3x3, null for identity
+     * \param P the projection matrix of the rectified camera, row-major 3x3 or 3x4 with `P_step` values per row. If
+     *        null the normalized coordinates are returned.
+     * \param P_step the number of values of each row of `P`
+     * \param x,y the coordinates of the distorted point, replaced by the rectified coordinates
+     * \param iterations the number of fixed-point iterations inverting the distortion. The default is the same of
+     *        OpenCV, more iterations improve the accuracy close to the image corners.
+     */
+    static void undistortPoint( const CameraIntrinsics& cam, const double R[9], const double* P, int P_step,
+                                double& x, double& y, int iterations = 5 );
+
+    /*!
+     * \brief Convert a rotation vector to a rotation matrix, as `cv::Rodrigues`
+     * \param rvec the rotation vector, in radians
+     * \param R the rotation matrix, row-major 3x3
+     */
+    static void rodrigues( const double rvec[3], double R[9] );
+};
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
+
+#endif // STEREORECTIFY_HPP
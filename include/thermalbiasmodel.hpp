@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef THERMALBIASMODEL_HPP
+#define THERMALBIASMODEL_HPP
+
+#include "defines.hpp"
+
+#include <string>
+#include <vector>
+
+#ifdef SENSORS_MOD_AVAILABLE
+
+#include "sensorconversion.hpp"
+
+namespace sl_oc {
+
+namespace sensors {
+
+/*!
+ * \brief Parameters of the temperature dependent bias model
+ */
+struct SL_OC_EXPORT ThermalBiasParams
+{
+    int order = 2;                  //!< Order of the bias polynomials (max \ref data::ImuThermalCoeffs::MAX_ORDER)
+    float ref_temp = 25.0f;         //!< Reference temperature of the model [°C]
+    int block_size = 400;           //!< Number of samples averaged for each model update (1 sec @ 400 Hz)
+    float gyro_std_max = 0.3f;      //!< Maximum standard deviation of the gyroscope data in a still block [°/s]
+    float acc_std_max = 0.05f;      //!< Maximum standard deviation of the accelerometer data in a still block [m/s²]
+    double forgetting = 0.9999;     //!< RLS forgetting factor applied for each block
+    int min_blocks = 30;            //!< Number of blocks required before the model is applied
+};
+
+/*!
+ * \brief The ThermalBiasModel class learns online the IMU biases as polynomial functions of the IMU temperature
+ *
+ * Samples acquired while the camera is still are averaged in blocks, and each block updates the polynomial
+ * coefficients with a recursive least squares (RLS) estimator. All the axes share the same regressor, so a single
+ * covariance matrix is used for the three gyroscope axes and a single one for the three accelerometer axes.
+ *
+ * While still, the gyroscope measures its own bias, so the full polynomial is estimated. The accelerometer measures
+ * the gravity too: only its variation with the temperature is observable, comparing the blocks of the same still
+ * period. The constant term of the accelerometer model is therefore zero and the accelerometer bias at the reference
+ * temperature must be handled by the IMU intrinsic calibration.
+ */
+class SL_OC_EXPORT ThermalBiasModel
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param params the model parameters
+     */
+    ThermalBiasModel( const ThermalBiasParams& params = ThermalBiasParams() );
+
+    /*!
+     * \brief Reset the learned coefficients
+     */
+    void reset();
+
+    /*!
+     * \brief Add a new IMU sample
+     * \param temp the IMU temperature [°C]
+     * \param gX,gY,gZ the angular velocity [°/s], not compensated with the model
+     * \param aX,aY,aZ the acceleration [m/s²], not compensated with the model
+     * \param still true if the camera is not moving
+     * \return true if the coefficients have been updated
+     */
+    bool addSample( float temp, float gX, float gY, float gZ, float aX, float aY, float aZ, bool still );
+
+    /*!
+     * \brief Get the coefficients of the model, enabled once enough blocks have been processed
+     * \return the model coefficients
+     */
+    data::ImuThermalCoeffs getCoefficients() const;
+
+    /*!
+     * \brief Save the model state (coefficients and covariances) to file
+     * \param filename the path of the destination file
+     * \return true if the file has been correctly written
+     */
+    bool saveToFile( const std::string& filename ) const;
+
+    /*!
+     * \brief Load the model state from file, to continue learning from a previous session
+     * \param filename the path of the model file
+     * \return false if the file cannot be read or if it has been saved with a different polynomial order
+     */
+    bool loadFromFile( const std::string& filename );
+
+    inline const ThermalBiasParams& getParams() const {return mParams;}   //!< The model parameters
+    inline uint64_t getBlockCount() const {return mBlocks;}               //!< Number of blocks used to fit the model
+
+private:
+    /*!
+     * \brief Recursive least squares estimator with three outputs sharing the same regressor
+     */
+    struct Rls
+    {
+        int n = 0;                      //!< Number of coefficients
+        std::vector<double> P;          //!< Covariance matrix [n x n]
+        std::vector<double> theta[3];   //!< Coefficients for each output
+
+        void init( int size );
+        void update( const double* phi, const double* y, double lambda );
+    };
+
+    void processBlock();                //!< Update the model with the accumulated block
+
+    ThermalBiasParams mParams;          //!< The model parameters
+
+    Rls mGyroRls;                       //!< Gyroscope coefficients [c0..cN]
+    Rls mAccRls;                        //!< Accelerometer coefficients [c1..cN]
+
+    uint64_t mBlocks = 0;               //!< Number of processed blocks
+    float mTempMin = 0.0f;              //!< Minimum temperature of the processed blocks [°C]
+    float mTempMax = 0.0f;              //!< Maximum temperature of the processed blocks [°C]
+
+    // ----> Block accumulator
+    int mBlockCount = 0;                //!< Number of samples in the current block
+    double mSumT = 0.0;                 //!< Sum of the temperatures
+    double mSum[6] = {};                //!< Sum of the gyroscope and accelerometer values
+    double mSumSq[6] = {};              //!< Sum of the squared gyroscope and accelerometer values
+    // <---- Block accumulator
+
+    // ----> Still period reference for the accelerometer
+    bool mSegValid = false;             //!< Indicates if a reference block is available for the current still period
+    double mSegT = 0.0;                 //!< Normalized temperature of the reference block
+    double mSegAcc[3] = {};             //!< Mean accelerations of the reference block
+    // <---- Still period reference for the accelerometer
+};
+
+}
+
+}
+
+#endif // SENSORS_MOD_AVAILABLE
+
+#endif // THERMALBIASMODEL_HPP
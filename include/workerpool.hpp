@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef WORKERPOOL_HPP
+#define WORKERPOOL_HPP
+
+#include "defines.hpp"
+
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+#ifdef VIDEO_MOD_AVAILABLE
+
+namespace sl_oc {
+
+namespace video {
+
+/*!
+ * \brief The WorkerPool class runs data parallel image processing tasks on a fixed set of threads
+ *
+ * The threads are created once and sleep between two jobs, so a job can be dispatched for each frame without the
+ * cost of creating threads. The calling thread takes part to the job.
+ *
+ * The tasks are split in contiguous ranges, one for each thread, so that each thread processes neighbouring tasks
+ * in order. A thread that completes its range steals the second half of the range of another thread.
+ */
+class SL_OC_EXPORT WorkerPool
+{
+public:
+    /*!
+     * \brief The default constructor
+     * \param thread_count number of threads running the jobs, including the calling thread. If 0 the number of
+     *        hardware threads is used.
+     */
+    explicit WorkerPool( size_t thread_count = 0 );
+
+    /*!
+     * \brief The class destructor, stops the threads
+     */
+    ~WorkerPool();
+
+    WorkerPool( const WorkerPool& ) = delete;
+    WorkerPool& operator=( const WorkerPool& ) = delete;
+
+    /*!
+     * \brief Get the number of threads running the jobs, including the calling thread
+     * \return the number of threads
+     */
+    inline size_t getThreadCount() const {return mThreads.size()+1;}
+
+    /*!
+     * \brief Run `task(i)` for each `i` in `[0,count)` and wait for the completion. The tasks are balanced between
+     *        the threads by work stealing, so they can have different durations.
+     * \param count the number of tasks, less than 2^32
+     * \param task the task function. It must be thread safe.
+     * \note Jobs submitted concurrently by different threads are serialized
+     */
+    void parallelFor( size_t count, const std::function<void(size_t)>& task );
+
+private:
+    /*!
+     * \brief Range of tasks owned by a thread, begin in the low 32 bits and end in the high 32 bits. The owner takes
+     *        the tasks from the beginning, the other threads steal them from the end.
+     */
+    struct TaskRange
+    {
+        std::atomic<uint64_t> range{0};
+        char padding[64-sizeof(std::atomic<uint64_t>)]; //!< Avoids false sharing between the threads
+    };
+
+    void workerFunc( size_t slot );     //!< The worker thread function
+    void runTasks( size_t slot );       //!< Run the tasks of the current job until there are none left
+    bool popTask( size_t slot, size_t& task );      //!< Take the first task of the own range
+    bool stealTasks( size_t slot, size_t& task );   //!< Move half of the range of another thread to the own range
+
+    std::vector<std::thread> mThreads;  //!< The worker threads
+
+    std::mutex mJobMutex;               //!< Serializes the jobs
+    std::mutex mMutex;                  //!< Protects the job state
+    std::condition_variable mStartCv;   //!< Signals a new job or the stop request to the workers
+    std::condition_variable mDoneCv;    //!< Signals the completion of the job to the calling thread
+
+    const std::function<void(size_t)>* mTask = nullptr; //!< The task function of the current job
+    std::vector<TaskRange> mRanges;     //!< Task ranges of the calling thread (index 0) and of the workers
+    size_t mBusy = 0;                   //!< Number of workers running the current job
+    uint64_t mGeneration = 0;           //!< Incremented for each new job
+    bool mStop = false;                 //!< Indicates that the workers must exit
+};
+
+}
+
+}
+
+#endif // VIDEO_MOD_AVAILABLE
+
+#endif // WORKERPOOL_HPP
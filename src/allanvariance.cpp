@@ -0,0 +1,242 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "allanvariance.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+namespace sl_oc {
+
+namespace sensors {
+
+static const uint64_t MIN_CLUSTERS_EXTREMA = 10;     //!< Minimum number of clusters for a point to be used as curve minimum
+static const uint64_t MIN_CLUSTERS_WHITE = 1000;     //!< Minimum number of clusters for a point to be used in the white noise fit
+
+AllanVariance::AllanVariance( int channels, double sample_period, int octaves, int overlap )
+{
+    mChannels = channels<1?1:channels;
+    mSamplePeriod = sample_period;
+
+    // The overlap must be a power of 2 to keep the strides aligned to the octaves
+    size_t ovr = 1;
+    while( ovr < static_cast<size_t>(overlap<1?1:overlap) )
+        ovr <<= 1;
+
+    mIntegral.resize(mChannels);
+    mOctaves.resize(octaves<1?1:octaves);
+
+    for( size_t k=0; k<mOctaves.size(); k++ )
+    {
+        Octave& oct = mOctaves[k];
+
+        uint64_t m = 1ULL<<k;
+        uint64_t stride = m>ovr?m/ovr:1;
+
+        oct.stride_mask = stride-1;
+        oct.lag = static_cast<size_t>(m/stride);
+        oct.ring_size = 2*oct.lag+1;
+        oct.ring.resize(oct.ring_size*mChannels);
+        oct.sum.resize(mChannels);
+    }
+
+    reset();
+}
+
+void AllanVariance::reset()
+{
+    mSampleCount = 0;
+    std::fill(mIntegral.begin(), mIntegral.end(), 0.0);
+
+    for( Octave& oct : mOctaves )
+    {
+        oct.count = 0;
+        std::fill(oct.sum.begin(), oct.sum.end(), 0.0);
+
+        // The first entry is the initial value of the integrated signal
+        std::fill(oct.ring.begin(), oct.ring.begin()+mChannels, 0.0);
+        oct.head = 1;
+        oct.filled = 1;
+    }
+}
+
+void AllanVariance::addSample( const double* values )
+{
+    for( int c=0; c<mChannels; c++ )
+        mIntegral[c] += values[c];
+
+    mSampleCount++;
+
+    for( Octave& oct : mOctaves )
+    {
+        // Octaves are sorted by increasing stride: if this one is not sampled, the following are not either
+        if( (mSampleCount & oct.stride_mask) != 0 )
+            break;
+
+        double* cur = &oct.ring[oct.head*mChannels];
+        for( int c=0; c<mChannels; c++ )
+            cur[c] = mIntegral[c];
+
+        if( oct.filled < oct.ring_size )
+            oct.filled++;
+
+        if( oct.filled == oct.ring_size )
+        {
+            size_t idx_1 = (oct.head+oct.ring_size-oct.lag)%oct.ring_size;
+            size_t idx_2 = (oct.head+1)%oct.ring_size; // The oldest entry is 2*lag entries behind the head
+            const double* th_1 = &oct.ring[idx_1*mChannels];
+            const double* th_2 = &oct.ring[idx_2*mChannels];
+
+            for( int c=0; c<mChannels; c++ )
+            {
+                double d = cur[c] - 2.0*th_1[c] + th_2[c];
+                oct.sum[c] += d*d;
+            }
+            oct.count++;
+        }
+
+        oct.head = (oct.head+1)%oct.ring_size;
+    }
+}
+
+std::vector<AllanPoint> AllanVariance::getCurve( int channel ) const
+{
+    std::vector<AllanPoint> curve;
+
+    if( channel<0 || channel>=mChannels )
+        return curve;
+
+    for( size_t k=0; k<mOctaves.size(); k++ )
+    {
+        const Octave& oct = mOctaves[k];
+        if( oct.count==0 )
+            break;
+
+        // The integrated signal is the sum of the samples: divide by the cluster length to get back to the input units
+        double m = static_cast<double>(1ULL<<k);
+        double avar = oct.sum[channel]/(2.0*m*m*static_cast<double>(oct.count));
+
+        AllanPoint pt;
+        pt.tau = m*mSamplePeriod;
+        pt.adev = std::sqrt(avar);
+        pt.clusters = oct.count;
+        curve.push_back(pt);
+    }
+
+    return curve;
+}
+
+NoiseParams AllanVariance::fitNoiseParams( int channel ) const
+{
+    NoiseParams params;
+
+    std::vector<AllanPoint> curve = getCurve(channel);
+    if( curve.empty() )
+        return params;
+
+    // ----> Bias instability: minimum of the curve
+    size_t min_idx = 0;
+    for( size_t i=1; i<curve.size(); i++ )
+    {
+        if( curve[i].clusters >= MIN_CLUSTERS_EXTREMA && curve[i].adev < curve[min_idx].adev )
+            min_idx = i;
+    }
+    params.bias_instability = curve[min_idx].adev/0.664;
+    params.bias_tau = curve[min_idx].tau;
+    // <---- Bias instability: minimum of the curve
+
+    // ----> White noise: -1/2 slope line fitted in the log domain on the left of the minimum
+    double log_sum = 0.0;
+    int n = 0;
+    for( size_t i=0; i<curve.size(); i++ )
+    {
+        if( i>0 && (curve[i].tau>0.5*curve[min_idx].tau || curve[i].clusters<MIN_CLUSTERS_WHITE) )
+            break;
+
+        log_sum += std::log(curve[i].adev*std::sqrt(curve[i].tau));
+        n++;
+    }
+    params.white_noise = std::exp(log_sum/n);
+    // <---- White noise: -1/2 slope line fitted in the log domain on the left of the minimum
+
+    // ----> Rate random walk: +1/2 slope line fitted in the log domain on the right of the minimum
+    log_sum = 0.0;
+    n = 0;
+    for( size_t i=min_idx+1; i<curve.size(); i++ )
+    {
+        if( curve[i].tau < 2.0*curve[min_idx].tau || curve[i].clusters < MIN_CLUSTERS_EXTREMA )
+            continue;
+        log_sum += std::log(curve[i].adev*std::sqrt(3.0/curve[i].tau));
+        n++;
+    }
+    if( n>0 )
+        params.random_walk = std::exp(log_sum/n);
+    // <---- Rate random walk: +1/2 slope line fitted in the log domain on the right of the minimum
+
+    return params;
+}
+
+bool AllanVariance::saveToFile( const std::string& filename, const std::vector<std::string>& names ) const
+{
+    std::ofstream file(filename);
+    if( !file.is_open() )
+        return false;
+
+    file << std::setprecision(9);
+    file << "# Allan deviation - samples: " << mSampleCount << " - sample period: " << mSamplePeriod << " s" << std::endl;
+
+    // ----> Fitted parameters
+    file << "# channel, white_noise [unit/sqrt(s)], bias_instability [unit], bias_tau [s], random_walk [unit*sqrt(s)]" << std::endl;
+    for( int c=0; c<mChannels; c++ )
+    {
+        NoiseParams par = fitNoiseParams(c);
+        std::string name = c<static_cast<int>(names.size())?names[c]:std::to_string(c);
+        file << "# " << name << ", " << par.white_noise << ", " << par.bias_instability << ", "
+             << par.bias_tau << ", " << par.random_walk << std::endl;
+    }
+    // <---- Fitted parameters
+
+    // ----> Curves
+    file << "tau,clusters";
+    for( int c=0; c<mChannels; c++ )
+        file << "," << (c<static_cast<int>(names.size())?names[c]:std::to_string(c));
+    file << std::endl;
+
+    std::vector<std::vector<AllanPoint>> curves;
+    for( int c=0; c<mChannels; c++ )
+        curves.push_back(getCurve(c));
+
+    for( size_t i=0; i<curves[0].size(); i++ )
+    {
+        file << curves[0][i].tau << "," << curves[0][i].clusters;
+        for( int c=0; c<mChannels; c++ )
+            file << "," << curves[c][i].adev;
+        file << std::endl;
+    }
+    // <---- Curves
+
+    return file.good();
+}
+
+}
+
+}
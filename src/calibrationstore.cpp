@@ -0,0 +1,498 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "calibrationstore.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <dirent.h>           // for opendir, readdir
+#include <sys/stat.h>         // for stat, mkdir
+#include <unistd.h>           // for getpid
+
+namespace sl_oc {
+
+namespace video {
+
+namespace {
+
+const size_t TAR_BLOCK_SIZE = 512;
+
+std::string toDirectory( const std::string& path )
+{
+    if( path.empty() || path.back()=='/' )
+        return path;
+    return path + "/";
+}
+
+bool isFile( const std::string& path )
+{
+    struct stat st;
+    return stat(path.c_str(), &st)==0 && S_ISREG(st.st_mode);
+}
+
+bool makeDirectories( const std::string& path )
+{
+    for( size_t pos=path.find('/', 1); ; pos=path.find('/', pos+1) )
+    {
+        const std::string dir = path.substr(0, pos);
+        if( !dir.empty() && mkdir(dir.c_str(), 0755)!=0 && errno!=EEXIST )
+            return false;
+        if( pos==std::string::npos )
+            return true;
+    }
+}
+
+/*!
+ * \brief Parse an octal number of a tar header field, terminated by a space or a NUL
+ */
+uint64_t parseOctal( const char* field, size_t length )
+{
+    uint64_t value = 0;
+    size_t i = 0;
+    while( i<length && field[i]==' ' )
+        i++;
+    for( ; i<length && field[i]>='0' && field[i]<='7'; i++ )
+        value = value*8 + static_cast<uint64_t>(field[i]-'0');
+    return value;
+}
+
+/*!
+ * \brief Verify the checksum of a tar header, computed with the checksum field filled with spaces
+ */
+bool checkTarHeader( const char* header )
+{
+    const uint64_t expected = parseOctal(header+148, 8);
+
+    uint64_t sum = 0;
+    for( size_t i=0; i<TAR_BLOCK_SIZE; i++ )
+        sum += (i>=148 && i<156) ? static_cast<uint64_t>(' ') : static_cast<uint8_t>(header[i]);
+
+    return sum==expected;
+}
+
+}
+
+CalibrationStore::CalibrationStore()
+{
+    mWritableDir = getDefaultDirectory();
+    addDirectory(mWritableDir);
+}
+
+CalibrationStore::~CalibrationStore()
+{
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mFetchCond.notify_all();
+
+    if( mFetchThread.joinable() )
+        mFetchThread.join();
+
+    // The fetch running when the store is destroyed completes, the queued ones fail
+    for( auto& request : mFetchQueue )
+        request.second->set_value(false);
+}
+
+std::string CalibrationStore::getDefaultDirectory()
+{
+    const char* home = getenv("HOME");
+    return std::string(home?home:".") + "/zed/settings/";
+}
+
+std::string CalibrationStore::getCalibrationFilename( unsigned int serial_number )
+{
+    return "SN" + std::to_string(serial_number) + ".conf";
+}
+
+bool CalibrationStore::parseFilename( const std::string& name, unsigned int& serial_number )
+{
+    // SN<digits>.conf
+    const std::string ext = ".conf";
+    if( name.size()<=2+ext.size() || name.compare(0, 2, "SN")!=0 ||
+            name.compare(name.size()-ext.size(), ext.size(), ext)!=0 )
+        return false;
+
+    const std::string digits = name.substr(2, name.size()-2-ext.size());
+    if( digits.size()>9 || digits.find_first_not_of("0123456789")!=std::string::npos )
+        return false;
+
+    serial_number = static_cast<unsigned int>(std::stoul(digits));
+    return true;
+}
+
+bool CalibrationStore::addDirectory( const std::string& path )
+{
+    Source source;
+    source.path = toDirectory(path);
+    source.archive = false;
+
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    for( const Source& s : mSources )
+    {
+        if( !s.archive && s.path==source.path )
+            return indexDirectory(source.path);
+    }
+
+    // A missing directory is kept in the search list: it is searched again when a camera is not found
+    mSources.push_back(source);
+    return indexDirectory(source.path);
+}
+
+bool CalibrationStore::addArchive( const std::string& path )
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    if( !indexArchive(path) )
+        return false;
+
+    Source source;
+    source.path = path;
+    source.archive = true;
+    mSources.push_back(source);
+    return true;
+}
+
+void CalibrationStore::clear()
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    mSources.clear();
+    mIndex.clear();
+}
+
+void CalibrationStore::rebuildIndex()
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    mIndex.clear();
+    for( const Source& s : mSources )
+    {
+        if( s.archive )
+            indexArchive(s.path);
+        else
+            indexDirectory(s.path);
+    }
+}
+
+void CalibrationStore::setWritableDirectory( const std::string& path )
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    mWritableDir = toDirectory(path);
+}
+
+bool CalibrationStore::indexDirectory( const std::string& path )
+{
+    DIR* dir = opendir(path.c_str());
+    if( !dir )
+        return false;
+
+    for( struct dirent* ent=readdir(dir); ent!=nullptr; ent=readdir(dir) )
+    {
+        unsigned int serial;
+        if( !parseFilename(ent->d_name, serial) || mIndex.count(serial) )
+            continue;
+
+        Entry entry;
+        entry.path = path + ent->d_name;
+        if( isFile(entry.path) )
+            mIndex[serial] = entry;
+    }
+
+    closedir(dir);
+    return true;
+}
+
+bool CalibrationStore::indexArchive( const std::string& path )
+{
+    std::ifstream file(path, std::ios::binary);
+    if( !file.is_open() )
+        return false;
+
+    char header[TAR_BLOCK_SIZE];
+    uint64_t pos = 0;
+    std::string long_name; // Name of the next entry from a GNU or pax extended header
+
+    while( file.read(header, TAR_BLOCK_SIZE) )
+    {
+        if( header[0]=='\0' ) // End of archive
+            return true;
+
+        if( !checkTarHeader(header) )
+            return false;
+
+        const uint64_t size = parseOctal(header+124, 12);
+        const char type = header[156];
+
+        // ----> Entry name, with the UStar prefix
+        std::string name(header, strnlen(header, 100));
+        if( memcmp(header+257, "ustar", 5)==0 && header[345]!='\0' )
+            name = std::string(header+345, strnlen(header+345, 155)) + "/" + name;
+
+        if( !long_name.empty() )
+        {
+            name = long_name;
+            long_name.clear();
+        }
+        // <---- Entry name, with the UStar prefix
+
+        // ----> Long names of the next entry
+        if( (type=='L' || type=='x') && size<=65536 )
+        {
+            std::string ext(static_cast<size_t>(size), '\0');
+            if( !file.read(&ext[0], static_cast<std::streamsize>(size)) )
+                return false;
+
+            if( type=='L' )
+                long_name = ext.c_str();
+            else
+            {
+                // pax records: "<length> <key>=<value>\n"
+                const size_t key = ext.find(" path=");
+                if( key!=std::string::npos )
+                {
+                    const size_t end = ext.find('\n', key);
+                    long_name = ext.substr(key+6, end==std::string::npos ? std::string::npos : end-key-6);
+                }
+            }
+        }
+        // <---- Long names of the next entry
+
+        const size_t slash = name.rfind('/');
+        if( slash!=std::string::npos )
+            name = name.substr(slash+1);
+
+        unsigned int serial;
+        if( (type=='0' || type=='\0') && parseFilename(name, serial) && !mIndex.count(serial) )
+        {
+            Entry entry;
+            entry.path = path;
+            entry.archived = true;
+            entry.offset = pos + TAR_BLOCK_SIZE;
+            entry.size = size;
+            mIndex[serial] = entry;
+        }
+
+        pos += TAR_BLOCK_SIZE + (size+TAR_BLOCK_SIZE-1)/TAR_BLOCK_SIZE*TAR_BLOCK_SIZE;
+        file.seekg(static_cast<std::streamoff>(pos));
+    }
+
+    // Archive without the end blocks
+    return pos>0;
+}
+
+bool CalibrationStore::findEntry( unsigned int serial_number, Entry& entry )
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mIndex.find(serial_number);
+    if( it!=mIndex.end() )
+    {
+        entry = it->second;
+        return true;
+    }
+
+    // The file could have been added to a directory after the scan
+    const std::string name = getCalibrationFilename(serial_number);
+    for( const Source& s : mSources )
+    {
+        if( !s.archive && isFile(s.path+name) )
+        {
+            entry = Entry();
+            entry.path = s.path+name;
+            mIndex[serial_number] = entry;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CalibrationStore::contains( unsigned int serial_number )
+{
+    Entry entry;
+    return findEntry(serial_number, entry);
+}
+
+std::vector<unsigned int> CalibrationStore::getSerialNumbers()
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    std::vector<unsigned int> serials;
+    for( const auto& item : mIndex )
+        serials.push_back(item.first);
+    return serials;
+}
+
+bool CalibrationStore::getData( unsigned int serial_number, std::string& data )
+{
+    Entry entry;
+    if( !findEntry(serial_number, entry) )
+        return false;
+
+    std::ifstream file(entry.path, std::ios::binary);
+    if( !file.is_open() )
+        return false;
+
+    if( entry.archived )
+    {
+        data.resize(static_cast<size_t>(entry.size));
+        file.seekg(static_cast<std::streamoff>(entry.offset));
+        return static_cast<bool>(file.read(&data[0], static_cast<std::streamsize>(entry.size)));
+    }
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    data = ss.str();
+    return true;
+}
+
+bool CalibrationStore::getFile( unsigned int serial_number, std::string& filename )
+{
+    Entry entry;
+    if( !findEntry(serial_number, entry) )
+        return false;
+
+    if( !entry.archived )
+    {
+        filename = entry.path;
+        return true;
+    }
+
+    std::string data;
+    return getData(serial_number, data) && saveFile(serial_number, data, filename);
+}
+
+bool CalibrationStore::saveFile( unsigned int serial_number, const std::string& data, std::string& filename )
+{
+    std::string dir;
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        dir = mWritableDir;
+    }
+
+    if( !makeDirectories(dir) )
+        return false;
+
+    // Written to a temporary file and renamed, so that other processes never read a partial file
+    filename = dir + getCalibrationFilename(serial_number);
+    const std::string tmp_name = filename + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(tmp_name, std::ios::binary | std::ios::trunc);
+        if( !file.is_open() || !file.write(data.data(), static_cast<std::streamsize>(data.size())) )
+        {
+            std::remove(tmp_name.c_str());
+            return false;
+        }
+    }
+
+    if( std::rename(tmp_name.c_str(), filename.c_str())!=0 )
+    {
+        std::remove(tmp_name.c_str());
+        return false;
+    }
+
+    const std::lock_guard<std::mutex> lock(mMutex);
+    Entry entry;
+    entry.path = filename;
+    mIndex[serial_number] = entry;
+    return true;
+}
+
+void CalibrationStore::setFetcher( Fetcher fetcher )
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    mFetcher = fetcher;
+}
+
+std::shared_future<bool> CalibrationStore::fetch( unsigned int serial_number )
+{
+    auto result = std::make_shared<std::promise<bool>>();
+
+    if( contains(serial_number) )
+    {
+        result->set_value(true);
+        return result->get_future().share();
+    }
+
+    const std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mPending.find(serial_number);
+    if( it!=mPending.end() )
+        return it->second;
+
+    if( !mFetcher )
+    {
+        result->set_value(false);
+        return result->get_future().share();
+    }
+
+    std::shared_future<bool> future = result->get_future().share();
+    mPending[serial_number] = future;
+    mFetchQueue.emplace_back(serial_number, result);
+
+    if( !mFetchThread.joinable() )
+        mFetchThread = std::thread(&CalibrationStore::fetchFunc, this);
+    mFetchCond.notify_one();
+
+    return future;
+}
+
+void CalibrationStore::fetchFunc()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    for(;;)
+    {
+        mFetchCond.wait(lock, [this]{return mStop || !mFetchQueue.empty();});
+        if( mStop )
+            return;
+
+        const unsigned int serial_number = mFetchQueue.front().first;
+        std::shared_ptr<std::promise<bool>> result = mFetchQueue.front().second;
+        mFetchQueue.pop_front();
+        Fetcher fetcher = mFetcher;
+
+        lock.unlock();
+        bool ok = false;
+        try
+        {
+            std::string data, filename;
+            ok = fetcher && fetcher(serial_number, data) && !data.empty() && saveFile(serial_number, data, filename);
+        }
+        catch(...)
+        {
+            ok = false; // The request fails, the thread keeps serving the queue
+        }
+        lock.lock();
+
+        mPending.erase(serial_number);
+        result->set_value(ok);
+    }
+}
+
+}
+
+}
@@ -0,0 +1,334 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "envhistory.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace sl_oc {
+
+namespace sensors {
+
+static const char ENV_HISTORY_MAGIC[8] = {'Z','O','C','E','N','V','H','\0'};
+static const uint32_t ENV_HISTORY_VERSION = 1;
+
+static const uint64_t LEVEL_INTERVALS[] = {1000000000ULL, 60000000000ULL, 3600000000000ULL}; //!< 1 sec, 1 min, 1 hour
+
+namespace {
+
+template<typename T>
+void writePod(std::ofstream& file, const T& val)
+{
+    file.write(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+template<typename T>
+bool readPod(std::ifstream& file, T& val)
+{
+    file.read(reinterpret_cast<char*>(&val), sizeof(T));
+    return file.good();
+}
+
+}
+
+void EnvHistory::Bucket::reset( uint64_t start_ts )
+{
+    start = start_ts;
+    for( int c=0; c<CH_COUNT; c++ )
+    {
+        count[c] = 0;
+        min[c] = 0.0f;
+        max[c] = 0.0f;
+        sum[c] = 0.0;
+    }
+}
+
+void EnvHistory::Bucket::merge( const Bucket& other )
+{
+    for( int c=0; c<CH_COUNT; c++ )
+    {
+        if( other.count[c]==0 )
+            continue;
+
+        if( count[c]==0 )
+        {
+            min[c] = other.min[c];
+            max[c] = other.max[c];
+        }
+        else
+        {
+            min[c] = std::min(min[c], other.min[c]);
+            max[c] = std::max(max[c], other.max[c]);
+        }
+        count[c] += other.count[c];
+        sum[c] += other.sum[c];
+    }
+}
+
+EnvHistory::EnvHistory( size_t sec_capacity, size_t min_capacity, size_t hour_capacity )
+{
+    const size_t capacities[RES_COUNT] = {sec_capacity, min_capacity, hour_capacity};
+
+    for( int l=0; l<RES_COUNT; l++ )
+    {
+        mLevels[l].interval = LEVEL_INTERVALS[l];
+        mLevels[l].ring.resize(capacities[l]<1?1:capacities[l]);
+    }
+
+    clear();
+}
+
+void EnvHistory::clear()
+{
+    for( Level& lvl : mLevels )
+    {
+        lvl.head = 0;
+        lvl.size = 0;
+        lvl.open = false;
+    }
+}
+
+void EnvHistory::addEnvironment( uint64_t timestamp, float temp, float press, float humid )
+{
+    const float values[3] = {temp, press, humid};
+    addSample(timestamp, values, static_cast<int>(CHANNEL::ENV_TEMP), 3);
+}
+
+void EnvHistory::addCameraTemperature( uint64_t timestamp, float temp_left, float temp_right )
+{
+    const float values[2] = {temp_left, temp_right};
+    addSample(timestamp, values, static_cast<int>(CHANNEL::CAM_TEMP_LEFT), 2);
+}
+
+void EnvHistory::addSample( uint64_t timestamp, const float* values, int first_ch, int count )
+{
+    Level& lvl = mLevels[0];
+    uint64_t start = timestamp - timestamp%lvl.interval;
+
+    if( lvl.open && lvl.current.start!=start )
+        closeBucket(0);
+
+    if( !lvl.open )
+    {
+        lvl.current.reset(start);
+        lvl.open = true;
+    }
+
+    Bucket& b = lvl.current;
+    for( int i=0; i<count; i++ )
+    {
+        int c = first_ch+i;
+        if( b.count[c]==0 )
+        {
+            b.min[c] = values[i];
+            b.max[c] = values[i];
+        }
+        else
+        {
+            b.min[c] = std::min(b.min[c], values[i]);
+            b.max[c] = std::max(b.max[c], values[i]);
+        }
+        b.count[c]++;
+        b.sum[c] += values[i];
+    }
+}
+
+void EnvHistory::closeBucket( int level )
+{
+    Level& lvl = mLevels[level];
+    lvl.open = false;
+    pushBucket(level, lvl.current);
+
+    if( level+1 >= RES_COUNT )
+        return;
+
+    // ----> Propagate to the lower resolution
+    Level& next = mLevels[level+1];
+    uint64_t start = lvl.current.start - lvl.current.start%next.interval;
+
+    if( next.open && next.current.start!=start )
+        closeBucket(level+1);
+
+    if( !next.open )
+    {
+        next.current.reset(start);
+        next.open = true;
+    }
+
+    next.current.merge(lvl.current);
+    // <---- Propagate to the lower resolution
+}
+
+void EnvHistory::pushBucket( int level, const Bucket& bucket )
+{
+    Level& lvl = mLevels[level];
+    lvl.ring[lvl.head] = bucket;
+    lvl.head = (lvl.head+1)%lvl.ring.size();
+    if( lvl.size < lvl.ring.size() )
+        lvl.size++;
+}
+
+std::vector<data::EnvRollup> EnvHistory::query( RESOLUTION res, CHANNEL channel, uint64_t from_ts, uint64_t to_ts ) const
+{
+    std::vector<data::EnvRollup> result;
+
+    int l = static_cast<int>(res);
+    int c = static_cast<int>(channel);
+    if( l<0 || l>=RES_COUNT || c<0 || c>=CH_COUNT )
+        return result;
+
+    const Level& lvl = mLevels[l];
+    const size_t cap = lvl.ring.size();
+    result.reserve(lvl.size);
+
+    for( size_t i=0; i<lvl.size; i++ )
+    {
+        const Bucket& b = lvl.ring[(lvl.head+cap-lvl.size+i)%cap];
+        if( b.count[c]==0 || b.start+lvl.interval <= from_ts || b.start > to_ts )
+            continue;
+
+        data::EnvRollup r;
+        r.timestamp = b.start;
+        r.duration = lvl.interval;
+        r.count = b.count[c];
+        r.min = b.min[c];
+        r.max = b.max[c];
+        r.mean = static_cast<float>(b.sum[c]/b.count[c]);
+        result.push_back(r);
+    }
+
+    // The wall clock can jump backward
+    std::sort(result.begin(), result.end(),
+              [](const data::EnvRollup& a, const data::EnvRollup& b) {return a.timestamp < b.timestamp;});
+
+    return result;
+}
+
+bool EnvHistory::saveToFile( const std::string& filename ) const
+{
+    std::ofstream file(filename, std::ios::binary);
+    if( !file.is_open() )
+        return false;
+
+    auto writeBucket = [&file](const Bucket& b) {
+        writePod(file, b.start);
+        for( int c=0; c<CH_COUNT; c++ )
+        {
+            float mean = b.count[c]?static_cast<float>(b.sum[c]/b.count[c]):0.0f;
+            writePod(file, b.count[c]);
+            writePod(file, b.min[c]);
+            writePod(file, b.max[c]);
+            writePod(file, mean);
+        }
+    };
+
+    file.write(ENV_HISTORY_MAGIC, sizeof(ENV_HISTORY_MAGIC));
+    writePod(file, ENV_HISTORY_VERSION);
+    writePod(file, static_cast<uint32_t>(CH_COUNT));
+    writePod(file, static_cast<uint32_t>(RES_COUNT));
+
+    for( const Level& lvl : mLevels )
+    {
+        const size_t cap = lvl.ring.size();
+        writePod(file, lvl.interval);
+        writePod(file, static_cast<uint32_t>(lvl.size));
+        writePod(file, static_cast<uint8_t>(lvl.open?1:0));
+
+        for( size_t i=0; i<lvl.size; i++ )
+            writeBucket(lvl.ring[(lvl.head+cap-lvl.size+i)%cap]);
+        if( lvl.open )
+            writeBucket(lvl.current);
+    }
+
+    return file.good();
+}
+
+bool EnvHistory::loadFromFile( const std::string& filename )
+{
+    std::ifstream file(filename, std::ios::binary);
+    if( !file.is_open() )
+        return false;
+
+    auto readBucket = [&file](Bucket& b) {
+        if( !readPod(file, b.start) )
+            return false;
+        for( int c=0; c<CH_COUNT; c++ )
+        {
+            float mean;
+            if( !readPod(file, b.count[c]) || !readPod(file, b.min[c]) || !readPod(file, b.max[c]) || !readPod(file, mean) )
+                return false;
+            b.sum[c] = static_cast<double>(mean)*b.count[c];
+        }
+        return true;
+    };
+
+    // ----> Header
+    char magic[sizeof(ENV_HISTORY_MAGIC)];
+    uint32_t version, channels, levels;
+    file.read(magic, sizeof(magic));
+    if( !file.good() || std::memcmp(magic, ENV_HISTORY_MAGIC, sizeof(magic))!=0 )
+        return false;
+    if( !readPod(file, version) || !readPod(file, channels) || !readPod(file, levels) )
+        return false;
+    if( version!=ENV_HISTORY_VERSION || channels!=CH_COUNT || levels!=RES_COUNT )
+        return false;
+    // <---- Header
+
+    Level loaded[RES_COUNT];
+    for( int l=0; l<RES_COUNT; l++ )
+    {
+        Level& lvl = loaded[l];
+        lvl.interval = mLevels[l].interval;
+        lvl.ring.resize(mLevels[l].ring.size());
+
+        uint64_t interval;
+        uint32_t count;
+        uint8_t open;
+        if( !readPod(file, interval) || !readPod(file, count) || !readPod(file, open) || interval!=lvl.interval )
+            return false;
+
+        // Oldest entries in excess are overwritten by the ring buffer
+        Bucket b;
+        for( uint32_t i=0; i<count; i++ )
+        {
+            if( !readBucket(b) )
+                return false;
+            lvl.ring[lvl.head] = b;
+            lvl.head = (lvl.head+1)%lvl.ring.size();
+            if( lvl.size < lvl.ring.size() )
+                lvl.size++;
+        }
+
+        lvl.open = open!=0;
+        if( lvl.open && !readBucket(lvl.current) )
+            return false;
+    }
+
+    for( int l=0; l<RES_COUNT; l++ )
+        mLevels[l] = loaded[l];
+
+    return true;
+}
+
+}
+
+}
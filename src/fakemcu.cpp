@@ -0,0 +1,339 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "fakemcu.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+namespace sl_oc {
+
+namespace sensors {
+
+static const double FAKE_MCU_START_NS = 1e9;    //!< MCU time of the first packet [nsec]
+static const int FAKE_MAG_DECIMATION = 8;       //!< Packets for each magnetometer sample
+static const int FAKE_ENV_DECIMATION = 16;      //!< Packets for each environmental sample
+
+namespace {
+
+inline int16_t toRaw(float val, float scale)
+{
+    long raw = std::lrint(val/scale);
+    return static_cast<int16_t>(std::min(32767L, std::max(-32768L, raw)));
+}
+
+}
+
+FakeMcuTransport::FakeMcuTransport( const FakeMcuParams& params )
+{
+    mParams = params;
+    if( mParams.rate <= 0.0 )
+        mParams.rate = 400.0;
+    if( mParams.drop_burst < 1 )
+        mParams.drop_burst = 1;
+
+    restart();
+}
+
+void FakeMcuTransport::restart()
+{
+    const std::lock_guard<std::mutex> lock(mGenMutex);
+
+    mRng.seed(mParams.seed);
+    mIndex = 0;
+    mBurstLeft = 0;
+    mFrameCount = 0;
+    mLastDeliveryNs = 0;
+    mPending = false;
+    mStartTime = std::chrono::steady_clock::now();
+}
+
+std::vector<HidDeviceInfo> FakeMcuTransport::enumerate( uint16_t vendor_id )
+{
+    std::vector<HidDeviceInfo> devices;
+    if( vendor_id!=SL_USB_VENDOR )
+        return devices;
+
+    HidDeviceInfo info;
+    info.vendor_id = SL_USB_VENDOR;
+    info.product_id = mParams.product_id;
+    info.release_number = mParams.release_number;
+    info.serial_number = mParams.serial_number;
+    info.path = "fake-mcu";
+    info.manufacturer = "STEREOLABS";
+    info.product = "Fake MCU";
+    devices.push_back(info);
+
+    return devices;
+}
+
+bool FakeMcuTransport::open( uint16_t vendor_id, uint16_t product_id, int serial_number )
+{
+    if( vendor_id!=SL_USB_VENDOR || product_id!=mParams.product_id || serial_number!=mParams.serial_number )
+        return false;
+
+    mStreaming = false;
+    mOpen = true;
+    return true;
+}
+
+void FakeMcuTransport::close()
+{
+    mStreaming = false;
+    mOpen = false;
+}
+
+uint64_t FakeMcuTransport::generatePacket( usb::RawData& packet )
+{
+    const std::lock_guard<std::mutex> lock(mGenMutex);
+    return nextPacket(packet);
+}
+
+uint64_t FakeMcuTransport::nextPacket( usb::RawData& packet )
+{
+    const double period_ns = 1e9/mParams.rate;
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    for(;;)
+    {
+        if( mParams.packet_count>0 && mIndex>=mParams.packet_count )
+            return UINT64_MAX;
+
+        const uint64_t idx = mIndex++;
+        const double host_ns = idx*period_ns;
+
+        // ----> Frame sync
+        bool sync = false;
+        if( mParams.sync_rate > 0.0 )
+        {
+            uint32_t frames = static_cast<uint32_t>(std::floor(host_ns*mParams.sync_rate*1e-9))+1;
+            if( frames != mFrameCount )
+            {
+                mFrameCount = frames;
+                sync = true;
+            }
+        }
+        // <---- Frame sync
+
+        // ----> Dropouts
+        // The first and the last packet are delivered: the receiver cannot detect the loss of the others
+        const bool can_drop = idx>0 && (mParams.packet_count==0 || idx+mParams.drop_burst<mParams.packet_count);
+        if( mBurstLeft==0 && mParams.drop_prob>0.0 && uniform(mRng)<mParams.drop_prob && can_drop )
+            mBurstLeft = mParams.drop_burst;
+
+        if( mBurstLeft>0 )
+        {
+            mBurstLeft--;
+            mDropped++;
+            continue;
+        }
+        // <---- Dropouts
+
+        std::memset(&packet, 0, sizeof(usb::RawData));
+        packet.struct_id = (mParams.product_id==SL_USB_PROD_MCU_ZED2_REVA || mParams.product_id==SL_USB_PROD_MCU_ZED2i_REVA)?
+                    usb::REP_ID_SENSOR_DATA:0;
+
+        // ----> IMU
+        const double mcu_ns = FAKE_MCU_START_NS + host_ns*(1.0+mParams.drift_ppm*1e-6);
+        packet.imu_not_valid = 0;
+        packet.timestamp = static_cast<uint64_t>(std::llround(mcu_ns/TS_SCALE));
+        packet.aX = toRaw(mParams.acc[0]+mParams.acc_noise*noise(mRng), ACC_SCALE);
+        packet.aY = toRaw(mParams.acc[1]+mParams.acc_noise*noise(mRng), ACC_SCALE);
+        packet.aZ = toRaw(mParams.acc[2]+mParams.acc_noise*noise(mRng), ACC_SCALE);
+        packet.gX = toRaw(mParams.gyro[0]+mParams.gyro_noise*noise(mRng), GYRO_SCALE);
+        packet.gY = toRaw(mParams.gyro[1]+mParams.gyro_noise*noise(mRng), GYRO_SCALE);
+        packet.gZ = toRaw(mParams.gyro[2]+mParams.gyro_noise*noise(mRng), GYRO_SCALE);
+        packet.imu_temp = toRaw(mParams.imu_temp, TEMP_SCALE);
+        // <---- IMU
+
+        // ----> Motion and free-fall interrupts
+        for( const FakeMcuInterrupt& irq : mParams.interrupts )
+        {
+            if( idx<irq.start )
+                continue;
+
+            const bool active = idx-irq.start<irq.length;
+            if( irq.free_fall )
+            {
+                packet.camera_falling_count++;
+                packet.camera_falling |= active?1:0;
+            }
+            else
+            {
+                packet.camera_moving_count++;
+                packet.camera_moving |= active?1:0;
+            }
+        }
+        // <---- Motion and free-fall interrupts
+
+        // ----> Synchronization
+        packet.sync_capabilities = mParams.sync_rate>0.0?1:0;
+        packet.frame_sync = sync?1:0;
+        packet.frame_sync_count = mFrameCount;
+        // <---- Synchronization
+
+        // ----> Magnetometer and environmental sensors
+        packet.mag_valid = (idx%FAKE_MAG_DECIMATION==0)?2:1;
+        packet.mX = toRaw(mParams.mag[0], MAG_SCALE);
+        packet.mY = toRaw(mParams.mag[1], MAG_SCALE);
+        packet.mZ = toRaw(mParams.mag[2], MAG_SCALE);
+
+        packet.env_valid = (idx%FAKE_ENV_DECIMATION==0)?2:1;
+        packet.temp = toRaw(mParams.env_temp, TEMP_SCALE);
+        packet.press = static_cast<uint32_t>(std::lround(mParams.press/PRESS_SCALE_NEW));
+        packet.humid = static_cast<uint32_t>(std::lround(mParams.humid/HUMID_SCALE_NEW));
+        packet.temp_cam_left = toRaw(mParams.cam_temp, TEMP_SCALE);
+        packet.temp_cam_right = toRaw(mParams.cam_temp, TEMP_SCALE);
+        // <---- Magnetometer and environmental sensors
+
+        // ----> Delivery time
+        double delay_ns = 0.0;
+        if( mParams.jitter_usec>0.0 )
+            delay_ns = std::fabs(noise(mRng))*mParams.jitter_usec*1e3;
+
+        // The USB reports are received in order
+        uint64_t delivery_ns = std::max(mLastDeliveryNs, static_cast<uint64_t>(host_ns+delay_ns));
+        mLastDeliveryNs = delivery_ns;
+        // <---- Delivery time
+
+        return delivery_ns;
+    }
+}
+
+int FakeMcuTransport::read( unsigned char* data, size_t length, int timeout_msec )
+{
+    if( !mOpen )
+        return -1;
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_msec<0?1000:timeout_msec);
+
+    if( !mStreaming )
+    {
+        if( mParams.realtime && timeout_msec!=0 )
+            std::this_thread::sleep_until(deadline);
+        return 0;
+    }
+
+    usb::RawData packet;
+    std::chrono::steady_clock::time_point delivery;
+    bool ended;
+    {
+        const std::lock_guard<std::mutex> lock(mGenMutex);
+        if( !mPending )
+        {
+            mPendingNs = nextPacket(mPendingPacket);
+            mPending = mPendingNs!=UINT64_MAX;
+        }
+
+        ended = !mPending;
+        if( !ended )
+        {
+            packet = mPendingPacket;
+            delivery = mStartTime + std::chrono::nanoseconds(mPendingNs);
+        }
+    }
+
+    // End of a finite stream: wait as the MCU with no new data, also when not in real time
+    if( ended )
+    {
+        if( timeout_msec!=0 )
+            std::this_thread::sleep_until(deadline);
+        return 0;
+    }
+
+    if( mParams.realtime )
+    {
+        if( delivery > deadline )
+        {
+            std::this_thread::sleep_until(deadline);
+            return 0;
+        }
+        std::this_thread::sleep_until(delivery);
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(mGenMutex);
+        mPending = false;
+    }
+
+    size_t size = std::min(length, sizeof(usb::RawData));
+    std::memcpy(data, &packet, size);
+    mDelivered++;
+
+    return static_cast<int>(size);
+}
+
+int FakeMcuTransport::setNonBlocking( bool /*nonblock*/ )
+{
+    return mOpen?0:-1;
+}
+
+int FakeMcuTransport::sendFeatureReport( const unsigned char* data, size_t length )
+{
+    if( !mOpen || length<2 )
+        return -1;
+
+    switch( data[0] )
+    {
+    case usb::REP_ID_SENSOR_STREAM_STATUS:
+    {
+        bool enable = data[1]!=0;
+        if( enable && !mStreaming )
+            restart();
+        mStreaming = enable;
+        break;
+    }
+    case usb::REP_ID_REQUEST_SET:
+        if( data[1]==usb::RQ_CMD_PING )
+            mPings++;
+        else if( data[1]==usb::RQ_CMD_RST )
+        {
+            mStreaming = false;
+            restart();
+        }
+        break;
+    default:
+        return -1;
+    }
+
+    return static_cast<int>(length);
+}
+
+int FakeMcuTransport::getFeatureReport( unsigned char* data, size_t length )
+{
+    if( !mOpen || length<sizeof(usb::StreamStatus) || data[0]!=usb::REP_ID_SENSOR_STREAM_STATUS )
+        return -1;
+
+    data[1] = mStreaming?1:0;
+    return sizeof(usb::StreamStatus);
+}
+
+std::string FakeMcuTransport::getLastError()
+{
+    return mOpen?std::string():std::string("Fake MCU not open");
+}
+
+}
+
+}
@@ -0,0 +1,314 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "gravityestimator.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace sl_oc {
+
+namespace sensors {
+
+static const float GRAVITY = 9.80665f;      //!< Standard gravity [m/s²]
+
+GravityEstimator::GravityEstimator( const GravityParams& params )
+{
+    setParams(params);
+}
+
+void GravityEstimator::setParams( const GravityParams& params )
+{
+    mParams = params;
+    if( mParams.time_const < 0.0f )
+        mParams.time_const = 0.0f;
+}
+
+void GravityEstimator::reset()
+{
+    mInitialized = false;
+    mLastTs = 0;
+}
+
+bool GravityEstimator::update( uint64_t timestamp, float aX, float aY, float aZ )
+{
+    if( mInitialized && timestamp <= mLastTs )
+        return false;
+
+    // Skip the samples dominated by the linear acceleration
+    const float norm = std::sqrt(aX*aX + aY*aY + aZ*aZ);
+    if( std::fabs(norm-GRAVITY) > mParams.acc_tolerance*GRAVITY )
+        return false;
+
+    if( !mInitialized )
+    {
+        mAcc[0] = aX;
+        mAcc[1] = aY;
+        mAcc[2] = aZ;
+        mInitialized = true;
+    }
+    else
+    {
+        const float dt = (timestamp-mLastTs)*1e-9f;
+        const float alpha = dt/(mParams.time_const+dt);
+        mAcc[0] += alpha*(aX-mAcc[0]);
+        mAcc[1] += alpha*(aY-mAcc[1]);
+        mAcc[2] += alpha*(aZ-mAcc[2]);
+    }
+
+    mLastTs = timestamp;
+    return true;
+}
+
+data::Gravity GravityEstimator::getGravity() const
+{
+    data::Gravity gravity;
+    if( !mInitialized )
+        return gravity;
+
+    const float norm = std::sqrt(mAcc[0]*mAcc[0] + mAcc[1]*mAcc[1] + mAcc[2]*mAcc[2]);
+    if( norm < 1e-6f )
+        return gravity;
+
+    // The accelerometer measures the reaction to the gravity, pointing up
+    gravity.valid = true;
+    gravity.timestamp = mLastTs;
+    gravity.dX = -mAcc[0]/norm;
+    gravity.dY = -mAcc[1]/norm;
+    gravity.dZ = -mAcc[2]/norm;
+    gravity.norm = norm;
+    return gravity;
+}
+
+data::Gravity GravityEstimator::interpolate( const data::Gravity& before, const data::Gravity& after, uint64_t timestamp )
+{
+    if( after.timestamp <= before.timestamp || timestamp <= before.timestamp )
+        return before;
+    if( timestamp >= after.timestamp )
+        return after;
+
+    const float t = static_cast<float>(static_cast<double>(timestamp-before.timestamp)/(after.timestamp-before.timestamp));
+
+    data::Gravity gravity = before;
+    gravity.timestamp = timestamp;
+    gravity.dX = before.dX + t*(after.dX-before.dX);
+    gravity.dY = before.dY + t*(after.dY-before.dY);
+    gravity.dZ = before.dZ + t*(after.dZ-before.dZ);
+    gravity.norm = before.norm + t*(after.norm-before.norm);
+
+    const float n = std::sqrt(gravity.dX*gravity.dX + gravity.dY*gravity.dY + gravity.dZ*gravity.dZ);
+    if( n > 1e-6f )
+    {
+        gravity.dX /= n;
+        gravity.dY /= n;
+        gravity.dZ /= n;
+    }
+
+    return gravity;
+}
+
+bool GravityEstimator::getAlignment( const data::Gravity& gravity, float* R, const float* imu_from_src )
+{
+    if( !gravity.valid )
+        return false;
+
+    // ----> Up direction in the source frame
+    float up[3] = {-gravity.dX, -gravity.dY, -gravity.dZ};
+    if( imu_from_src )
+    {
+        // Transposed rotation: from the IMU frame to the source frame
+        float imu_up[3];
+        std::memcpy(imu_up, up, sizeof(imu_up));
+        for( int r=0; r<3; r++ )
+            up[r] = imu_from_src[0*3+r]*imu_up[0] + imu_from_src[1*3+r]*imu_up[1] + imu_from_src[2*3+r]*imu_up[2];
+    }
+    // <---- Up direction in the source frame
+
+    // ----> Horizontal X axis
+    // Projection of the source X axis on the horizontal plane, or of the Z axis if X is vertical
+    float x[3] = {1.0f-up[0]*up[0], -up[0]*up[1], -up[0]*up[2]};
+    float n = std::sqrt(x[0]*x[0] + x[1]*x[1] + x[2]*x[2]);
+    if( n < 1e-3f )
+    {
+        x[0] = -up[2]*up[0];
+        x[1] = -up[2]*up[1];
+        x[2] = 1.0f-up[2]*up[2];
+        n = std::sqrt(x[0]*x[0] + x[1]*x[1] + x[2]*x[2]);
+    }
+    for( int i=0; i<3; i++ )
+        x[i] /= n;
+    // <---- Horizontal X axis
+
+    // Y = Z x X
+    const float y[3] = {up[1]*x[2] - up[2]*x[1],
+                        up[2]*x[0] - up[0]*x[2],
+                        up[0]*x[1] - up[1]*x[0]};
+
+    // The rows are the aligned axes expressed in the source frame
+    for( int c=0; c<3; c++ )
+    {
+        R[0*3+c] = x[c];
+        R[1*3+c] = y[c];
+        R[2*3+c] = up[c];
+    }
+
+    return true;
+}
+
+void GravityEstimator::rotatePoints( const float* R, const float* in, float* out, size_t count, size_t stride )
+{
+    if( stride < 3 )
+        return;
+
+    size_t i = 0;
+
+    // Stride 3: blocks of 4 points are transposed to X,Y,Z vectors.
+    // Larger strides: each point is loaded as 4 floats and the 4th one is copied unchanged with a bit mask, so that
+    // NaN values do not propagate.
+#if defined(__SSE2__)
+    if( stride == 3 )
+    {
+        const __m128 r00 = _mm_set1_ps(R[0]), r01 = _mm_set1_ps(R[1]), r02 = _mm_set1_ps(R[2]);
+        const __m128 r10 = _mm_set1_ps(R[3]), r11 = _mm_set1_ps(R[4]), r12 = _mm_set1_ps(R[5]);
+        const __m128 r20 = _mm_set1_ps(R[6]), r21 = _mm_set1_ps(R[7]), r22 = _mm_set1_ps(R[8]);
+
+        for( ; i+4<=count; i+=4 )
+        {
+            // v0 = x0 y0 z0 x1, v1 = y1 z1 x2 y2, v2 = z2 x3 y3 z3
+            __m128 v0 = _mm_loadu_ps(in+i*3);
+            __m128 v1 = _mm_loadu_ps(in+i*3+4);
+            __m128 v2 = _mm_loadu_ps(in+i*3+8);
+
+            __m128 vx = _mm_shuffle_ps(v0, _mm_shuffle_ps(v1,v2,_MM_SHUFFLE(1,1,2,2)), _MM_SHUFFLE(2,0,3,0));
+            __m128 vy = _mm_shuffle_ps(_mm_shuffle_ps(v0,v1,_MM_SHUFFLE(0,0,1,1)),
+                                       _mm_shuffle_ps(v1,v2,_MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0));
+            __m128 vz = _mm_shuffle_ps(_mm_shuffle_ps(v0,v1,_MM_SHUFFLE(1,1,2,2)),
+                                       _mm_shuffle_ps(v2,v2,_MM_SHUFFLE(3,3,0,0)), _MM_SHUFFLE(2,0,2,0));
+
+            __m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r00,vx),_mm_mul_ps(r01,vy)),_mm_mul_ps(r02,vz));
+            __m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r10,vx),_mm_mul_ps(r11,vy)),_mm_mul_ps(r12,vz));
+            __m128 oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r20,vx),_mm_mul_ps(r21,vy)),_mm_mul_ps(r22,vz));
+
+            v0 = _mm_shuffle_ps(_mm_shuffle_ps(ox,oy,_MM_SHUFFLE(0,0,1,0)),
+                                _mm_shuffle_ps(oz,ox,_MM_SHUFFLE(1,1,0,0)), _MM_SHUFFLE(2,0,2,0));
+            v1 = _mm_shuffle_ps(_mm_shuffle_ps(oy,oz,_MM_SHUFFLE(1,1,1,1)),
+                                _mm_shuffle_ps(ox,oy,_MM_SHUFFLE(2,2,2,2)), _MM_SHUFFLE(2,0,2,0));
+            v2 = _mm_shuffle_ps(_mm_shuffle_ps(oz,ox,_MM_SHUFFLE(3,3,2,2)),
+                                _mm_shuffle_ps(oy,oz,_MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(2,0,2,0));
+
+            _mm_storeu_ps(out+i*3, v0);
+            _mm_storeu_ps(out+i*3+4, v1);
+            _mm_storeu_ps(out+i*3+8, v2);
+        }
+    }
+    else
+    {
+        const __m128 c0 = _mm_setr_ps(R[0], R[3], R[6], 0.0f);
+        const __m128 c1 = _mm_setr_ps(R[1], R[4], R[7], 0.0f);
+        const __m128 c2 = _mm_setr_ps(R[2], R[5], R[8], 0.0f);
+        const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+        for( ; i<count; i++ )
+        {
+            __m128 p = _mm_loadu_ps(in+i*stride);
+
+            __m128 px = _mm_shuffle_ps(p, p, _MM_SHUFFLE(0,0,0,0));
+            __m128 py = _mm_shuffle_ps(p, p, _MM_SHUFFLE(1,1,1,1));
+            __m128 pz = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2,2,2,2));
+
+            __m128 o = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0,px),_mm_mul_ps(c1,py)),_mm_mul_ps(c2,pz));
+            o = _mm_or_ps(_mm_and_ps(mask,o),_mm_andnot_ps(mask,p));
+            _mm_storeu_ps(out+i*stride, o);
+        }
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if( stride == 3 )
+    {
+        for( ; i+4<=count; i+=4 )
+        {
+            float32x4x3_t p = vld3q_f32(in+i*3);
+            float32x4x3_t o;
+
+            o.val[0] = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(p.val[0],R[0]),p.val[1],R[1]),p.val[2],R[2]);
+            o.val[1] = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(p.val[0],R[3]),p.val[1],R[4]),p.val[2],R[5]);
+            o.val[2] = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(p.val[0],R[6]),p.val[1],R[7]),p.val[2],R[8]);
+
+            vst3q_f32(out+i*3, o);
+        }
+    }
+    else
+    {
+        const float c0_val[4] = {R[0], R[3], R[6], 0.0f};
+        const float c1_val[4] = {R[1], R[4], R[7], 0.0f};
+        const float c2_val[4] = {R[2], R[5], R[8], 0.0f};
+        const uint32_t mask_val[4] = {0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0u};
+        const float32x4_t c0 = vld1q_f32(c0_val);
+        const float32x4_t c1 = vld1q_f32(c1_val);
+        const float32x4_t c2 = vld1q_f32(c2_val);
+        const uint32x4_t mask = vld1q_u32(mask_val);
+
+        for( ; i<count; i++ )
+        {
+            float32x4_t p = vld1q_f32(in+i*stride);
+            float32x2_t lo = vget_low_f32(p);
+            float32x2_t hi = vget_high_f32(p);
+
+            float32x4_t o = vmulq_lane_f32(c0, lo, 0);
+            o = vmlaq_lane_f32(o, c1, lo, 1);
+            o = vmlaq_lane_f32(o, c2, hi, 0);
+            vst1q_f32(out+i*stride, vbslq_f32(mask, o, p));
+        }
+    }
+#endif
+
+    const size_t simd_end = i;
+
+    // Scalar tail (or full loop if SIMD is not available)
+    for( ; i<count; i++ )
+    {
+        const float* p = in+i*stride;
+        float* o = out+i*stride;
+
+        float x = p[0], y = p[1], z = p[2];
+        o[0] = R[0]*x + R[1]*y + R[2]*z;
+        o[1] = R[3]*x + R[4]*y + R[5]*z;
+        o[2] = R[6]*x + R[7]*y + R[8]*z;
+
+        if( out != in && stride > 3 )
+            std::memcpy(o+3, p+3, (stride-3)*sizeof(float));
+    }
+
+    // Copy the elements following the 4th one of the points processed with SIMD instructions
+    if( out != in && stride > 4 )
+    {
+        for( size_t k=0; k<simd_end; k++ )
+            std::memcpy(out+k*stride+4, in+k*stride+4, (stride-4)*sizeof(float));
+    }
+}
+
+}
+
+}
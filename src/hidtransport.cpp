@@ -0,0 +1,124 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "hidtransport.hpp"
+#include "sensorcapture_def.hpp"
+
+#include "hidapi.h"
+
+namespace sl_oc {
+
+namespace sensors {
+
+HidApiTransport::~HidApiTransport()
+{
+    close();
+}
+
+std::vector<HidDeviceInfo> HidApiTransport::enumerate( uint16_t vendor_id )
+{
+    std::vector<HidDeviceInfo> devices;
+
+    if( hid_init()==-1 )
+        return devices;
+
+    struct hid_device_info* devs = hid_enumerate(vendor_id, 0x0);
+    for( struct hid_device_info* cur_dev = devs; cur_dev; cur_dev = cur_dev->next )
+    {
+        if( !cur_dev->serial_number )
+            continue;
+
+        HidDeviceInfo info;
+        info.vendor_id = cur_dev->vendor_id;
+        info.product_id = cur_dev->product_id;
+        info.release_number = cur_dev->release_number;
+        info.serial_number = std::stoi(wstr2str(cur_dev->serial_number));
+        info.path = cur_dev->path?cur_dev->path:"";
+        info.manufacturer = wstr2str(cur_dev->manufacturer_string);
+        info.product = wstr2str(cur_dev->product_string);
+        devices.push_back(info);
+    }
+
+    hid_free_enumeration(devs);
+
+    return devices;
+}
+
+bool HidApiTransport::open( uint16_t vendor_id, uint16_t product_id, int serial_number )
+{
+    close();
+
+    std::string sn_str = std::to_string(serial_number);
+    std::wstring wide_sn_string = std::wstring(sn_str.begin(), sn_str.end());
+
+    mDevHandle = hid_open(vendor_id, product_id, wide_sn_string.c_str());
+
+    return mDevHandle!=nullptr;
+}
+
+void HidApiTransport::close()
+{
+    if( mDevHandle )
+    {
+        hid_close(mDevHandle);
+        mDevHandle = nullptr;
+    }
+}
+
+int HidApiTransport::read( unsigned char* data, size_t length, int timeout_msec )
+{
+    if( !mDevHandle )
+        return -1;
+
+    return hid_read_timeout(mDevHandle, data, length, timeout_msec);
+}
+
+int HidApiTransport::setNonBlocking( bool nonblock )
+{
+    if( !mDevHandle )
+        return -1;
+
+    return hid_set_nonblocking(mDevHandle, nonblock?1:0);
+}
+
+int HidApiTransport::sendFeatureReport( const unsigned char* data, size_t length )
+{
+    if( !mDevHandle )
+        return -1;
+
+    return hid_send_feature_report(mDevHandle, data, length);
+}
+
+int HidApiTransport::getFeatureReport( unsigned char* data, size_t length )
+{
+    if( !mDevHandle )
+        return -1;
+
+    return hid_get_feature_report(mDevHandle, data, length);
+}
+
+std::string HidApiTransport::getLastError()
+{
+    return wstr2str(hid_error(mDevHandle));
+}
+
+}
+
+}
@@ -0,0 +1,547 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "imulog.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+namespace sl_oc {
+
+namespace sensors {
+
+static const char IMU_LOG_MAGIC[8] = {'Z','O','C','I','M','U','L','\0'};
+static const char IMU_LOG_END_MAGIC[8] = {'Z','O','C','I','M','U','E','\0'};
+static const uint32_t IMU_LOG_VERSION = 1;
+static const uint64_t IMU_LOG_HEADER_SIZE = 32;
+
+static const uint8_t REC_KEYFRAME = 0x01;   //!< Record flag: absolute timestamp
+static const uint8_t REC_SYNC = 0x02;       //!< Record flag: sample synchronized with a video frame
+static const uint8_t REC_GAP = 0x04;        //!< Record flag: packets lost before the sample
+static const uint8_t REC_END = 0xFF;        //!< Marker of the end of the records, followed by the index
+
+static const size_t REC_VALUES = 7;         //!< Values of each record: aX, aY, aZ, gX, gY, gZ, temp
+static const size_t REC_MAX_SIZE = 1+10+REC_VALUES*sizeof(int16_t); //!< Flags, varint timestamp, values
+
+static const size_t WRITE_BUFFER_SIZE = 65536;
+static const size_t READ_BUFFER_SIZE = 1<<20;
+
+namespace {
+
+// The file is little endian whatever the host byte order: the values are encoded byte by byte
+
+inline void putLe(uint8_t* p, uint64_t val, size_t size)
+{
+    for( size_t i=0; i<size; i++ )
+        p[i] = static_cast<uint8_t>(val>>(8*i));
+}
+
+inline uint64_t getLe(const uint8_t* p, size_t size)
+{
+    uint64_t val = 0;
+    for( size_t i=0; i<size; i++ )
+        val |= static_cast<uint64_t>(p[i])<<(8*i);
+    return val;
+}
+
+template<typename T>
+void writeLe(std::ofstream& file, T val)
+{
+    uint8_t buf[sizeof(T)];
+    putLe(buf, static_cast<uint64_t>(val), sizeof(T));
+    file.write(reinterpret_cast<const char*>(buf), sizeof(T));
+}
+
+inline void writeLe(std::ofstream& file, float val)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    writeLe(file, bits);
+}
+
+template<typename T>
+bool readLe(std::ifstream& file, T& val)
+{
+    uint8_t buf[sizeof(T)];
+    file.read(reinterpret_cast<char*>(buf), sizeof(T));
+    if( !file.good() )
+        return false;
+    val = static_cast<T>(static_cast<typename std::make_unsigned<T>::type>(getLe(buf, sizeof(T))));
+    return true;
+}
+
+inline bool readLe(std::ifstream& file, float& val)
+{
+    uint32_t bits;
+    if( !readLe(file, bits) )
+        return false;
+    std::memcpy(&val, &bits, sizeof(val));
+    return true;
+}
+
+inline int16_t quantize(float val, float inv_scale)
+{
+    long q = std::lrint(val*inv_scale);
+    return static_cast<int16_t>(std::min(32767L, std::max(-32768L, q)));
+}
+
+/*!
+ * \brief Decode a record
+ * \return the size of the record, 0 if the record is incomplete or invalid
+ */
+inline size_t decodeRecord(const uint8_t* p, size_t avail, uint8_t& flags, uint64_t& ts, int64_t& last_delta,
+                           int16_t* values)
+{
+    if( avail < 1 )
+        return 0;
+
+    size_t n = 0;
+    flags = p[n++];
+    if( flags & ~(REC_KEYFRAME|REC_SYNC|REC_GAP) )
+        return 0;
+
+    if( flags & REC_KEYFRAME )
+    {
+        if( avail < n+sizeof(uint64_t) )
+            return 0;
+        ts = getLe(p+n, sizeof(uint64_t));
+        n += sizeof(uint64_t);
+        last_delta = 0;
+    }
+    else
+    {
+        uint64_t zz = 0;
+        int shift = 0;
+        for(;;)
+        {
+            if( n>=avail || shift>63 )
+                return 0;
+            uint8_t b = p[n++];
+            zz |= static_cast<uint64_t>(b&0x7F)<<shift;
+            if( !(b&0x80) )
+                break;
+            shift += 7;
+        }
+
+        int64_t dd = static_cast<int64_t>(zz>>1) ^ -static_cast<int64_t>(zz&1);
+        last_delta += dd;
+        ts += static_cast<uint64_t>(last_delta);
+    }
+
+    if( avail < n+REC_VALUES*sizeof(int16_t) )
+        return 0;
+    for( size_t i=0; i<REC_VALUES; i++ )
+        values[i] = static_cast<int16_t>(static_cast<uint16_t>(getLe(p+n+i*sizeof(int16_t), sizeof(int16_t))));
+    n += REC_VALUES*sizeof(int16_t);
+
+    return n;
+}
+
+}
+
+// ----> ImuLogWriter
+ImuLogWriter::~ImuLogWriter()
+{
+    if( isOpen() )
+        close();
+}
+
+bool ImuLogWriter::open( const std::string& filename, const ImuLogParams& params )
+{
+    if( isOpen() )
+        close();
+
+    mParams = params;
+    if( mParams.keyframe_interval < 1 )
+        mParams.keyframe_interval = 1;
+    if( mParams.acc_scale<=0.0f || mParams.gyro_scale<=0.0f || mParams.temp_scale<=0.0f )
+        return false;
+
+    mInvScale[0] = 1.0f/mParams.acc_scale;
+    mInvScale[1] = 1.0f/mParams.gyro_scale;
+    mInvScale[2] = 1.0f/mParams.temp_scale;
+
+    mFile.open(filename, std::ios::binary|std::ios::trunc);
+    if( !mFile.is_open() )
+        return false;
+
+    mFile.write(IMU_LOG_MAGIC, sizeof(IMU_LOG_MAGIC));
+    writeLe(mFile, IMU_LOG_VERSION);
+    writeLe(mFile, mParams.keyframe_interval);
+    writeLe(mFile, mParams.acc_scale);
+    writeLe(mFile, mParams.gyro_scale);
+    writeLe(mFile, mParams.temp_scale);
+    writeLe(mFile, mParams.serial);
+
+    mBuffer.clear();
+    mBuffer.reserve(WRITE_BUFFER_SIZE);
+    mFileOffset = IMU_LOG_HEADER_SIZE;
+    mError = !mFile.good();
+
+    mIndex.clear();
+    mCount = 0;
+    mLastTs = 0;
+    mLastDelta = 0;
+
+    return !mError;
+}
+
+bool ImuLogWriter::write( uint64_t timestamp, float aX, float aY, float aZ, float gX, float gY, float gZ, float temp,
+                          bool sync, bool gap )
+{
+    if( !isOpen() || mError )
+        return false;
+    if( mCount>0 && timestamp<=mLastTs )
+        return false;
+
+    if( mBuffer.size()+REC_MAX_SIZE > WRITE_BUFFER_SIZE && !flush() )
+        return false;
+
+    uint8_t rec[REC_MAX_SIZE];
+    size_t n = 0;
+
+    const bool key = (mCount%mParams.keyframe_interval)==0;
+    rec[n++] = (key?REC_KEYFRAME:0) | (sync?REC_SYNC:0) | (gap?REC_GAP:0);
+
+    // ----> Timestamp
+    if( key )
+    {
+        ImuLogKeyFrame kf;
+        kf.timestamp = timestamp;
+        kf.offset = mFileOffset+mBuffer.size();
+        kf.sample = mCount;
+        mIndex.push_back(kf);
+
+        putLe(rec+n, timestamp, sizeof(uint64_t));
+        n += sizeof(uint64_t);
+        mLastDelta = 0;
+    }
+    else
+    {
+        // The sampling interval is almost constant: its variation is stored
+        int64_t delta = static_cast<int64_t>(timestamp-mLastTs);
+        int64_t dd = delta-mLastDelta;
+        uint64_t zz = (static_cast<uint64_t>(dd)<<1) ^ static_cast<uint64_t>(dd>>63);
+        while( zz>=0x80 )
+        {
+            rec[n++] = static_cast<uint8_t>(zz|0x80);
+            zz >>= 7;
+        }
+        rec[n++] = static_cast<uint8_t>(zz);
+        mLastDelta = delta;
+    }
+    mLastTs = timestamp;
+    // <---- Timestamp
+
+    // ----> Values
+    const int16_t values[REC_VALUES] = {
+        quantize(aX, mInvScale[0]), quantize(aY, mInvScale[0]), quantize(aZ, mInvScale[0]),
+        quantize(gX, mInvScale[1]), quantize(gY, mInvScale[1]), quantize(gZ, mInvScale[1]),
+        quantize(temp, mInvScale[2])
+    };
+    for( size_t i=0; i<REC_VALUES; i++ )
+        putLe(rec+n+i*sizeof(int16_t), static_cast<uint16_t>(values[i]), sizeof(int16_t));
+    n += sizeof(values);
+    // <---- Values
+
+    mBuffer.insert(mBuffer.end(), rec, rec+n);
+    mCount++;
+
+    return true;
+}
+
+bool ImuLogWriter::flush()
+{
+    if( !mBuffer.empty() )
+    {
+        mFile.write(reinterpret_cast<const char*>(mBuffer.data()), mBuffer.size());
+        mFileOffset += mBuffer.size();
+        mBuffer.clear();
+    }
+
+    if( !mFile.good() )
+        mError = true;
+
+    return !mError;
+}
+
+bool ImuLogWriter::close()
+{
+    if( !isOpen() )
+        return false;
+
+    flush();
+
+    // ----> Index
+    const uint64_t index_offset = mFileOffset;
+    writeLe(mFile, REC_END);
+    writeLe(mFile, static_cast<uint32_t>(mIndex.size()));
+    for( const ImuLogKeyFrame& kf : mIndex )
+    {
+        writeLe(mFile, kf.timestamp);
+        writeLe(mFile, kf.offset);
+        writeLe(mFile, kf.sample);
+    }
+    writeLe(mFile, mCount);
+    writeLe(mFile, index_offset);
+    mFile.write(IMU_LOG_END_MAGIC, sizeof(IMU_LOG_END_MAGIC));
+    // <---- Index
+
+    bool ok = !mError && mFile.good();
+    mFile.close();
+    mBuffer.clear();
+    mIndex.clear();
+
+    return ok;
+}
+// <---- ImuLogWriter
+
+// ----> ImuLogReader
+bool ImuLogReader::open( const std::string& filename )
+{
+    close();
+
+    mFile.open(filename, std::ios::binary);
+    if( !mFile.is_open() )
+        return false;
+
+    // ----> Header
+    char magic[sizeof(IMU_LOG_MAGIC)];
+    uint32_t version;
+    mFile.read(magic, sizeof(magic));
+    if( !mFile.good() || std::memcmp(magic, IMU_LOG_MAGIC, sizeof(magic))!=0 ||
+            !readLe(mFile, version) || version!=IMU_LOG_VERSION ||
+            !readLe(mFile, mParams.keyframe_interval) || !readLe(mFile, mParams.acc_scale) ||
+            !readLe(mFile, mParams.gyro_scale) || !readLe(mFile, mParams.temp_scale) ||
+            !readLe(mFile, mParams.serial) )
+    {
+        close();
+        return false;
+    }
+    mDataStart = IMU_LOG_HEADER_SIZE;
+    // <---- Header
+
+    mBuffer.resize(READ_BUFFER_SIZE);
+
+    if( !loadIndex() && !scanIndex() )
+    {
+        close();
+        return false;
+    }
+
+    return moveTo(mDataStart, 0);
+}
+
+void ImuLogReader::close()
+{
+    if( mFile.is_open() )
+        mFile.close();
+
+    mParams = ImuLogParams();
+    mIndex.clear();
+    mCount = 0;
+    mDataStart = 0;
+    mDataEnd = 0;
+    mBufPos = 0;
+    mBufSize = 0;
+    mSample = 0;
+}
+
+bool ImuLogReader::loadIndex()
+{
+    mFile.clear();
+    mFile.seekg(0, std::ios::end);
+    const uint64_t file_size = static_cast<uint64_t>(mFile.tellg());
+    if( file_size < mDataStart+1+sizeof(uint32_t)+3*sizeof(uint64_t) )
+        return false;
+
+    uint64_t index_offset;
+    char magic[sizeof(IMU_LOG_END_MAGIC)];
+    mFile.seekg(file_size-sizeof(uint64_t)-sizeof(magic));
+    if( !readLe(mFile, index_offset) )
+        return false;
+    mFile.read(magic, sizeof(magic));
+    if( !mFile.good() || std::memcmp(magic, IMU_LOG_END_MAGIC, sizeof(magic))!=0 ||
+            index_offset<mDataStart || index_offset>=file_size )
+        return false;
+
+    mFile.seekg(index_offset);
+    uint8_t marker;
+    uint32_t count;
+    if( !readLe(mFile, marker) || marker!=REC_END || !readLe(mFile, count) )
+        return false;
+
+    std::vector<ImuLogKeyFrame> index(count);
+    for( ImuLogKeyFrame& kf : index )
+    {
+        if( !readLe(mFile, kf.timestamp) || !readLe(mFile, kf.offset) || !readLe(mFile, kf.sample) )
+            return false;
+    }
+    if( !readLe(mFile, mCount) )
+        return false;
+
+    mIndex.swap(index);
+    mDataEnd = index_offset;
+    return true;
+}
+
+bool ImuLogReader::scanIndex()
+{
+    // The file has not been closed: the records are decoded up to the last complete one
+    mFile.clear();
+    mFile.seekg(0, std::ios::end);
+    mDataEnd = static_cast<uint64_t>(mFile.tellg());
+    mIndex.clear();
+
+    if( !moveTo(mDataStart, 0) )
+        return false;
+
+    uint64_t count = 0;
+    uint64_t end = mDataStart;
+    uint8_t flags;
+    int16_t values[REC_VALUES];
+    while( fill() )
+    {
+        const uint8_t* p = mBuffer.data()+mBufPos;
+        size_t n = decodeRecord(p, mBufSize-mBufPos, flags, mLastTs, mLastDelta, values);
+        if( n==0 || (count==0 && !(flags&REC_KEYFRAME)) )
+            break;
+
+        if( flags&REC_KEYFRAME )
+        {
+            ImuLogKeyFrame kf;
+            kf.timestamp = mLastTs;
+            kf.offset = mBufOffset+mBufPos;
+            kf.sample = count;
+            mIndex.push_back(kf);
+        }
+
+        mBufPos += n;
+        end = mBufOffset+mBufPos;
+        count++;
+    }
+
+    mDataEnd = end;
+    mCount = count;
+    return true;
+}
+
+bool ImuLogReader::moveTo( uint64_t offset, uint64_t sample )
+{
+    if( !mFile.is_open() )
+        return false;
+
+    mFile.clear();
+    mFile.seekg(offset);
+    mBufOffset = offset;
+    mBufPos = 0;
+    mBufSize = 0;
+    mSample = sample;
+    mLastTs = 0;
+    mLastDelta = 0;
+
+    return mFile.good();
+}
+
+bool ImuLogReader::fill()
+{
+    size_t avail = mBufSize-mBufPos;
+    const uint64_t next_read = mBufOffset+mBufSize;
+
+    if( avail < REC_MAX_SIZE && next_read < mDataEnd )
+    {
+        if( avail>0 )
+            std::memmove(mBuffer.data(), mBuffer.data()+mBufPos, avail);
+        mBufOffset += mBufPos;
+        mBufPos = 0;
+        mBufSize = avail;
+
+        size_t len = static_cast<size_t>(std::min<uint64_t>(mBuffer.size()-avail, mDataEnd-next_read));
+        mFile.read(reinterpret_cast<char*>(mBuffer.data()+avail), len);
+        mBufSize += static_cast<size_t>(mFile.gcount());
+        avail = mBufSize;
+    }
+
+    return avail>0;
+}
+
+bool ImuLogReader::seek( uint64_t timestamp )
+{
+    if( mIndex.empty() )
+        return false;
+
+    auto it = std::upper_bound(mIndex.begin(), mIndex.end(), timestamp,
+                               [](uint64_t ts, const ImuLogKeyFrame& kf) {return ts < kf.timestamp;});
+    if( it!=mIndex.begin() )
+        --it;
+
+    return moveTo(it->offset, it->sample);
+}
+
+size_t ImuLogReader::read( data::ImuBatch& batch, size_t max_count )
+{
+    if( !mFile.is_open() || mSample>=mCount )
+    {
+        batch.resize(0);
+        return 0;
+    }
+
+    max_count = static_cast<size_t>(std::min<uint64_t>(max_count, mCount-mSample));
+    batch.resize(max_count);
+
+    const float acc_scale = mParams.acc_scale;
+    const float gyro_scale = mParams.gyro_scale;
+    const float temp_scale = mParams.temp_scale;
+
+    size_t count = 0;
+    uint8_t flags;
+    int16_t v[REC_VALUES];
+    while( count<max_count && fill() )
+    {
+        size_t n = decodeRecord(mBuffer.data()+mBufPos, mBufSize-mBufPos, flags, mLastTs, mLastDelta, v);
+        if( n==0 )
+            break;
+        mBufPos += n;
+
+        batch.timestamp[count] = mLastTs;
+        batch.aX[count] = v[0]*acc_scale;
+        batch.aY[count] = v[1]*acc_scale;
+        batch.aZ[count] = v[2]*acc_scale;
+        batch.gX[count] = v[3]*gyro_scale;
+        batch.gY[count] = v[4]*gyro_scale;
+        batch.gZ[count] = v[5]*gyro_scale;
+        batch.temp[count] = v[6]*temp_scale;
+        batch.valid[count] = 1;
+        batch.sync[count] = (flags&REC_SYNC)?1:0;
+        batch.gap[count] = (flags&REC_GAP)?1:0;
+        count++;
+    }
+
+    mSample += count;
+    batch.resize(count);
+    return count;
+}
+// <---- ImuLogReader
+
+}
+
+}
@@ -0,0 +1,227 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "imuresampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sl_oc {
+
+namespace sensors {
+
+static const double PI = 3.14159265358979323846;
+static const uint64_t MAX_INPUT_GAP = 50000000ULL; //!< Input gap resetting the filter state [nsec]
+static const double HALF_TRANSITION = 3.0; //!< Blackman transition half width, times the taps [cycles/sample]
+
+ImuResampler::ImuResampler( const ImuResamplerParams& params )
+{
+    setParams(params);
+}
+
+void ImuResampler::setParams( const ImuResamplerParams& params )
+{
+    mParams = params;
+    if( mParams.rate < 1 )
+        mParams.rate = 1;
+    if( mParams.cutoff <= 0.0f || mParams.cutoff > 1.0f )
+        mParams.cutoff = 1.0f;
+    if( mParams.taps < 1 )
+        mParams.taps = 1;
+    if( mParams.taps%2 == 0 )
+        mParams.taps++;
+
+    mPeriod = 1000000000ULL/static_cast<uint64_t>(mParams.rate);
+
+    reset();
+}
+
+void ImuResampler::reset()
+{
+    mInputRate = 0.0;
+    mEstStartTs = 0;
+    mEstCount = -1;
+
+    mTaps = 1;
+    mCoeffs.assign(1, 1.0f);
+    mLastInTs = 0;
+    mGapPending = false;
+
+    restartFilter();
+}
+
+void ImuResampler::restartFilter()
+{
+    mLine.assign(2*mTaps*LANES, 0.0f);
+    mLineTs.assign(2*mTaps, 0);
+    mPos = 0;
+    mFill = 0;
+    mPrevValid = false;
+}
+
+void ImuResampler::designFilter()
+{
+    // Output Nyquist frequency [cycles/input sample]
+    const double nyquist = 0.5*mParams.rate/mInputRate;
+
+    if( nyquist >= 0.5 || mParams.taps==1 )
+    {
+        // No decimation: interpolation only
+        mTaps = 1;
+        mCoeffs.assign(1, 1.0f);
+        restartFilter();
+        return;
+    }
+
+    // The window spreads the cutoff over +/- HALF_TRANSITION/taps: the cutoff is lowered so that the stopband starts
+    // at the output Nyquist frequency, and the filter is made longer if it would remove more than half of the band
+    mTaps = mParams.taps;
+    const int min_taps = static_cast<int>(std::ceil(2.0*HALF_TRANSITION/nyquist));
+    if( mTaps < min_taps )
+        mTaps = min_taps|1;
+    const double fc = std::min(mParams.cutoff*nyquist, nyquist-HALF_TRANSITION/mTaps);
+
+    mCoeffs.resize(mTaps);
+
+    const double M = (mTaps-1)/2.0;
+    double sum = 0.0;
+    std::vector<double> h(mTaps);
+    for( int k=0; k<mTaps; k++ )
+    {
+        double x = k-M;
+        double sinc = (x==0.0)?2.0*fc:std::sin(2.0*PI*fc*x)/(PI*x);
+        double w = 0.42 - 0.5*std::cos(2.0*PI*k/(mTaps-1)) + 0.08*std::cos(4.0*PI*k/(mTaps-1));
+        h[k] = sinc*w;
+        sum += h[k];
+    }
+
+    // Unitary DC gain
+    for( int k=0; k<mTaps; k++ )
+        mCoeffs[k] = static_cast<float>(h[k]/sum);
+
+    restartFilter();
+}
+
+size_t ImuResampler::addSample( uint64_t timestamp, float aX, float aY, float aZ, float gX, float gY, float gZ,
+                                float temp, bool gap, data::ImuBatch& out )
+{
+    out.resize(0);
+
+    // ----> Input gaps
+    if( mLastInTs!=0 && (gap || timestamp<=mLastInTs || timestamp-mLastInTs>MAX_INPUT_GAP) )
+    {
+        restartFilter();
+        mGapPending = true;
+        if( mEstCount>=0 && mEstCount<RATE_EST_COUNT )
+            mEstCount = -1;
+    }
+    mLastInTs = timestamp;
+    // <---- Input gaps
+
+    // ----> Input rate measurement
+    if( mEstCount < RATE_EST_COUNT )
+    {
+        if( mEstCount<0 )
+            mEstStartTs = timestamp;
+        mEstCount++;
+
+        if( mEstCount==RATE_EST_COUNT )
+        {
+            mInputRate = RATE_EST_COUNT*1e9/static_cast<double>(timestamp-mEstStartTs);
+            designFilter();
+        }
+
+        // No output until the filter is designed
+        return 0;
+    }
+    // <---- Input rate measurement
+
+    // ----> Delay line
+    const float values[LANES] = {aX, aY, aZ, gX, gY, gZ, 0.0f, 0.0f};
+    std::copy(values, values+LANES, &mLine[mPos*LANES]);
+    std::copy(values, values+LANES, &mLine[(mPos+mTaps)*LANES]);
+    mLineTs[mPos] = timestamp;
+    mLineTs[mPos+mTaps] = timestamp;
+    mPos = (mPos+1)%mTaps;
+
+    if( mFill < mTaps )
+        mFill++;
+    if( mFill < mTaps )
+        return 0;
+    // <---- Delay line
+
+    // ----> FIR filter
+    // The window starting at the oldest sample is contiguous thanks to the mirrored delay line. The channels are the
+    // inner loop, so each tap is a single vector multiply-add without reordering the sums.
+    float acc[LANES] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    const float* x = &mLine[mPos*LANES];
+    const float* h = mCoeffs.data();
+    for( int k=0; k<mTaps; k++ )
+    {
+        const float hk = h[k];
+        const float* xk = x+k*LANES;
+        for( int c=0; c<LANES; c++ )
+            acc[c] += hk*xk[c];
+    }
+    const uint64_t acc_ts = mLineTs[mPos+mTaps/2];
+    // <---- FIR filter
+
+    if( !mPrevValid )
+    {
+        mNextTs = ((acc_ts+mPeriod-1)/mPeriod)*mPeriod;
+    }
+    else
+    {
+        // ----> Interpolation on the output grid
+        const double span = static_cast<double>(acc_ts-mPrevTs);
+        while( mNextTs <= acc_ts )
+        {
+            const float alpha = static_cast<float>((mNextTs-mPrevTs)/span);
+
+            size_t idx = out.size();
+            out.resize(idx+1);
+            out.timestamp[idx] = mNextTs;
+            out.aX[idx] = mPrev[0] + alpha*(acc[0]-mPrev[0]);
+            out.aY[idx] = mPrev[1] + alpha*(acc[1]-mPrev[1]);
+            out.aZ[idx] = mPrev[2] + alpha*(acc[2]-mPrev[2]);
+            out.gX[idx] = mPrev[3] + alpha*(acc[3]-mPrev[3]);
+            out.gY[idx] = mPrev[4] + alpha*(acc[4]-mPrev[4]);
+            out.gZ[idx] = mPrev[5] + alpha*(acc[5]-mPrev[5]);
+            out.temp[idx] = temp;
+            out.valid[idx] = 1;
+            out.sync[idx] = 0;
+            out.gap[idx] = mGapPending?1:0;
+            mGapPending = false;
+
+            mNextTs += mPeriod;
+        }
+        // <---- Interpolation on the output grid
+    }
+
+    mPrevValid = true;
+    mPrevTs = acc_ts;
+    std::copy(acc, acc+LANES, mPrev);
+
+    return out.size();
+}
+
+}
+
+}
@@ -0,0 +1,313 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "magcalibration.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sl_oc {
+
+namespace sensors {
+
+static const double FIT_SCALE = 1.0/64.0;   //!< Normalization of the raw values [1/uT], to improve the conditioning
+
+namespace {
+
+/*!
+ * \brief Solve the linear system `A*x = b` of size `n` with Gaussian elimination and partial pivoting. A and b are
+ *        modified.
+ */
+bool solveLinear(double* A, double* b, double* x, int n)
+{
+    for( int c=0; c<n; c++ )
+    {
+        int piv = c;
+        for( int r=c+1; r<n; r++ )
+        {
+            if( std::fabs(A[r*n+c]) > std::fabs(A[piv*n+c]) )
+                piv = r;
+        }
+
+        if( std::fabs(A[piv*n+c]) < 1e-12 )
+            return false;
+
+        if( piv!=c )
+        {
+            for( int k=0; k<n; k++ )
+                std::swap(A[c*n+k], A[piv*n+k]);
+            std::swap(b[c], b[piv]);
+        }
+
+        for( int r=c+1; r<n; r++ )
+        {
+            double f = A[r*n+c]/A[c*n+c];
+            for( int k=c; k<n; k++ )
+                A[r*n+k] -= f*A[c*n+k];
+            b[r] -= f*b[c];
+        }
+    }
+
+    for( int r=n-1; r>=0; r-- )
+    {
+        double s = b[r];
+        for( int k=r+1; k<n; k++ )
+            s -= A[r*n+k]*x[k];
+        x[r] = s/A[r*n+r];
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Eigen decomposition of a 3x3 symmetric matrix with the cyclic Jacobi method. The eigenvectors are stored
+ *        in the columns of `V`.
+ */
+void eigenSym3(const double* M, double* d, double* V)
+{
+    double a[9];
+    std::memcpy(a, M, sizeof(a));
+    for( int i=0; i<9; i++ )
+        V[i] = (i%4==0)?1.0:0.0;
+
+    for( int sweep=0; sweep<50; sweep++ )
+    {
+        double off = a[1]*a[1] + a[2]*a[2] + a[5]*a[5];
+        if( off < 1e-30 )
+            break;
+
+        for( int p=0; p<2; p++ )
+        {
+            for( int q=p+1; q<3; q++ )
+            {
+                double apq = a[p*3+q];
+                if( std::fabs(apq) < 1e-300 )
+                    continue;
+
+                double theta = (a[q*3+q]-a[p*3+p])/(2.0*apq);
+                double t = (theta>=0?1.0:-1.0)/(std::fabs(theta)+std::sqrt(theta*theta+1.0));
+                double c = 1.0/std::sqrt(t*t+1.0);
+                double s = t*c;
+
+                // A' = Jᵀ A J
+                for( int k=0; k<3; k++ )
+                {
+                    double akp = a[k*3+p], akq = a[k*3+q];
+                    a[k*3+p] = c*akp - s*akq;
+                    a[k*3+q] = s*akp + c*akq;
+                }
+                for( int k=0; k<3; k++ )
+                {
+                    double apk = a[p*3+k], aqk = a[q*3+k];
+                    a[p*3+k] = c*apk - s*aqk;
+                    a[q*3+k] = s*apk + c*aqk;
+                }
+                for( int k=0; k<3; k++ )
+                {
+                    double vkp = V[k*3+p], vkq = V[k*3+q];
+                    V[k*3+p] = c*vkp - s*vkq;
+                    V[k*3+q] = s*vkp + c*vkq;
+                }
+            }
+        }
+    }
+
+    d[0] = a[0];
+    d[1] = a[4];
+    d[2] = a[8];
+}
+
+}
+
+MagCalibrator::MagCalibrator( const MagCalibrationParams& params )
+{
+    mParams = params;
+    if( mParams.update_interval < 1 )
+        mParams.update_interval = 1;
+    if( mParams.forgetting <= 0.0 || mParams.forgetting > 1.0 )
+        mParams.forgetting = 1.0;
+
+    reset();
+}
+
+void MagCalibrator::reset()
+{
+    std::fill(mS, mS+9*9, 0.0);
+    std::fill(mB, mB+9, 0.0);
+    mW = 0.0;
+    mCount = 0;
+    mSinceFit = 0;
+}
+
+bool MagCalibrator::addSample( float mX, float mY, float mZ )
+{
+    const double x = mX*FIT_SCALE;
+    const double y = mY*FIT_SCALE;
+    const double z = mZ*FIT_SCALE;
+    const double u[9] = {x*x, y*y, z*z, 2.0*y*z, 2.0*x*z, 2.0*x*y, 2.0*x, 2.0*y, 2.0*z};
+
+    // ----> Normal equations update
+    if( mParams.forgetting < 1.0 )
+    {
+        const double l = mParams.forgetting;
+        for( int i=0; i<9*9; i++ )
+            mS[i] *= l;
+        for( int i=0; i<9; i++ )
+            mB[i] *= l;
+        mW *= l;
+    }
+
+    for( int r=0; r<9; r++ )
+    {
+        for( int c=r; c<9; c++ )
+            mS[r*9+c] += u[r]*u[c];
+        mB[r] += u[r];
+    }
+    mW += 1.0;
+    // <---- Normal equations update
+
+    mCount++;
+    mSinceFit++;
+
+    if( mCount < static_cast<uint64_t>(mParams.min_samples) || mSinceFit < mParams.update_interval )
+        return false;
+
+    mSinceFit = 0;
+    return fit();
+}
+
+bool MagCalibrator::fit()
+{
+    // ----> Algebraic least squares solution
+    double S[9*9];
+    double b[9];
+    double v[9];
+    for( int r=0; r<9; r++ )
+    {
+        for( int c=0; c<9; c++ )
+            S[r*9+c] = c>=r?mS[r*9+c]:mS[c*9+r];
+        b[r] = mB[r];
+    }
+
+    if( !solveLinear(S, b, v, 9) )
+        return false;
+    // <---- Algebraic least squares solution
+
+    // ----> Ellipsoid center
+    const double A[9] = {v[0], v[5], v[4],
+                         v[5], v[1], v[3],
+                         v[4], v[3], v[2]};
+    double Ac[9];
+    double g[3] = {-v[6], -v[7], -v[8]};
+    double center[3];
+    std::memcpy(Ac, A, sizeof(Ac));
+    if( !solveLinear(Ac, g, center, 3) )
+        return false;
+
+    double k = 1.0;
+    for( int r=0; r<3; r++ )
+        for( int c=0; c<3; c++ )
+            k += center[r]*A[r*3+c]*center[c];
+
+    if( k <= 0.0 )
+        return false;
+    // <---- Ellipsoid center
+
+    // ----> Ellipsoid axes: (x-c)ᵀ M (x-c) = 1
+    double M[9];
+    for( int i=0; i<9; i++ )
+        M[i] = A[i]/k;
+
+    double d[3];
+    double V[9];
+    eigenSym3(M, d, V);
+    if( d[0]<=0.0 || d[1]<=0.0 || d[2]<=0.0 )
+        return false;
+
+    double r_min = 1.0/std::sqrt(std::max(d[0],std::max(d[1],d[2])));
+    double r_max = 1.0/std::sqrt(std::min(d[0],std::min(d[1],d[2])));
+    double field = std::cbrt(1.0/std::sqrt(d[0]*d[1]*d[2]));  // Geometric mean of the radii
+
+    if( r_max/r_min > mParams.max_axis_ratio ||
+            field/FIT_SCALE < mParams.min_field || field/FIT_SCALE > mParams.max_field )
+        return false;
+    // <---- Ellipsoid axes: (x-c)ᵀ M (x-c) = 1
+
+    // ----> Directions coverage
+    double mean[3] = {mB[6]/(2.0*mW), mB[7]/(2.0*mW), mB[8]/(2.0*mW)};
+    double C[9] = {mB[0]/mW - mean[0]*mean[0], mB[5]/(2.0*mW) - mean[0]*mean[1], mB[4]/(2.0*mW) - mean[0]*mean[2],
+                   0.0, mB[1]/mW - mean[1]*mean[1], mB[3]/(2.0*mW) - mean[1]*mean[2],
+                   0.0, 0.0, mB[2]/mW - mean[2]*mean[2]};
+    C[3] = C[1];
+    C[6] = C[2];
+    C[7] = C[5];
+
+    double cd[3];
+    double CV[9];
+    eigenSym3(C, cd, CV);
+    double min_var = std::min(cd[0],std::min(cd[1],cd[2]));
+    double min_std = mParams.min_coverage*field;
+    if( min_var < min_std*min_std )
+        return false;
+    // <---- Directions coverage
+
+    // ----> Calibration: soft_iron = field * sqrt(M), in raw units
+    data::MagCalibration calib;
+    calib.valid = true;
+    for( int r=0; r<3; r++ )
+    {
+        calib.hard_iron[r] = static_cast<float>(center[r]/FIT_SCALE);
+        for( int c=0; c<3; c++ )
+        {
+            double val = 0.0;
+            for( int e=0; e<3; e++ )
+                val += V[r*3+e]*std::sqrt(d[e])*V[c*3+e];
+            calib.soft_iron[r*3+c] = static_cast<float>(field*val);
+        }
+    }
+    calib.field = static_cast<float>(field/FIT_SCALE);
+
+    // RMS of the algebraic residuals: (vᵀSv - 2vᵀb + W)/W
+    double res = mW;
+    for( int r=0; r<9; r++ )
+    {
+        res -= 2.0*v[r]*mB[r];
+        for( int c=0; c<9; c++ )
+            res += v[r]*(c>=r?mS[r*9+c]:mS[c*9+r])*v[c];
+    }
+    calib.fit_error = static_cast<float>(std::sqrt(std::max(0.0,res)/mW));
+    calib.samples = mCount;
+    // <---- Calibration: soft_iron = field * sqrt(M), in raw units
+
+    mCalib = calib;
+    return true;
+}
+
+void MagCalibrator::apply( const data::MagCalibration& calib, const float* raw, float* out )
+{
+    float d[3] = {raw[0]-calib.hard_iron[0], raw[1]-calib.hard_iron[1], raw[2]-calib.hard_iron[2]};
+    for( int r=0; r<3; r++ )
+        out[r] = calib.soft_iron[r*3+0]*d[0] + calib.soft_iron[r*3+1]*d[1] + calib.soft_iron[r*3+2]*d[2];
+}
+
+}
+
+}
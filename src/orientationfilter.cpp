@@ -0,0 +1,246 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "orientationfilter.hpp"
+#include "sensorcapture_def.hpp"
+
+#include <cmath>
+
+namespace sl_oc {
+
+namespace sensors {
+
+static const float DEG2RAD = 0.017453292519943295f;
+static const float RAD2DEG = 57.29577951308232f;
+static const uint64_t MAX_DT_NSEC = 100000000ULL;    //!< Larger timestamp gaps are not integrated
+
+OrientationFilter::OrientationFilter( const OrientationFilterParams& params )
+{
+    setParams(params);
+}
+
+void OrientationFilter::setParams( const OrientationFilterParams& params )
+{
+    mParams = params;
+}
+
+void OrientationFilter::reset()
+{
+    mInitialized = false;
+    mLastTs = 0;
+
+    mQ[0] = 1.0f;
+    mQ[1] = mQ[2] = mQ[3] = 0.0f;
+    mIntegral[0] = mIntegral[1] = mIntegral[2] = 0.0f;
+}
+
+void OrientationFilter::initFromAcc( float aX, float aY, float aZ )
+{
+    // Shortest arc rotation bringing the measured gravity direction on the Z axis
+    float norm = std::sqrt(aX*aX + aY*aY + aZ*aZ);
+    aX /= norm;
+    aY /= norm;
+    aZ /= norm;
+
+    if( aZ < -0.999999f )
+    {
+        // Upside down: 180° around the X axis
+        mQ[0] = 0.0f;
+        mQ[1] = 1.0f;
+        mQ[2] = mQ[3] = 0.0f;
+        return;
+    }
+
+    // q = [1 + a·z, a × z] normalized
+    float w = 1.0f + aZ;
+    float x = aY;
+    float y = -aX;
+    float n = std::sqrt(w*w + x*x + y*y);
+
+    mQ[0] = w/n;
+    mQ[1] = x/n;
+    mQ[2] = y/n;
+    mQ[3] = 0.0f;
+}
+
+bool OrientationFilter::update( uint64_t timestamp, float gX, float gY, float gZ, float aX, float aY, float aZ )
+{
+    float acc_norm = std::sqrt(aX*aX + aY*aY + aZ*aZ);
+
+    // ----> Initialization
+    if( !mInitialized )
+    {
+        if( acc_norm < 1e-3f )
+            return false;
+
+        initFromAcc(aX, aY, aZ);
+        mLastTs = timestamp;
+        mInitialized = true;
+        return true;
+    }
+    // <---- Initialization
+
+    // ----> Integration step
+    if( timestamp <= mLastTs )
+        return false;
+
+    uint64_t dt_nsec = timestamp - mLastTs;
+    mLastTs = timestamp;
+
+    if( dt_nsec > MAX_DT_NSEC )
+        return false;
+
+    float dt = static_cast<float>(dt_nsec)*1e-9f;
+    // <---- Integration step
+
+    float wx = gX*DEG2RAD;
+    float wy = gY*DEG2RAD;
+    float wz = gZ*DEG2RAD;
+
+    float qw = mQ[0], qx = mQ[1], qy = mQ[2], qz = mQ[3];
+
+    // ----> Accelerometer correction
+    if( acc_norm > 1e-3f && std::fabs(acc_norm/DEFAULT_GRAVITY - 1.0f) <= mParams.acc_tolerance )
+    {
+        float ax = aX/acc_norm, ay = aY/acc_norm, az = aZ/acc_norm;
+
+        // Gravity direction estimated by the current orientation, in the IMU frame
+        float vx = 2.0f*(qx*qz - qw*qy);
+        float vy = 2.0f*(qw*qx + qy*qz);
+        float vz = qw*qw - qx*qx - qy*qy + qz*qz;
+
+        // Error: cross product between measured and estimated gravity directions
+        float ex = ay*vz - az*vy;
+        float ey = az*vx - ax*vz;
+        float ez = ax*vy - ay*vx;
+
+        if( mParams.ki > 0.0f )
+        {
+            const float max_int = mParams.max_bias*DEG2RAD;
+            float* e[3] = {&ex, &ey, &ez};
+            for( int i=0; i<3; i++ )
+            {
+                mIntegral[i] += mParams.ki*(*e[i])*dt;
+                if( mIntegral[i] > max_int ) mIntegral[i] = max_int;
+                if( mIntegral[i] < -max_int ) mIntegral[i] = -max_int;
+            }
+        }
+
+        wx += mParams.kp*ex;
+        wy += mParams.kp*ey;
+        wz += mParams.kp*ez;
+    }
+
+    // The integral term is applied even without a valid accelerometer correction: it is the bias estimation
+    wx += mIntegral[0];
+    wy += mIntegral[1];
+    wz += mIntegral[2];
+    // <---- Accelerometer correction
+
+    // ----> Quaternion integration: dq/dt = 0.5 * q ⊗ [0,w]
+    float hdt = 0.5f*dt;
+    mQ[0] = qw + hdt*(-qx*wx - qy*wy - qz*wz);
+    mQ[1] = qx + hdt*( qw*wx + qy*wz - qz*wy);
+    mQ[2] = qy + hdt*( qw*wy - qx*wz + qz*wx);
+    mQ[3] = qz + hdt*( qw*wz + qx*wy - qy*wx);
+
+    float n = std::sqrt(mQ[0]*mQ[0] + mQ[1]*mQ[1] + mQ[2]*mQ[2] + mQ[3]*mQ[3]);
+    mQ[0] /= n;
+    mQ[1] /= n;
+    mQ[2] /= n;
+    mQ[3] /= n;
+    // <---- Quaternion integration: dq/dt = 0.5 * q ⊗ [0,w]
+
+    return true;
+}
+
+data::Orientation OrientationFilter::getOrientation() const
+{
+    data::Orientation orient;
+
+    if( !mInitialized )
+        return orient;
+
+    orient.valid = data::Orientation::NEW_VAL;
+    orient.timestamp = mLastTs;
+    orient.qW = mQ[0];
+    orient.qX = mQ[1];
+    orient.qY = mQ[2];
+    orient.qZ = mQ[3];
+    orient.bX = -mIntegral[0]*RAD2DEG;
+    orient.bY = -mIntegral[1]*RAD2DEG;
+    orient.bZ = -mIntegral[2]*RAD2DEG;
+
+    return orient;
+}
+
+data::Orientation OrientationFilter::interpolate( const data::Orientation& before, const data::Orientation& after, uint64_t timestamp )
+{
+    if( after.timestamp <= before.timestamp || timestamp <= before.timestamp )
+        return before;
+    if( timestamp >= after.timestamp )
+        return after;
+
+    float t = static_cast<float>(static_cast<double>(timestamp-before.timestamp)/static_cast<double>(after.timestamp-before.timestamp));
+
+    // ----> Quaternion SLERP on the shortest path
+    float bw = after.qW, bx = after.qX, by = after.qY, bz = after.qZ;
+    float dot = before.qW*bw + before.qX*bx + before.qY*by + before.qZ*bz;
+    if( dot < 0.0f )
+    {
+        dot = -dot;
+        bw = -bw; bx = -bx; by = -by; bz = -bz;
+    }
+
+    float k0 = 1.0f-t;
+    float k1 = t;
+    if( dot < 0.9995f ) // Linear interpolation is accurate enough for very close quaternions
+    {
+        float theta = std::acos(dot);
+        float sin_theta = std::sin(theta);
+        k0 = std::sin(k0*theta)/sin_theta;
+        k1 = std::sin(k1*theta)/sin_theta;
+    }
+
+    data::Orientation res;
+    res.valid = before.valid;
+    res.timestamp = timestamp;
+    res.qW = k0*before.qW + k1*bw;
+    res.qX = k0*before.qX + k1*bx;
+    res.qY = k0*before.qY + k1*by;
+    res.qZ = k0*before.qZ + k1*bz;
+
+    float n = std::sqrt(res.qW*res.qW + res.qX*res.qX + res.qY*res.qY + res.qZ*res.qZ);
+    res.qW /= n;
+    res.qX /= n;
+    res.qY /= n;
+    res.qZ /= n;
+    // <---- Quaternion SLERP on the shortest path
+
+    res.bX = before.bX + t*(after.bX-before.bX);
+    res.bY = before.bY + t*(after.bY-before.bY);
+    res.bZ = before.bZ + t*(after.bZ-before.bZ);
+
+    return res;
+}
+
+}
+
+}
@@ -0,0 +1,414 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "pointrectifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace sl_oc {
+
+namespace video {
+
+const int PointRectifier::DEFAULT_GRID_STEP;
+
+namespace {
+
+// The grid is computed once, so the distortion is inverted up to convergence
+const int GRID_ITERATIONS = 20;
+
+/*!
+ * \brief Map a rectified point to the source image, as StereoRectify::computeMap
+ */
+inline void unrectifyPoint( const CameraIntrinsics& cam, const double iKR[9], double u, double v,
+                            double& src_x, double& src_y )
+{
+    const double w = 1.0/(iKR[6]*u + iKR[7]*v + iKR[8]);
+    const double x = (iKR[0]*u + iKR[1]*v + iKR[2])*w;
+    const double y = (iKR[3]*u + iKR[4]*v + iKR[5])*w;
+    const double x2 = x*x, y2 = y*y;
+    const double r2 = x2 + y2, _2xy = 2*x*y;
+    const double kr = 1 + ((cam.k3*r2 + cam.k2)*r2 + cam.k1)*r2;
+
+    src_x = cam.fx*(x*kr + cam.p1*_2xy + cam.p2*(r2 + 2*x2)) + cam.cx;
+    src_y = cam.fy*(y*kr + cam.p1*(r2 + 2*y2) + cam.p2*_2xy) + cam.cy;
+}
+
+// ----> Two points per iteration
+// The points are processed in double precision as by the scalar functions, with the same sequence of operations, so
+// that the results do not depend on the instruction set. ARMv7 NEON has no double precision lanes: scalar only.
+#if defined(__SSE2__)
+#define POINT_SIMD
+typedef __m128d Double2;
+
+inline Double2 dup( double v ) {return _mm_set1_pd(v);}
+inline Double2 set( double a, double b ) {return _mm_setr_pd(a,b);}
+inline Double2 add( Double2 a, Double2 b ) {return _mm_add_pd(a,b);}
+inline Double2 sub( Double2 a, Double2 b ) {return _mm_sub_pd(a,b);}
+inline Double2 mul( Double2 a, Double2 b ) {return _mm_mul_pd(a,b);}
+inline Double2 div( Double2 a, Double2 b ) {return _mm_div_pd(a,b);}
+inline void store( double* p, Double2 a ) {_mm_storeu_pd(p,a);}
+
+// Clamp to [0,hi], NaN gives 0 as `a>0.0 ? std::min(a,hi) : 0.0`: the second operand is returned for NaN
+inline Double2 clamp( Double2 a, Double2 hi ) {return _mm_min_pd(_mm_max_pd(a,_mm_setzero_pd()),hi);}
+
+// a if lo<=t<=hi for both t and u, else b. NaN gives b.
+inline Double2 selectInside( Double2 t, Double2 u, Double2 lo, Double2 hi, Double2 a, Double2 b )
+{
+    const __m128d m = _mm_and_pd(_mm_and_pd(_mm_cmpge_pd(t,lo),_mm_cmple_pd(t,hi)),
+                                 _mm_and_pd(_mm_cmpge_pd(u,lo),_mm_cmple_pd(u,hi)));
+    return _mm_or_pd(_mm_and_pd(m,a),_mm_andnot_pd(m,b));
+}
+
+// Interleaved x0,y0,x1,y1 floats to x and y lanes
+inline void loadPoints( const float* p, Double2& x, Double2& y )
+{
+    const __m128 v = _mm_loadu_ps(p);
+    const __m128d p0 = _mm_cvtps_pd(v);
+    const __m128d p1 = _mm_cvtps_pd(_mm_movehl_ps(v,v));
+    x = _mm_unpacklo_pd(p0,p1);
+    y = _mm_unpackhi_pd(p0,p1);
+}
+
+// Four consecutive floats of two points to one lane per float: v[k] = {a[k],b[k]}
+inline void loadNodes( const float* a, const float* b, Double2 v[4] )
+{
+    const __m128 va = _mm_loadu_ps(a);
+    const __m128 vb = _mm_loadu_ps(b);
+    const __m128d a01 = _mm_cvtps_pd(va), a23 = _mm_cvtps_pd(_mm_movehl_ps(va,va));
+    const __m128d b01 = _mm_cvtps_pd(vb), b23 = _mm_cvtps_pd(_mm_movehl_ps(vb,vb));
+    v[0] = _mm_unpacklo_pd(a01,b01);
+    v[1] = _mm_unpackhi_pd(a01,b01);
+    v[2] = _mm_unpacklo_pd(a23,b23);
+    v[3] = _mm_unpackhi_pd(a23,b23);
+}
+
+inline void storePoints( float* p, Double2 x, Double2 y )
+{
+    const __m128 p0 = _mm_cvtpd_ps(_mm_unpacklo_pd(x,y));
+    const __m128 p1 = _mm_cvtpd_ps(_mm_unpackhi_pd(x,y));
+    _mm_storeu_ps(p, _mm_movelh_ps(p0,p1));
+}
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#define POINT_SIMD
+typedef float64x2_t Double2;
+
+inline Double2 dup( double v ) {return vdupq_n_f64(v);}
+inline Double2 set( double a, double b ) {return vsetq_lane_f64(b, vdupq_n_f64(a), 1);}
+inline Double2 add( Double2 a, Double2 b ) {return vaddq_f64(a,b);}
+inline Double2 sub( Double2 a, Double2 b ) {return vsubq_f64(a,b);}
+inline Double2 mul( Double2 a, Double2 b ) {return vmulq_f64(a,b);}
+inline Double2 div( Double2 a, Double2 b ) {return vdivq_f64(a,b);}
+inline void store( double* p, Double2 a ) {vst1q_f64(p,a);}
+
+// Clamp to [0,hi], NaN gives 0 as `a>0.0 ? std::min(a,hi) : 0.0`: maxnm returns the number for NaN
+inline Double2 clamp( Double2 a, Double2 hi ) {return vminnmq_f64(vmaxnmq_f64(a,vdupq_n_f64(0.0)),hi);}
+
+// a if lo<=t<=hi for both t and u, else b. NaN gives b.
+inline Double2 selectInside( Double2 t, Double2 u, Double2 lo, Double2 hi, Double2 a, Double2 b )
+{
+    const uint64x2_t m = vandq_u64(vandq_u64(vcgeq_f64(t,lo),vcleq_f64(t,hi)),
+                                   vandq_u64(vcgeq_f64(u,lo),vcleq_f64(u,hi)));
+    return vbslq_f64(m,a,b);
+}
+
+// Interleaved x0,y0,x1,y1 floats to x and y lanes
+inline void loadPoints( const float* p, Double2& x, Double2& y )
+{
+    const float32x2x2_t v = vld2_f32(p);
+    x = vcvt_f64_f32(v.val[0]);
+    y = vcvt_f64_f32(v.val[1]);
+}
+
+// Four consecutive floats of two points to one lane per float: v[k] = {a[k],b[k]}
+inline void loadNodes( const float* a, const float* b, Double2 v[4] )
+{
+    const float32x4_t va = vld1q_f32(a);
+    const float32x4_t vb = vld1q_f32(b);
+    const float64x2_t a01 = vcvt_f64_f32(vget_low_f32(va)), a23 = vcvt_high_f64_f32(va);
+    const float64x2_t b01 = vcvt_f64_f32(vget_low_f32(vb)), b23 = vcvt_high_f64_f32(vb);
+    v[0] = vzip1q_f64(a01,b01);
+    v[1] = vzip2q_f64(a01,b01);
+    v[2] = vzip1q_f64(a23,b23);
+    v[3] = vzip2q_f64(a23,b23);
+}
+
+inline void storePoints( float* p, Double2 x, Double2 y )
+{
+    float32x2x2_t v;
+    v.val[0] = vcvt_f32_f64(x);
+    v.val[1] = vcvt_f32_f64(y);
+    vst2_f32(p, v);
+}
+#endif
+
+#ifdef POINT_SIMD
+/*!
+ * \brief The parameters of \ref unrectifyPoint, broadcast to both lanes
+ */
+struct Unrectify2
+{
+    Double2 iKR[9];
+    Double2 fx, fy, cx, cy, k1, k2, k3, p1, p2;
+
+    Unrectify2( const CameraIntrinsics& cam, const double ikr[9] )
+    {
+        for( int i=0; i<9; i++ )
+            iKR[i] = dup(ikr[i]);
+        fx = dup(cam.fx); fy = dup(cam.fy); cx = dup(cam.cx); cy = dup(cam.cy);
+        k1 = dup(cam.k1); k2 = dup(cam.k2); k3 = dup(cam.k3); p1 = dup(cam.p1); p2 = dup(cam.p2);
+    }
+
+    //! Same operations of \ref unrectifyPoint
+    inline void apply( Double2 u, Double2 v, Double2& src_x, Double2& src_y ) const
+    {
+        const Double2 one = dup(1.0), two = dup(2.0);
+        const Double2 w = div(one, add(add(mul(iKR[6],u), mul(iKR[7],v)), iKR[8]));
+        const Double2 x = mul(add(add(mul(iKR[0],u), mul(iKR[1],v)), iKR[2]), w);
+        const Double2 y = mul(add(add(mul(iKR[3],u), mul(iKR[4],v)), iKR[5]), w);
+        const Double2 x2 = mul(x,x), y2 = mul(y,y);
+        const Double2 r2 = add(x2,y2), _2xy = mul(mul(two,x),y);
+        const Double2 kr = add(one, mul(add(mul(add(mul(k3,r2),k2),r2),k1),r2));
+
+        src_x = add(mul(fx, add(add(mul(x,kr), mul(p1,_2xy)), mul(p2,add(r2,mul(two,x2))))), cx);
+        src_y = add(mul(fy, add(add(mul(y,kr), mul(p1,add(r2,mul(two,y2)))), mul(p2,_2xy))), cy);
+    }
+};
+#endif
+// <---- Two points per iteration
+
+}
+
+bool PointRectifier::init( const StereoCameraParams& calib, int grid_step )
+{
+    RectificationParams rect;
+    if( !StereoRectify::compute(calib, rect) )
+        return false;
+
+    return init(calib, rect, grid_step);
+}
+
+bool PointRectifier::init( const StereoCameraParams& calib, const RectificationParams& rect, int grid_step )
+{
+    if( !calib.valid || grid_step<1 || calib.width<2 || calib.height<2 )
+        return false;
+
+    mRect = rect;
+    mGridStep = grid_step;
+    mGridCols = (calib.width-1 + grid_step-1)/grid_step + 1;
+    mGridRows = (calib.height-1 + grid_step-1)/grid_step + 1;
+
+    for( int s=0; s<2; s++ )
+    {
+        Side& side = mSides[s];
+        side.cam = s==0 ? calib.left : calib.right;
+        const double* R = s==0 ? rect.R_left : rect.R_right;
+        const double* P = s==0 ? rect.P_left : rect.P_right;
+
+        if( !StereoRectify::invertProjection(R, P, side.iKR) )
+        {
+            mSides[0].lut.clear();
+            return false;
+        }
+
+        // ----> Inverse distortion grid
+        side.lut.resize(static_cast<size_t>(mGridCols)*mGridRows*2);
+        float* node = side.lut.data();
+        for( int gy=0; gy<mGridRows; gy++ )
+        {
+            for( int gx=0; gx<mGridCols; gx++, node+=2 )
+            {
+                double x = gx*grid_step;
+                double y = gy*grid_step;
+                StereoRectify::undistortPoint(side.cam, R, P, 4, x, y, GRID_ITERATIONS);
+                node[0] = static_cast<float>(x);
+                node[1] = static_cast<float>(y);
+            }
+        }
+        // <---- Inverse distortion grid
+    }
+
+    return true;
+}
+
+void PointRectifier::rectifyPoints( CAM_SENS_POS side, const float* src, float* dst, size_t count ) const
+{
+    const Side& s = mSides[side==CAM_SENS_POS::LEFT ? 0 : 1];
+    if( s.lut.empty() )
+        return;
+
+    const float* lut = s.lut.data();
+    const size_t row_step = static_cast<size_t>(mGridCols)*2;
+    const double inv_step = 1.0/mGridStep;
+    const double max_col = mGridCols-2;
+    const double max_row = mGridRows-2;
+
+    size_t i = 0;
+
+#ifdef POINT_SIMD
+    // The cells are gathered with scalar loads, the interpolation and the Newton step run on both lanes
+    const Unrectify2 model(s.cam, s.iKR);
+    const Double2 v_inv_step = dup(inv_step);
+    const Double2 v_max_col = dup(max_col);
+    const Double2 v_max_row = dup(max_row);
+    const Double2 v_lo = dup(-1.0);
+    const Double2 v_hi = dup(2.0);
+
+    for( ; i+2<=count; i+=2 )
+    {
+        Double2 px, py;
+        loadPoints(src+2*i, px, py);
+        const Double2 gx = mul(px, v_inv_step);
+        const Double2 gy = mul(py, v_inv_step);
+
+        // ----> Gather of the cells
+        double cell_x[2], cell_y[2];
+        store(cell_x, clamp(gx, v_max_col));
+        store(cell_y, clamp(gy, v_max_row));
+        const int cx0 = static_cast<int>(cell_x[0]), cx1 = static_cast<int>(cell_x[1]);
+        const int cy0 = static_cast<int>(cell_y[0]), cy1 = static_cast<int>(cell_y[1]);
+        const float* a = lut + cy0*row_step + cx0*2;
+        const float* b = lut + cy1*row_step + cx1*2;
+
+        Double2 n0[4], n1[4];
+        loadNodes(a, b, n0);
+        loadNodes(a+row_step, b+row_step, n1);
+        // <---- Gather of the cells
+
+        const Double2 tx = sub(gx, set(cx0, cx1));
+        const Double2 ty = sub(gy, set(cy0, cy1));
+
+        // ----> Bilinear interpolation of the grid
+        const Double2 dx0 = sub(n0[2], n0[0]), dy0 = sub(n0[3], n0[1]);
+        const Double2 dx1 = sub(n1[2], n1[0]), dy1 = sub(n1[3], n1[1]);
+        const Double2 x0 = add(n0[0], mul(dx0,tx)), y0 = add(n0[1], mul(dy0,tx));
+        const Double2 x1 = add(n1[0], mul(dx1,tx)), y1 = add(n1[1], mul(dy1,tx));
+
+        Double2 rx = add(x0, mul(sub(x1,x0),ty));
+        Double2 ry = add(y0, mul(sub(y1,y0),ty));
+        // <---- Bilinear interpolation of the grid
+
+        // ----> Newton step
+        Double2 ux, uy;
+        model.apply(rx, ry, ux, uy);
+
+        const Double2 ex = mul(sub(px,ux), v_inv_step);
+        const Double2 ey = mul(sub(py,uy), v_inv_step);
+        const Double2 nx = add(rx, add(mul(add(dx0, mul(sub(dx1,dx0),ty)),ex), mul(sub(x1,x0),ey)));
+        const Double2 ny = add(ry, add(mul(add(dy0, mul(sub(dy1,dy0),ty)),ex), mul(sub(y1,y0),ey)));
+        rx = selectInside(tx, ty, v_lo, v_hi, nx, rx);
+        ry = selectInside(tx, ty, v_lo, v_hi, ny, ry);
+        // <---- Newton step
+
+        storePoints(dst+2*i, rx, ry);
+    }
+#endif
+
+    // Scalar tail (or full loop if SIMD is not available)
+    for( ; i<count; i++ )
+    {
+        const double px = src[2*i];
+        const double py = src[2*i+1];
+        const double gx = px*inv_step;
+        const double gy = py*inv_step;
+
+        // Cell of the point, the border cells extrapolate the points outside the grid. NaN selects the first cell.
+        const int cx = static_cast<int>(gx>0.0 ? std::min(gx, max_col) : 0.0);
+        const int cy = static_cast<int>(gy>0.0 ? std::min(gy, max_row) : 0.0);
+        const double tx = gx - cx;
+        const double ty = gy - cy;
+
+        const float* n0 = lut + cy*row_step + cx*2;
+        const float* n1 = n0 + row_step;
+
+        // ----> Bilinear interpolation of the grid
+        const double dx0 = static_cast<double>(n0[2])-n0[0], dy0 = static_cast<double>(n0[3])-n0[1];
+        const double dx1 = static_cast<double>(n1[2])-n1[0], dy1 = static_cast<double>(n1[3])-n1[1];
+        const double x0 = n0[0] + dx0*tx, y0 = n0[1] + dy0*tx;
+        const double x1 = n1[0] + dx1*tx, y1 = n1[1] + dy1*tx;
+
+        double rx = x0 + (x1-x0)*ty;
+        double ry = y0 + (y1-y0)*ty;
+        // <---- Bilinear interpolation of the grid
+
+        // ----> Newton step
+        // The derivatives of the interpolation approximate the inverse Jacobian of the analytic model, that gives
+        // the residual of the interpolated point: the error becomes quadratic in the interpolation error. Points far
+        // from the grid are only extrapolated, the distortion model is not meaningful there.
+        if( tx>=-1.0 && tx<=2.0 && ty>=-1.0 && ty<=2.0 )
+        {
+            double ux, uy;
+            unrectifyPoint(s.cam, s.iKR, rx, ry, ux, uy);
+
+            const double ex = (px - ux)*inv_step;
+            const double ey = (py - uy)*inv_step;
+            rx += (dx0 + (dx1-dx0)*ty)*ex + (x1-x0)*ey;
+            ry += (dy0 + (dy1-dy0)*ty)*ex + (y1-y0)*ey;
+        }
+        // <---- Newton step
+
+        dst[2*i] = static_cast<float>(rx);
+        dst[2*i+1] = static_cast<float>(ry);
+    }
+}
+
+void PointRectifier::unrectifyPoints( CAM_SENS_POS side, const float* src, float* dst, size_t count ) const
+{
+    const Side& s = mSides[side==CAM_SENS_POS::LEFT ? 0 : 1];
+    if( s.lut.empty() )
+        return;
+
+    size_t i = 0;
+
+#ifdef POINT_SIMD
+    const Unrectify2 model(s.cam, s.iKR);
+    for( ; i+2<=count; i+=2 )
+    {
+        Double2 u, v, x, y;
+        loadPoints(src+2*i, u, v);
+        model.apply(u, v, x, y);
+        storePoints(dst+2*i, x, y);
+    }
+#endif
+
+    // Scalar tail (or full loop if SIMD is not available)
+    for( ; i<count; i++ )
+    {
+        double x, y;
+        unrectifyPoint(s.cam, s.iKR, src[2*i], src[2*i+1], x, y);
+        dst[2*i] = static_cast<float>(x);
+        dst[2*i+1] = static_cast<float>(y);
+    }
+}
+
+size_t PointRectifier::getLutMemory() const
+{
+    return (mSides[0].lut.size() + mSides[1].lut.size())*sizeof(float);
+}
+
+}
+
+}
@@ -0,0 +1,331 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "rectificationmanager.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace sl_oc {
+
+namespace video {
+
+const size_t RectificationManager::DEFAULT_MEMORY_BUDGET;
+
+RectificationManager::RectificationManager( WorkerPool* pool )
+    : mPool(pool)
+{
+}
+
+RectificationManager::~RectificationManager()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCond.notify_all();
+
+    if( mBuilder.joinable() )
+        mBuilder.join();
+}
+
+std::shared_ptr<Rectifier> RectificationManager::buildRectifier( const StereoCameraParams& calib,
+                                                                 const RectificationParams& rect, int grid_step,
+                                                                 WorkerPool* pool )
+{
+    const int BAND_ROWS = 32;
+
+    const int width = rect.width;
+    const int height = rect.height;
+    std::vector<float> map_x(static_cast<size_t>(width)*height);
+    std::vector<float> map_y(static_cast<size_t>(width)*height);
+
+    std::shared_ptr<Rectifier> rectifier = std::make_shared<Rectifier>(pool);
+    rectifier->setMapGridStep(grid_step);
+
+    for( int s=0; s<2; s++ )
+    {
+        const CameraIntrinsics& cam = s==0 ? calib.left : calib.right;
+        const double* R = s==0 ? rect.R_left : rect.R_right;
+        const double* P = s==0 ? rect.P_left : rect.P_right;
+
+        if( pool )
+        {
+            pool->parallelFor(static_cast<size_t>((height+BAND_ROWS-1)/BAND_ROWS), [&]( size_t band )
+            {
+                const int row_begin = static_cast<int>(band)*BAND_ROWS;
+                const int row_end = std::min(row_begin+BAND_ROWS, height);
+                StereoRectify::computeMap(cam, R, P, width, row_begin, row_end, map_x.data(), map_y.data());
+            });
+        }
+        else
+            StereoRectify::computeMap(cam, R, P, width, 0, height, map_x.data(), map_y.data());
+
+        if( !rectifier->setMaps(s==0 ? CAM_SENS_POS::LEFT : CAM_SENS_POS::RIGHT, map_x.data(), map_y.data(),
+                                width, height, calib.width, calib.height) )
+            return nullptr;
+    }
+
+    return rectifier;
+}
+
+bool RectificationManager::setCalibration( const StereoCalibration& calib, RESOLUTION res )
+{
+    const int current = static_cast<int>(res);
+    if( current<0 || current>=StereoCalibration::RESOLUTION_COUNT )
+        return false;
+
+    int grid_step = 0;
+    double scale = 1.0;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        grid_step = mGridStep;
+        scale = mScale;
+    }
+
+    // ----> Rectification of all the resolutions, maps of the current one
+    Entry entries[StereoCalibration::RESOLUTION_COUNT];
+    for( int r=0; r<StereoCalibration::RESOLUTION_COUNT; r++ )
+    {
+        entries[r].calib = calib.getParams(static_cast<RESOLUTION>(r));
+        entries[r].valid = StereoRectify::compute(entries[r].calib, entries[r].rect);
+        if( entries[r].valid && scale!=1.0 )
+            StereoRectify::scale(entries[r].rect, scale, entries[r].rect);
+    }
+
+    if( entries[current].valid )
+        entries[current].rectifier = buildRectifier(entries[current].calib, entries[current].rect, grid_step,
+                                                    mPool);
+    // <---- Rectification of all the resolutions, maps of the current one
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mGeneration++;
+    mQueue.clear();
+    mCurrent = current;
+    for( int r=0; r<StereoCalibration::RESOLUTION_COUNT; r++ )
+        mEntries[r] = entries[r];
+    mEntries[current].last_use = ++mTick;
+
+    return mEntries[current].rectifier!=nullptr;
+}
+
+bool RectificationManager::setResolution( RESOLUTION res )
+{
+    const int r = static_cast<int>(res);
+    if( r<0 || r>=StereoCalibration::RESOLUTION_COUNT )
+        return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mCurrent = r;
+    Entry& entry = mEntries[r];
+    if( !entry.rectifier )
+    {
+        request(r);
+        return false;
+    }
+
+    entry.last_use = ++mTick;
+    evict();
+    return true;
+}
+
+RESOLUTION RectificationManager::getResolution() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return static_cast<RESOLUTION>(mCurrent);
+}
+
+void RectificationManager::prefetch( RESOLUTION res )
+{
+    const int r = static_cast<int>(res);
+    if( r<0 || r>=StereoCalibration::RESOLUTION_COUNT )
+        return;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    request(r);
+}
+
+bool RectificationManager::isReady( RESOLUTION res ) const
+{
+    const int r = static_cast<int>(res);
+    if( r<0 || r>=StereoCalibration::RESOLUTION_COUNT )
+        return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries[r].rectifier!=nullptr;
+}
+
+std::shared_ptr<Rectifier> RectificationManager::getRectifier()
+{
+    return getRectifier(getResolution());
+}
+
+std::shared_ptr<Rectifier> RectificationManager::getRectifier( RESOLUTION res )
+{
+    const int r = static_cast<int>(res);
+    if( r<0 || r>=StereoCalibration::RESOLUTION_COUNT )
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    Entry& entry = mEntries[r];
+    if( !entry.rectifier )
+    {
+        request(r);
+        return nullptr;
+    }
+
+    entry.last_use = ++mTick;
+    return entry.rectifier;
+}
+
+bool RectificationManager::getRectification( RESOLUTION res, RectificationParams& rect ) const
+{
+    const int r = static_cast<int>(res);
+    if( r<0 || r>=StereoCalibration::RESOLUTION_COUNT )
+        return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if( !mEntries[r].valid )
+        return false;
+
+    rect = mEntries[r].rect;
+    return true;
+}
+
+void RectificationManager::setMemoryBudget( size_t bytes )
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mBudget = bytes;
+    evict();
+}
+
+size_t RectificationManager::getMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    size_t total = 0;
+    for( const Entry& entry : mEntries )
+    {
+        if( entry.rectifier )
+            total += entry.rectifier->getMapMemory();
+    }
+    return total;
+}
+
+void RectificationManager::setMapGridStep( int grid_step )
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mGridStep = grid_step;
+}
+
+bool RectificationManager::setOutputScale( double scale )
+{
+    if( !(scale>0.0) || !std::isfinite(scale) )
+        return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mScale = scale;
+    return true;
+}
+
+void RectificationManager::request( int r )
+{
+    Entry& entry = mEntries[r];
+    if( !entry.valid || entry.pending || entry.rectifier )
+        return;
+
+    entry.pending = true;
+    mQueue.push_back(r);
+
+    if( !mBuilder.joinable() )
+        mBuilder = std::thread(&RectificationManager::builderFunc, this);
+    mCond.notify_one();
+}
+
+void RectificationManager::evict()
+{
+    size_t total = 0;
+    for( const Entry& entry : mEntries )
+    {
+        if( entry.rectifier )
+            total += entry.rectifier->getMapMemory();
+    }
+
+    while( total>mBudget )
+    {
+        // Least recently used maps, excluding the current resolution
+        int lru = -1;
+        for( int r=0; r<StereoCalibration::RESOLUTION_COUNT; r++ )
+        {
+            if( r!=mCurrent && mEntries[r].rectifier && (lru<0 || mEntries[r].last_use<mEntries[lru].last_use) )
+                lru = r;
+        }
+        if( lru<0 )
+            break;
+
+        total -= mEntries[lru].rectifier->getMapMemory();
+        mEntries[lru].rectifier.reset();
+    }
+}
+
+void RectificationManager::builderFunc()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    for(;;)
+    {
+        mCond.wait(lock, [this]{return mStop || !mQueue.empty();});
+        if( mStop )
+            return;
+
+        const int r = mQueue.front();
+        mQueue.pop_front();
+
+        const uint64_t generation = mGeneration;
+        const StereoCameraParams calib = mEntries[r].calib;
+        const RectificationParams rect = mEntries[r].rect;
+        const int grid_step = mGridStep;
+
+        // The maps are built on this thread only: the worker pool is left to the rectification of the frames
+        lock.unlock();
+        std::shared_ptr<Rectifier> rectifier = buildRectifier(calib, rect, grid_step, nullptr);
+        if( rectifier )
+            rectifier->setWorkerPool(mPool);
+        lock.lock();
+
+        if( generation!=mGeneration || mStop )
+            continue;
+
+        Entry& entry = mEntries[r];
+        entry.pending = false;
+        entry.valid = rectifier!=nullptr;
+        entry.rectifier = rectifier;
+        entry.last_use = ++mTick;
+        evict();
+    }
+}
+
+}
+
+}
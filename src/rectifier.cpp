@@ -0,0 +1,988 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "rectifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace sl_oc {
+
+namespace video {
+
+const int Rectifier::MAP_FRAC_BITS;
+const uint16_t Rectifier::MAP_INVALID;
+const int Rectifier::MAX_SRC_SIZE;
+const int Rectifier::MAX_GRID_STEP;
+const int Rectifier::BAND_ROWS;
+
+namespace {
+
+const int FRAC_ONE = 1<<Rectifier::MAP_FRAC_BITS;
+const int FRAC_MASK = FRAC_ONE-1;
+
+const size_t CACHE_LINE_SIZE = 64;
+const size_t PREFETCH_MAX_BYTES = 32*1024;  // Areas larger than the L1 cache are not prefetched
+
+/*!
+ * \brief Convert a source coordinate to Q12.4. Coordinates within half a pixel from the image are clamped, so that
+ *        the bilinear interpolation never reads outside the image.
+ */
+inline uint16_t toFixed(float v, int size)
+{
+    if( !(v >= -0.5f && v < size-0.5f) ) // NaN is invalid too
+        return Rectifier::MAP_INVALID;
+
+    // Rounded half up: negative values are clamped to 0 anyway
+    const int q = static_cast<int>(v*FRAC_ONE + 0.5f);
+    return static_cast<uint16_t>(std::min(std::max(q, 0), (size-1)*FRAC_ONE-1));
+}
+
+const int GRID_FRAC_BITS = 12;  // Additional fractional bits of the coordinates interpolated from the map grid
+const int32_t GRID_HALF = 1<<(GRID_FRAC_BITS-1);
+const float GRID_LIMIT = 2.f*Rectifier::MAX_SRC_SIZE; // Far outside the image, avoids the integer overflow
+
+/*!
+ * \brief Convert a source coordinate interpolated from the map grid to Q12.4 with GRID_FRAC_BITS more fractional bits
+ */
+inline int32_t toGridFixed( float v )
+{
+    v = std::min(std::max(v, -GRID_LIMIT), GRID_LIMIT);
+    return static_cast<int32_t>(std::floor(v*(FRAC_ONE<<GRID_FRAC_BITS) + 0.5f));
+}
+
+/*!
+ * \brief Limits of the coordinates interpolated from the map grid, as toFixed
+ */
+struct GridLimits
+{
+    int32_t min_a;      //!< Minimum valid coordinate, with GRID_FRAC_BITS more fractional bits
+    int32_t max_ax;     //!< Limit of the valid X coordinates, with GRID_FRAC_BITS more fractional bits
+    int32_t max_ay;     //!< Limit of the valid Y coordinates, with GRID_FRAC_BITS more fractional bits
+    int32_t max_x;      //!< Maximum Q12.4 X coordinate
+    int32_t max_y;      //!< Maximum Q12.4 Y coordinate
+};
+
+/*!
+ * \brief Convert a coordinate with GRID_FRAC_BITS more fractional bits to Q12.4
+ */
+inline uint16_t fromGridFixed( int32_t ax, int32_t ay, const GridLimits& lim, uint16_t& y )
+{
+    if( ax<lim.min_a || ax>=lim.max_ax || ay<lim.min_a || ay>=lim.max_ay )
+    {
+        y = Rectifier::MAP_INVALID;
+        return Rectifier::MAP_INVALID;
+    }
+
+    y = static_cast<uint16_t>(std::min(std::max((ay+GRID_HALF)>>GRID_FRAC_BITS, 0), lim.max_y));
+    return static_cast<uint16_t>(std::min(std::max((ax+GRID_HALF)>>GRID_FRAC_BITS, 0), lim.max_x));
+}
+
+/*!
+ * \brief Step `count` coordinates along a cell of the map grid, same arithmetic of \ref fromGridFixed
+ */
+inline void stepGrid( int32_t ax, int32_t dax, int32_t ay, int32_t day, int count, const GridLimits& lim,
+                      uint16_t* out_x, uint16_t* out_y )
+{
+    int k = 0;
+
+#if defined(__SSE2__)
+    const __m128i half = _mm_set1_epi32(GRID_HALF);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+    const __m128i invalid = _mm_set1_epi32(0xFFFF);
+    const __m128i min_a = _mm_set1_epi32(lim.min_a-1);
+    const __m128i max_ax = _mm_set1_epi32(lim.max_ax);
+    const __m128i max_ay = _mm_set1_epi32(lim.max_ay);
+    const __m128i max_x = _mm_set1_epi32(lim.max_x);
+    const __m128i max_y = _mm_set1_epi32(lim.max_y);
+    const __m128i step_x = _mm_set1_epi32(4*dax);
+    const __m128i step_y = _mm_set1_epi32(4*day);
+
+    __m128i vx = _mm_setr_epi32(ax, ax+dax, ax+2*dax, ax+3*dax);
+    __m128i vy = _mm_setr_epi32(ay, ay+day, ay+2*day, ay+3*day);
+
+    for( ; k+4<=count; k+=4, vx=_mm_add_epi32(vx, step_x), vy=_mm_add_epi32(vy, step_y) )
+    {
+        __m128i valid = _mm_and_si128(_mm_cmpgt_epi32(vx, min_a), _mm_cmplt_epi32(vx, max_ax));
+        valid = _mm_and_si128(valid, _mm_and_si128(_mm_cmpgt_epi32(vy, min_a), _mm_cmplt_epi32(vy, max_ay)));
+
+        // Clamp with compare and select, SSE2 has no 32 bit min and max
+        __m128i x = _mm_srai_epi32(_mm_add_epi32(vx, half), GRID_FRAC_BITS);
+        __m128i y = _mm_srai_epi32(_mm_add_epi32(vy, half), GRID_FRAC_BITS);
+        x = _mm_andnot_si128(_mm_cmplt_epi32(x, zero), x);
+        y = _mm_andnot_si128(_mm_cmplt_epi32(y, zero), y);
+        __m128i over = _mm_cmpgt_epi32(x, max_x);
+        x = _mm_or_si128(_mm_and_si128(over, max_x), _mm_andnot_si128(over, x));
+        over = _mm_cmpgt_epi32(y, max_y);
+        y = _mm_or_si128(_mm_and_si128(over, max_y), _mm_andnot_si128(over, y));
+
+        // Invalid coordinates to 0xFFFF, then unsigned 16 bit packing through the signed one
+        x = _mm_sub_epi32(_mm_or_si128(x, _mm_andnot_si128(valid, invalid)), bias);
+        y = _mm_sub_epi32(_mm_or_si128(y, _mm_andnot_si128(valid, invalid)), bias);
+        const __m128i xy = _mm_xor_si128(_mm_packs_epi32(x, y), bias16);
+
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out_x+k), xy);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out_y+k), _mm_srli_si128(xy, 8));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const int32_t lane[4] = {0, 1, 2, 3};
+    const int32x4_t idx = vld1q_s32(lane);
+    const int32x4_t half = vdupq_n_s32(GRID_HALF);
+    const int32x4_t zero = vdupq_n_s32(0);
+    const int32x4_t min_a = vdupq_n_s32(lim.min_a);
+    const int32x4_t max_ax = vdupq_n_s32(lim.max_ax);
+    const int32x4_t max_ay = vdupq_n_s32(lim.max_ay);
+    const int32x4_t max_x = vdupq_n_s32(lim.max_x);
+    const int32x4_t max_y = vdupq_n_s32(lim.max_y);
+    const int32x4_t step_x = vdupq_n_s32(4*dax);
+    const int32x4_t step_y = vdupq_n_s32(4*day);
+
+    int32x4_t vx = vmlaq_n_s32(vdupq_n_s32(ax), idx, dax);
+    int32x4_t vy = vmlaq_n_s32(vdupq_n_s32(ay), idx, day);
+
+    for( ; k+4<=count; k+=4, vx=vaddq_s32(vx, step_x), vy=vaddq_s32(vy, step_y) )
+    {
+        uint32x4_t valid = vandq_u32(vcgeq_s32(vx, min_a), vcltq_s32(vx, max_ax));
+        valid = vandq_u32(valid, vandq_u32(vcgeq_s32(vy, min_a), vcltq_s32(vy, max_ay)));
+
+        const int32x4_t x = vminq_s32(vmaxq_s32(vshrq_n_s32(vaddq_s32(vx, half), GRID_FRAC_BITS), zero), max_x);
+        const int32x4_t y = vminq_s32(vmaxq_s32(vshrq_n_s32(vaddq_s32(vy, half), GRID_FRAC_BITS), zero), max_y);
+
+        // Invalid coordinates to 0xFFFFFFFF, narrowed to 0xFFFF
+        vst1_u16(out_x+k, vmovn_u32(vorrq_u32(vreinterpretq_u32_s32(x), vmvnq_u32(valid))));
+        vst1_u16(out_y+k, vmovn_u32(vorrq_u32(vreinterpretq_u32_s32(y), vmvnq_u32(valid))));
+    }
+#endif
+
+    for( ; k<count; k++ )
+        out_x[k] = fromGridFixed(ax+k*dax, ay+k*day, lim, out_y[k]);
+}
+
+/*!
+ * \brief Value of a full size map at a grid node. Nodes beyond the last row or column are linearly extrapolated.
+ */
+float sampleMap( const float* map, int width, int height, int x, int y )
+{
+    const int cx = std::min(x, width-1);
+    const int cy = std::min(y, height-1);
+    const float* p = map + static_cast<size_t>(cy)*width + cx;
+
+    float v = p[0];
+    if( x>cx )
+        v += (x-cx)*(p[0]-p[-1]);
+    if( y>cy )
+        v += (y-cy)*(p[0]-p[-width]);
+    return v;
+}
+
+/*!
+ * \brief Bilinear interpolation with 4 bit weights. `top` and `bot` contain the pixel pairs of the two source rows,
+ *        the left pixel in the low byte.
+ */
+inline uint8_t interpolate1(uint16_t top, uint16_t bot, uint16_t mx, uint16_t my)
+{
+    const int fx = mx&FRAC_MASK;
+    const int fy = my&FRAC_MASK;
+    const int a = (top&0xFF)*(FRAC_ONE-fx) + (top>>8)*fx;
+    const int b = (bot&0xFF)*(FRAC_ONE-fx) + (bot>>8)*fx;
+    return static_cast<uint8_t>((a*(FRAC_ONE-fy) + b*fy + 128) >> 8);
+}
+
+/*!
+ * \brief Bilinear interpolation of 8 pixels, same arithmetic of \ref interpolate1
+ */
+inline void interpolate8(const uint16_t* top, const uint16_t* bot, const uint16_t* mx, const uint16_t* my, uint8_t* out)
+{
+#if defined(__SSE2__)
+    const __m128i lo_mask = _mm_set1_epi16(0x00FF);
+    const __m128i frac_mask = _mm_set1_epi16(FRAC_MASK);
+    const __m128i one = _mm_set1_epi16(FRAC_ONE);
+    const __m128i round = _mm_set1_epi16(128);
+
+    __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bot));
+    __m128i fx = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mx)), frac_mask);
+    __m128i fy = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(my)), frac_mask);
+    __m128i ifx = _mm_sub_epi16(one, fx);
+
+    // Max value: 255*16*16 + 128, fits in 16 bits unsigned
+    __m128i a = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(t,lo_mask),ifx), _mm_mullo_epi16(_mm_srli_epi16(t,8),fx));
+    __m128i c = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(b,lo_mask),ifx), _mm_mullo_epi16(_mm_srli_epi16(b,8),fx));
+    __m128i r = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(a,_mm_sub_epi16(one,fy)), _mm_mullo_epi16(c,fy)), round);
+    r = _mm_srli_epi16(r, 8);
+
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(r,r));
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint16x8_t lo_mask = vdupq_n_u16(0x00FF);
+    const uint16x8_t frac_mask = vdupq_n_u16(FRAC_MASK);
+    const uint16x8_t one = vdupq_n_u16(FRAC_ONE);
+
+    uint16x8_t t = vld1q_u16(top);
+    uint16x8_t b = vld1q_u16(bot);
+    uint16x8_t fx = vandq_u16(vld1q_u16(mx), frac_mask);
+    uint16x8_t fy = vandq_u16(vld1q_u16(my), frac_mask);
+    uint16x8_t ifx = vsubq_u16(one, fx);
+
+    uint16x8_t a = vmlaq_u16(vmulq_u16(vandq_u16(t,lo_mask),ifx), vshrq_n_u16(t,8), fx);
+    uint16x8_t c = vmlaq_u16(vmulq_u16(vandq_u16(b,lo_mask),ifx), vshrq_n_u16(b,8), fx);
+    uint16x8_t r = vmlaq_u16(vmulq_u16(a,vsubq_u16(one,fy)), c, fy);
+
+    vst1_u8(out, vrshrn_n_u16(r, 8));
+#else
+    for( int k=0; k<8; k++ )
+        out[k] = interpolate1(top[k], bot[k], mx[k], my[k]);
+#endif
+}
+
+/*!
+ * \brief Load the pixel pairs of the two source rows needed to interpolate a pixel. `bpp` is the distance in bytes
+ *        between two horizontally adjacent samples.
+ */
+template<int bpp>
+inline void gather(const uint8_t* src, size_t src_step, uint16_t mx, uint16_t my, uint16_t& top, uint16_t& bot)
+{
+    if( mx==Rectifier::MAP_INVALID )
+    {
+        top = bot = 0;
+        return;
+    }
+
+    const uint8_t* p = src + (my>>Rectifier::MAP_FRAC_BITS)*src_step + (mx>>Rectifier::MAP_FRAC_BITS)*bpp;
+    top = static_cast<uint16_t>(p[0] | (p[bpp]<<8));
+    bot = static_cast<uint16_t>(p[src_step] | (p[src_step+bpp]<<8));
+}
+
+/*!
+ * \brief Load the 3x3 source pixels of the box-filtered interpolation of a pixel in column `k` of `taps`, and its
+ *        weights. The footprint starts half a pixel before the source coordinate and is clamped inside the image.
+ */
+template<int bpp>
+inline void gatherBox(const uint8_t* src, size_t src_step, uint16_t mx, uint16_t my, int max_qx, int max_qy,
+                      uint16_t taps[9][8], uint16_t* gx, uint16_t* gy, int k)
+{
+    if( mx==Rectifier::MAP_INVALID )
+    {
+        for( int i=0; i<9; i++ )
+            taps[i][k] = 0;
+        gx[k] = gy[k] = 0;
+        return;
+    }
+
+    const int qx = std::min(std::max(mx-FRAC_ONE/2, 0), max_qx);
+    const int qy = std::min(std::max(my-FRAC_ONE/2, 0), max_qy);
+    gx[k] = static_cast<uint16_t>(qx&FRAC_MASK);
+    gy[k] = static_cast<uint16_t>(qy&FRAC_MASK);
+
+    const uint8_t* p = src + (qy>>Rectifier::MAP_FRAC_BITS)*src_step + (qx>>Rectifier::MAP_FRAC_BITS)*bpp;
+    for( int r=0; r<3; r++, p+=src_step )
+    {
+        taps[3*r][k] = p[0];
+        taps[3*r+1][k] = p[bpp];
+        taps[3*r+2][k] = p[2*bpp];
+    }
+}
+
+/*!
+ * \brief Bilinear interpolation of the 2x2 box-filtered source. Along each axis the 3 pixels are weighted
+ *        `(16-g, 16, g)/32`: the horizontal sums keep 2 fractional bits so that the vertical sum fits in 16 bits.
+ */
+inline uint8_t interpolateBox1(const uint16_t taps[9][8], const uint16_t* gx, const uint16_t* gy, int k)
+{
+    int h[3];
+    for( int r=0; r<3; r++ )
+    {
+        const int s = (FRAC_ONE-gx[k])*taps[3*r][k] + FRAC_ONE*taps[3*r+1][k] + gx[k]*taps[3*r+2][k];
+        h[r] = (s + 4) >> 3;
+    }
+    return static_cast<uint8_t>(((FRAC_ONE-gy[k])*h[0] + FRAC_ONE*h[1] + gy[k]*h[2] + 64) >> 7);
+}
+
+/*!
+ * \brief Box-filtered interpolation of 8 pixels, same arithmetic of \ref interpolateBox1
+ */
+inline void interpolateBox8(const uint16_t taps[9][8], const uint16_t* gx, const uint16_t* gy, uint8_t* out)
+{
+#if defined(__SSE2__)
+    const __m128i one = _mm_set1_epi16(FRAC_ONE);
+    const __m128i fx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gx));
+    const __m128i fy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gy));
+    const __m128i ifx = _mm_sub_epi16(one, fx);
+
+    // Max horizontal sum: 255*32 = 8160, max vertical sum: 1020*32 = 32640
+    __m128i h[3];
+    for( int r=0; r<3; r++ )
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(taps[3*r]));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(taps[3*r+1]));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(taps[3*r+2]));
+        __m128i s = _mm_add_epi16(_mm_mullo_epi16(a, ifx), _mm_slli_epi16(b, Rectifier::MAP_FRAC_BITS));
+        s = _mm_add_epi16(s, _mm_mullo_epi16(c, fx));
+        h[r] = _mm_srli_epi16(_mm_add_epi16(s, _mm_set1_epi16(4)), 3);
+    }
+
+    __m128i v = _mm_add_epi16(_mm_mullo_epi16(h[0], _mm_sub_epi16(one, fy)),
+                              _mm_slli_epi16(h[1], Rectifier::MAP_FRAC_BITS));
+    v = _mm_add_epi16(v, _mm_mullo_epi16(h[2], fy));
+    v = _mm_srli_epi16(_mm_add_epi16(v, _mm_set1_epi16(64)), 7);
+
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(v,v));
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint16x8_t one = vdupq_n_u16(FRAC_ONE);
+    const uint16x8_t fx = vld1q_u16(gx);
+    const uint16x8_t fy = vld1q_u16(gy);
+    const uint16x8_t ifx = vsubq_u16(one, fx);
+
+    uint16x8_t h[3];
+    for( int r=0; r<3; r++ )
+    {
+        uint16x8_t s = vmlaq_u16(vshlq_n_u16(vld1q_u16(taps[3*r+1]), Rectifier::MAP_FRAC_BITS),
+                                 vld1q_u16(taps[3*r]), ifx);
+        s = vmlaq_u16(s, vld1q_u16(taps[3*r+2]), fx);
+        h[r] = vrshrq_n_u16(s, 3);
+    }
+
+    uint16x8_t v = vmlaq_u16(vshlq_n_u16(h[1], Rectifier::MAP_FRAC_BITS), h[0], vsubq_u16(one, fy));
+    v = vmlaq_u16(v, h[2], fy);
+
+    vst1_u8(out, vrshrn_n_u16(v, 7));
+#else
+    for( int k=0; k<8; k++ )
+        out[k] = interpolateBox1(taps, gx, gy, k);
+#endif
+}
+
+/*!
+ * \brief Prefetch an area of the source image in the cache
+ */
+inline void prefetchArea( const uint8_t* src, size_t src_step, int x, int y, int width, int height, int bpp )
+{
+    const size_t row_bytes = static_cast<size_t>(width)*bpp;
+    if( row_bytes==0 || row_bytes*height>PREFETCH_MAX_BYTES )
+        return;
+
+#if defined(__GNUC__)
+    for( int r=0; r<height; r++ )
+    {
+        const uint8_t* row = src + (y+r)*src_step + x*bpp;
+        for( size_t b=0; b<row_bytes; b+=CACHE_LINE_SIZE )
+            __builtin_prefetch(row+b);
+        __builtin_prefetch(row+row_bytes-1);
+    }
+#else
+    (void)src;
+    (void)src_step;
+    (void)x;
+    (void)y;
+    (void)height;
+#endif
+}
+
+}
+
+Rectifier::Rectifier( WorkerPool* pool )
+    : mPool(pool)
+{
+}
+
+bool Rectifier::setMaps( CAM_SENS_POS side, const float* map_x, const float* map_y, int width, int height,
+                         int src_width, int src_height )
+{
+    if( side!=CAM_SENS_POS::LEFT && side!=CAM_SENS_POS::RIGHT )
+        return false;
+    if( !map_x || !map_y || width<=0 || height<=0 ||
+            src_width<2 || src_height<2 || src_width>MAX_SRC_SIZE || src_height>MAX_SRC_SIZE )
+        return false;
+    if( mGridStep>0 && (width<2 || height<2 || width>MAX_SRC_SIZE) )
+        return false;
+
+    FixedMap& map = mMaps[static_cast<int>(side)];
+    const size_t count = static_cast<size_t>(width)*height;
+    map.width = width;
+    map.height = height;
+    map.src_width = src_width;
+    map.src_height = src_height;
+    map.max_error = 0.f;
+    map.mean_error = 0.f;
+    map.box_filter = 2*width<=src_width && 2*height<=src_height && src_width>=4 && src_height>=4;
+
+    if( mGridStep==0 )
+    {
+        map.grid_cols = map.grid_rows = 0;
+        map.grid_x.clear();
+        map.grid_y.clear();
+        map.grid_x.shrink_to_fit();
+        map.grid_y.shrink_to_fit();
+
+        map.x.resize(count);
+        map.y.resize(count);
+
+        for( size_t i=0; i<count; i++ )
+        {
+            uint16_t x = toFixed(map_x[i], src_width);
+            uint16_t y = toFixed(map_y[i], src_height);
+            if( x==MAP_INVALID || y==MAP_INVALID )
+                x = y = MAP_INVALID;
+            map.x[i] = x;
+            map.y[i] = y;
+        }
+    }
+    else
+    {
+        map.x.clear();
+        map.y.clear();
+        map.x.shrink_to_fit();
+        map.y.shrink_to_fit();
+
+        // ----> Grid nodes, covering the last row and column
+        map.grid_shift = 0;
+        while( (1<<map.grid_shift)<mGridStep )
+            map.grid_shift++;
+        map.grid_cols = ((width-1+mGridStep-1)>>map.grid_shift) + 1;
+        map.grid_rows = ((height-1+mGridStep-1)>>map.grid_shift) + 1;
+        map.grid_x.resize(static_cast<size_t>(map.grid_cols)*map.grid_rows);
+        map.grid_y.resize(map.grid_x.size());
+
+        for( int gy=0; gy<map.grid_rows; gy++ )
+        {
+            for( int gx=0; gx<map.grid_cols; gx++ )
+            {
+                const size_t node = static_cast<size_t>(gy)*map.grid_cols + gx;
+                map.grid_x[node] = sampleMap(map_x, width, height, gx<<map.grid_shift, gy<<map.grid_shift);
+                map.grid_y[node] = sampleMap(map_y, width, height, gx<<map.grid_shift, gy<<map.grid_shift);
+            }
+        }
+        // <---- Grid nodes, covering the last row and column
+    }
+
+    // ----> Error compared to the given map, including the fixed-point quantization
+    // The coordinates are clamped to the last valid fixed-point value like in toFixed, to not count the border clamping
+    const float max_x = ((src_width-1)*FRAC_ONE-1)*(1.f/FRAC_ONE);
+    const float max_y = ((src_height-1)*FRAC_ONE-1)*(1.f/FRAC_ONE);
+    std::vector<uint16_t> buf_x(MAX_SRC_SIZE), buf_y(MAX_SRC_SIZE);
+    double sum = 0.0;
+    size_t valid = 0;
+    for( int r=0; r<height; r++ )
+    {
+        const uint16_t* mx;
+        const uint16_t* my;
+        getMapRow(map, r, 0, width, buf_x.data(), buf_y.data(), mx, my);
+
+        const size_t offset = static_cast<size_t>(r)*width;
+        for( int c=0; c<width; c++ )
+        {
+            float x = map_x[offset+c];
+            float y = map_y[offset+c];
+            if( mx[c]==MAP_INVALID || toFixed(x, src_width)==MAP_INVALID || toFixed(y, src_height)==MAP_INVALID )
+                continue;
+            x = std::min(std::max(x, 0.f), max_x);
+            y = std::min(std::max(y, 0.f), max_y);
+
+            const float err = std::hypot(mx[c]*(1.f/FRAC_ONE) - x, my[c]*(1.f/FRAC_ONE) - y);
+            map.max_error = std::max(map.max_error, err);
+            sum += err;
+            valid++;
+        }
+    }
+    map.mean_error = valid ? static_cast<float>(sum/valid) : 0.f;
+    // <---- Error compared to the given map, including the fixed-point quantization
+
+    updateTiles(map);
+
+    return true;
+}
+
+bool Rectifier::isReady( CAM_SENS_POS side ) const
+{
+    if( side!=CAM_SENS_POS::LEFT && side!=CAM_SENS_POS::RIGHT )
+        return false;
+
+    return mMaps[static_cast<int>(side)].isSet();
+}
+
+void Rectifier::getSize( CAM_SENS_POS side, int& width, int& height, RECT_FORMAT format ) const
+{
+    width = height = 0;
+    if( !isReady(side) )
+        return;
+
+    width = mMaps[static_cast<int>(side)].width;
+    height = mMaps[static_cast<int>(side)].height;
+
+    if( format==RECT_FORMAT::YUYV_TO_GRAY_HALF )
+    {
+        width /= 2;
+        height /= 2;
+    }
+}
+
+size_t Rectifier::getMapMemory() const
+{
+    size_t size = 0;
+    for( const FixedMap& map : mMaps )
+    {
+        size += (map.x.size()+map.y.size())*sizeof(uint16_t);
+        size += (map.grid_x.size()+map.grid_y.size())*sizeof(float);
+    }
+    return size;
+}
+
+void Rectifier::setMapGridStep( int grid_step )
+{
+    if( grid_step<=0 )
+    {
+        mGridStep = 0;
+        return;
+    }
+
+    mGridStep = 1;
+    while( mGridStep<grid_step && mGridStep<MAX_GRID_STEP )
+        mGridStep *= 2;
+}
+
+bool Rectifier::getMapError( CAM_SENS_POS side, float& max_error, float& mean_error ) const
+{
+    if( !isReady(side) )
+        return false;
+
+    max_error = mMaps[static_cast<int>(side)].max_error;
+    mean_error = mMaps[static_cast<int>(side)].mean_error;
+    return true;
+}
+
+void Rectifier::getMapRow( const FixedMap& map, int row, int col_begin, int col_end, uint16_t* buf_x, uint16_t* buf_y,
+                           const uint16_t*& mx, const uint16_t*& my )
+{
+    if( map.grid_cols==0 )
+    {
+        mx = map.x.data() + static_cast<size_t>(row)*map.width;
+        my = map.y.data() + static_cast<size_t>(row)*map.width;
+        return;
+    }
+
+    const int step = 1<<map.grid_shift;
+    const float inv_step = 1.f/step;
+
+    GridLimits lim;
+    lim.min_a = -(FRAC_ONE/2)*(1<<GRID_FRAC_BITS);
+    lim.max_ax = (map.src_width*FRAC_ONE-FRAC_ONE/2)*(1<<GRID_FRAC_BITS);
+    lim.max_ay = (map.src_height*FRAC_ONE-FRAC_ONE/2)*(1<<GRID_FRAC_BITS);
+    lim.max_x = (map.src_width-1)*FRAC_ONE-1;
+    lim.max_y = (map.src_height-1)*FRAC_ONE-1;
+
+    // Nodes of the grid rows above and below. The last node row and column belong to the last cell.
+    const int gy = std::min(row>>map.grid_shift, map.grid_rows-2);
+    const float fy = (row-(gy<<map.grid_shift))*inv_step;
+    const float* x0 = map.grid_x.data() + static_cast<size_t>(gy)*map.grid_cols;
+    const float* y0 = map.grid_y.data() + static_cast<size_t>(gy)*map.grid_cols;
+    const float* x1 = x0 + map.grid_cols;
+    const float* y1 = y0 + map.grid_cols;
+
+    int c = col_begin;
+    while( c<col_end )
+    {
+        // Coordinates interpolated on the row at the cell corners, then stepped along the cell
+        const int gx = std::min(c>>map.grid_shift, map.grid_cols-2);
+        const int cell_end = gx+2<map.grid_cols ? std::min((gx+1)<<map.grid_shift, col_end) : col_end;
+
+        const float xl = x0[gx] + (x1[gx]-x0[gx])*fy;
+        const float yl = y0[gx] + (y1[gx]-y0[gx])*fy;
+        const float xr = x0[gx+1] + (x1[gx+1]-x0[gx+1])*fy;
+        const float yr = y0[gx+1] + (y1[gx+1]-y0[gx+1])*fy;
+        const float dx = (xr-xl)*inv_step;
+        const float dy = (yr-yl)*inv_step;
+        const float t = static_cast<float>(c-(gx<<map.grid_shift));
+
+        // Integer stepping of the Q12.4 coordinates, with GRID_FRAC_BITS more fractional bits
+        const int32_t ax = toGridFixed(xl + dx*t);
+        const int32_t ay = toGridFixed(yl + dy*t);
+        const int32_t dax = toGridFixed(dx);
+        const int32_t day = toGridFixed(dy);
+
+        stepGrid(ax, dax, ay, day, cell_end-c, lim, buf_x+c, buf_y+c);
+        c = cell_end;
+    }
+
+    mx = buf_x;
+    my = buf_y;
+}
+
+bool Rectifier::rectify( CAM_SENS_POS side, RECT_FORMAT format, const uint8_t* src, size_t src_step,
+                         uint8_t* dst, size_t dst_step )
+{
+    if( !isReady(side) || !src || !dst )
+        return false;
+
+    Job job = {&mMaps[static_cast<int>(side)], format, src, src_step, dst, dst_step};
+    run(&job, 1);
+    return true;
+}
+
+bool Rectifier::rectifyStereo( RECT_FORMAT format, const uint8_t* src, size_t src_step,
+                               uint8_t* dst_left, uint8_t* dst_right, size_t dst_step )
+{
+    if( !isReady(CAM_SENS_POS::LEFT) || !isReady(CAM_SENS_POS::RIGHT) || !src || !dst_left || !dst_right )
+        return false;
+
+    // The right image follows the left one in each row of the side-by-side frame
+    const size_t bpp = format==RECT_FORMAT::GRAY?1:2;
+    const uint8_t* src_right = src + mMaps[0].src_width*bpp;
+
+    Job jobs[2] = {{&mMaps[0], format, src, src_step, dst_left, dst_step},
+                   {&mMaps[1], format, src_right, src_step, dst_right, dst_step}};
+    run(jobs, 2);
+    return true;
+}
+
+void Rectifier::setTileSize( int tile_width, int tile_height )
+{
+    if( tile_width<=0 || tile_height<=0 )
+        tile_width = tile_height = 0;
+    else
+    {
+        // Multiple of 16 columns to keep full SIMD blocks at half resolution, even rows for the 2x2 average
+        tile_width = (tile_width+15)/16*16;
+        tile_height = (tile_height+1)/2*2;
+    }
+
+    mTileWidth = tile_width;
+    mTileHeight = tile_height;
+
+    for( FixedMap& map : mMaps )
+    {
+        if( map.isSet() )
+            updateTiles(map);
+    }
+}
+
+void Rectifier::updateTiles( FixedMap& map ) const
+{
+    // Bands of rows when the tiling is disabled
+    const int tile_width = mTileWidth>0 ? mTileWidth : map.width;
+    const int tile_height = mTileHeight>0 ? mTileHeight : BAND_ROWS;
+
+    // The box-filtered interpolation reads one more source pixel on each side
+    const int margin = map.box_filter ? 1 : 0;
+
+    std::vector<uint16_t> buf_x(MAX_SRC_SIZE), buf_y(MAX_SRC_SIZE);
+
+    map.tiles.clear();
+    for( int y=0; y<map.height; y+=tile_height )
+    {
+        for( int x=0; x<map.width; x+=tile_width )
+        {
+            Tile tile;
+            tile.x = x;
+            tile.y = y;
+            tile.width = std::min(tile_width, map.width-x);
+            tile.height = std::min(tile_height, map.height-y);
+
+            // ----> Bounding box of the source pixels read by the bilinear interpolation
+            int min_x = map.src_width, min_y = map.src_height, max_x = -1, max_y = -1;
+            for( int r=y; r<y+tile.height; r++ )
+            {
+                const uint16_t* row_x;
+                const uint16_t* row_y;
+                getMapRow(map, r, x, x+tile.width, buf_x.data(), buf_y.data(), row_x, row_y);
+
+                for( int c=x; c<x+tile.width; c++ )
+                {
+                    const uint16_t mx = row_x[c];
+                    if( mx==MAP_INVALID )
+                        continue;
+
+                    const int sx = mx>>MAP_FRAC_BITS;
+                    const int sy = row_y[c]>>MAP_FRAC_BITS;
+                    min_x = std::min(min_x, std::max(sx-margin, 0));
+                    max_x = std::max(max_x, std::min(sx+1+margin, map.src_width-1));
+                    min_y = std::min(min_y, std::max(sy-margin, 0));
+                    max_y = std::max(max_y, std::min(sy+1+margin, map.src_height-1));
+                }
+            }
+
+            tile.src_x = min_x;
+            tile.src_y = min_y;
+            tile.src_width = std::max(max_x-min_x+1, 0);
+            tile.src_height = std::max(max_y-min_y+1, 0);
+            // <---- Bounding box of the source pixels read by the bilinear interpolation
+
+            map.tiles.push_back(tile);
+        }
+    }
+}
+
+void Rectifier::run( const Job* jobs, size_t job_count )
+{
+    std::vector<size_t> first_tile(job_count+1, 0);
+    for( size_t j=0; j<job_count; j++ )
+        first_tile[j+1] = first_tile[j] + jobs[j].map->tiles.size();
+
+    auto task = [&](size_t index) {
+        size_t j = 0;
+        while( index >= first_tile[j+1] )
+            j++;
+
+        const Job& job = jobs[j];
+        const std::vector<Tile>& tiles = job.map->tiles;
+        const size_t t = index-first_tile[j];
+
+        // Load the source area of the next tile while this one is processed. The next tile is usually processed
+        // by the same thread, since the worker pool assigns contiguous ranges of tasks.
+        if( t+1<tiles.size() )
+        {
+            const Tile& next = tiles[t+1];
+            prefetchArea(job.src, job.src_step, next.src_x, next.src_y, next.src_width, next.src_height,
+                         job.format==RECT_FORMAT::GRAY?1:2);
+        }
+
+        const Tile& tile = tiles[t];
+        int col_begin = tile.x;
+        int col_end = tile.x+tile.width;
+        int row_begin = tile.y;
+        int row_end = tile.y+tile.height;
+
+        if( job.format==RECT_FORMAT::YUYV_TO_GRAY_HALF )
+        {
+            col_begin /= 2;
+            col_end = std::min(col_end/2, job.map->width/2);
+            row_begin /= 2;
+            row_end = std::min(row_end/2, job.map->height/2);
+        }
+
+        if( col_begin>=col_end || row_begin>=row_end )
+            return;
+
+        switch( job.format )
+        {
+        case RECT_FORMAT::GRAY:
+            if( job.map->box_filter )
+                rectifyLumaBox<1>(job, col_begin, col_end, row_begin, row_end);
+            else
+                rectifyLuma<1>(job, col_begin, col_end, row_begin, row_end);
+            break;
+        case RECT_FORMAT::YUYV:
+            rectifyYuyv(job, col_begin, col_end, row_begin, row_end);
+            break;
+        case RECT_FORMAT::YUYV_TO_GRAY:
+            if( job.map->box_filter )
+                rectifyLumaBox<2>(job, col_begin, col_end, row_begin, row_end);
+            else
+                rectifyLuma<2>(job, col_begin, col_end, row_begin, row_end);
+            break;
+        case RECT_FORMAT::YUYV_TO_GRAY_HALF:
+            rectifyLumaHalf(job, col_begin, col_end, row_begin, row_end);
+            break;
+        }
+    };
+
+    const size_t tile_count = first_tile[job_count];
+    if( mPool )
+        mPool->parallelFor(tile_count, task);
+    else
+    {
+        for( size_t t=0; t<tile_count; t++ )
+            task(t);
+    }
+}
+
+template<int bpp>
+void Rectifier::rectifyLuma( const Job& job, int col_begin, int col_end, int row_begin, int row_end )
+{
+    const FixedMap& map = *job.map;
+    uint16_t top[8], bot[8];
+    uint16_t buf_x[MAX_SRC_SIZE], buf_y[MAX_SRC_SIZE];
+
+    for( int r=row_begin; r<row_end; r++ )
+    {
+        const uint16_t* mx;
+        const uint16_t* my;
+        getMapRow(map, r, col_begin, col_end, buf_x, buf_y, mx, my);
+        uint8_t* out = job.dst + r*job.dst_step;
+
+        int c = col_begin;
+        for( ; c+8<=col_end; c+=8 )
+        {
+            for( int k=0; k<8; k++ )
+                gather<bpp>(job.src, job.src_step, mx[c+k], my[c+k], top[k], bot[k]);
+            interpolate8(top, bot, mx+c, my+c, out+c);
+        }
+
+        for( ; c<col_end; c++ )
+        {
+            gather<bpp>(job.src, job.src_step, mx[c], my[c], top[0], bot[0]);
+            out[c] = interpolate1(top[0], bot[0], mx[c], my[c]);
+        }
+    }
+}
+
+template<int bpp>
+void Rectifier::rectifyLumaBox( const Job& job, int col_begin, int col_end, int row_begin, int row_end )
+{
+    const FixedMap& map = *job.map;
+    const int max_qx = (map.src_width-2)*FRAC_ONE-1;
+    const int max_qy = (map.src_height-2)*FRAC_ONE-1;
+    uint16_t taps[9][8], gx[8], gy[8];
+    uint16_t buf_x[MAX_SRC_SIZE], buf_y[MAX_SRC_SIZE];
+
+    for( int r=row_begin; r<row_end; r++ )
+    {
+        const uint16_t* mx;
+        const uint16_t* my;
+        getMapRow(map, r, col_begin, col_end, buf_x, buf_y, mx, my);
+        uint8_t* out = job.dst + r*job.dst_step;
+
+        int c = col_begin;
+        for( ; c+8<=col_end; c+=8 )
+        {
+            for( int k=0; k<8; k++ )
+                gatherBox<bpp>(job.src, job.src_step, mx[c+k], my[c+k], max_qx, max_qy, taps, gx, gy, k);
+            interpolateBox8(taps, gx, gy, out+c);
+        }
+
+        for( ; c<col_end; c++ )
+        {
+            gatherBox<bpp>(job.src, job.src_step, mx[c], my[c], max_qx, max_qy, taps, gx, gy, 0);
+            out[c] = interpolateBox1(taps, gx, gy, 0);
+        }
+    }
+}
+
+void Rectifier::rectifyLumaHalf( const Job& job, int col_begin, int col_end, int row_begin, int row_end )
+{
+    const FixedMap& map = *job.map;
+    uint16_t top[8], bot[8];
+    uint8_t luma[2][16];
+    uint16_t buf_x[2][MAX_SRC_SIZE], buf_y[2][MAX_SRC_SIZE];
+
+    for( int r=row_begin; r<row_end; r++ )
+    {
+        uint8_t* out = job.dst + r*job.dst_step;
+
+        const uint16_t* row_x[2];
+        const uint16_t* row_y[2];
+        for( int i=0; i<2; i++ )
+            getMapRow(map, 2*r+i, 2*col_begin, 2*col_end, buf_x[i], buf_y[i], row_x[i], row_y[i]);
+
+        // Each output pixel is the average of the 2x2 rectified pixels, interpolated 8 at a time from two map rows
+        for( int c=col_begin; c<col_end; c+=8 )
+        {
+            const int n = std::min(8, col_end-c);
+
+            for( int i=0; i<2; i++ )
+            {
+                const uint16_t* mx = row_x[i] + 2*c;
+                const uint16_t* my = row_y[i] + 2*c;
+
+                for( int h=0; h<2*n; h+=8 )
+                {
+                    const int m = std::min(8, 2*n-h);
+                    for( int k=0; k<m; k++ )
+                        gather<2>(job.src, job.src_step, mx[h+k], my[h+k], top[k], bot[k]);
+
+                    if( m==8 )
+                        interpolate8(top, bot, mx+h, my+h, luma[i]+h);
+                    else
+                    {
+                        for( int k=0; k<m; k++ )
+                            luma[i][h+k] = interpolate1(top[k], bot[k], mx[h+k], my[h+k]);
+                    }
+                }
+            }
+
+            for( int k=0; k<n; k++ )
+                out[c+k] = static_cast<uint8_t>((luma[0][2*k] + luma[0][2*k+1] + luma[1][2*k] + luma[1][2*k+1] + 2) >> 2);
+        }
+    }
+}
+
+void Rectifier::rectifyYuyv( const Job& job, int col_begin, int col_end, int row_begin, int row_end )
+{
+    const FixedMap& map = *job.map;
+    const int max_cx = (map.src_width/2-1)*FRAC_ONE-1; // Last chroma pair of the source row
+    uint16_t top[8], bot[8];
+    uint8_t luma[8];
+    uint16_t buf_x[MAX_SRC_SIZE], buf_y[MAX_SRC_SIZE];
+
+    for( int r=row_begin; r<row_end; r++ )
+    {
+        const uint16_t* mx;
+        const uint16_t* my;
+        getMapRow(map, r, col_begin, col_end, buf_x, buf_y, mx, my);
+        uint8_t* out = job.dst + r*job.dst_step;
+
+        for( int c=col_begin; c<col_end; c+=8 )
+        {
+            const int n = std::min(8, col_end-c);
+
+            // ----> Luma
+            for( int k=0; k<n; k++ )
+                gather<2>(job.src, job.src_step, mx[c+k], my[c+k], top[k], bot[k]);
+
+            if( n==8 )
+                interpolate8(top, bot, mx+c, my+c, luma);
+            else
+            {
+                for( int k=0; k<n; k++ )
+                    luma[k] = interpolate1(top[k], bot[k], mx[c+k], my[c+k]);
+            }
+            // <---- Luma
+
+            // ----> Chroma, sampled at the position of the even pixel of each pair
+            for( int k=0; k<n; k++ )
+            {
+                uint8_t* o = out + 2*(c+k);
+                o[0] = luma[k];
+
+                if( k&1 )
+                    continue;
+
+                const uint16_t x = mx[c+k];
+                const uint16_t y = my[c+k];
+                uint8_t u = 128, v = 128;
+                if( x!=MAP_INVALID )
+                {
+                    // Chroma samples are at half the horizontal resolution, at the even pixels
+                    const int cx = std::min(x>>1, max_cx);
+                    const uint16_t cmx = static_cast<uint16_t>(cx);
+                    const uint8_t* p = job.src + (y>>MAP_FRAC_BITS)*job.src_step + (cx>>MAP_FRAC_BITS)*4;
+                    const uint8_t* q = p + job.src_step;
+                    u = interpolate1(static_cast<uint16_t>(p[1] | (p[5]<<8)), static_cast<uint16_t>(q[1] | (q[5]<<8)), cmx, y);
+                    v = interpolate1(static_cast<uint16_t>(p[3] | (p[7]<<8)), static_cast<uint16_t>(q[3] | (q[7]<<8)), cmx, y);
+                }
+
+                o[1] = u;
+                if( c+k+1<col_end )
+                    o[3] = v;
+            }
+            // <---- Chroma
+        }
+    }
+}
+
+}
+
+}
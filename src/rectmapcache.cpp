@@ -0,0 +1,254 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "rectmapcache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>            // for open, O_RDONLY
+#include <unistd.h>           // for close, getpid
+#include <sys/mman.h>         // for mmap, munmap, madvise
+#include <sys/stat.h>         // for fstat
+
+namespace sl_oc {
+
+namespace video {
+
+static const char RECT_MAP_MAGIC[8] = {'Z','O','C','R','M','A','P','\0'};
+static const uint32_t RECT_MAP_VERSION = 1;
+static const uint64_t RECT_MAP_ALIGN = 64;  //!< Alignment of the maps in the file [bytes], for aligned SIMD loads
+
+namespace {
+
+/*!
+ * \brief Fixed size header of the cache file. The file is local to the machine, so it is stored in the host byte order.
+ */
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    int32_t serial;
+    int32_t width;
+    int32_t height;
+    int32_t reserved;
+    uint64_t calib_hash;
+    double P_left[12];
+    double P_right[12];
+    double baseline;
+    uint64_t map_offset[4];
+};
+
+inline uint64_t alignOffset(uint64_t offset)
+{
+    return (offset+RECT_MAP_ALIGN-1)/RECT_MAP_ALIGN*RECT_MAP_ALIGN;
+}
+
+}
+
+RectMapCache::~RectMapCache()
+{
+    close();
+}
+
+uint64_t RectMapCache::hashFile( const std::string& filename )
+{
+    std::ifstream file(filename, std::ios::binary);
+    if( !file.is_open() )
+        return 0;
+
+    uint64_t hash = 14695981039346656037ULL;
+    char buf[4096];
+    while( file )
+    {
+        file.read(buf, sizeof(buf));
+        std::streamsize n = file.gcount();
+        for( std::streamsize i=0; i<n; i++ )
+        {
+            hash ^= static_cast<uint8_t>(buf[i]);
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    return hash;
+}
+
+std::string RectMapCache::getCacheFilename( const std::string& folder, int serial, int width, int height )
+{
+    return folder + "SN" + std::to_string(serial) + "_" + std::to_string(width) + "x" + std::to_string(height) +
+            ".rectmap";
+}
+
+bool RectMapCache::save( const std::string& filename, const RectMapInfo& info,
+                         const float* left_x, const float* left_y, const float* right_x, const float* right_y )
+{
+    if( info.width<=0 || info.height<=0 || !left_x || !left_y || !right_x || !right_y )
+        return false;
+
+    const uint64_t map_bytes = static_cast<uint64_t>(info.width)*info.height*sizeof(float);
+    const float* maps[4] = {left_x, left_y, right_x, right_y};
+
+    // ----> Header
+    FileHeader hdr;
+    std::memset(&hdr, 0, sizeof(hdr));
+    std::memcpy(hdr.magic, RECT_MAP_MAGIC, sizeof(hdr.magic));
+    hdr.version = RECT_MAP_VERSION;
+    hdr.header_size = sizeof(FileHeader);
+    hdr.serial = info.serial;
+    hdr.width = info.width;
+    hdr.height = info.height;
+    hdr.calib_hash = info.calib_hash;
+    std::memcpy(hdr.P_left, info.P_left, sizeof(hdr.P_left));
+    std::memcpy(hdr.P_right, info.P_right, sizeof(hdr.P_right));
+    hdr.baseline = info.baseline;
+
+    uint64_t offset = alignOffset(sizeof(FileHeader));
+    for( int m=0; m<4; m++ )
+    {
+        hdr.map_offset[m] = offset;
+        offset = alignOffset(offset+map_bytes);
+    }
+    // <---- Header
+
+    // The temporary file is renamed when complete: processes mapping the old file keep their pages
+    std::string tmp_name = filename + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(tmp_name, std::ios::binary|std::ios::trunc);
+        if( !file.is_open() )
+            return false;
+
+        static const char zeros[RECT_MAP_ALIGN] = {};
+        file.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        uint64_t pos = sizeof(hdr);
+        for( int m=0; m<4; m++ )
+        {
+            file.write(zeros, static_cast<std::streamsize>(hdr.map_offset[m]-pos));
+            file.write(reinterpret_cast<const char*>(maps[m]), static_cast<std::streamsize>(map_bytes));
+            pos = hdr.map_offset[m]+map_bytes;
+        }
+
+        if( !file.good() )
+        {
+            file.close();
+            std::remove(tmp_name.c_str());
+            return false;
+        }
+    }
+
+    if( std::rename(tmp_name.c_str(), filename.c_str())!=0 )
+    {
+        std::remove(tmp_name.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool RectMapCache::open( const std::string& filename, int serial, int width, int height, uint64_t calib_hash )
+{
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if( fd<0 )
+        return false;
+
+    struct stat st;
+    if( fstat(fd, &st)!=0 || static_cast<uint64_t>(st.st_size) < sizeof(FileHeader) )
+    {
+        ::close(fd);
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps a reference to the file
+    if( data==MAP_FAILED )
+        return false;
+
+    // ----> Validation
+    FileHeader hdr;
+    std::memcpy(&hdr, data, sizeof(hdr));
+
+    const uint64_t map_bytes = static_cast<uint64_t>(width)*height*sizeof(float);
+    bool valid = std::memcmp(hdr.magic, RECT_MAP_MAGIC, sizeof(hdr.magic))==0 &&
+            hdr.version==RECT_MAP_VERSION && hdr.header_size==sizeof(FileHeader) &&
+            hdr.serial==serial && hdr.width==width && hdr.height==height && hdr.calib_hash==calib_hash &&
+            width>0 && height>0;
+
+    for( int m=0; valid && m<4; m++ )
+    {
+        valid = hdr.map_offset[m]%RECT_MAP_ALIGN==0 && hdr.map_offset[m]>=sizeof(FileHeader) &&
+                hdr.map_offset[m]+map_bytes <= size;
+    }
+
+    if( !valid )
+    {
+        munmap(data, size);
+        return false;
+    }
+    // <---- Validation
+
+    // The maps are read entirely by each rectification
+    madvise(data, size, MADV_WILLNEED);
+
+    mData = data;
+    mSize = size;
+
+    mInfo.serial = hdr.serial;
+    mInfo.width = hdr.width;
+    mInfo.height = hdr.height;
+    mInfo.calib_hash = hdr.calib_hash;
+    std::memcpy(mInfo.P_left, hdr.P_left, sizeof(mInfo.P_left));
+    std::memcpy(mInfo.P_right, hdr.P_right, sizeof(mInfo.P_right));
+    mInfo.baseline = hdr.baseline;
+
+    for( int m=0; m<MAP_COUNT; m++ )
+        mMaps[m] = reinterpret_cast<const float*>(static_cast<const uint8_t*>(mData)+hdr.map_offset[m]);
+
+    return true;
+}
+
+void RectMapCache::close()
+{
+    if( mData )
+        munmap(mData, mSize);
+
+    mData = nullptr;
+    mSize = 0;
+    mInfo = RectMapInfo();
+    for( int m=0; m<MAP_COUNT; m++ )
+        mMaps[m] = nullptr;
+}
+
+const float* RectMapCache::getMapX( CAM_SENS_POS side ) const
+{
+    return side==CAM_SENS_POS::RIGHT?mMaps[2]:mMaps[0];
+}
+
+const float* RectMapCache::getMapY( CAM_SENS_POS side ) const
+{
+    return side==CAM_SENS_POS::RIGHT?mMaps[3]:mMaps[1];
+}
+
+}
+
+}
@@ -34,6 +34,12 @@ namespace sl_oc {
 namespace sensors {
 
 SensorCapture::SensorCapture(VERBOSITY verbose_lvl )
+    : SensorCapture(std::unique_ptr<HidTransport>(new HidApiTransport()), verbose_lvl)
+{
+}
+
+SensorCapture::SensorCapture(std::unique_ptr<HidTransport> transport, VERBOSITY verbose_lvl )
+    : mTransport(std::move(transport))
 {
     mVerbose = verbose_lvl;
 
@@ -58,49 +64,34 @@ int SensorCapture::enumerateDevices()
     mSlDevPid.clear();
     mSlDevFwVer.clear();
 
-    struct hid_device_info *devs, *cur_dev;
+    std::vector<HidDeviceInfo> devs = mTransport->enumerate(SL_USB_VENDOR);
 
-    if (hid_init()==-1)
-        return 0;
-
-    devs = hid_enumerate(SL_USB_VENDOR, 0x0);
-    cur_dev = devs;
-    while (cur_dev) {
-        int fw_major = cur_dev->release_number>>8;
-        int fw_minor = cur_dev->release_number&0x00FF;
-        uint16_t pid = cur_dev->product_id;
-        if(!cur_dev->serial_number)
-        {
-            cur_dev = cur_dev->next;
-            continue;
-        }
-        std::string sn_str = wstr2str( cur_dev->serial_number );
-        int sn = std::stoi( sn_str );
+    for (const HidDeviceInfo& cur_dev : devs) {
+        int fw_major = cur_dev.release_number>>8;
+        int fw_minor = cur_dev.release_number&0x00FF;
+        uint16_t pid = cur_dev.product_id;
+        int sn = cur_dev.serial_number;
 
         mSlDevPid[sn]=pid;
-        mSlDevFwVer[sn]=cur_dev->release_number;
+        mSlDevFwVer[sn]=cur_dev.release_number;
 
         if(mVerbose)
         {
             std::ostringstream smsg;
 
             smsg << "Device Found: " << std::endl;
-            smsg << "  VID: " << std::hex << cur_dev->vendor_id << " PID: " << std::hex << cur_dev->product_id << std::endl;
-            smsg << "  Path: " << cur_dev->path << std::endl;
-            smsg << "  Serial_number:   " << sn_str << std::endl;
-            smsg << "  Manufacturer:   " << wstr2str(cur_dev->manufacturer_string) << std::endl;
-            smsg << "  Product:   " << wstr2str(cur_dev->product_string) << std::endl;
+            smsg << "  VID: " << std::hex << cur_dev.vendor_id << " PID: " << std::hex << cur_dev.product_id << std::endl;
+            smsg << "  Path: " << cur_dev.path << std::endl;
+            smsg << "  Serial_number:   " << std::dec << sn << std::endl;
+            smsg << "  Manufacturer:   " << cur_dev.manufacturer << std::endl;
+            smsg << "  Product:   " << cur_dev.product << std::endl;
             smsg << "  Release number:   v" << std::dec << fw_major << "." << fw_minor << std::endl;
             smsg << "***" << std::endl;
 
             INFO_OUT(mVerbose,smsg.str());
         }
-
-        cur_dev = cur_dev->next;
     }
 
-    hid_free_enumeration(devs);
-
     return mSlDevPid.size();
 }
 
@@ -120,16 +111,11 @@ std::vector<int> SensorCapture::getDeviceList(bool refresh)
 
 bool SensorCapture::open( uint16_t pid, int serial_number)
 {
-    std::string sn_str = std::to_string(serial_number);
-    std::wstring wide_sn_string = std::wstring(sn_str.begin(), sn_str.end());
-
-    const wchar_t* wsn = wide_sn_string.c_str();
-
-    mDevHandle = hid_open(SL_USB_VENDOR, pid, wsn );
+    bool opened = mTransport->open(SL_USB_VENDOR, pid, serial_number);
 
-    if(mDevHandle) mDevSerial = serial_number;
+    if(opened) mDevSerial = serial_number;
 
-    return mDevHandle!=0;
+    return opened;
 }
 
 bool SensorCapture::initializeSensors( int sn )
@@ -183,6 +169,7 @@ bool SensorCapture::initializeSensors( int sn )
 
     mDevFwVer = mSlDevFwVer[sn];
     mDevPid = pid;
+    mConverter.setFirmwareVersion(mDevFwVer);
     mInitialized = startCapture();
 
     return true;
@@ -208,18 +195,18 @@ int SensorCapture::getSerialNumber()
 }
 
 bool SensorCapture::enableDataStream(bool enable) {
-    if( !mDevHandle )
+    if( !mTransport->isOpen() )
         return false;
     unsigned char buf[65];
     buf[0] = usb::REP_ID_SENSOR_STREAM_STATUS;
     buf[1] = enable?1:0;
 
-    int res = hid_send_feature_report(mDevHandle, buf, 2);
+    int res = mTransport->sendFeatureReport(buf, 2);
     if (res < 0) {
         if(mVerbose)
         {
             std::string msg = "Unable to set a feature report [SensStreamStatus] - ";
-            msg += wstr2str(hid_error(mDevHandle));
+            msg += mTransport->getLastError();
 
             WARNING_OUT( mVerbose, msg);
         }
@@ -231,17 +218,17 @@ bool SensorCapture::enableDataStream(bool enable) {
 }
 
 bool SensorCapture::isDataStreamEnabled() {
-    if( !mDevHandle ) {
+    if( !mTransport->isOpen() ) {
         return false;
     }
 
     unsigned char buf[65];
     buf[0] = usb::REP_ID_SENSOR_STREAM_STATUS;
-    int res = hid_get_feature_report(mDevHandle, buf, sizeof(buf));
+    int res = mTransport->getFeatureReport(buf, sizeof(buf));
     if (res < 0)
     {
         std::string msg = "Unable to get a feature report [SensStreamStatus] - ";
-        msg += wstr2str(hid_error(mDevHandle));
+        msg += mTransport->getLastError();
 
         WARNING_OUT( mVerbose,msg );
 
@@ -289,10 +276,12 @@ void SensorCapture::close()
 
     enableDataStream(false);
 
-    if( mDevHandle ) {
-        hid_close(mDevHandle);
-        mDevHandle = nullptr;
-    }
+    if( mThermalEnabled )
+        saveThermalBiasModel();
+
+    stopImuLog();
+
+    mTransport->close();
 
     if( mVerbose && mInitialized)
     {
@@ -319,6 +308,14 @@ void SensorCapture::grabThreadFunc()
     int ping_data_count = 0;
 
     mFirstImuData = true;
+    mMotionInitialized = false;
+
+    {
+        // The relative MCU timestamp restarts from zero
+        const std::lock_guard<std::mutex> lock(mStatsMutex);
+        mLatencyRef.reset();
+        mLatencyLastRxTs = 0;
+    }
 
     uint64_t rel_mcu_ts = 0;
 
@@ -341,11 +338,17 @@ void SensorCapture::grabThreadFunc()
 
         // Sensor data request
         usbBuf[1]=usb::REP_ID_SENSOR_DATA;
-        int res = hid_read_timeout( mDevHandle, usbBuf, 64, 2000 );
+        int res = mTransport->read( usbBuf, 64, 2000 );
+        uint64_t rx_steady_ts = getSteadyTimestamp();
 
         // ----> Data received?
         if( res < static_cast<int>(sizeof(usb::RawData)) )  {
-            hid_set_nonblocking( mDevHandle, 0 );
+            if( res > 0 )
+            {
+                const std::lock_guard<std::mutex> lock(mStatsMutex);
+                mPacketStats.short_reads++;
+            }
+            mTransport->setNonBlocking( false );
             continue;
         }
         // <---- Data received?
@@ -362,7 +365,12 @@ void SensorCapture::grabThreadFunc()
                 WARNING_OUT(mVerbose,std::string("REP_ID_SENSOR_DATA - Sensor Data type mismatch") );
             }
 
-            hid_set_nonblocking( mDevHandle, 0 );
+            {
+                const std::lock_guard<std::mutex> lock(mStatsMutex);
+                mPacketStats.invalid++;
+            }
+
+            mTransport->setNonBlocking( false );
             continue;
         }
         // <---- Received data are correct?
@@ -370,8 +378,49 @@ void SensorCapture::grabThreadFunc()
         // Data structure static conversion
         usb::RawData* data = (usb::RawData*)usbBuf;
 
+        // ----> IMU calibration update
+        if(mImuCalibChanged)
+        {
+            const std::lock_guard<std::mutex> lock(mCalibMutex);
+            mConverter.setImuCalibration(mImuCalib);
+            mImuCalibChanged = false;
+        }
+        // <---- IMU calibration update
+
+        // Conversion to physical units
+        mConverter.convertImu(data, 1, mImuBatch);
+
+        // ----> Packet loss detection
+        bool packet_gap = false;
+        if(!mFirstImuData && !checkPacketSequence(mImuBatch.timestamp[0], packet_gap))
+            continue;
+        // <---- Packet loss detection
+
+        // ----> Temperature dependent bias compensation
+        if(mThermalChanged)
+        {
+            const std::lock_guard<std::mutex> lock(mThermalMutex);
+            mConverter.setThermalCompensation(mThermalEnabled?mThermalModel.getCoefficients():data::ImuThermalCoeffs());
+            mThermalChanged = false;
+        }
+
+        if(mThermalEnabled && mImuBatch.valid[0])
+        {
+            const std::lock_guard<std::mutex> lock(mThermalMutex);
+            if(mThermalModel.addSample(mImuBatch.temp[0],
+                                       mImuBatch.gX[0], mImuBatch.gY[0], mImuBatch.gZ[0],
+                                       mImuBatch.aX[0], mImuBatch.aY[0], mImuBatch.aZ[0],
+                                       mStillEnabled?mCameraStill.load():!mCameraMoving))
+            {
+                mConverter.setThermalCompensation(mThermalModel.getCoefficients());
+            }
+        }
+
+        mConverter.compensateThermalBias(mImuBatch, 0, 1);
+        // <---- Temperature dependent bias compensation
+
         // ----> Timestamp update
-        uint64_t mcu_ts_nsec = static_cast<uint64_t>(std::round(static_cast<float>(data->timestamp)*TS_SCALE));
+        uint64_t mcu_ts_nsec = mImuBatch.timestamp[0];
 
         if(mFirstImuData && data->imu_not_valid!=1)
         {
@@ -380,6 +429,12 @@ void SensorCapture::grabThreadFunc()
 
             mLastMcuTs = mcu_ts_nsec;
             mFirstImuData = false;
+
+            // The first packet is only the timestamp reference, but it has been received
+            {
+                const std::lock_guard<std::mutex> lock(mStatsMutex);
+                mPacketStats.received++;
+            }
             continue;
         }
 
@@ -454,21 +509,189 @@ void SensorCapture::grabThreadFunc()
         mLastFrameSyncCount = data->frame_sync_count;
         // <---- Camera/Sensors Synchronization
 
+        // Motion and free-fall events
+        processMotionEvents(data, current_data_ts);
+
+        // ----> Standstill detection
+        if(mStillEnabled && mImuBatch.valid[0])
+        {
+            if(mStillParamsChanged || mGyroBiasChanged)
+            {
+                const std::lock_guard<std::mutex> lock(mStillMutex);
+                if(mStillParamsChanged)
+                {
+                    mStillDetector.setParams(mStillParams);
+                    mStillParamsChanged = false;
+                }
+                if(mGyroBiasChanged)
+                {
+                    mStillDetector.setBias(mGyroBias);
+                    mGyroBiasChanged = false;
+                }
+            }
+
+            if(packet_gap)
+                mStillDetector.reset();
+
+            mCameraStill = mStillDetector.update(current_data_ts,
+                                                 mImuBatch.aX[0], mImuBatch.aY[0], mImuBatch.aZ[0],
+                                                 mImuBatch.gX[0], mImuBatch.gY[0], mImuBatch.gZ[0],
+                                                 mCameraMoving);
+
+            const data::GyroBias& bias = mStillDetector.getBias();
+            if(mCameraStill)
+            {
+                const std::lock_guard<std::mutex> lock(mStillMutex);
+                mGyroBias = bias;
+            }
+
+            if(mStillAutoSubtract && bias.valid)
+            {
+                mImuBatch.gX[0] -= bias.bX;
+                mImuBatch.gY[0] -= bias.bY;
+                mImuBatch.gZ[0] -= bias.bZ;
+            }
+        }
+        // <---- Standstill detection
+
+        // ----> Orientation filter
+        if(mOrientEnabled)
+        {
+            if(mOrientParamsChanged)
+            {
+                const std::lock_guard<std::mutex> lock(mOrientMutex);
+                mOrientFilter.setParams(mOrientParams);
+                mOrientFilter.reset();
+                mOrientHistory.clear(); // Do not interpolate across the reset
+                mOrientParamsChanged = false;
+            }
+
+            if(mImuBatch.valid[0] &&
+                    mOrientFilter.update(current_data_ts,
+                                         mImuBatch.gX[0], mImuBatch.gY[0], mImuBatch.gZ[0],
+                                         mImuBatch.aX[0], mImuBatch.aY[0], mImuBatch.aZ[0]))
+            {
+                mOrientHistory.push(mOrientFilter.getOrientation());
+            }
+        }
+        // <---- Orientation filter
+
+        // ----> Gravity estimator
+        if(mGravityEnabled)
+        {
+            if(mGravityParamsChanged)
+            {
+                const std::lock_guard<std::mutex> lock(mGravityMutex);
+                mGravityEstimator.setParams(mGravityParams);
+                mGravityEstimator.reset();
+                mGravityHistory.clear(); // Do not interpolate across the reset
+                mGravityParamsChanged = false;
+            }
+
+            if(mImuBatch.valid[0] &&
+                    mGravityEstimator.update(current_data_ts, mImuBatch.aX[0], mImuBatch.aY[0], mImuBatch.aZ[0]))
+            {
+                mGravityHistory.push(mGravityEstimator.getGravity());
+            }
+        }
+        // <---- Gravity estimator
+
         // ----> IMU data
         mIMUMutex.lock();
-        mLastIMUData.sync = data->frame_sync;
-        mLastIMUData.valid = (data->imu_not_valid!=1)?(data::Imu::NEW_VAL):(data::Imu::OLD_VAL);
+        mLastIMUData.sync = mImuBatch.sync[0];
+        mLastIMUData.valid = mImuBatch.valid[0]?(data::Imu::NEW_VAL):(data::Imu::OLD_VAL);
         mLastIMUData.timestamp = current_data_ts;
-        mLastIMUData.aX = data->aX*ACC_SCALE;
-        mLastIMUData.aY = data->aY*ACC_SCALE;
-        mLastIMUData.aZ = data->aZ*ACC_SCALE;
-        mLastIMUData.gX = data->gX*GYRO_SCALE;
-        mLastIMUData.gY = data->gY*GYRO_SCALE;
-        mLastIMUData.gZ = data->gZ*GYRO_SCALE;
-        mLastIMUData.temp = data->imu_temp*TEMP_SCALE;
+        mLastIMUData.aX = mImuBatch.aX[0];
+        mLastIMUData.aY = mImuBatch.aY[0];
+        mLastIMUData.aZ = mImuBatch.aZ[0];
+        mLastIMUData.gX = mImuBatch.gX[0];
+        mLastIMUData.gY = mImuBatch.gY[0];
+        mLastIMUData.gZ = mImuBatch.gZ[0];
+        mLastIMUData.temp = mImuBatch.temp[0];
+        // The gap flag is kept if the previous sample has not been read
+        mLastIMUData.gap = packet_gap || (mNewIMUData && mLastIMUData.gap);
         mNewIMUData = true;
+        data::Imu imu = mLastIMUData;
         mIMUMutex.unlock();
 
+        // ----> IMU callback
+        std::shared_ptr<ImuCallback> imu_callback;
+        {
+            const std::lock_guard<std::mutex> lock(mImuCallbackMutex);
+            imu_callback = mImuCallback;
+        }
+        if(imu_callback)
+        {
+            imu.gap = packet_gap;
+            (*imu_callback)(imu);
+        }
+        // <---- IMU callback
+
+        updateLatencyStats(rx_steady_ts, rel_mcu_ts);
+
+        // ----> IMU log
+        if(mImuBatch.valid[0])
+        {
+            const std::lock_guard<std::mutex> lock(mImuLogMutex);
+            if(mImuLog.isOpen())
+            {
+                mImuLog.write(current_data_ts,
+                              mImuBatch.aX[0], mImuBatch.aY[0], mImuBatch.aZ[0],
+                              mImuBatch.gX[0], mImuBatch.gY[0], mImuBatch.gZ[0],
+                              mImuBatch.temp[0], mImuBatch.sync[0]!=0, packet_gap);
+            }
+        }
+        // <---- IMU log
+
+        // ----> IMU resampler
+        if(mResampEnabled && !mImuBatch.valid[0])
+            mResampSkipped = true;
+        else if(mResampEnabled)
+        {
+            std::shared_ptr<ImuCallback> callback;
+            {
+                const std::lock_guard<std::mutex> lock(mResampMutex);
+                if(mResampParamsChanged)
+                {
+                    mResampler.setParams(mResampParams);
+                    mResampParamsChanged = false;
+                }
+                callback = mResampCallback;
+            }
+
+            size_t count = mResampler.addSample(current_data_ts,
+                                                mImuBatch.aX[0], mImuBatch.aY[0], mImuBatch.aZ[0],
+                                                mImuBatch.gX[0], mImuBatch.gY[0], mImuBatch.gZ[0],
+                                                mImuBatch.temp[0], packet_gap || mResampSkipped, mResampBatch);
+            mResampSkipped = false;
+            for(size_t i=0; i<count; i++)
+            {
+                data::Imu imu;
+                imu.valid = data::Imu::NEW_VAL;
+                imu.timestamp = mResampBatch.timestamp[i];
+                imu.aX = mResampBatch.aX[i];
+                imu.aY = mResampBatch.aY[i];
+                imu.aZ = mResampBatch.aZ[i];
+                imu.gX = mResampBatch.gX[i];
+                imu.gY = mResampBatch.gY[i];
+                imu.gZ = mResampBatch.gZ[i];
+                imu.temp = mResampBatch.temp[i];
+                imu.sync = false;
+                imu.gap = mResampBatch.gap[i]!=0;
+
+                mResampDataMutex.lock();
+                const bool unread_gap = mNewResampIMUData && mLastResampIMUData.gap;
+                mLastResampIMUData = imu;
+                mLastResampIMUData.gap = imu.gap || unread_gap;
+                mNewResampIMUData = true;
+                mResampDataMutex.unlock();
+
+                if(callback)
+                    (*callback)(imu);
+            }
+        }
+        // <---- IMU resampler
+
         //std::string msg = std::to_string(mLastMAGData.timestamp);
         //INFO_OUT(msg);
         // <---- IMU data
@@ -476,12 +699,35 @@ void SensorCapture::grabThreadFunc()
         // ----> Magnetometer data
         if(data->mag_valid == data::Magnetometer::NEW_VAL)
         {
+            float mag_raw[3] = {data->mX*MAG_SCALE, data->mY*MAG_SCALE, data->mZ*MAG_SCALE};
+            float mag_cal[3] = {mag_raw[0], mag_raw[1], mag_raw[2]};
+            bool calibrated = false;
+
+            // ----> Magnetometer calibration
+            {
+                const std::lock_guard<std::mutex> lock(mMagCalibMutex);
+                if(mMagCalibEnabled)
+                    mMagCalibrator.addSample(mag_raw[0], mag_raw[1], mag_raw[2]);
+
+                const data::MagCalibration& calib = mMagCalibrator.getCalibration();
+                if(calib.valid)
+                {
+                    MagCalibrator::apply(calib, mag_raw, mag_cal);
+                    calibrated = true;
+                }
+            }
+            // <---- Magnetometer calibration
+
             mMagMutex.lock();
             mLastMagData.valid = data::Magnetometer::NEW_VAL;
             mLastMagData.timestamp = current_data_ts;
-            mLastMagData.mY = data->mY*MAG_SCALE;
-            mLastMagData.mZ = data->mZ*MAG_SCALE;
-            mLastMagData.mX = data->mX*MAG_SCALE;
+            mLastMagData.mY = mag_raw[1];
+            mLastMagData.mZ = mag_raw[2];
+            mLastMagData.mX = mag_raw[0];
+            mLastMagData.calibrated = calibrated;
+            mLastMagData.mX_cal = mag_cal[0];
+            mLastMagData.mY_cal = mag_cal[1];
+            mLastMagData.mZ_cal = mag_cal[2];
             mNewMagData = true;
             mMagMutex.unlock();
 
@@ -506,19 +752,15 @@ void SensorCapture::grabThreadFunc()
             mLastEnvData.valid = data::Environment::NEW_VAL;
             mLastEnvData.timestamp = current_data_ts;
             mLastEnvData.temp = data->temp*TEMP_SCALE;
-            if( atLeast(mDevFwVer, ZED_2_FW::FW_3_9))
-            {
-                mLastEnvData.press = data->press*PRESS_SCALE_NEW;
-                mLastEnvData.humid = data->humid*HUMID_SCALE_NEW;
-            }
-            else
-            {
-                mLastEnvData.press = data->press*PRESS_SCALE_OLD;
-                mLastEnvData.humid = data->humid*HUMID_SCALE_OLD;
-            }
+            mLastEnvData.press = data->press*mConverter.getPressureScale();
+            mLastEnvData.humid = data->humid*mConverter.getHumidityScale();
             mNewEnvData = true;
             mEnvMutex.unlock();
 
+            mEnvHistMutex.lock();
+            mEnvHistory.addEnvironment(current_data_ts, mLastEnvData.temp, mLastEnvData.press, mLastEnvData.humid);
+            mEnvHistMutex.unlock();
+
             //std::string msg = std::to_string(mLastENVData.timestamp);
             //INFO_OUT(msg);
         }
@@ -546,6 +788,10 @@ void SensorCapture::grabThreadFunc()
             mNewCamTempData=true;
             mCamTempMutex.unlock();
 
+            mEnvHistMutex.lock();
+            mEnvHistory.addCameraTemperature(current_data_ts, mLastCamTempData.temp_left, mLastCamTempData.temp_right);
+            mEnvHistMutex.unlock();
+
             //std::string msg = std::to_string(mLastCamTempData.timestamp);
             //INFO_OUT(msg);
         }
@@ -559,6 +805,145 @@ void SensorCapture::grabThreadFunc()
     mGrabRunning = false;
 }
 
+void SensorCapture::updateLatencyStats(uint64_t rx_steady_ts, uint64_t mcu_rel_ts)
+{
+    uint64_t proc_time = getSteadyTimestamp() - rx_steady_ts;
+
+    // The relative MCU time is not moved by the video synchronization offset, so the reference is reset only when the
+    // MCU timestamp restarts or the grabbing restarts. It follows the MCU clock drift, corrected only with video sync.
+    int64_t offset = static_cast<int64_t>(rx_steady_ts) - static_cast<int64_t>(mcu_rel_ts);
+
+    const std::lock_guard<std::mutex> lock(mStatsMutex);
+
+    // ----> Transport latency
+    mLatencyStats.transport.add(mLatencyRef.update(static_cast<int64_t>(rx_steady_ts), offset)/1000);
+    // <---- Transport latency
+
+    // ----> Inter-arrival jitter
+    if( mLatencyLastRxTs!=0 )
+    {
+        int64_t rx_delta = static_cast<int64_t>(rx_steady_ts-mLatencyLastRxTs);
+        int64_t data_delta = static_cast<int64_t>(mcu_rel_ts-mLatencyLastDataTs);
+        mLatencyStats.jitter.add((rx_delta-data_delta)/1000);
+    }
+    mLatencyLastRxTs = rx_steady_ts;
+    mLatencyLastDataTs = mcu_rel_ts;
+    // <---- Inter-arrival jitter
+
+    mLatencyStats.processing.add(static_cast<int64_t>(proc_time/1000));
+}
+
+bool SensorCapture::checkPacketSequence(uint64_t mcu_ts, bool& gap)
+{
+    const std::lock_guard<std::mutex> lock(mStatsMutex);
+
+    gap = false;
+
+    if( mcu_ts == mLastMcuTs )
+    {
+        mPacketStats.duplicated++;
+        return false;
+    }
+
+    if( mcu_ts < mLastMcuTs )
+    {
+        if( mLastMcuTs-mcu_ts < SENS_TS_RESTART_NSEC )
+        {
+            mPacketStats.out_of_order++;
+            return false;
+        }
+
+        // The MCU timestamp restarted: the packet is used as new timestamp reference
+        WARNING_OUT(mVerbose,std::string("MCU timestamp restarted"));
+        mLastMcuTs = mcu_ts;
+        mLatencyRef.reset(); // The time elapsed during the restart is lost by the relative MCU timestamp
+        mLatencyLastRxTs = 0;
+        mPacketStats.gaps++;
+        return false;
+    }
+
+    // Number of sampling periods elapsed since the previous packet, rounded to tolerate the MCU jitter
+    uint64_t periods = (mcu_ts-mLastMcuTs+SENS_DATA_PERIOD_NSEC/2)/SENS_DATA_PERIOD_NSEC;
+    if( periods > 1 )
+    {
+        mPacketStats.lost += periods-1;
+        mPacketStats.gaps++;
+        gap = true;
+    }
+
+    mPacketStats.received++;
+    return true;
+}
+
+void SensorCapture::processMotionEvents(const usb::RawData* data, uint64_t data_ts)
+{
+    bool moving = data->camera_moving!=0;
+    bool falling = data->camera_falling!=0;
+
+    if( !mMotionInitialized )
+    {
+        mMovingCount = data->camera_moving_count;
+        mFallingCount = data->camera_falling_count;
+        mMotionInitialized = true;
+    }
+
+    // ----> Camera moving
+    if( data->camera_moving_count!=mMovingCount )
+    {
+        // New interrupt since the previous packet: the previous one ended, even if the flag is still set
+        if( mCameraMoving )
+            fireMotionEvent(data::MotionEvent::MOTION_STOP, data_ts, data->camera_moving_count);
+        fireMotionEvent(data::MotionEvent::MOTION_START, data_ts, data->camera_moving_count);
+        if( !moving ) // Interrupt started and ended between two packets
+            fireMotionEvent(data::MotionEvent::MOTION_STOP, data_ts, data->camera_moving_count);
+    }
+    else if( moving && !mCameraMoving )
+        fireMotionEvent(data::MotionEvent::MOTION_START, data_ts, data->camera_moving_count);
+    else if( !moving && mCameraMoving )
+        fireMotionEvent(data::MotionEvent::MOTION_STOP, data_ts, data->camera_moving_count);
+    mCameraMoving = moving;
+    mMovingCount = data->camera_moving_count;
+    // <---- Camera moving
+
+    // ----> Camera falling
+    if( data->camera_falling_count!=mFallingCount )
+    {
+        // New interrupt since the previous packet: the previous one ended, even if the flag is still set
+        if( mCameraFalling )
+            fireMotionEvent(data::MotionEvent::FREE_FALL_STOP, data_ts, data->camera_falling_count);
+        fireMotionEvent(data::MotionEvent::FREE_FALL_START, data_ts, data->camera_falling_count);
+        if( !falling ) // Interrupt started and ended between two packets
+            fireMotionEvent(data::MotionEvent::FREE_FALL_STOP, data_ts, data->camera_falling_count);
+    }
+    else if( falling && !mCameraFalling )
+        fireMotionEvent(data::MotionEvent::FREE_FALL_START, data_ts, data->camera_falling_count);
+    else if( !falling && mCameraFalling )
+        fireMotionEvent(data::MotionEvent::FREE_FALL_STOP, data_ts, data->camera_falling_count);
+    mCameraFalling = falling;
+    mFallingCount = data->camera_falling_count;
+    // <---- Camera falling
+}
+
+void SensorCapture::fireMotionEvent(data::MotionEvent::MotionEventType type, uint64_t data_ts, uint32_t count)
+{
+    std::shared_ptr<MotionEventCallback> callback;
+    {
+        // Only the pointer copy is protected: the callback can replace itself
+        const std::lock_guard<std::mutex> lock(mEventMutex);
+        callback = mMotionCallback;
+    }
+
+    if( !callback )
+        return;
+
+    data::MotionEvent event;
+    event.type = type;
+    event.timestamp = data_ts;
+    event.count = count;
+
+    (*callback)(event);
+}
+
 #ifdef VIDEO_MOD_AVAILABLE
 void SensorCapture::updateTimestampOffset( uint64_t frame_ts)
 {
@@ -583,18 +968,18 @@ void SensorCapture::updateTimestampOffset( uint64_t frame_ts)
 #endif
 
 bool SensorCapture::sendPing() {
-    if( !mDevHandle )
+    if( !mTransport->isOpen() )
         return false;
 
     unsigned char buf[65];
     buf[0] = usb::REP_ID_REQUEST_SET;
     buf[1] = usb::RQ_CMD_PING;
 
-    int res = hid_send_feature_report(mDevHandle, buf, 2);
+    int res = mTransport->sendFeatureReport(buf, 2);
     if (res < 0)
     {
         std::string msg = "Unable to send ping [REP_ID_REQUEST_SET-RQ_CMD_PING] - ";
-        msg += wstr2str(hid_error(mDevHandle));
+        msg += mTransport->getLastError();
 
         WARNING_OUT(mVerbose,msg);
 
@@ -614,24 +999,15 @@ bool SensorCapture::searchForConnectedDev(int* serial_number, unsigned short* fo
     int found_serial_number = 0;
 
     // ----> Search for connected device
-    struct hid_device_info *devs, *cur_dev;
-
-    if (hid_init()==-1)
-        return false;
-
-    devs = hid_enumerate(SL_USB_VENDOR, 0x0);
-    cur_dev = devs;
+    HidApiTransport transport;
+    std::vector<HidDeviceInfo> devs = transport.enumerate(SL_USB_VENDOR);
 
     bool found = false;
     uint16_t pid=0;
-    std::string sn_str;
 
-    while (cur_dev) {
-        //int fw_major = cur_dev->release_number>>8;
-        //int fw_minor = cur_dev->release_number&0x00FF;
-        pid = cur_dev->product_id;
-        sn_str = wstr2str( cur_dev->serial_number );
-        int sn = std::stoi( sn_str );
+    for (const HidDeviceInfo& cur_dev : devs) {
+        pid = cur_dev.product_id;
+        int sn = cur_dev.serial_number;
 
         if(in_serial_number==0 || sn==in_serial_number)
         {
@@ -652,11 +1028,7 @@ bool SensorCapture::searchForConnectedDev(int* serial_number, unsigned short* fo
                     return false;
             }
         }
-
-        cur_dev = cur_dev->next;
     }
-
-    hid_free_enumeration(devs);
     // <---- Search for connected device
 
     if(!found) {
@@ -693,13 +1065,9 @@ bool SensorCapture::resetSensorModule(int serial_number)
         return false;
     }
 
-    std::string sn_str = std::to_string(found_sn);
-    std::wstring wide_sn_string = std::wstring(sn_str.begin(), sn_str.end());
-    const wchar_t* wsn = wide_sn_string.c_str();
-
-    hid_device* devHandle = hid_open(SL_USB_VENDOR, pid, wsn );
+    HidApiTransport transport;
 
-    if(!devHandle)
+    if(!transport.open(SL_USB_VENDOR, pid, found_sn))
     {
         std::string msg = "Unable to open the MCU HID device";
         std::cerr << msg << std::endl;
@@ -711,7 +1079,7 @@ bool SensorCapture::resetSensorModule(int serial_number)
     buf[0] = static_cast<unsigned char>(usb::REP_ID_REQUEST_SET);
     buf[1] = static_cast<unsigned char>(usb::RQ_CMD_RST);
 
-    hid_send_feature_report(devHandle, buf, 2);
+    transport.sendFeatureReport(buf, 2);
     // Note: cannot verify the return value of the `hid_send_feature_report` command because the MCU is suddenly reset
     // and it cannot return a valid value
 
@@ -745,13 +1113,9 @@ bool SensorCapture::resetVideoModule(int serial_number)
         return false;
     }
 
-    std::string sn_str = std::to_string(found_sn);
-    std::wstring wide_sn_string = std::wstring(sn_str.begin(), sn_str.end());
-    const wchar_t* wsn = wide_sn_string.c_str();
+    HidApiTransport transport;
 
-    hid_device* devHandle = hid_open(SL_USB_VENDOR, pid, wsn );
-
-    if(!devHandle)
+    if(!transport.open(SL_USB_VENDOR, pid, found_sn))
     {
         std::string msg = "Unable to open the MCU HID device";
         std::cerr << msg << std::endl;
@@ -767,8 +1131,8 @@ bool SensorCapture::resetVideoModule(int serial_number)
     unsigned char buf[65];
     memcpy(buf, &(cmd.struct_id), sizeof(usb::OV580CmdStruct));
 
-    int ret = hid_send_feature_report(devHandle, buf, sizeof(usb::OV580CmdStruct));
-    hid_close(devHandle);
+    int ret = transport.sendFeatureReport(buf, sizeof(usb::OV580CmdStruct));
+    transport.close();
 
     if(ret!=sizeof(usb::OV580CmdStruct)) {
         std::cerr << "[sl_oc::sensors::SensorCapture] INFO: Video Module reset failed" << std::endl;
@@ -781,6 +1145,350 @@ bool SensorCapture::resetVideoModule(int serial_number)
     return true;
 }
 
+void SensorCapture::setImuCalibration( const data::ImuCalibration& calib )
+{
+    const std::lock_guard<std::mutex> lock(mCalibMutex);
+    mImuCalib = calib;
+    mImuCalibChanged = true;
+}
+
+bool SensorCapture::loadImuCalibration( const std::string& filename )
+{
+    data::ImuCalibration calib;
+    if( !sensors::loadImuCalibration(filename, calib) )
+    {
+        std::string msg = "Unable to load the IMU calibration file ";
+        msg += filename;
+        WARNING_OUT(mVerbose,msg);
+        return false;
+    }
+
+    setImuCalibration(calib);
+    return true;
+}
+
+data::ImuCalibration SensorCapture::getImuCalibration()
+{
+    const std::lock_guard<std::mutex> lock(mCalibMutex);
+    return mImuCalib;
+}
+
+void SensorCapture::enableOrientationFilter( bool enable, const OrientationFilterParams& params )
+{
+    if(enable)
+    {
+        const std::lock_guard<std::mutex> lock(mOrientMutex);
+        mOrientParams = params;
+        mOrientParamsChanged = true;
+    }
+
+    mOrientEnabled = enable;
+}
+
+data::Orientation SensorCapture::getLastOrientationData()
+{
+    data::Orientation orient;
+    if( !mOrientEnabled || mOrientParamsChanged || !mOrientHistory.getLast(orient) )
+        return data::Orientation();
+
+    return orient;
+}
+
+bool SensorCapture::getOrientationAt( uint64_t timestamp, data::Orientation& orientation )
+{
+    // The history is cleared by the sensor thread when the new parameters are applied
+    data::Orientation before, after;
+    if( !mOrientEnabled || mOrientParamsChanged || !mOrientHistory.getBracket(timestamp, before, after) )
+        return false;
+
+    orientation = OrientationFilter::interpolate(before, after, timestamp);
+    return true;
+}
+
+void SensorCapture::enableGravityEstimator( bool enable, const GravityParams& params )
+{
+    if(enable)
+    {
+        const std::lock_guard<std::mutex> lock(mGravityMutex);
+        mGravityParams = params;
+        mGravityParamsChanged = true;
+    }
+
+    mGravityEnabled = enable;
+}
+
+data::Gravity SensorCapture::getLastGravityData()
+{
+    data::Gravity gravity;
+    if( !mGravityEnabled || mGravityParamsChanged || !mGravityHistory.getLast(gravity) )
+        return data::Gravity();
+
+    return gravity;
+}
+
+bool SensorCapture::getGravityAt( uint64_t timestamp, data::Gravity& gravity )
+{
+    // The history is cleared by the sensor thread when the new parameters are applied
+    data::Gravity before, after;
+    if( !mGravityEnabled || mGravityParamsChanged || !mGravityHistory.getBracket(timestamp, before, after) )
+        return false;
+
+    gravity = GravityEstimator::interpolate(before, after, timestamp);
+    return true;
+}
+
+data::SensorLatencyStats SensorCapture::getLatencyStats()
+{
+    const std::lock_guard<std::mutex> lock(mStatsMutex);
+    return mLatencyStats;
+}
+
+void SensorCapture::resetLatencyStats()
+{
+    const std::lock_guard<std::mutex> lock(mStatsMutex);
+    mLatencyStats.transport.reset();
+    mLatencyStats.jitter.reset();
+    mLatencyStats.processing.reset();
+    mLatencyRef.reset();
+    mLatencyLastRxTs = 0;
+}
+
+data::SensorPacketStats SensorCapture::getPacketStats()
+{
+    const std::lock_guard<std::mutex> lock(mStatsMutex);
+    return mPacketStats;
+}
+
+void SensorCapture::resetPacketStats()
+{
+    const std::lock_guard<std::mutex> lock(mStatsMutex);
+    mPacketStats = data::SensorPacketStats();
+}
+
+void SensorCapture::setMotionEventCallback( MotionEventCallback callback )
+{
+    std::shared_ptr<MotionEventCallback> ptr;
+    if( callback )
+        ptr = std::make_shared<MotionEventCallback>(callback);
+
+    const std::lock_guard<std::mutex> lock(mEventMutex);
+    mMotionCallback = ptr;
+}
+
+void SensorCapture::enableStandstillDetection( bool enable, const StandstillParams& params, bool auto_subtract )
+{
+    if(enable)
+    {
+        const std::lock_guard<std::mutex> lock(mStillMutex);
+        mStillParams = params;
+        mStillParamsChanged = true;
+        mStillAutoSubtract = auto_subtract;
+    }
+    else
+    {
+        mCameraStill = false;
+    }
+
+    mStillEnabled = enable;
+}
+
+data::GyroBias SensorCapture::getGyroBias()
+{
+    const std::lock_guard<std::mutex> lock(mStillMutex);
+    return mGyroBias;
+}
+
+void SensorCapture::setGyroBias( const data::GyroBias& bias )
+{
+    const std::lock_guard<std::mutex> lock(mStillMutex);
+    mGyroBias = bias;
+    mGyroBiasChanged = true;
+}
+
+void SensorCapture::enableImuResampler( bool enable, const ImuResamplerParams& params )
+{
+    if(enable)
+    {
+        const std::lock_guard<std::mutex> lock(mResampMutex);
+        mResampParams = params;
+        mResampParamsChanged = true;
+    }
+
+    mResampEnabled = enable;
+}
+
+void SensorCapture::setImuCallback( ImuCallback callback )
+{
+    std::shared_ptr<ImuCallback> ptr;
+    if( callback )
+        ptr = std::make_shared<ImuCallback>(callback);
+
+    const std::lock_guard<std::mutex> lock(mImuCallbackMutex);
+    mImuCallback = ptr;
+}
+
+void SensorCapture::setResampledImuCallback( ImuCallback callback )
+{
+    std::shared_ptr<ImuCallback> ptr;
+    if( callback )
+        ptr = std::make_shared<ImuCallback>(callback);
+
+    const std::lock_guard<std::mutex> lock(mResampMutex);
+    mResampCallback = ptr;
+}
+
+bool SensorCapture::startImuLog( const std::string& filename, const ImuLogParams& params )
+{
+    ImuLogParams log_params = params;
+    if( log_params.serial==-1 )
+        log_params.serial = mDevSerial;
+
+    const std::lock_guard<std::mutex> lock(mImuLogMutex);
+    if( !mImuLog.open(filename, log_params) )
+    {
+        WARNING_OUT(mVerbose,std::string("Cannot create the IMU log file: ") + filename);
+        return false;
+    }
+
+    return true;
+}
+
+bool SensorCapture::stopImuLog()
+{
+    const std::lock_guard<std::mutex> lock(mImuLogMutex);
+    if( !mImuLog.isOpen() )
+        return false;
+
+    return mImuLog.close();
+}
+
+bool SensorCapture::isImuLogging()
+{
+    const std::lock_guard<std::mutex> lock(mImuLogMutex);
+    return mImuLog.isOpen();
+}
+
+bool SensorCapture::enableThermalBiasCompensation( bool enable, const std::string& model_folder,
+                                                   const ThermalBiasParams& params )
+{
+    if( !enable )
+    {
+        if( mThermalEnabled )
+            saveThermalBiasModel();
+
+        mThermalEnabled = false;
+        mThermalChanged = true;
+        return true;
+    }
+
+    if( !mInitialized )
+    {
+        WARNING_OUT(mVerbose,std::string("The sensors must be initialized to enable the thermal bias compensation"));
+        return false;
+    }
+
+    // ----> Model file of the connected camera
+    std::string folder = model_folder;
+    if( folder.empty() )
+    {
+        const char* home = getenv("HOME");
+        folder = std::string(home?home:".") + "/zed/settings/";
+    }
+    if( folder.back()!='/' )
+        folder += "/";
+    // <---- Model file of the connected camera
+
+    const std::lock_guard<std::mutex> lock(mThermalMutex);
+
+    mThermalFile = folder + "SN" + std::to_string(mDevSerial) + "_imu_thermal.conf";
+    mThermalModel = ThermalBiasModel(params);
+    if( mThermalModel.loadFromFile(mThermalFile) )
+    {
+        std::string msg = "Loaded IMU thermal bias model: ";
+        msg += mThermalFile;
+        INFO_OUT(mVerbose,msg);
+    }
+
+    mThermalEnabled = true;
+    mThermalChanged = true;
+    return true;
+}
+
+bool SensorCapture::saveThermalBiasModel()
+{
+    ThermalBiasModel model;
+    std::string filename;
+    {
+        const std::lock_guard<std::mutex> lock(mThermalMutex);
+        model = mThermalModel;
+        filename = mThermalFile;
+    }
+
+    if( filename.empty() )
+        return false;
+
+    if( !model.saveToFile(filename) )
+    {
+        std::string msg = "Unable to save the IMU thermal bias model ";
+        msg += filename;
+        WARNING_OUT(mVerbose,msg);
+        return false;
+    }
+
+    return true;
+}
+
+data::ImuThermalCoeffs SensorCapture::getThermalBiasCoefficients()
+{
+    const std::lock_guard<std::mutex> lock(mThermalMutex);
+    return mThermalModel.getCoefficients();
+}
+
+void SensorCapture::enableMagCalibration( bool enable, const MagCalibrationParams& params )
+{
+    const std::lock_guard<std::mutex> lock(mMagCalibMutex);
+
+    if( enable )
+    {
+        data::MagCalibration calib = mMagCalibrator.getCalibration();
+        mMagCalibrator = MagCalibrator(params);
+        mMagCalibrator.setCalibration(calib);
+    }
+
+    mMagCalibEnabled = enable;
+}
+
+void SensorCapture::setMagCalibration( const data::MagCalibration& calib )
+{
+    const std::lock_guard<std::mutex> lock(mMagCalibMutex);
+    mMagCalibrator.setCalibration(calib);
+}
+
+data::MagCalibration SensorCapture::getMagCalibration()
+{
+    const std::lock_guard<std::mutex> lock(mMagCalibMutex);
+    return mMagCalibrator.getCalibration();
+}
+
+std::vector<data::EnvRollup> SensorCapture::getEnvironmentHistory( EnvHistory::RESOLUTION res, EnvHistory::CHANNEL channel,
+                                                                   uint64_t from_ts, uint64_t to_ts )
+{
+    const std::lock_guard<std::mutex> lock(mEnvHistMutex);
+    return mEnvHistory.query(res, channel, from_ts, to_ts);
+}
+
+bool SensorCapture::saveEnvironmentHistory( const std::string& filename )
+{
+    const std::lock_guard<std::mutex> lock(mEnvHistMutex);
+    return mEnvHistory.saveToFile(filename);
+}
+
+bool SensorCapture::loadEnvironmentHistory( const std::string& filename )
+{
+    const std::lock_guard<std::mutex> lock(mEnvHistMutex);
+    return mEnvHistory.loadFromFile(filename);
+}
+
 const data::Imu& SensorCapture::getLastIMUData(uint64_t timeout_usec)
 {
     // ----> Wait for a new frame
@@ -804,6 +1512,28 @@ const data::Imu& SensorCapture::getLastIMUData(uint64_t timeout_usec)
     return mLastIMUData;
 }
 
+const data::Imu& SensorCapture::getLastResampledIMUData(uint64_t timeout_usec)
+{
+    // ----> Wait for a new sample
+    uint64_t time_count = (timeout_usec<100?100:timeout_usec)/100;
+    while( !mNewResampIMUData )
+    {
+        if(time_count==0)
+        {
+            if(mLastResampIMUData.valid!=data::Imu::NOT_PRESENT)
+                mLastResampIMUData.valid = data::Imu::OLD_VAL;
+            return mLastResampIMUData;
+        }
+        time_count--;
+        usleep(100);
+    }
+    // <---- Wait for a new sample
+
+    const std::lock_guard<std::mutex> lock(mResampDataMutex);
+    mNewResampIMUData = false;
+    return mLastResampIMUData;
+}
+
 const data::Magnetometer& SensorCapture::getLastMagnetometerData(uint64_t timeout_usec)
 {
     // ----> Wait for a new frame
@@ -0,0 +1,361 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "sensorconversion.hpp"
+
+#include <cmath>              // for llround
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace sl_oc {
+
+namespace sensors {
+
+namespace data {
+
+void ImuBatch::resize(size_t count)
+{
+    timestamp.resize(count);
+    aX.resize(count);
+    aY.resize(count);
+    aZ.resize(count);
+    gX.resize(count);
+    gY.resize(count);
+    gZ.resize(count);
+    temp.resize(count);
+    valid.resize(count);
+    sync.resize(count);
+    gap.resize(count);
+}
+
+}
+
+namespace {
+
+/*!
+ * \brief Apply in place a 3x4 row-major affine transform to three struct-of-arrays buffers
+ */
+void applyAffine3(const float* m, float* x, float* y, float* z, size_t count)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128 m00 = _mm_set1_ps(m[0]), m01 = _mm_set1_ps(m[1]), m02 = _mm_set1_ps(m[2]), b0 = _mm_set1_ps(m[3]);
+    const __m128 m10 = _mm_set1_ps(m[4]), m11 = _mm_set1_ps(m[5]), m12 = _mm_set1_ps(m[6]), b1 = _mm_set1_ps(m[7]);
+    const __m128 m20 = _mm_set1_ps(m[8]), m21 = _mm_set1_ps(m[9]), m22 = _mm_set1_ps(m[10]), b2 = _mm_set1_ps(m[11]);
+
+    for( ; i+4<=count; i+=4 )
+    {
+        __m128 vx = _mm_loadu_ps(x+i);
+        __m128 vy = _mm_loadu_ps(y+i);
+        __m128 vz = _mm_loadu_ps(z+i);
+
+        __m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00,vx),_mm_mul_ps(m01,vy)),_mm_add_ps(_mm_mul_ps(m02,vz),b0));
+        __m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10,vx),_mm_mul_ps(m11,vy)),_mm_add_ps(_mm_mul_ps(m12,vz),b1));
+        __m128 oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m20,vx),_mm_mul_ps(m21,vy)),_mm_add_ps(_mm_mul_ps(m22,vz),b2));
+
+        _mm_storeu_ps(x+i,ox);
+        _mm_storeu_ps(y+i,oy);
+        _mm_storeu_ps(z+i,oz);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t b0 = vdupq_n_f32(m[3]), b1 = vdupq_n_f32(m[7]), b2 = vdupq_n_f32(m[11]);
+
+    for( ; i+4<=count; i+=4 )
+    {
+        float32x4_t vx = vld1q_f32(x+i);
+        float32x4_t vy = vld1q_f32(y+i);
+        float32x4_t vz = vld1q_f32(z+i);
+
+        float32x4_t ox = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(b0,vx,m[0]),vy,m[1]),vz,m[2]);
+        float32x4_t oy = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(b1,vx,m[4]),vy,m[5]),vz,m[6]);
+        float32x4_t oz = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(b2,vx,m[8]),vy,m[9]),vz,m[10]);
+
+        vst1q_f32(x+i,ox);
+        vst1q_f32(y+i,oy);
+        vst1q_f32(z+i,oz);
+    }
+#endif
+
+    // Scalar tail (or full loop if SIMD is not available)
+    for( ; i<count; i++ )
+    {
+        float vx = x[i], vy = y[i], vz = z[i];
+        x[i] = m[0]*vx + m[1]*vy + m[2]*vz + m[3];
+        y[i] = m[4]*vx + m[5]*vy + m[6]*vz + m[7];
+        z[i] = m[8]*vx + m[9]*vy + m[10]*vz + m[11];
+    }
+}
+
+/*!
+ * \brief Compose the 3x4 row-major affine transform `M*(scale*raw - bias)`
+ */
+void composeAffine(float* m, float scale, const float* M, const float* bias)
+{
+    for( int r=0; r<3; r++ )
+    {
+        m[r*4+3] = 0.0f;
+        for( int c=0; c<3; c++ )
+        {
+            m[r*4+c] = M[r*3+c]*scale;
+            m[r*4+3] -= M[r*3+c]*bias[c];
+        }
+    }
+}
+
+/*!
+ * \brief Evaluate the polynomial `sum_k c[k]*t^k` with the Horner scheme
+ */
+inline float evalPoly(const float* c, int order, float t)
+{
+    float p = c[order];
+    for( int k=order-1; k>=0; k-- )
+        p = p*t + c[k];
+    return p;
+}
+
+/*!
+ * \brief Parse a list of `count` floating point values
+ */
+bool parseValues(const std::string& str, float* values, int count)
+{
+    std::istringstream ss(str);
+    for( int i=0; i<count; i++ )
+    {
+        if( !(ss >> values[i]) )
+            return false;
+    }
+    return true;
+}
+
+void writeValues(std::ofstream& file, const char* key, const float* values, int count)
+{
+    file << key << " =";
+    for( int i=0; i<count; i++ )
+        file << " " << values[i];
+    file << std::endl;
+}
+
+}
+
+bool loadImuCalibration( const std::string& filename, data::ImuCalibration& calib )
+{
+    std::ifstream file(filename);
+    if( !file.is_open() )
+        return false;
+
+    data::ImuCalibration loaded;
+    float* M = nullptr;
+    float* bias = nullptr;
+
+    std::string line;
+    while( std::getline(file, line) )
+    {
+        // Strip comments and surrounding spaces
+        line = line.substr(0, line.find_first_of("#;"));
+        size_t first = line.find_first_not_of(" \t\r");
+        if( first==std::string::npos )
+            continue;
+        line = line.substr(first, line.find_last_not_of(" \t\r")-first+1);
+
+        if( line.front()=='[' )
+        {
+            if( line=="[accelerometer]" )
+            {
+                M = loaded.acc_M;
+                bias = loaded.acc_bias;
+            }
+            else if( line=="[gyroscope]" )
+            {
+                M = loaded.gyro_M;
+                bias = loaded.gyro_bias;
+            }
+            else
+            {
+                M = bias = nullptr;
+            }
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if( eq==std::string::npos || eq==0 || M==nullptr )
+            continue;
+
+        std::string key = line.substr(0, line.find_last_not_of(" \t", eq-1)+1);
+        std::string value = line.substr(eq+1);
+
+        if( key=="M" && !parseValues(value, M, 9) )
+            return false;
+        if( key=="bias" && !parseValues(value, bias, 3) )
+            return false;
+    }
+
+    calib = loaded;
+    return true;
+}
+
+bool saveImuCalibration( const std::string& filename, const data::ImuCalibration& calib )
+{
+    std::ofstream file(filename);
+    if( !file.is_open() )
+        return false;
+
+    file << std::setprecision(9);
+    file << "[accelerometer]" << std::endl;
+    writeValues(file, "M", calib.acc_M, 9);
+    writeValues(file, "bias", calib.acc_bias, 3);
+    file << std::endl << "[gyroscope]" << std::endl;
+    writeValues(file, "M", calib.gyro_M, 9);
+    writeValues(file, "bias", calib.gyro_bias, 3);
+
+    return file.good();
+}
+
+SensorConverter::SensorConverter( int fw_version )
+{
+    setFirmwareVersion(fw_version);
+}
+
+void SensorConverter::setFirmwareVersion( int fw_version )
+{
+    updateImuAffine();
+
+    if( atLeast(fw_version, ZED_2_FW::FW_3_9) )
+    {
+        mPressScale = PRESS_SCALE_NEW;
+        mHumidScale = HUMID_SCALE_NEW;
+    }
+    else
+    {
+        mPressScale = PRESS_SCALE_OLD;
+        mHumidScale = HUMID_SCALE_OLD;
+    }
+}
+
+void SensorConverter::setImuCalibration( const data::ImuCalibration& calib )
+{
+    mImuCalib = calib;
+    updateImuAffine();
+}
+
+void SensorConverter::updateImuAffine()
+{
+    composeAffine(mAccAffine, ACC_SCALE, mImuCalib.acc_M, mImuCalib.acc_bias);
+    composeAffine(mGyroAffine, GYRO_SCALE, mImuCalib.gyro_M, mImuCalib.gyro_bias);
+}
+
+void SensorConverter::setThermalCompensation( const data::ImuThermalCoeffs& coeffs )
+{
+    mThermal = coeffs;
+
+    if( mThermal.order < 0 )
+        mThermal.order = 0;
+    if( mThermal.order > data::ImuThermalCoeffs::MAX_ORDER )
+        mThermal.order = data::ImuThermalCoeffs::MAX_ORDER;
+    if( mThermal.temp_scale == 0.0f )
+        mThermal.temp_scale = 1.0f;
+}
+
+size_t SensorConverter::compensateThermalBias( data::ImuBatch& batch, size_t offset, size_t count ) const
+{
+    if( !mThermal.enabled || batch.size() < offset+count )
+        return 0;
+
+    const float* temp = batch.temp.data()+offset;
+    float* gyro[3] = {batch.gX.data()+offset, batch.gY.data()+offset, batch.gZ.data()+offset};
+    float* acc[3] = {batch.aX.data()+offset, batch.aY.data()+offset, batch.aZ.data()+offset};
+
+    const float inv_scale = 1.0f/mThermal.temp_scale;
+    for( size_t i=0; i<count; i++ )
+    {
+        // Temperatures outside the range used to fit the model are clamped to avoid polynomial extrapolation
+        float T = temp[i]<mThermal.temp_min?mThermal.temp_min:(temp[i]>mThermal.temp_max?mThermal.temp_max:temp[i]);
+        float t = (T-mThermal.ref_temp)*inv_scale;
+        for( int a=0; a<3; a++ )
+        {
+            gyro[a][i] -= evalPoly(mThermal.gyro[a], mThermal.order, t);
+            acc[a][i] -= evalPoly(mThermal.acc[a], mThermal.order, t);
+        }
+    }
+
+    return count;
+}
+
+uint64_t SensorConverter::convertTimestamp( uint64_t raw_ts )
+{
+    return static_cast<uint64_t>(std::llround(static_cast<double>(raw_ts)*static_cast<double>(TS_SCALE)));
+}
+
+size_t SensorConverter::convertImu( const usb::RawData* raw, size_t count, data::ImuBatch& out, size_t offset ) const
+{
+    if( out.size() < offset+count )
+        out.resize(offset+count);
+
+    uint64_t* ts = out.timestamp.data()+offset;
+    float* aX = out.aX.data()+offset;
+    float* aY = out.aY.data()+offset;
+    float* aZ = out.aZ.data()+offset;
+    float* gX = out.gX.data()+offset;
+    float* gY = out.gY.data()+offset;
+    float* gZ = out.gZ.data()+offset;
+    float* temp = out.temp.data()+offset;
+    uint8_t* valid = out.valid.data()+offset;
+    uint8_t* sync = out.sync.data()+offset;
+    uint8_t* gap = out.gap.data()+offset;
+
+    // ----> De-interleave the packed RAW packets
+    for( size_t i=0; i<count; i++ )
+    {
+        const usb::RawData& pkt = raw[i];
+        ts[i] = convertTimestamp(pkt.timestamp);
+        aX[i] = pkt.aX;
+        aY[i] = pkt.aY;
+        aZ[i] = pkt.aZ;
+        gX[i] = pkt.gX;
+        gY[i] = pkt.gY;
+        gZ[i] = pkt.gZ;
+        temp[i] = pkt.imu_temp;
+        valid[i] = (pkt.imu_not_valid!=1)?1:0;
+        sync[i] = pkt.frame_sync;
+        gap[i] = 0;
+    }
+    // <---- De-interleave the packed RAW packets
+
+    // ----> Conversion to physical units
+    applyAffine3(mAccAffine, aX, aY, aZ, count);
+    applyAffine3(mGyroAffine, gX, gY, gZ, count);
+
+    for( size_t i=0; i<count; i++ )
+        temp[i] *= TEMP_SCALE;
+    // <---- Conversion to physical units
+
+    return count;
+}
+
+}
+
+}
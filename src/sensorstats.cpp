@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "sensorstats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+
+namespace sl_oc {
+
+namespace sensors {
+
+LatencyHistogram::LatencyHistogram( int64_t lower_bound, int64_t bin_width, size_t bin_count )
+{
+    mLowerBound = lower_bound;
+    mBinWidth = bin_width<1?1:bin_width;
+    mBins.resize(bin_count<1?1:bin_count);
+}
+
+void LatencyHistogram::add( int64_t value )
+{
+    if( mCount==0 )
+    {
+        mMin = value;
+        mMax = value;
+    }
+    else
+    {
+        mMin = std::min(mMin, value);
+        mMax = std::max(mMax, value);
+    }
+    mCount++;
+    mSum += static_cast<double>(value);
+
+    if( value < mLowerBound )
+    {
+        mUnderflow++;
+        return;
+    }
+
+    uint64_t idx = static_cast<uint64_t>((value-mLowerBound)/mBinWidth);
+    if( idx >= mBins.size() )
+    {
+        mOverflow++;
+        return;
+    }
+
+    mBins[idx]++;
+}
+
+void LatencyHistogram::reset()
+{
+    std::fill(mBins.begin(), mBins.end(), 0);
+    mCount = 0;
+    mUnderflow = 0;
+    mOverflow = 0;
+    mMin = 0;
+    mMax = 0;
+    mSum = 0.0;
+}
+
+int64_t LatencyHistogram::getPercentile( double percent ) const
+{
+    if( mCount==0 )
+        return 0;
+
+    uint64_t target = static_cast<uint64_t>(std::ceil(percent/100.0*static_cast<double>(mCount)));
+    if( target==0 )
+        target = 1;
+
+    uint64_t acc = mUnderflow;
+    if( acc >= target )
+        return mMin;
+
+    for( size_t i=0; i<mBins.size(); i++ )
+    {
+        acc += mBins[i];
+        if( acc >= target )
+            return std::min(mMax, mLowerBound + static_cast<int64_t>(i+1)*mBinWidth);
+    }
+
+    return mMax;
+}
+
+LatencyReference::LatencyReference( int64_t window_nsec, size_t window_count )
+{
+    mWindow = window_nsec<1?1:window_nsec;
+    mMinima.resize(window_count<2?2:window_count);
+}
+
+void LatencyReference::reset()
+{
+    mMinPos = 0;
+    mMinFill = 0;
+    mValid = false;
+    mSlope = 0.0;
+}
+
+int64_t LatencyReference::update( int64_t host_ts, int64_t offset )
+{
+    if( !mValid )
+    {
+        mValid = true;
+        mWinStart = host_ts;
+        mWinMin = {host_ts, offset};
+        mRunMin = offset;
+        return 0;
+    }
+
+    // ----> Window minima
+    if( host_ts-mWinStart >= mWindow )
+    {
+        mMinima[mMinPos] = mWinMin;
+        mMinPos = (mMinPos+1)%mMinima.size();
+        mMinFill = std::min(mMinFill+1, mMinima.size());
+        if( mMinFill>=2 )
+            fit();
+
+        mWinStart = host_ts;
+        mWinMin = {host_ts, offset};
+    }
+    else if( offset<mWinMin.offset )
+        mWinMin = {host_ts, offset};
+    mRunMin = std::min(mRunMin, offset);
+    // <---- Window minima
+
+    double ref;
+    if( mMinFill>=2 )
+        ref = mFitOffset + mSlope*static_cast<double>(host_ts-mFitTs);
+    else
+        ref = static_cast<double>(mRunMin);
+
+    const double latency = static_cast<double>(offset)-ref;
+    return latency>0.0 ? static_cast<int64_t>(latency) : 0;
+}
+
+void LatencyReference::fit()
+{
+    // Times relative to the last minimum, to keep the precision of the nanoseconds
+    const Minimum& last = mMinima[(mMinPos+mMinima.size()-1)%mMinima.size()];
+
+    double mean_t = 0.0, mean_o = 0.0;
+    for( size_t i=0; i<mMinFill; i++ )
+    {
+        mean_t += static_cast<double>(mMinima[i].ts-last.ts);
+        mean_o += static_cast<double>(mMinima[i].offset-last.offset);
+    }
+    mean_t /= mMinFill;
+    mean_o /= mMinFill;
+
+    double cov = 0.0, var = 0.0;
+    for( size_t i=0; i<mMinFill; i++ )
+    {
+        const double dt = static_cast<double>(mMinima[i].ts-last.ts) - mean_t;
+        cov += dt*(static_cast<double>(mMinima[i].offset-last.offset) - mean_o);
+        var += dt*dt;
+    }
+    mSlope = var>0.0 ? cov/var : 0.0;
+
+    // The line is lowered to pass below all the minima
+    double low = 0.0;
+    for( size_t i=0; i<mMinFill; i++ )
+    {
+        const double v = static_cast<double>(mMinima[i].offset-last.offset) -
+                mSlope*static_cast<double>(mMinima[i].ts-last.ts);
+        low = i==0 ? v : std::min(low, v);
+    }
+
+    mFitTs = last.ts;
+    mFitOffset = static_cast<double>(last.offset) + low;
+}
+
+std::string LatencyHistogram::toString() const
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    ss << "n: " << mCount << " - min: " << mMin << " - mean: " << getMean() << " - max: " << mMax
+       << " - p50: " << getPercentile(50.0) << " - p90: " << getPercentile(90.0)
+       << " - p99: " << getPercentile(99.0) << " - p99.9: " << getPercentile(99.9) << " [usec]";
+    return ss.str();
+}
+
+}
+
+}
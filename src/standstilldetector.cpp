@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "standstilldetector.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sl_oc {
+
+namespace sensors {
+
+static const uint64_t MAX_SAMPLE_GAP = 50000000ULL; //!< Input gap resetting the sliding window [nsec]
+
+StandstillDetector::StandstillDetector( const StandstillParams& params )
+{
+    setParams(params);
+}
+
+void StandstillDetector::setParams( const StandstillParams& params )
+{
+    mParams = params;
+    if( mParams.window < 2 )
+        mParams.window = 2;
+    if( mParams.bias_time_const <= 0.0f )
+        mParams.bias_time_const = 1.0f;
+
+    mWindow.resize(mParams.window);
+    reset();
+}
+
+void StandstillDetector::reset()
+{
+    mPos = 0;
+    mFill = 0;
+    for( int a=0; a<3; a++ )
+        mAccSum[a] = mAccSumSq[a] = 0.0;
+    mMovingCount = 0;
+    mLastTs = 0;
+    mStill = false;
+}
+
+bool StandstillDetector::update( uint64_t timestamp, float aX, float aY, float aZ, float gX, float gY, float gZ,
+                                 bool hw_moving )
+{
+    if( mLastTs!=0 && (timestamp<=mLastTs || timestamp-mLastTs>MAX_SAMPLE_GAP) )
+        reset();
+
+    const double dt = mLastTs!=0?(timestamp-mLastTs)*1e-9:0.0;
+    mLastTs = timestamp;
+
+    // ----> Sliding window
+    Sample s;
+    s.acc[0] = aX;
+    s.acc[1] = aY;
+    s.acc[2] = aZ;
+
+    const float wX = gX-mBias.bX;
+    const float wY = gY-mBias.bY;
+    const float wZ = gZ-mBias.bZ;
+    // Before the first estimate the bias is unknown, up to `max_bias`
+    const float gyro_max = mBias.valid?mParams.gyro_max:mParams.gyro_max+mParams.max_bias;
+    s.moving = (wX*wX+wY*wY+wZ*wZ > gyro_max*gyro_max) || (mParams.use_motion_flag && hw_moving);
+
+    if( mFill==mParams.window )
+    {
+        // Remove the oldest sample
+        const Sample& old = mWindow[mPos];
+        for( int a=0; a<3; a++ )
+        {
+            mAccSum[a] -= old.acc[a];
+            mAccSumSq[a] -= static_cast<double>(old.acc[a])*old.acc[a];
+        }
+        if( old.moving )
+            mMovingCount--;
+    }
+    else
+    {
+        mFill++;
+    }
+
+    mWindow[mPos] = s;
+    mPos = (mPos+1)%mParams.window;
+    for( int a=0; a<3; a++ )
+    {
+        mAccSum[a] += s.acc[a];
+        mAccSumSq[a] += static_cast<double>(s.acc[a])*s.acc[a];
+    }
+    if( s.moving )
+        mMovingCount++;
+    // <---- Sliding window
+
+    // ----> Standstill test
+    mStill = false;
+    if( mFill==mParams.window && mMovingCount==0 )
+    {
+        const double n = mFill;
+        const double var_max = static_cast<double>(mParams.acc_std_max)*mParams.acc_std_max;
+        mStill = true;
+        for( int a=0; a<3; a++ )
+        {
+            double mean = mAccSum[a]/n;
+            if( mAccSumSq[a]/n - mean*mean > var_max )
+            {
+                mStill = false;
+                break;
+            }
+        }
+    }
+    // <---- Standstill test
+
+    // ----> Gyroscope bias
+    if( mStill )
+    {
+        mBias.samples++;
+
+        // Cumulative average, then exponential average
+        float alpha = std::max(1.0f/mBias.samples, static_cast<float>(dt/mParams.bias_time_const));
+        if( !mBias.valid )
+        {
+            mBias.valid = true;
+            alpha = 1.0f;
+        }
+
+        mBias.bX += alpha*(gX-mBias.bX);
+        mBias.bY += alpha*(gY-mBias.bY);
+        mBias.bZ += alpha*(gZ-mBias.bZ);
+
+        mBias.bX = std::min(mParams.max_bias, std::max(-mParams.max_bias, mBias.bX));
+        mBias.bY = std::min(mParams.max_bias, std::max(-mParams.max_bias, mBias.bY));
+        mBias.bZ = std::min(mParams.max_bias, std::max(-mParams.max_bias, mBias.bZ));
+
+        mBias.timestamp = timestamp;
+    }
+    // <---- Gyroscope bias
+
+    return mStill;
+}
+
+}
+
+}
@@ -0,0 +1,567 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "stereocalibration.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace sl_oc {
+
+namespace video {
+
+const int StereoCalibration::RESOLUTION_COUNT;
+
+namespace {
+
+const char BINARY_MAGIC[8] = {'Z','O','C','C','A','L','I','B'};
+const uint32_t BINARY_VERSION = 2;
+
+// Resolution suffixes of the section and key names, in the order of RESOLUTION
+const char* RES_SUFFIX[StereoCalibration::RESOLUTION_COUNT] = {"2k", "fhd", "hd", "vga"};
+const char* RES_NAME[StereoCalibration::RESOLUTION_COUNT] = {"HD2K", "HD1080", "HD720", "VGA"};
+
+// Presence flags of the mandatory intrinsic parameters
+const unsigned int HAS_FX = 1;
+const unsigned int HAS_FY = 2;
+const unsigned int HAS_CX = 4;
+const unsigned int HAS_CY = 8;
+const unsigned int HAS_ALL = HAS_FX|HAS_FY|HAS_CX|HAS_CY;
+
+/*!
+ * \brief Header of the binary serialization. It is stored in the host byte order.
+ */
+struct BinaryHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t payload_size;
+    uint64_t checksum;
+};
+
+// Serialized size of StereoCameraParams: valid flag, image size, 2x9 intrinsics and 6 extrinsics
+const size_t BINARY_PARAMS_SIZE = 1 + 2*sizeof(int32_t) + 24*sizeof(double);
+
+/*!
+ * \brief Serialize the fields one by one, in the host byte order, so that struct padding never reaches the buffer
+ */
+template<typename T>
+inline uint8_t* putValue( uint8_t* dst, T val )
+{
+    memcpy(dst, &val, sizeof(T));
+    return dst + sizeof(T);
+}
+
+template<typename T>
+inline const uint8_t* getValue( const uint8_t* src, T& val )
+{
+    memcpy(&val, src, sizeof(T));
+    return src + sizeof(T);
+}
+
+uint8_t* writeIntrinsics( uint8_t* dst, const CameraIntrinsics& cam )
+{
+    for( double val : {cam.fx, cam.fy, cam.cx, cam.cy, cam.k1, cam.k2, cam.p1, cam.p2, cam.k3} )
+        dst = putValue(dst, val);
+    return dst;
+}
+
+const uint8_t* readIntrinsics( const uint8_t* src, CameraIntrinsics& cam )
+{
+    for( double* val : {&cam.fx, &cam.fy, &cam.cx, &cam.cy, &cam.k1, &cam.k2, &cam.p1, &cam.p2, &cam.k3} )
+        src = getValue(src, *val);
+    return src;
+}
+
+uint8_t* writeParams( uint8_t* dst, const StereoCameraParams& params )
+{
+    dst = putValue<uint8_t>(dst, params.valid?1:0);
+    dst = putValue<int32_t>(dst, params.width);
+    dst = putValue<int32_t>(dst, params.height);
+    dst = writeIntrinsics(dst, params.left);
+    dst = writeIntrinsics(dst, params.right);
+    for( double val : {params.baseline, params.ty, params.tz, params.rx, params.ry, params.rz} )
+        dst = putValue(dst, val);
+    return dst;
+}
+
+const uint8_t* readParams( const uint8_t* src, StereoCameraParams& params )
+{
+    uint8_t valid;
+    int32_t width, height;
+    src = getValue(src, valid);
+    src = getValue(src, width);
+    src = getValue(src, height);
+    params.valid = valid!=0;
+    params.width = width;
+    params.height = height;
+    src = readIntrinsics(src, params.left);
+    src = readIntrinsics(src, params.right);
+    for( double* val : {&params.baseline, &params.ty, &params.tz, &params.rx, &params.ry, &params.rz} )
+        src = getValue(src, *val);
+    return src;
+}
+
+uint64_t fnv1a( const void* data, size_t size, uint64_t hash = 14695981039346656037ULL )
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for( size_t i=0; i<size; i++ )
+    {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline char toLower( char c )
+{
+    return (c>='A' && c<='Z') ? static_cast<char>(c-'A'+'a') : c;
+}
+
+/*!
+ * \brief Case insensitive comparison of the text [begin,end) with a lower case string
+ */
+bool equals( const char* begin, const char* end, const char* str )
+{
+    for( ; begin<end && *str; begin++, str++ )
+    {
+        if( toLower(*begin)!=*str )
+            return false;
+    }
+    return begin==end && *str=='\0';
+}
+
+/*!
+ * \brief Case insensitive check that the text [begin,end) is `prefix` followed by a resolution suffix
+ * \return the resolution index, -1 if not matching
+ */
+int matchResolution( const char* begin, const char* end, const char* prefix )
+{
+    const size_t len = strlen(prefix);
+    if( static_cast<size_t>(end-begin)<=len || !equals(begin, begin+len, prefix) )
+        return -1;
+
+    for( int r=0; r<StereoCalibration::RESOLUTION_COUNT; r++ )
+    {
+        if( equals(begin+len, end, RES_SUFFIX[r]) )
+            return r;
+    }
+    return -1;
+}
+
+/*!
+ * \brief Parse a decimal number, independently of the C locale
+ */
+bool parseNumber( const char* begin, const char* end, double& value )
+{
+    const double POW10[] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,
+                            1e19,1e20,1e21,1e22};
+
+    const char* p = begin;
+    bool negative = false;
+    if( p<end && (*p=='-' || *p=='+') )
+        negative = (*p++=='-');
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    bool any = false;
+
+    for( ; p<end && *p>='0' && *p<='9'; p++, any=true )
+    {
+        if( digits<19 )
+        {
+            mantissa = mantissa*10 + static_cast<uint64_t>(*p-'0');
+            if( mantissa )
+                digits++;
+        }
+        else
+            exponent++;
+    }
+
+    if( p<end && *p=='.' )
+    {
+        for( p++; p<end && *p>='0' && *p<='9'; p++, any=true )
+        {
+            if( digits<19 )
+            {
+                mantissa = mantissa*10 + static_cast<uint64_t>(*p-'0');
+                exponent--;
+                if( mantissa )
+                    digits++;
+            }
+        }
+    }
+
+    if( !any )
+        return false;
+
+    if( p<end && (*p=='e' || *p=='E') )
+    {
+        p++;
+        bool exp_negative = false;
+        if( p<end && (*p=='-' || *p=='+') )
+            exp_negative = (*p++=='-');
+
+        int exp = 0;
+        bool exp_any = false;
+        for( ; p<end && *p>='0' && *p<='9'; p++, exp_any=true )
+            exp = std::min(exp*10 + (*p-'0'), 1000);
+        if( !exp_any )
+            return false;
+
+        exponent += exp_negative ? -exp : exp;
+    }
+
+    if( p!=end )
+        return false;
+
+    // Exact for mantissas below 2^53 and exponents up to 22, the usual case
+    double v = static_cast<double>(mantissa);
+    if( exponent>=0 )
+        v = exponent<=22 ? v*POW10[exponent] : v*std::pow(10.0, exponent);
+    else
+        v = exponent>=-22 ? v/POW10[-exponent] : v*std::pow(10.0, exponent);
+
+    value = negative ? -v : v;
+    return true;
+}
+
+}
+
+bool StereoCalibration::parse( const std::string& data, std::string* error )
+{
+    enum class SECTION { OTHER, LEFT, RIGHT, STEREO };
+
+    StereoCameraParams params[RESOLUTION_COUNT];
+    unsigned int found[RESOLUTION_COUNT][2] = {};
+    double baseline = 0.0;
+    bool has_baseline = false;
+
+    SECTION section = SECTION::OTHER;
+    int section_res = -1;
+
+    const char* p = data.data();
+    const char* data_end = p + data.size();
+
+    while( p<data_end )
+    {
+        // ----> Trimmed line
+        const char* line_end = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(data_end-p)));
+        if( !line_end )
+            line_end = data_end;
+
+        const char* begin = p;
+        const char* end = line_end;
+        p = line_end+1;
+
+        while( begin<end && isspace(static_cast<unsigned char>(*begin)) )
+            begin++;
+        while( end>begin && isspace(static_cast<unsigned char>(end[-1])) )
+            end--;
+
+        if( begin==end || *begin==';' || *begin=='#' )
+            continue;
+        // <---- Trimmed line
+
+        // ----> Section
+        if( *begin=='[' )
+        {
+            if( end[-1]!=']' )
+            {
+                section = SECTION::OTHER;
+                continue;
+            }
+
+            begin++;
+            end--;
+            if( (section_res=matchResolution(begin, end, "left_cam_"))>=0 )
+                section = SECTION::LEFT;
+            else if( (section_res=matchResolution(begin, end, "right_cam_"))>=0 )
+                section = SECTION::RIGHT;
+            else if( equals(begin, end, "stereo") )
+                section = SECTION::STEREO;
+            else
+                section = SECTION::OTHER;
+            continue;
+        }
+
+        if( section==SECTION::OTHER )
+            continue;
+        // <---- Section
+
+        // ----> Key and value
+        const char* eq = static_cast<const char*>(memchr(begin, '=', static_cast<size_t>(end-begin)));
+        if( !eq )
+            continue;
+
+        const char* key_end = eq;
+        while( key_end>begin && isspace(static_cast<unsigned char>(key_end[-1])) )
+            key_end--;
+        const char* value_begin = eq+1;
+        while( value_begin<end && isspace(static_cast<unsigned char>(*value_begin)) )
+            value_begin++;
+
+        double value;
+        if( !parseNumber(value_begin, end, value) )
+            continue;
+        // <---- Key and value
+
+        if( section==SECTION::STEREO )
+        {
+            int r;
+            if( equals(begin, key_end, "baseline") )
+            {
+                baseline = value;
+                has_baseline = true;
+            }
+            else if( (r=matchResolution(begin, key_end, "ty_"))>=0 )
+                params[r].ty = value;
+            else if( (r=matchResolution(begin, key_end, "tz_"))>=0 )
+                params[r].tz = value;
+            else if( (r=matchResolution(begin, key_end, "rx_"))>=0 )
+                params[r].rx = value;
+            else if( (r=matchResolution(begin, key_end, "cv_"))>=0 )
+                params[r].ry = value;
+            else if( (r=matchResolution(begin, key_end, "rz_"))>=0 )
+                params[r].rz = value;
+            continue;
+        }
+
+        const int side = section==SECTION::LEFT ? 0 : 1;
+        CameraIntrinsics& cam = side==0 ? params[section_res].left : params[section_res].right;
+        unsigned int& flags = found[section_res][side];
+
+        if( equals(begin, key_end, "fx") )      { cam.fx = value; flags |= HAS_FX; }
+        else if( equals(begin, key_end, "fy") ) { cam.fy = value; flags |= HAS_FY; }
+        else if( equals(begin, key_end, "cx") ) { cam.cx = value; flags |= HAS_CX; }
+        else if( equals(begin, key_end, "cy") ) { cam.cy = value; flags |= HAS_CY; }
+        else if( equals(begin, key_end, "k1") ) cam.k1 = value;
+        else if( equals(begin, key_end, "k2") ) cam.k2 = value;
+        else if( equals(begin, key_end, "p1") ) cam.p1 = value;
+        else if( equals(begin, key_end, "p2") ) cam.p2 = value;
+        else if( equals(begin, key_end, "k3") ) cam.k3 = value;
+    }
+
+    // ----> Validation
+    std::string errors;
+    bool any_valid = false;
+
+    for( int r=0; r<RESOLUTION_COUNT; r++ )
+    {
+        StereoCameraParams& par = params[r];
+        par.width = static_cast<int>(cameraResolution[r].width);
+        par.height = static_cast<int>(cameraResolution[r].height);
+        par.baseline = baseline;
+
+        std::string res_error;
+        if( found[r][0]!=HAS_ALL || found[r][1]!=HAS_ALL )
+            res_error = "missing intrinsic parameters";
+        else if( !has_baseline )
+            res_error = "missing baseline";
+        else
+            validate(par, res_error);
+
+        par.valid = res_error.empty();
+        any_valid |= par.valid;
+
+        if( !par.valid )
+            errors += std::string(RES_NAME[r]) + ": " + res_error + "; ";
+    }
+    // <---- Validation
+
+    if( error )
+        *error = errors;
+
+    if( !any_valid )
+        return false;
+
+    for( int r=0; r<RESOLUTION_COUNT; r++ )
+        mParams[r] = params[r];
+    mHash = fnv1a(data.data(), data.size());
+    return true;
+}
+
+bool StereoCalibration::validate( StereoCameraParams& params, std::string& error )
+{
+    const double max_rot = 0.5; // radians, a stereo rig is nearly parallel
+
+    const CameraIntrinsics* cams[2] = {&params.left, &params.right};
+    for( const CameraIntrinsics* cam : cams )
+    {
+        const double values[] = {cam->fx, cam->fy, cam->cx, cam->cy, cam->k1, cam->k2, cam->p1, cam->p2, cam->k3};
+        for( double v : values )
+        {
+            if( !std::isfinite(v) )
+            {
+                error = "not finite intrinsic parameter";
+                return false;
+            }
+        }
+
+        if( cam->fx<=0.0 || cam->fy<=0.0 || cam->fx>10.0*params.width || cam->fy>10.0*params.width )
+        {
+            error = "focal length out of range";
+            return false;
+        }
+        if( cam->cx<=0.0 || cam->cx>=params.width || cam->cy<=0.0 || cam->cy>=params.height )
+        {
+            error = "principal point outside the image";
+            return false;
+        }
+    }
+
+    // A file read with the wrong decimal separator has no distortion
+    if( params.left.k1==0.0 && params.left.k2==0.0 && params.right.k1==0.0 && params.right.k2==0.0 )
+    {
+        error = "no distortion coefficients";
+        return false;
+    }
+
+    if( !std::isfinite(params.baseline) || params.baseline<=0.0 || params.baseline>10000.0 )
+    {
+        error = "baseline out of range";
+        return false;
+    }
+
+    const double extrinsics[] = {params.ty, params.tz, params.rx, params.ry, params.rz};
+    for( double v : extrinsics )
+    {
+        if( !std::isfinite(v) )
+        {
+            error = "not finite extrinsic parameter";
+            return false;
+        }
+    }
+    if( std::fabs(params.ty)>params.baseline || std::fabs(params.tz)>params.baseline )
+    {
+        error = "translation out of range";
+        return false;
+    }
+    if( std::fabs(params.rx)>max_rot || std::fabs(params.ry)>max_rot || std::fabs(params.rz)>max_rot )
+    {
+        error = "rotation out of range";
+        return false;
+    }
+
+    return true;
+}
+
+bool StereoCalibration::load( const std::string& filename, std::string* error )
+{
+    std::ifstream file(filename, std::ios::binary);
+    if( !file.is_open() )
+    {
+        if( error )
+            *error = "cannot open " + filename;
+        return false;
+    }
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return parse(ss.str(), error);
+}
+
+void StereoCalibration::toBinary( std::vector<uint8_t>& buffer ) const
+{
+    const size_t payload_size = RESOLUTION_COUNT*BINARY_PARAMS_SIZE + sizeof(mHash);
+
+    BinaryHeader header;
+    memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+    header.version = BINARY_VERSION;
+    header.payload_size = static_cast<uint32_t>(payload_size);
+
+    buffer.resize(sizeof(header) + payload_size);
+    uint8_t* payload = buffer.data() + sizeof(header);
+    uint8_t* dst = payload;
+    for( int r=0; r<RESOLUTION_COUNT; r++ )
+        dst = writeParams(dst, mParams[r]);
+    putValue(dst, mHash);
+
+    header.checksum = fnv1a(payload, payload_size);
+    memcpy(buffer.data(), &header, sizeof(header));
+}
+
+bool StereoCalibration::fromBinary( const uint8_t* data, size_t size )
+{
+    const size_t payload_size = RESOLUTION_COUNT*BINARY_PARAMS_SIZE + sizeof(mHash);
+
+    BinaryHeader header;
+    if( !data || size!=sizeof(header)+payload_size )
+        return false;
+
+    memcpy(&header, data, sizeof(header));
+    const uint8_t* payload = data + sizeof(header);
+    if( memcmp(header.magic, BINARY_MAGIC, sizeof(header.magic))!=0 || header.version!=BINARY_VERSION ||
+            header.payload_size!=payload_size || header.checksum!=fnv1a(payload, payload_size) )
+        return false;
+
+    const uint8_t* src = payload;
+    for( int r=0; r<RESOLUTION_COUNT; r++ )
+        src = readParams(src, mParams[r]);
+    getValue(src, mHash);
+    return true;
+}
+
+bool StereoCalibration::saveBinary( const std::string& filename ) const
+{
+    std::vector<uint8_t> buffer;
+    toBinary(buffer);
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    return file.is_open() && file.write(reinterpret_cast<const char*>(buffer.data()),
+                                        static_cast<std::streamsize>(buffer.size()));
+}
+
+bool StereoCalibration::loadBinary( const std::string& filename )
+{
+    std::ifstream file(filename, std::ios::binary);
+    if( !file.is_open() )
+        return false;
+
+    std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return fromBinary(buffer.data(), buffer.size());
+}
+
+bool StereoCalibration::isValid( RESOLUTION res ) const
+{
+    const int r = static_cast<int>(res);
+    return r>=0 && r<RESOLUTION_COUNT && mParams[r].valid;
+}
+
+const StereoCameraParams& StereoCalibration::getParams( RESOLUTION res ) const
+{
+    static const StereoCameraParams invalid;
+
+    const int r = static_cast<int>(res);
+    if( r<0 || r>=RESOLUTION_COUNT )
+        return invalid;
+    return mParams[r];
+}
+
+}
+
+}
@@ -0,0 +1,336 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "stereorectify.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace sl_oc {
+
+namespace video {
+
+namespace {
+
+// ----> 3x3 matrix helpers, row-major
+void matMul( const double A[9], const double B[9], double C[9] )
+{
+    for( int r=0; r<3; r++ )
+        for( int c=0; c<3; c++ )
+            C[r*3+c] = A[r*3]*B[c] + A[r*3+1]*B[3+c] + A[r*3+2]*B[6+c];
+}
+
+void matMulTransposed( const double A[9], const double B[9], double C[9] ) // A*B^T
+{
+    for( int r=0; r<3; r++ )
+        for( int c=0; c<3; c++ )
+            C[r*3+c] = A[r*3]*B[c*3] + A[r*3+1]*B[c*3+1] + A[r*3+2]*B[c*3+2];
+}
+
+void matVec( const double A[9], const double v[3], double out[3] )
+{
+    for( int r=0; r<3; r++ )
+        out[r] = A[r*3]*v[0] + A[r*3+1]*v[1] + A[r*3+2]*v[2];
+}
+
+bool matInvert( const double A[9], double inv[9] )
+{
+    const double c0 = A[4]*A[8] - A[5]*A[7];
+    const double c1 = A[5]*A[6] - A[3]*A[8];
+    const double c2 = A[3]*A[7] - A[4]*A[6];
+    const double det = A[0]*c0 + A[1]*c1 + A[2]*c2;
+    if( det==0.0 )
+        return false;
+
+    const double d = 1.0/det;
+    inv[0] = c0*d;  inv[1] = (A[2]*A[7] - A[1]*A[8])*d;  inv[2] = (A[1]*A[5] - A[2]*A[4])*d;
+    inv[3] = c1*d;  inv[4] = (A[0]*A[8] - A[2]*A[6])*d;  inv[5] = (A[2]*A[3] - A[0]*A[5])*d;
+    inv[6] = c2*d;  inv[7] = (A[1]*A[6] - A[0]*A[7])*d;  inv[8] = (A[0]*A[4] - A[1]*A[3])*d;
+    return true;
+}
+// <---- 3x3 matrix helpers, row-major
+
+/*!
+ * \brief Rectangle of the rectified image containing only valid pixels, as the inner rectangle of the OpenCV
+ *        `getRectangles`
+ */
+void getInnerRectangle( const CameraIntrinsics& cam, const double R[9], const double P[12], int width, int height,
+                        double inner[4] )
+{
+    const int N = 9;
+
+    double iX0=-DBL_MAX, iX1=DBL_MAX, iY0=-DBL_MAX, iY1=DBL_MAX;
+
+    for( int y=0; y<N; y++ )
+    {
+        for( int x=0; x<N; x++ )
+        {
+            double px = static_cast<double>(x)*(width-1)/(N-1);
+            double py = static_cast<double>(y)*(height-1)/(N-1);
+            StereoRectify::undistortPoint(cam, R, P, 4, px, py);
+
+            if( x==0 )
+                iX0 = std::max(iX0, px);
+            if( x==N-1 )
+                iX1 = std::min(iX1, px);
+            if( y==0 )
+                iY0 = std::max(iY0, py);
+            if( y==N-1 )
+                iY1 = std::min(iY1, py);
+        }
+    }
+
+    inner[0] = iX0; inner[1] = iY0; inner[2] = iX1-iX0; inner[3] = iY1-iY0;
+}
+
+}
+
+void StereoRectify::rodrigues( const double rvec[3], double R[9] )
+{
+    const double theta = std::sqrt(rvec[0]*rvec[0] + rvec[1]*rvec[1] + rvec[2]*rvec[2]);
+    if( theta<DBL_EPSILON )
+    {
+        const double I[9] = {1,0,0, 0,1,0, 0,0,1};
+        std::copy(I, I+9, R);
+        return;
+    }
+
+    const double kx = rvec[0]/theta, ky = rvec[1]/theta, kz = rvec[2]/theta;
+    const double c = std::cos(theta), s = std::sin(theta), c1 = 1.0-c;
+
+    R[0] = c + c1*kx*kx;     R[1] = c1*kx*ky - s*kz;  R[2] = c1*kx*kz + s*ky;
+    R[3] = c1*ky*kx + s*kz;  R[4] = c + c1*ky*ky;     R[5] = c1*ky*kz - s*kx;
+    R[6] = c1*kz*kx - s*ky;  R[7] = c1*kz*ky + s*kx;  R[8] = c + c1*kz*kz;
+}
+
+void StereoRectify::undistortPoint( const CameraIntrinsics& cam, const double R[9], const double* P, int P_step,
+                                    double& x, double& y, int iterations )
+{
+    const double x0 = (x - cam.cx)/cam.fx;
+    const double y0 = (y - cam.cy)/cam.fy;
+    double ux = x0, uy = y0;
+
+    for( int i=0; i<iterations; i++ )
+    {
+        const double r2 = ux*ux + uy*uy;
+        const double icdist = 1.0/(1.0 + ((cam.k3*r2 + cam.k2)*r2 + cam.k1)*r2);
+        const double dx = 2.0*cam.p1*ux*uy + cam.p2*(r2 + 2.0*ux*ux);
+        const double dy = cam.p1*(r2 + 2.0*uy*uy) + 2.0*cam.p2*ux*uy;
+        ux = (x0 - dx)*icdist;
+        uy = (y0 - dy)*icdist;
+    }
+
+    if( R )
+    {
+        const double v[3] = {ux, uy, 1.0};
+        double w[3];
+        matVec(R, v, w);
+        ux = w[0]/w[2];
+        uy = w[1]/w[2];
+    }
+
+    if( P )
+    {
+        x = ux*P[0] + uy*P[1] + P[2];
+        y = ux*P[P_step] + uy*P[P_step+1] + P[P_step+2];
+    }
+    else
+    {
+        x = ux;
+        y = uy;
+    }
+}
+
+bool StereoRectify::compute( const StereoCameraParams& calib, RectificationParams& rect )
+{
+    if( !calib.valid )
+        return false;
+
+    const int nx = calib.width;
+    const int ny = calib.height;
+    const CameraIntrinsics* cams[2] = {&calib.left, &calib.right};
+    const double T[3] = {calib.baseline, calib.ty, calib.tz};
+
+    // ----> Rotations
+    // Each camera is rotated by half the relative rotation, then both are aligned to the baseline
+    double om[3] = {-0.5*calib.rx, -0.5*calib.ry, -0.5*calib.rz};
+    double r_r[9];
+    rodrigues(om, r_r);
+
+    double t[3];
+    matVec(r_r, T, t);
+
+    const int idx = std::fabs(t[0])>std::fabs(t[1]) ? 0 : 1;
+    const double c = t[idx];
+    const double nt = std::sqrt(t[0]*t[0] + t[1]*t[1] + t[2]*t[2]);
+
+    double uu[3] = {0.0, 0.0, 0.0};
+    uu[idx] = c>0 ? 1.0 : -1.0;
+
+    double ww[3] = {t[1]*uu[2] - t[2]*uu[1], t[2]*uu[0] - t[0]*uu[2], t[0]*uu[1] - t[1]*uu[0]};
+    const double nw = std::sqrt(ww[0]*ww[0] + ww[1]*ww[1] + ww[2]*ww[2]);
+    if( nw>0.0 )
+    {
+        const double scale = std::acos(std::fabs(c)/nt)/nw;
+        ww[0] *= scale; ww[1] *= scale; ww[2] *= scale;
+    }
+
+    double wR[9];
+    rodrigues(ww, wR);
+
+    matMulTransposed(wR, r_r, rect.R_left);
+    matMul(wR, r_r, rect.R_right);
+    matVec(rect.R_right, T, t);
+    // <---- Rotations
+
+    // New focal length, the average of the cameras
+    double fc_new = 0.0;
+    for( int k=0; k<2; k++ )
+        fc_new += 0.5*(idx==0 ? cams[k]->fy : cams[k]->fx);
+
+    // ----> New principal points, centering the rectified corners
+    double cc_new[2][2];
+    for( int k=0; k<2; k++ )
+    {
+        const double* R = k==0 ? rect.R_left : rect.R_right;
+        double avg_x = 0.0, avg_y = 0.0;
+        for( int i=0; i<4; i++ )
+        {
+            double x = (i%2)*(nx-1);
+            double y = (i<2 ? 0 : 1)*(ny-1);
+            undistortPoint(*cams[k], R, nullptr, 0, x, y);
+            avg_x += fc_new*x;
+            avg_y += fc_new*y;
+        }
+        cc_new[k][0] = 0.5*(nx-1) - avg_x/4;
+        cc_new[k][1] = 0.5*(ny-1) - avg_y/4;
+    }
+
+    // Zero disparity at infinity
+    cc_new[0][0] = cc_new[1][0] = (cc_new[0][0] + cc_new[1][0])*0.5;
+    cc_new[0][1] = cc_new[1][1] = (cc_new[0][1] + cc_new[1][1])*0.5;
+    // <---- New principal points, centering the rectified corners
+
+    double* P[2] = {rect.P_left, rect.P_right};
+    for( int k=0; k<2; k++ )
+    {
+        std::fill(P[k], P[k]+12, 0.0);
+        P[k][0] = P[k][5] = fc_new;
+        P[k][2] = cc_new[k][0];
+        P[k][6] = cc_new[k][1];
+        P[k][10] = 1.0;
+    }
+    rect.P_right[idx*4+3] = t[idx]*fc_new;
+
+    // ----> Scale to keep only valid pixels (alpha=0)
+    double s = 0.0;
+    for( int k=0; k<2; k++ )
+    {
+        double inner[4];
+        getInnerRectangle(*cams[k], k==0 ? rect.R_left : rect.R_right, P[k], nx, ny, inner);
+
+        const double cx = cc_new[k][0];
+        const double cy = cc_new[k][1];
+        s = std::max(s, cx/(cx - inner[0]));
+        s = std::max(s, cy/(cy - inner[1]));
+        s = std::max(s, (nx - 1 - cx)/(inner[0] + inner[2] - cx));
+        s = std::max(s, (ny - 1 - cy)/(inner[1] + inner[3] - cy));
+    }
+
+    fc_new *= s;
+    for( int k=0; k<2; k++ )
+        P[k][0] = P[k][5] = fc_new;
+    rect.P_right[idx*4+3] *= s;
+    // <---- Scale to keep only valid pixels (alpha=0)
+
+    rect.width = nx;
+    rect.height = ny;
+    return true;
+}
+
+bool StereoRectify::scale( const RectificationParams& rect, double scale, RectificationParams& scaled )
+{
+    if( !(scale>0.0) || rect.width<=0 || rect.height<=0 )
+        return false;
+
+    const int width = std::max(1, static_cast<int>(std::lround(rect.width*scale)));
+    const int height = std::max(1, static_cast<int>(std::lround(rect.height*scale)));
+    const double sx = static_cast<double>(width)/rect.width;
+    const double sy = static_cast<double>(height)/rect.height;
+
+    if( &scaled!=&rect )
+        scaled = rect;
+    scaled.width = width;
+    scaled.height = height;
+
+    // Pixel centers aligned: u' = (u+0.5)*s - 0.5
+    for( double* P : {scaled.P_left, scaled.P_right} )
+    {
+        for( int i=0; i<4; i++ )
+        {
+            P[i] = sx*P[i] + (0.5*sx - 0.5)*P[8+i];
+            P[4+i] = sy*P[4+i] + (0.5*sy - 0.5)*P[8+i];
+        }
+    }
+
+    return true;
+}
+
+bool StereoRectify::invertProjection( const double R[9], const double P[12], double iKR[9] )
+{
+    const double K[9] = {P[0], P[1], P[2], P[4], P[5], P[6], P[8], P[9], P[10]};
+    double KR[9];
+    matMul(K, R, KR);
+    return matInvert(KR, iKR);
+}
+
+void StereoRectify::computeMap( const CameraIntrinsics& cam, const double R[9], const double P[12], int width,
+                                int row_begin, int row_end, float* map_x, float* map_y )
+{
+    double iR[9];
+    if( !invertProjection(R, P, iR) )
+        return;
+
+    for( int i=row_begin; i<row_end; i++ )
+    {
+        float* mx = map_x + static_cast<size_t>(i)*width;
+        float* my = map_y + static_cast<size_t>(i)*width;
+
+        double _x = i*iR[1] + iR[2];
+        double _y = i*iR[4] + iR[5];
+        double _w = i*iR[7] + iR[8];
+
+        for( int j=0; j<width; j++, _x+=iR[0], _y+=iR[3], _w+=iR[6] )
+        {
+            const double w = 1.0/_w;
+            const double x = _x*w, y = _y*w;
+            const double x2 = x*x, y2 = y*y;
+            const double r2 = x2 + y2, _2xy = 2*x*y;
+            const double kr = 1 + ((cam.k3*r2 + cam.k2)*r2 + cam.k1)*r2;
+            mx[j] = static_cast<float>(cam.fx*(x*kr + cam.p1*_2xy + cam.p2*(r2 + 2*x2)) + cam.cx);
+            my[j] = static_cast<float>(cam.fy*(y*kr + cam.p1*(r2 + 2*y2) + cam.p2*_2xy) + cam.cy);
+        }
+    }
+}
+
+}
+
+}
@@ -0,0 +1,359 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "thermalbiasmodel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+namespace sl_oc {
+
+namespace sensors {
+
+static const double RLS_INIT_COV = 100.0;    //!< Initial covariance of the coefficients, also used as covariance bound
+
+namespace {
+
+bool parseValues(const std::string& str, std::vector<double>& values, size_t count)
+{
+    std::istringstream ss(str);
+    values.resize(count);
+    for( size_t i=0; i<count; i++ )
+    {
+        if( !(ss >> values[i]) )
+            return false;
+    }
+    return true;
+}
+
+void writeValues(std::ofstream& file, const std::string& key, const std::vector<double>& values)
+{
+    file << key << " =";
+    for( double v : values )
+        file << " " << v;
+    file << std::endl;
+}
+
+}
+
+void ThermalBiasModel::Rls::init( int size )
+{
+    n = size;
+    P.assign(n*n, 0.0);
+    for( int i=0; i<n; i++ )
+        P[i*n+i] = RLS_INIT_COV;
+
+    for( int o=0; o<3; o++ )
+        theta[o].assign(n, 0.0);
+}
+
+void ThermalBiasModel::Rls::update( const double* phi, const double* y, double lambda )
+{
+    if( n==0 )
+        return;
+
+    // ----> Gain
+    std::vector<double> Pphi(n, 0.0);
+    double denom = lambda;
+    for( int r=0; r<n; r++ )
+    {
+        for( int c=0; c<n; c++ )
+            Pphi[r] += P[r*n+c]*phi[c];
+        denom += phi[r]*Pphi[r];
+    }
+    // <---- Gain
+
+    // ----> Coefficients
+    for( int o=0; o<3; o++ )
+    {
+        double err = y[o];
+        for( int k=0; k<n; k++ )
+            err -= phi[k]*theta[o][k];
+
+        for( int k=0; k<n; k++ )
+            theta[o][k] += Pphi[k]/denom*err;
+    }
+    // <---- Coefficients
+
+    // ----> Covariance
+    double trace = 0.0;
+    for( int r=0; r<n; r++ )
+    {
+        for( int c=0; c<n; c++ )
+            P[r*n+c] -= Pphi[r]*Pphi[c]/denom;
+        trace += P[r*n+r];
+    }
+
+    // The forgetting factor is not applied if the covariance is already large, to avoid the windup of the
+    // directions not excited while the temperature is stable
+    if( trace/lambda < n*RLS_INIT_COV )
+    {
+        for( double& p : P )
+            p /= lambda;
+    }
+    // <---- Covariance
+}
+
+ThermalBiasModel::ThermalBiasModel( const ThermalBiasParams& params )
+{
+    mParams = params;
+
+    if( mParams.order < 0 )
+        mParams.order = 0;
+    if( mParams.order > data::ImuThermalCoeffs::MAX_ORDER )
+        mParams.order = data::ImuThermalCoeffs::MAX_ORDER;
+    if( mParams.block_size < 2 )
+        mParams.block_size = 2;
+    if( mParams.forgetting <= 0.0 || mParams.forgetting > 1.0 )
+        mParams.forgetting = 1.0;
+
+    reset();
+}
+
+void ThermalBiasModel::reset()
+{
+    mGyroRls.init(mParams.order+1);
+    mAccRls.init(mParams.order);
+
+    mBlocks = 0;
+    mTempMin = 0.0f;
+    mTempMax = 0.0f;
+
+    mBlockCount = 0;
+    mSegValid = false;
+}
+
+bool ThermalBiasModel::addSample( float temp, float gX, float gY, float gZ, float aX, float aY, float aZ, bool still )
+{
+    if( !still )
+    {
+        // Still period ended: the accelerometer reference is no more valid
+        mBlockCount = 0;
+        mSegValid = false;
+        return false;
+    }
+
+    if( mBlockCount==0 )
+    {
+        mSumT = 0.0;
+        for( int i=0; i<6; i++ )
+            mSum[i] = mSumSq[i] = 0.0;
+    }
+
+    const float values[6] = {gX, gY, gZ, aX, aY, aZ};
+    mSumT += temp;
+    for( int i=0; i<6; i++ )
+    {
+        mSum[i] += values[i];
+        mSumSq[i] += static_cast<double>(values[i])*values[i];
+    }
+    mBlockCount++;
+
+    if( mBlockCount < mParams.block_size )
+        return false;
+
+    mBlockCount = 0;
+
+    // ----> Block validation
+    const double n = mParams.block_size;
+    double mean[6];
+    for( int i=0; i<6; i++ )
+    {
+        mean[i] = mSum[i]/n;
+        double var = mSumSq[i]/n - mean[i]*mean[i];
+        double std_max = i<3?mParams.gyro_std_max:mParams.acc_std_max;
+        if( var > std_max*std_max )
+        {
+            // Small motions not detected by the IMU hardware
+            mSegValid = false;
+            return false;
+        }
+    }
+    // <---- Block validation
+
+    float block_temp = static_cast<float>(mSumT/n);
+    double t = (block_temp-mParams.ref_temp)/data::ImuThermalCoeffs().temp_scale;
+
+    // ----> Gyroscope: the still gyroscope measures its bias
+    double phi[data::ImuThermalCoeffs::MAX_ORDER+1];
+    double tk = 1.0;
+    for( int k=0; k<=mParams.order; k++ )
+    {
+        phi[k] = tk;
+        tk *= t;
+    }
+    mGyroRls.update(phi, mean, mParams.forgetting);
+    // <---- Gyroscope: the still gyroscope measures its bias
+
+    // ----> Accelerometer: variation respect to the first block of the still period
+    if( mSegValid )
+    {
+        double y[3];
+        for( int a=0; a<3; a++ )
+            y[a] = mean[3+a]-mSegAcc[a];
+
+        double tk_ref = mSegT;
+        tk = t;
+        for( int k=0; k<mParams.order; k++ )
+        {
+            phi[k] = tk - tk_ref;
+            tk *= t;
+            tk_ref *= mSegT;
+        }
+        mAccRls.update(phi, y, mParams.forgetting);
+    }
+    else
+    {
+        mSegValid = true;
+        mSegT = t;
+        for( int a=0; a<3; a++ )
+            mSegAcc[a] = mean[3+a];
+    }
+    // <---- Accelerometer: variation respect to the first block of the still period
+
+    // ----> Validity range
+    if( mBlocks==0 )
+    {
+        mTempMin = block_temp;
+        mTempMax = block_temp;
+    }
+    else
+    {
+        mTempMin = std::min(mTempMin, block_temp);
+        mTempMax = std::max(mTempMax, block_temp);
+    }
+    mBlocks++;
+    // <---- Validity range
+
+    return true;
+}
+
+data::ImuThermalCoeffs ThermalBiasModel::getCoefficients() const
+{
+    data::ImuThermalCoeffs coeffs;
+    coeffs.enabled = mBlocks >= static_cast<uint64_t>(mParams.min_blocks);
+    coeffs.order = mParams.order;
+    coeffs.ref_temp = mParams.ref_temp;
+    if( mBlocks>0 )
+    {
+        coeffs.temp_min = mTempMin;
+        coeffs.temp_max = mTempMax;
+    }
+
+    for( int a=0; a<3; a++ )
+    {
+        for( int k=0; k<=mParams.order; k++ )
+            coeffs.gyro[a][k] = static_cast<float>(mGyroRls.theta[a][k]);
+
+        coeffs.acc[a][0] = 0.0f;
+        for( int k=1; k<=mParams.order; k++ )
+            coeffs.acc[a][k] = static_cast<float>(mAccRls.theta[a][k-1]);
+    }
+
+    return coeffs;
+}
+
+bool ThermalBiasModel::saveToFile( const std::string& filename ) const
+{
+    std::ofstream file(filename);
+    if( !file.is_open() )
+        return false;
+
+    const char* axes[3] = {"x","y","z"};
+
+    file << std::setprecision(12);
+    file << "[thermal_bias]" << std::endl;
+    file << "order = " << mParams.order << std::endl;
+    file << "ref_temp = " << mParams.ref_temp << std::endl;
+    file << "blocks = " << mBlocks << std::endl;
+    file << "temp_range = " << mTempMin << " " << mTempMax << std::endl;
+    for( int a=0; a<3; a++ )
+        writeValues(file, std::string("gyro_")+axes[a], mGyroRls.theta[a]);
+    for( int a=0; a<3; a++ )
+        writeValues(file, std::string("acc_")+axes[a], mAccRls.theta[a]);
+    writeValues(file, "gyro_P", mGyroRls.P);
+    writeValues(file, "acc_P", mAccRls.P);
+
+    return file.good();
+}
+
+bool ThermalBiasModel::loadFromFile( const std::string& filename )
+{
+    std::ifstream file(filename);
+    if( !file.is_open() )
+        return false;
+
+    ThermalBiasModel loaded(mParams);
+    const size_t ng = loaded.mGyroRls.n;
+    const size_t na = loaded.mAccRls.n;
+    bool order_ok = false;
+
+    std::string line;
+    while( std::getline(file, line) )
+    {
+        size_t eq = line.find('=');
+        if( eq==std::string::npos || eq==0 )
+            continue;
+
+        std::string key = line.substr(0, line.find_last_not_of(" \t", eq-1)+1);
+        std::string value = line.substr(eq+1);
+        std::vector<double> vals;
+        bool ok = true;
+
+        if( key=="order" )
+            ok = order_ok = parseValues(value, vals, 1) && static_cast<int>(vals[0])==mParams.order;
+        else if( key=="ref_temp" )
+            ok = parseValues(value, vals, 1) && std::fabs(vals[0]-mParams.ref_temp)<1e-3;
+        else if( key=="blocks" )
+        {
+            ok = parseValues(value, vals, 1);
+            if( ok ) loaded.mBlocks = static_cast<uint64_t>(vals[0]);
+        }
+        else if( key=="temp_range" )
+        {
+            ok = parseValues(value, vals, 2);
+            if( ok ) { loaded.mTempMin = static_cast<float>(vals[0]); loaded.mTempMax = static_cast<float>(vals[1]); }
+        }
+        else if( key.size()==6 && key.compare(0,5,"gyro_")==0 && key[5]>='x' && key[5]<='z' )
+            ok = parseValues(value, loaded.mGyroRls.theta[key[5]-'x'], ng);
+        else if( key.size()==5 && key.compare(0,4,"acc_")==0 && key[4]>='x' && key[4]<='z' )
+            ok = parseValues(value, loaded.mAccRls.theta[key[4]-'x'], na);
+        else if( key=="gyro_P" )
+            ok = parseValues(value, loaded.mGyroRls.P, ng*ng);
+        else if( key=="acc_P" )
+            ok = parseValues(value, loaded.mAccRls.P, na*na);
+
+        if( !ok )
+            return false;
+    }
+
+    if( !order_ok )
+        return false;
+
+    *this = loaded;
+    return true;
+}
+
+}
+
+}
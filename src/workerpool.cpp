@@ -0,0 +1,175 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include "workerpool.hpp"
+
+namespace sl_oc {
+
+namespace video {
+
+WorkerPool::WorkerPool( size_t thread_count )
+{
+    if( thread_count==0 )
+        thread_count = std::thread::hardware_concurrency();
+    if( thread_count==0 )
+        thread_count = 1;
+
+    mRanges = std::vector<TaskRange>(thread_count);
+
+    for( size_t i=1; i<thread_count; i++ )
+        mThreads.emplace_back(&WorkerPool::workerFunc, this, i);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mStartCv.notify_all();
+
+    for( std::thread& t : mThreads )
+        t.join();
+}
+
+void WorkerPool::parallelFor( size_t count, const std::function<void(size_t)>& task )
+{
+    if( count==0 )
+        return;
+
+    if( mThreads.empty() || count==1 )
+    {
+        for( size_t i=0; i<count; i++ )
+            task(i);
+        return;
+    }
+
+    const std::lock_guard<std::mutex> job_lock(mJobMutex);
+
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        mTask = &task;
+
+        const size_t slots = mRanges.size();
+        for( size_t s=0; s<slots; s++ )
+        {
+            const uint64_t begin = count*s/slots;
+            const uint64_t end = count*(s+1)/slots;
+            mRanges[s].range.store(begin | (end<<32), std::memory_order_relaxed);
+        }
+
+        mBusy = mThreads.size();
+        mGeneration++;
+    }
+    mStartCv.notify_all();
+
+    runTasks(0);
+
+    // The job state must not change until all the workers left it
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDoneCv.wait(lock, [this]{return mBusy==0;});
+    mTask = nullptr;
+}
+
+void WorkerPool::runTasks( size_t slot )
+{
+    size_t task;
+    while( popTask(slot, task) || stealTasks(slot, task) )
+        (*mTask)(task);
+}
+
+bool WorkerPool::popTask( size_t slot, size_t& task )
+{
+    std::atomic<uint64_t>& range = mRanges[slot].range;
+    uint64_t cur = range.load();
+
+    while( 1 )
+    {
+        const uint64_t begin = cur & 0xFFFFFFFF;
+        const uint64_t end = cur >> 32;
+        if( begin>=end )
+            return false;
+
+        if( range.compare_exchange_weak(cur, (begin+1) | (end<<32)) )
+        {
+            task = static_cast<size_t>(begin);
+            return true;
+        }
+    }
+}
+
+bool WorkerPool::stealTasks( size_t slot, size_t& task )
+{
+    const size_t slots = mRanges.size();
+
+    for( size_t i=1; i<slots; i++ )
+    {
+        std::atomic<uint64_t>& victim = mRanges[(slot+i)%slots].range;
+        uint64_t cur = victim.load();
+
+        while( 1 )
+        {
+            const uint64_t begin = cur & 0xFFFFFFFF;
+            const uint64_t end = cur >> 32;
+            if( begin>=end )
+                break;
+
+            // Take the second half, the victim keeps the tasks close to the ones it is processing
+            const uint64_t mid = begin + (end-begin)/2;
+            if( victim.compare_exchange_weak(cur, begin | (mid<<32)) )
+            {
+                // The own range is empty, only this thread can make it not empty
+                task = static_cast<size_t>(mid);
+                mRanges[slot].range.store((mid+1) | (end<<32));
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void WorkerPool::workerFunc( size_t slot )
+{
+    uint64_t generation = 0;
+
+    while( 1 )
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mStartCv.wait(lock, [this,generation]{return mStop || mGeneration!=generation;});
+            if( mStop )
+                return;
+            generation = mGeneration;
+        }
+
+        runTasks(slot);
+
+        {
+            const std::lock_guard<std::mutex> lock(mMutex);
+            mBusy--;
+        }
+        mDoneCv.notify_one();
+    }
+}
+
+}
+
+}
@@ -0,0 +1,124 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// The fake MCU must generate a deterministic packet sequence and drive SensorCapture as a real camera
+
+#include "sensorcapture.hpp"
+#include "fakemcu.hpp"
+#include "testutils.hpp"
+
+#include <cstring>
+
+using namespace sl_oc::sensors;
+
+static void testDeterministicSequence()
+{
+    FakeMcuParams params;
+    params.drop_prob = 0.02;
+    params.drop_burst = 2;
+    params.jitter_usec = 100.0;
+    params.packet_count = 2000;
+
+    FakeMcuTransport fake1(params), fake2(params);
+    usb::RawData p1, p2;
+    uint64_t count = 0, first_ts = 0, last_ts = 0;
+    for(;;)
+    {
+        const uint64_t t1 = fake1.generatePacket(p1);
+        const uint64_t t2 = fake2.generatePacket(p2);
+        TEST_CHECK_EQUAL(t1, t2);
+        if( t1==UINT64_MAX )
+            break;
+
+        TEST_CHECK(std::memcmp(&p1, &p2, sizeof(usb::RawData))==0);
+        if( count++==0 )
+            first_ts = p1.timestamp;
+        last_ts = p1.timestamp;
+    }
+
+    // The first and the last packets are never lost
+    const uint64_t period = static_cast<uint64_t>(std::llround(1e9/params.rate/TS_SCALE));
+    TEST_CHECK(fake1.getDroppedCount()>0);
+    TEST_CHECK_EQUAL(count + fake1.getDroppedCount(), params.packet_count);
+    TEST_CHECK_NEAR(static_cast<double>(last_ts-first_ts), static_cast<double>((params.packet_count-1)*period), 1.0);
+}
+
+static void testInterrupts()
+{
+    FakeMcuParams params;
+    FakeMcuInterrupt irq;
+    irq.start = 10;
+    irq.length = 5;
+    params.interrupts.push_back(irq);
+    irq.free_fall = true;
+    irq.start = 20;
+    irq.length = 0;
+    params.interrupts.push_back(irq);
+
+    FakeMcuTransport fake(params);
+    usb::RawData p;
+    for( uint64_t idx=0; idx<30; idx++ )
+    {
+        fake.generatePacket(p);
+        TEST_CHECK_EQUAL(p.camera_moving, (idx>=10 && idx<15) ? 1 : 0);
+        TEST_CHECK_EQUAL(p.camera_moving_count, idx>=10 ? 1u : 0u);
+        TEST_CHECK_EQUAL(p.camera_falling, 0);
+        TEST_CHECK_EQUAL(p.camera_falling_count, idx>=20 ? 1u : 0u);
+    }
+}
+
+static void testSensorCapture()
+{
+    FakeMcuParams params;
+    params.realtime = false;
+    params.packet_count = 400;
+    params.acc[0] = 1.0f;
+    params.acc[1] = -9.5f;
+    params.acc[2] = 2.0f;
+    params.acc_noise = 0.0f;
+    params.gyro_noise = 0.0f;
+
+    FakeMcuTransport* fake = new FakeMcuTransport(params);
+    SensorCapture sens{std::unique_ptr<HidTransport>(fake)};
+
+    std::vector<int> devs = sens.getDeviceList();
+    TEST_CHECK_EQUAL(devs.size(), 1u);
+    if( devs.empty() )
+        return;
+    TEST_CHECK_EQUAL(devs[0], params.serial_number);
+    TEST_CHECK(sens.initializeSensors(devs[0]));
+
+    TEST_CHECK(sl_oc::test::waitFor([&]{return sens.getPacketStats().received==params.packet_count;}));
+
+    const data::Imu& imu = sens.getLastIMUData(0);
+    TEST_CHECK(imu.valid!=data::Imu::NOT_PRESENT);
+    TEST_CHECK_NEAR(std::sqrt(imu.aX*imu.aX + imu.aY*imu.aY + imu.aZ*imu.aZ),
+                    std::sqrt(1.0f + 9.5f*9.5f + 4.0f), 0.01f);
+    TEST_CHECK_EQUAL(fake->getDeliveredCount(), params.packet_count);
+}
+
+int main()
+{
+    testDeterministicSequence();
+    testInterrupts();
+    testSensorCapture();
+
+    return sl_oc::test::result();
+}
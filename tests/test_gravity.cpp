@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// The gravity estimator must follow the direction of the measured acceleration and its history must only answer
+// for the timestamps covered since it was last enabled
+
+#include "sensorcapture.hpp"
+#include "fakemcu.hpp"
+#include "testutils.hpp"
+
+using namespace sl_oc::sensors;
+
+int main()
+{
+    FakeMcuParams params;
+    params.realtime = false;
+    params.packet_count = 2000;
+    params.acc[0] = 1.0f;
+    params.acc[1] = -9.5f;
+    params.acc[2] = 2.0f;
+    params.acc_noise = 0.0f;
+
+    FakeMcuTransport* fake = new FakeMcuTransport(params);
+    SensorCapture sens{std::unique_ptr<HidTransport>(fake)};
+
+    data::Gravity gravity;
+    TEST_CHECK(!sens.getLastGravityData().valid);
+    TEST_CHECK(!sens.getGravityAt(0, gravity));
+
+    sens.enableGravityEstimator(true);
+    TEST_CHECK(sens.initializeSensors(params.serial_number));
+    TEST_CHECK(sl_oc::test::waitFor([&]{return sens.getPacketStats().received==params.packet_count;}));
+
+    // The gravity direction points down, opposite to the measured acceleration
+    const float norm = std::sqrt(params.acc[0]*params.acc[0] + params.acc[1]*params.acc[1] + params.acc[2]*params.acc[2]);
+    const data::Gravity last = sens.getLastGravityData();
+    TEST_CHECK(last.valid);
+    TEST_CHECK_NEAR(last.dX, -params.acc[0]/norm, 1e-3f);
+    TEST_CHECK_NEAR(last.dY, -params.acc[1]/norm, 1e-3f);
+    TEST_CHECK_NEAR(last.dZ, -params.acc[2]/norm, 1e-3f);
+    TEST_CHECK_NEAR(last.norm, norm, 0.01f);
+
+    const data::Imu& imu = sens.getLastIMUData(0);
+    TEST_CHECK_EQUAL(last.timestamp, imu.timestamp);
+
+    // Timestamp queries interpolate the history
+    const uint64_t ts = last.timestamp - 1000000; // 1 msec before the last sample
+    TEST_CHECK(sens.getGravityAt(ts, gravity));
+    TEST_CHECK_EQUAL(gravity.timestamp, ts);
+    TEST_CHECK_NEAR(gravity.dX, last.dX, 1e-3f);
+    TEST_CHECK_NEAR(gravity.dY, last.dY, 1e-3f);
+    TEST_CHECK_NEAR(gravity.dZ, last.dZ, 1e-3f);
+    TEST_CHECK(!sens.getGravityAt(last.timestamp + 1000000, gravity));
+
+    // Enabling the estimator again clears the history
+    sens.enableGravityEstimator(true);
+    TEST_CHECK(!sens.getLastGravityData().valid);
+    TEST_CHECK(!sens.getGravityAt(ts, gravity));
+
+    sens.enableGravityEstimator(false);
+    TEST_CHECK(!sens.getLastGravityData().valid);
+    TEST_CHECK(!sens.getGravityAt(ts, gravity));
+
+    return sl_oc::test::result();
+}
@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// The lock-free history must never return a torn element, nor an element pushed before the last clear
+
+#include "historybuffer.hpp"
+#include "testutils.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+struct Element
+{
+    uint64_t timestamp;
+    uint64_t generation;    // Number of clears before the push
+    uint64_t check[6];      // Copies of the timestamp, to detect the torn reads
+};
+
+static Element makeElement( uint64_t timestamp, uint64_t generation )
+{
+    Element val;
+    val.timestamp = timestamp;
+    val.generation = generation;
+    for( uint64_t& c : val.check )
+        c = timestamp;
+    return val;
+}
+
+static bool isTorn( const Element& val )
+{
+    for( uint64_t c : val.check )
+        if( c!=val.timestamp )
+            return true;
+    return false;
+}
+
+static void testClear()
+{
+    sl_oc::HistoryBuffer<Element,32> history;
+    Element val, before, after;
+    TEST_CHECK(!history.getLast(val));
+
+    for( uint64_t i=1; i<=100; i++ )
+        history.push(makeElement(i*10, 0));
+    TEST_CHECK_EQUAL(history.getPushCount(), 100);
+    TEST_CHECK(history.getLast(val));
+    TEST_CHECK_EQUAL(val.timestamp, 1000);
+    TEST_CHECK(history.getBracket(995, before, after));
+    TEST_CHECK_EQUAL(before.timestamp, 990);
+    TEST_CHECK_EQUAL(after.timestamp, 1000);
+
+    history.clear();
+    TEST_CHECK_EQUAL(history.getPushCount(), 0);
+    TEST_CHECK(!history.getLast(val));
+    TEST_CHECK(!history.getBracket(995, before, after));
+
+    // Only the new elements are searched, even if the old ones are still in the slots
+    history.push(makeElement(2000, 1));
+    history.push(makeElement(2010, 1));
+    TEST_CHECK_EQUAL(history.getPushCount(), 2);
+    TEST_CHECK(!history.getBracket(995, before, after));
+    TEST_CHECK(history.getBracket(2005, before, after));
+    TEST_CHECK_EQUAL(before.timestamp, 2000);
+    TEST_CHECK_EQUAL(after.timestamp, 2010);
+}
+
+static void testConcurrentReads()
+{
+    sl_oc::HistoryBuffer<Element,8> history;
+    std::atomic<uint64_t> cleared{0};   // Number of completed clears
+    std::atomic<bool> stop{false};
+    std::atomic<int> torn{0}, stale{0}, mixed{0}, misplaced{0};
+    std::atomic<uint64_t> reads{0};
+
+    std::vector<std::thread> readers;
+    for( int r=0; r<3; r++ )
+    {
+        readers.emplace_back([&]{
+            Element val, before, after;
+            while( !stop )
+            {
+                const uint64_t generation = cleared.load();
+                if( history.getLast(val) )
+                {
+                    torn += isTorn(val);
+                    stale += val.generation<generation;
+                    reads++;
+                }
+
+                const uint64_t ts = val.timestamp>3?val.timestamp-3:0;
+                if( history.getBracket(ts, before, after) )
+                {
+                    torn += isTorn(before) + isTorn(after);
+                    stale += (before.generation<generation) + (after.generation<generation);
+                    mixed += before.generation!=after.generation;
+                    misplaced += before.timestamp>ts || after.timestamp<ts;
+                }
+            }
+        });
+    }
+
+    // Keep writing until the readers have run concurrently long enough
+    uint64_t ts = 0;
+    history.push(makeElement(++ts, 0));
+    TEST_CHECK(sl_oc::test::waitFor([&]{return reads.load()>0;}));
+    for( uint64_t generation=0; generation<1000 || (reads.load()<1000000 && generation<10000000); generation++ )
+    {
+        for( int i=0; i<7; i++ )
+            history.push(makeElement(++ts, generation));
+
+        history.clear();
+        cleared = generation+1;
+    }
+
+    stop = true;
+    for( std::thread& t : readers )
+        t.join();
+
+    TEST_CHECK(reads.load()>0);
+    TEST_CHECK_EQUAL(torn.load(), 0);
+    TEST_CHECK_EQUAL(stale.load(), 0);
+    TEST_CHECK_EQUAL(mixed.load(), 0);
+    TEST_CHECK_EQUAL(misplaced.load(), 0);
+}
+
+int main()
+{
+    testClear();
+    testConcurrentReads();
+
+    return sl_oc::test::result();
+}
@@ -0,0 +1,212 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// The binary IMU log must be read back exactly, in little endian byte order, with random access and with the index
+// rebuilt when the file has not been closed
+
+#include "imulog.hpp"
+#include "testutils.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace sl_oc::sensors;
+
+static const char* LOG_FILE = "test_imu_log.bin";
+static const char* TRUNC_FILE = "test_imu_log_trunc.bin";
+static const uint64_t SAMPLE_COUNT = 5000;
+static const uint32_t KEYFRAME_INTERVAL = 100;
+
+static uint64_t sampleTs( uint64_t i )
+{
+    // 400 Hz with a few microseconds of jitter and a 1 second pause
+    return 1000000000ULL + i*2500000ULL + (i*7919%13)*1000ULL + (i>=3000?1000000000ULL:0);
+}
+
+static float sampleValue( uint64_t i, int ch )
+{
+    return std::sin(0.01f*i + ch)*(ch<3?20.0f:200.0f);
+}
+
+static std::vector<uint8_t> readFile( const char* filename )
+{
+    std::ifstream file(filename, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static uint64_t getLe( const std::vector<uint8_t>& bytes, size_t offset, size_t size )
+{
+    uint64_t val = 0;
+    for( size_t i=0; i<size; i++ )
+        val |= static_cast<uint64_t>(bytes[offset+i])<<(8*i);
+    return val;
+}
+
+static void writeLog()
+{
+    ImuLogParams params;
+    params.keyframe_interval = KEYFRAME_INTERVAL;
+    params.serial = 12345;
+
+    ImuLogWriter writer;
+    TEST_CHECK(writer.open(LOG_FILE, params));
+    for( uint64_t i=0; i<SAMPLE_COUNT; i++ )
+    {
+        TEST_CHECK(writer.write(sampleTs(i), sampleValue(i,0), sampleValue(i,1), sampleValue(i,2),
+                                sampleValue(i,3), sampleValue(i,4), sampleValue(i,5), 35.0f, i%50==0, i==3000));
+    }
+    TEST_CHECK(!writer.write(sampleTs(SAMPLE_COUNT-1), 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 35.0f));
+    TEST_CHECK_EQUAL(writer.getSampleCount(), SAMPLE_COUNT);
+    TEST_CHECK(writer.close());
+}
+
+/*!
+ * \brief Check the decoded samples against the written ones
+ */
+static void checkSamples( const data::ImuBatch& batch, uint64_t first )
+{
+    int errors = 0;
+    for( size_t k=0; k<batch.size(); k++ )
+    {
+        const uint64_t i = first+k;
+        const float values[6] = {batch.aX[k], batch.aY[k], batch.aZ[k], batch.gX[k], batch.gY[k], batch.gZ[k]};
+        bool ok = batch.timestamp[k]==sampleTs(i) && batch.sync[k]==(i%50==0) && batch.gap[k]==(i==3000) &&
+                std::fabs(batch.temp[k]-35.0f)<=TEMP_SCALE;
+        for( int ch=0; ch<6; ch++ )
+            ok = ok && std::fabs(values[ch]-sampleValue(i,ch))<=0.5f*(ch<3?ACC_SCALE:GYRO_SCALE)*1.01f;
+        errors += ok?0:1;
+    }
+    TEST_CHECK_EQUAL(errors, 0);
+}
+
+static void testByteOrder()
+{
+    // Header and keyframe timestamps are little endian on any host
+    const std::vector<uint8_t> bytes = readFile(LOG_FILE);
+    TEST_CHECK(bytes.size()>40);
+    TEST_CHECK_EQUAL(getLe(bytes, 8, 4), 1u);                   // version
+    TEST_CHECK_EQUAL(getLe(bytes, 12, 4), KEYFRAME_INTERVAL);   // keyframe interval
+    TEST_CHECK_EQUAL(getLe(bytes, 28, 4), 12345u);              // serial number
+    TEST_CHECK_EQUAL(bytes[32], 0x03);                          // first record: keyframe and sync flags...
+    TEST_CHECK_EQUAL(getLe(bytes, 33, 8), sampleTs(0));         // ...and absolute timestamp
+
+    // The index ends with the sample count, the index offset and the end magic
+    TEST_CHECK_EQUAL(getLe(bytes, bytes.size()-24, 8), SAMPLE_COUNT);
+    const uint64_t index_offset = getLe(bytes, bytes.size()-16, 8);
+    TEST_CHECK_EQUAL(bytes[index_offset], 0xFF);
+    TEST_CHECK_EQUAL(getLe(bytes, index_offset+1, 4), SAMPLE_COUNT/KEYFRAME_INTERVAL);
+}
+
+static void testRoundTrip()
+{
+    ImuLogReader reader;
+    TEST_CHECK(reader.open(LOG_FILE));
+    TEST_CHECK_EQUAL(reader.getSampleCount(), SAMPLE_COUNT);
+    TEST_CHECK_EQUAL(reader.getParams().keyframe_interval, KEYFRAME_INTERVAL);
+    TEST_CHECK_EQUAL(reader.getParams().serial, 12345);
+    TEST_CHECK_EQUAL(reader.getParams().acc_scale, ACC_SCALE);
+
+    // Read in batches not aligned with the keyframes
+    data::ImuBatch batch;
+    uint64_t total = 0;
+    size_t count;
+    while( (count = reader.read(batch, 333))>0 )
+    {
+        checkSamples(batch, total);
+        total += count;
+    }
+    TEST_CHECK_EQUAL(total, SAMPLE_COUNT);
+}
+
+static void testSeek()
+{
+    ImuLogReader reader;
+    TEST_CHECK(reader.open(LOG_FILE));
+    data::ImuBatch batch;
+
+    // The read restarts from the last keyframe not newer than the timestamp
+    TEST_CHECK(reader.seek(sampleTs(1234)));
+    TEST_CHECK_EQUAL(reader.read(batch, 100), 100u);
+    TEST_CHECK_EQUAL(batch.timestamp[0], sampleTs(1200));
+    checkSamples(batch, 1200);
+
+    // Across the timestamp jump
+    TEST_CHECK(reader.seek(sampleTs(3000)-1));
+    TEST_CHECK_EQUAL(reader.read(batch, 10), 10u);
+    TEST_CHECK_EQUAL(batch.timestamp[0], sampleTs(2900));
+
+    TEST_CHECK(reader.seek(0));
+    TEST_CHECK_EQUAL(reader.read(batch, 10), 10u);
+    checkSamples(batch, 0);
+
+    TEST_CHECK(reader.seek(sampleTs(SAMPLE_COUNT)+1000000000ULL));
+    TEST_CHECK_EQUAL(reader.read(batch), static_cast<size_t>(KEYFRAME_INTERVAL));
+    checkSamples(batch, SAMPLE_COUNT-KEYFRAME_INTERVAL);
+    TEST_CHECK_EQUAL(reader.read(batch), 0u);
+}
+
+static void testIndexRebuild()
+{
+    // A file not closed: no index and the last record incomplete
+    std::vector<uint8_t> bytes = readFile(LOG_FILE);
+    const uint64_t index_offset = getLe(bytes, bytes.size()-16, 8);
+    bytes.resize(index_offset-5);
+    {
+        std::ofstream file(TRUNC_FILE, std::ios::binary|std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    ImuLogReader reader;
+    TEST_CHECK(reader.open(TRUNC_FILE));
+    TEST_CHECK_EQUAL(reader.getSampleCount(), SAMPLE_COUNT-1);
+
+    data::ImuBatch batch;
+    TEST_CHECK(reader.seek(sampleTs(2550)));
+    TEST_CHECK_EQUAL(reader.read(batch, 50), 50u);
+    checkSamples(batch, 2500);
+
+    TEST_CHECK(reader.seek(sampleTs(SAMPLE_COUNT-1)));
+    TEST_CHECK_EQUAL(reader.read(batch), static_cast<size_t>(KEYFRAME_INTERVAL-1));
+    checkSamples(batch, SAMPLE_COUNT-KEYFRAME_INTERVAL);
+
+    // Not a log
+    bytes[0] = 'X';
+    {
+        std::ofstream file(TRUNC_FILE, std::ios::binary|std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+    TEST_CHECK(!reader.open(TRUNC_FILE));
+}
+
+int main()
+{
+    writeLog();
+    testByteOrder();
+    testRoundTrip();
+    testSeek();
+    testIndexRebuild();
+
+    std::remove(LOG_FILE);
+    std::remove(TRUNC_FILE);
+
+    return sl_oc::test::result();
+}
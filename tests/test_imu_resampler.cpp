@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// The resampler must reject the input frequencies above the output Nyquist frequency and restart its filter, flagging
+// the output, on any missing input sample
+
+#include "imuresampler.hpp"
+#include "testutils.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace sl_oc::sensors;
+
+static const uint64_t IN_PERIOD = 2500000; // 400 Hz input
+
+/*!
+ * \brief Feed 10 seconds of a sine on aX and get the peak amplitude of the resampled output
+ */
+static float sinePeak( const ImuResamplerParams& params, double freq )
+{
+    ImuResampler resampler(params);
+    sl_oc::sensors::data::ImuBatch out;
+    float peak = 0.0f;
+    size_t count = 0;
+    for( uint64_t i=0; i<4000; i++ )
+    {
+        const double t = i*IN_PERIOD*1e-9;
+        const float aX = static_cast<float>(std::sin(2.0*3.14159265358979*freq*t));
+        resampler.addSample(1000000000ULL+i*IN_PERIOD, aX, 0.0f, 9.81f, 0.0f, 0.0f, 0.0f, 30.0f, false, out);
+        for( size_t k=0; k<out.size(); k++ )
+            peak = std::max(peak, std::fabs(out.aX[k]));
+        count += out.size();
+    }
+
+    TEST_CHECK(count > 0);
+    return peak;
+}
+
+static void testAntiAliasing()
+{
+    // Default filter at 400 -> 100 Hz: the stopband starts at 50 Hz
+    ImuResamplerParams params;
+    params.rate = 100;
+    TEST_CHECK_NEAR(sinePeak(params, 5.0), 1.0, 0.01);
+    TEST_CHECK(sinePeak(params, 52.0) < 1e-3f);
+    TEST_CHECK(sinePeak(params, 60.0) < 1e-3f);
+    TEST_CHECK(sinePeak(params, 150.0) < 1e-3f);
+
+    // Too few taps for 400 -> 50 Hz: the filter is made longer
+    params.rate = 50;
+    params.taps = 15;
+    TEST_CHECK_NEAR(sinePeak(params, 2.0), 1.0, 0.01);
+    TEST_CHECK(sinePeak(params, 26.0) < 1e-3f);
+}
+
+static void testGap()
+{
+    ImuResamplerParams params;
+    params.rate = 100;
+    ImuResampler resampler(params);
+    sl_oc::sensors::data::ImuBatch out;
+
+    uint64_t ts = 1000000000ULL;
+    size_t count = 0, gaps = 0;
+    for( int i=0; i<400; i++, ts+=IN_PERIOD )
+    {
+        resampler.addSample(ts, 0.0f, 0.0f, 9.81f, 0.0f, 0.0f, 0.0f, 30.0f, false, out);
+        count += out.size();
+        for( size_t k=0; k<out.size(); k++ )
+            gaps += out.gap[k];
+    }
+    TEST_CHECK(count > 0);
+    TEST_CHECK_EQUAL(gaps, 0);
+
+    // A single missing sample, far below the time gap limit: the filter restarts and the output stops until the
+    // delay line is filled again
+    ts += IN_PERIOD;
+    resampler.addSample(ts, 0.0f, 0.0f, 9.81f, 0.0f, 0.0f, 0.0f, 30.0f, true, out);
+    TEST_CHECK_EQUAL(out.size(), 0);
+
+    int silent = 0;
+    for( ; silent<1000; silent++ )
+    {
+        ts += IN_PERIOD;
+        resampler.addSample(ts, 0.0f, 0.0f, 9.81f, 0.0f, 0.0f, 0.0f, 30.0f, false, out);
+        if( out.size()>0 )
+            break;
+    }
+    TEST_CHECK(silent >= params.taps-1);
+    TEST_CHECK(out.size() > 0);
+    TEST_CHECK_EQUAL(out.gap[0], 1);
+
+    // The flag is only set on the first output sample after the restart
+    gaps = 0;
+    for( size_t k=1; k<out.size(); k++ )
+        gaps += out.gap[k];
+    for( int i=0; i<100; i++ )
+    {
+        ts += IN_PERIOD;
+        resampler.addSample(ts, 0.0f, 0.0f, 9.81f, 0.0f, 0.0f, 0.0f, 30.0f, false, out);
+        for( size_t k=0; k<out.size(); k++ )
+            gaps += out.gap[k];
+    }
+    TEST_CHECK_EQUAL(gaps, 0);
+}
+
+int main()
+{
+    testAntiAliasing();
+    testGap();
+
+    return sl_oc::test::result();
+}
@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// The transport latency reference must follow the drift of the MCU clock, so that the latency measured without
+// video synchronization does not grow with the time
+
+#include "sensorstats.hpp"
+#include "testutils.hpp"
+
+#include <random>
+
+using namespace sl_oc::sensors;
+
+/*!
+ * \brief Feed 30 seconds of 400 Hz packets whose offset drifts by `drift_ppm`, with a minimum transport time of
+ *        50 usec plus a random latency, and compare the measured latency with the random one
+ */
+static void testDrift( double drift_ppm )
+{
+    const int64_t period = 2500000;
+    const int64_t min_transport = 50000;
+    std::mt19937 rng(7);
+    std::exponential_distribution<double> extra(1.0/200000.0);
+
+    LatencyReference ref;
+    double max_err_fit = 0.0, max_err = 0.0;
+    for( int64_t i=0; i<30*400; i++ )
+    {
+        const int64_t host_ts = 1000000000000 + i*period;
+        const int64_t latency = static_cast<int64_t>(extra(rng));
+        const int64_t offset = 123456789 + static_cast<int64_t>(drift_ppm*1e-6*(i*period)) + min_transport + latency;
+
+        const double err = std::fabs(static_cast<double>(ref.update(host_ts, offset) - latency));
+        if( i>=4*400 )
+            max_err = std::max(max_err, err);
+        else if( i>=2*400 )
+            max_err_fit = std::max(max_err_fit, err);
+    }
+
+    // The first fits use few minima: the error decreases as more windows are complete. Without the drift tracking
+    // the error would reach 1.8 msec at 60 ppm.
+    TEST_CHECK(max_err_fit<=25000.0);
+    TEST_CHECK(max_err<=10000.0);
+    TEST_CHECK_NEAR(ref.getDriftPpm(), drift_ppm, 2.0);
+}
+
+static void testReset()
+{
+    LatencyReference ref(100, 2);
+    TEST_CHECK_EQUAL(ref.update(0, 1000), 0);
+    TEST_CHECK_EQUAL(ref.update(10, 1500), 500);
+    TEST_CHECK_EQUAL(ref.update(20, 900), 0);
+    TEST_CHECK_EQUAL(ref.update(30, 1000), 100);
+
+    // After a reset the first packet is the new reference
+    ref.reset();
+    TEST_CHECK_EQUAL(ref.update(40, 5000), 0);
+    TEST_CHECK_EQUAL(ref.update(50, 5200), 200);
+    TEST_CHECK_EQUAL(ref.getDriftPpm(), 0.0);
+}
+
+int main()
+{
+    testDrift(0.0);
+    testDrift(60.0);
+    testDrift(-60.0);
+    testReset();
+
+    return sl_oc::test::result();
+}
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// The motion and free-fall interrupts of the IMU must generate one start and one stop event each, also when they
+// start and end between two packets or restart while the flag is still set
+
+#include "sensorcapture.hpp"
+#include "fakemcu.hpp"
+#include "testutils.hpp"
+
+#include <mutex>
+
+using namespace sl_oc::sensors;
+
+static FakeMcuInterrupt makeInterrupt( bool free_fall, uint64_t start, uint64_t length )
+{
+    FakeMcuInterrupt irq;
+    irq.free_fall = free_fall;
+    irq.start = start;
+    irq.length = length;
+    return irq;
+}
+
+int main()
+{
+    typedef data::MotionEvent Ev;
+
+    FakeMcuParams params;
+    params.realtime = false;
+    params.packet_count = 800;
+    params.interrupts.push_back(makeInterrupt(false, 100, 50));
+    params.interrupts.push_back(makeInterrupt(false, 200, 0));     // Between two packets
+    params.interrupts.push_back(makeInterrupt(false, 300, 100));
+    params.interrupts.push_back(makeInterrupt(false, 350, 50));    // Restarted while the flag is set
+    params.interrupts.push_back(makeInterrupt(true, 500, 10));
+    params.interrupts.push_back(makeInterrupt(true, 600, 0));
+
+    const struct {Ev::MotionEventType type; uint32_t count;} expected[] = {
+        {Ev::MOTION_START, 1}, {Ev::MOTION_STOP, 1},
+        {Ev::MOTION_START, 2}, {Ev::MOTION_STOP, 2},
+        {Ev::MOTION_START, 3}, {Ev::MOTION_STOP, 4}, {Ev::MOTION_START, 4}, {Ev::MOTION_STOP, 4},
+        {Ev::FREE_FALL_START, 1}, {Ev::FREE_FALL_STOP, 1},
+        {Ev::FREE_FALL_START, 2}, {Ev::FREE_FALL_STOP, 2}
+    };
+    const size_t expected_count = sizeof(expected)/sizeof(expected[0]);
+
+    std::mutex mutex;
+    std::vector<data::MotionEvent> events;
+
+    FakeMcuTransport* fake = new FakeMcuTransport(params);
+    SensorCapture sens{std::unique_ptr<HidTransport>(fake)};
+    sens.setMotionEventCallback([&](const data::MotionEvent& ev) {
+        const std::lock_guard<std::mutex> lock(mutex);
+        events.push_back(ev);
+    });
+    TEST_CHECK(sens.initializeSensors(params.serial_number));
+
+    TEST_CHECK(sl_oc::test::waitFor([&]{return sens.getPacketStats().received==params.packet_count;}));
+    TEST_CHECK(!sens.isCameraMoving());
+    TEST_CHECK(!sens.isCameraFalling());
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    TEST_CHECK_EQUAL(events.size(), expected_count);
+    for( size_t i=0; i<events.size() && i<expected_count; i++ )
+    {
+        TEST_CHECK_EQUAL(static_cast<int>(events[i].type), static_cast<int>(expected[i].type));
+        TEST_CHECK_EQUAL(events[i].count, expected[i].count);
+        if( i>0 )
+            TEST_CHECK(events[i].timestamp>=events[i-1].timestamp);
+    }
+
+    return sl_oc::test::result();
+}
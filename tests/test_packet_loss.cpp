@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// The packets lost by the fake MCU must be counted exactly by SensorCapture
+
+#include "sensorcapture.hpp"
+#include "fakemcu.hpp"
+#include "testutils.hpp"
+
+#include <atomic>
+
+using namespace sl_oc::sensors;
+
+static void testLossCounting( double drift_ppm, double jitter_usec )
+{
+    FakeMcuParams params;
+    params.realtime = false;
+    params.packet_count = 20000;
+    params.drop_prob = 0.01;
+    params.drop_burst = 3;
+    params.drift_ppm = drift_ppm;
+    params.jitter_usec = jitter_usec;
+
+    FakeMcuTransport* fake = new FakeMcuTransport(params);
+    SensorCapture sens{std::unique_ptr<HidTransport>(fake)};
+
+    // The callback receives every sample, with the gap flag set only after the lost packets
+    std::atomic<uint64_t> cb_count{0}, cb_gaps{0};
+    sens.setImuCallback([&](const data::Imu& imu){
+        cb_count++;
+        cb_gaps += imu.gap?1:0;
+    });
+
+    TEST_CHECK(sens.initializeSensors(params.serial_number));
+
+    TEST_CHECK(sl_oc::test::waitFor([&]{return fake->getDeliveredCount()+fake->getDroppedCount()==params.packet_count &&
+                                              sens.getPacketStats().received==fake->getDeliveredCount();}));
+    // The last callback is called after the packet is counted. The first packet is only the timestamp reference.
+    TEST_CHECK(sl_oc::test::waitFor([&]{return cb_count.load()+1==sens.getPacketStats().received;}));
+
+    const data::SensorPacketStats stats = sens.getPacketStats();
+    TEST_CHECK(fake->getDroppedCount()>0);
+    TEST_CHECK_EQUAL(stats.lost, fake->getDroppedCount());
+    TEST_CHECK_EQUAL(stats.duplicated, 0u);
+    TEST_CHECK_EQUAL(stats.out_of_order, 0u);
+    TEST_CHECK_EQUAL(stats.short_reads, 0u);
+    TEST_CHECK_EQUAL(stats.invalid, 0u);
+
+    // Consecutive dropouts are merged in a single gap
+    TEST_CHECK(stats.gaps>0);
+    TEST_CHECK_EQUAL(stats.lost%params.drop_burst, 0u);
+    TEST_CHECK(stats.gaps*params.drop_burst<=stats.lost);
+
+    TEST_CHECK_EQUAL(cb_count.load()+1, stats.received);
+    TEST_CHECK_EQUAL(cb_gaps.load(), stats.gaps);
+
+    sens.resetPacketStats();
+    const data::SensorPacketStats reset = sens.getPacketStats();
+    TEST_CHECK_EQUAL(reset.received, 0u);
+    TEST_CHECK_EQUAL(reset.lost, 0u);
+    TEST_CHECK_EQUAL(reset.gaps, 0u);
+}
+
+int main()
+{
+    testLossCounting(0.0, 0.0);
+
+    // The gaps are detected from the MCU timestamps: host delivery jitter and MCU clock drift do not matter
+    testLossCounting(50.0, 1000.0);
+    testLossCounting(-50.0, 1000.0);
+
+    return sl_oc::test::result();
+}
@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// The point mappings must invert each other within the documented accuracy, match the dense rectification maps, and
+// give the same results with the vectorized and the scalar code
+
+#include "pointrectifier.hpp"
+#include "testutils.hpp"
+
+#include <cstring>
+#include <random>
+
+using namespace sl_oc::video;
+
+namespace {
+
+/*!
+ * \brief Calibration with the lens distortion of a ZED camera, scaled to the resolution
+ */
+StereoCameraParams makeCalibration( RESOLUTION res )
+{
+    const int r = static_cast<int>(res);
+    const double f[] = {1400.12, 1400.12, 700.12, 350.12};
+    const double cx[] = {1105.5, 961.5, 641.5, 337.5};
+    const double cy[] = {618.75, 537.75, 357.75, 185.75};
+
+    StereoCameraParams calib;
+    calib.valid = true;
+    calib.width = static_cast<int>(cameraResolution[r].width);
+    calib.height = static_cast<int>(cameraResolution[r].height);
+    for( CameraIntrinsics* cam : {&calib.left, &calib.right} )
+    {
+        cam->fx = f[r];
+        cam->fy = f[r] + 0.22;
+        cam->cx = cx[r];
+        cam->cy = cy[r];
+        cam->k1 = -0.1736;
+        cam->k2 = 0.0271;
+        cam->p1 = 0.0002;
+        cam->p2 = -0.0001;
+        cam->k3 = -1.2e-3;
+    }
+    calib.baseline = 119.907;
+    calib.ty = 0.05;
+    calib.tz = -0.2;
+    calib.rx = -0.0012;
+    calib.ry = 0.0051;
+    calib.rz = 0.0003;
+    return calib;
+}
+
+/*!
+ * \brief Random points covering the whole source image, an odd count to include the scalar tail of the vector code
+ */
+std::vector<float> randomPoints( int width, int height, size_t count )
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> ux(0.0f, static_cast<float>(width-1));
+    std::uniform_real_distribution<float> uy(0.0f, static_cast<float>(height-1));
+
+    std::vector<float> pts(2*count);
+    for( size_t i=0; i<count; i++ )
+    {
+        pts[2*i] = ux(rng);
+        pts[2*i+1] = uy(rng);
+    }
+    return pts;
+}
+
+double maxRoundTripError( RESOLUTION res, int grid_step )
+{
+    const StereoCameraParams calib = makeCalibration(res);
+    PointRectifier pr;
+    TEST_CHECK(pr.init(calib, grid_step));
+
+    const size_t count = 20001;
+    const std::vector<float> raw = randomPoints(calib.width, calib.height, count);
+    std::vector<float> rect(raw.size()), back(raw.size());
+
+    double max_err = 0.0;
+    for( CAM_SENS_POS side : {CAM_SENS_POS::LEFT, CAM_SENS_POS::RIGHT} )
+    {
+        pr.rectifyPoints(side, raw.data(), rect.data(), count);
+        pr.unrectifyPoints(side, rect.data(), back.data(), count);
+        for( size_t i=0; i<count; i++ )
+            max_err = std::max(max_err, static_cast<double>(std::hypot(back[2*i]-raw[2*i], back[2*i+1]-raw[2*i+1])));
+    }
+    return max_err;
+}
+
+}
+
+static void testRoundTrip()
+{
+    // Accuracy stated in the PointRectifier documentation
+    TEST_CHECK(maxRoundTripError(RESOLUTION::HD2K, 16)<1e-3);
+    TEST_CHECK(maxRoundTripError(RESOLUTION::HD1080, 16)<1e-3);
+    TEST_CHECK(maxRoundTripError(RESOLUTION::HD720, 16)<1e-3);
+    TEST_CHECK(maxRoundTripError(RESOLUTION::VGA, 16)<4e-3);
+    TEST_CHECK(maxRoundTripError(RESOLUTION::VGA, 8)<5e-4);
+}
+
+static void testDenseMap()
+{
+    // A rectified pixel maps to the source coordinates of the dense map
+    for( RESOLUTION res : {RESOLUTION::HD2K, RESOLUTION::VGA} )
+    {
+        const StereoCameraParams calib = makeCalibration(res);
+        PointRectifier pr;
+        TEST_CHECK(pr.init(calib));
+        const RectificationParams& rect = pr.getRectification();
+
+        const int w = rect.width;
+        const int h = rect.height;
+        std::vector<float> map_x(static_cast<size_t>(w*h)), map_y(static_cast<size_t>(w*h));
+        std::vector<float> pts(2*static_cast<size_t>(w)), src(2*static_cast<size_t>(w));
+        for( CAM_SENS_POS side : {CAM_SENS_POS::LEFT, CAM_SENS_POS::RIGHT} )
+        {
+            const bool left = side==CAM_SENS_POS::LEFT;
+            StereoRectify::computeMap(left?calib.left:calib.right, left?rect.R_left:rect.R_right,
+                                      left?rect.P_left:rect.P_right, w, 0, h, map_x.data(), map_y.data());
+
+            double max_err = 0.0;
+            for( int y=0; y<h; y+=7 )
+            {
+                for( int x=0; x<w; x++ )
+                {
+                    pts[2*x] = static_cast<float>(x);
+                    pts[2*x+1] = static_cast<float>(y);
+                }
+                pr.unrectifyPoints(side, pts.data(), src.data(), static_cast<size_t>(w));
+                for( int x=0; x<w; x++ )
+                {
+                    max_err = std::max(max_err, static_cast<double>(std::fabs(src[2*x]-map_x[y*w+x])));
+                    max_err = std::max(max_err, static_cast<double>(std::fabs(src[2*x+1]-map_y[y*w+x])));
+                }
+            }
+            // About one float ulp of the 2K coordinates
+            TEST_CHECK(max_err<=1.5e-4);
+        }
+    }
+}
+
+static void testVectorCode()
+{
+    const StereoCameraParams calib = makeCalibration(RESOLUTION::HD720);
+    PointRectifier pr;
+    TEST_CHECK(pr.init(calib));
+
+    // Not finite and outside points are processed as the other ones
+    const size_t count = 1001;
+    std::vector<float> raw = randomPoints(calib.width, calib.height, count);
+    raw[0] = NAN;
+    raw[3] = -500.0f;
+    raw[4] = 1e5f;
+
+    std::vector<float> rect(raw.size()), back(raw.size()), one(raw.size());
+    pr.rectifyPoints(CAM_SENS_POS::LEFT, raw.data(), rect.data(), count);
+    pr.unrectifyPoints(CAM_SENS_POS::LEFT, rect.data(), back.data(), count);
+    TEST_CHECK(std::isnan(rect[0]) && std::isnan(rect[1]));
+    TEST_CHECK(std::isnan(back[0]) && std::isnan(back[1]));
+    TEST_CHECK(std::isfinite(rect[2]) && std::isfinite(rect[3]) && std::isfinite(rect[4]) && std::isfinite(rect[5]));
+
+    // Same bits of the scalar code
+    for( size_t i=0; i<count; i++ )
+        pr.rectifyPoints(CAM_SENS_POS::LEFT, &raw[2*i], &one[2*i], 1);
+    TEST_CHECK(std::memcmp(one.data(), rect.data(), rect.size()*sizeof(float))==0);
+    for( size_t i=0; i<count; i++ )
+        pr.unrectifyPoints(CAM_SENS_POS::LEFT, &rect[2*i], &one[2*i], 1);
+    TEST_CHECK(std::memcmp(one.data(), back.data(), back.size()*sizeof(float))==0);
+
+    // In place
+    std::vector<float> inplace = raw;
+    pr.rectifyPoints(CAM_SENS_POS::LEFT, inplace.data(), inplace.data(), count);
+    TEST_CHECK(std::memcmp(inplace.data(), rect.data(), rect.size()*sizeof(float))==0);
+    pr.unrectifyPoints(CAM_SENS_POS::LEFT, inplace.data(), inplace.data(), count);
+    TEST_CHECK(std::memcmp(inplace.data(), back.data(), back.size()*sizeof(float))==0);
+}
+
+int main()
+{
+    testRoundTrip();
+    testDenseMap();
+    testVectorCode();
+
+    return sl_oc::test::result();
+}
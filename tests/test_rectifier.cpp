@@ -0,0 +1,441 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// The fixed-point rectification must match a floating point bilinear interpolation, with the pixels mapped outside the
+// source image set to black, for each pixel format, for any split of the image in parallel tasks and within the map
+// error measured for the maps stored on a grid. Maps downscaling by 2 must sample a 2x2 box-filtered luma.
+
+#include "rectifier.hpp"
+#include "stereorectify.hpp"
+#include "testutils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+using namespace sl_oc::video;
+
+namespace {
+
+const int SRC_W = 320;
+const int SRC_H = 240;
+const int DST_W = 314;  // Not a multiple of 8, to include the scalar tail of the vector code
+const int DST_H = 238;
+
+/*!
+ * \brief A plane of 8 bit samples, `bpp` bytes apart in each row
+ */
+struct Plane
+{
+    const uint8_t* data;
+    size_t step;
+    int bpp;
+    int width;
+    int height;
+
+    inline double at( int x, int y ) const {return data[y*step + x*bpp];}
+};
+
+struct Map
+{
+    int width;
+    int height;
+    std::vector<float> x;
+    std::vector<float> y;
+};
+
+/*!
+ * \brief A smooth map with a barrel distortion that moves the borders outside the source image, with coordinates
+ *        rounded to multiples of `quantum` when it is not 0
+ */
+Map makeMap( int width, int height, int src_width, int src_height, float quantum )
+{
+    Map map = {width, height, std::vector<float>(static_cast<size_t>(width*height)),
+               std::vector<float>(static_cast<size_t>(width*height))};
+
+    const double sx = static_cast<double>(src_width)/width;
+    const double sy = static_cast<double>(src_height)/height;
+    for( int r=0; r<height; r++ )
+    {
+        for( int c=0; c<width; c++ )
+        {
+            const double xn = (c-(width-1)*0.5)/(width*0.5);
+            const double yn = (r-(height-1)*0.5)/(height*0.5);
+            const double k = 1.05*(1.0 + 0.08*(xn*xn + yn*yn));
+            double x = (src_width-1)*0.5 + xn*k*src_width*0.5 + 0.3*std::sin(r/13.0) + 0.002*sx;
+            double y = (src_height-1)*0.5 + yn*k*src_height*0.5 + 0.3*std::cos(c/17.0) - 0.003*sy;
+            if( quantum>0.f )
+            {
+                x = std::round(x/quantum)*quantum;
+                y = std::round(y/quantum)*quantum;
+            }
+            map.x[r*width+c] = static_cast<float>(x);
+            map.y[r*width+c] = static_cast<float>(y);
+        }
+    }
+
+    // Not finite coordinates are outside the image too
+    map.x[5] = NAN;
+    map.y[width+7] = NAN;
+    return map;
+}
+
+std::vector<uint8_t> randomImage( size_t step, int height, unsigned int seed )
+{
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> img(step*height);
+    for( uint8_t& v : img )
+        v = static_cast<uint8_t>(rng()>>24);
+    return img;
+}
+
+inline bool isInside( float x, float y, int width, int height )
+{
+    return x>=-0.5f && x<width-0.5f && y>=-0.5f && y<height-0.5f;
+}
+
+/*!
+ * \brief Bilinear interpolation. Coordinates within half a pixel from the image are clamped to the last 1/16 pixel
+ *        before the last column and row, the position of the last pixel pair read by the fixed-point code.
+ */
+double bilinear( const Plane& p, double x, double y )
+{
+    x = std::min(std::max(x, 0.0), p.width-1-1.0/16);
+    y = std::min(std::max(y, 0.0), p.height-1-1.0/16);
+    const int ix = static_cast<int>(x);
+    const int iy = static_cast<int>(y);
+    const double fx = x-ix;
+    const double fy = y-iy;
+    const double top = p.at(ix,iy)*(1.0-fx) + p.at(ix+1,iy)*fx;
+    const double bot = p.at(ix,iy+1)*(1.0-fx) + p.at(ix+1,iy+1)*fx;
+    return top*(1.0-fy) + bot*fy;
+}
+
+/*!
+ * \brief Bilinear interpolation of the 2x2 box-filtered plane, whose samples are centered between the source pixels.
+ *        The 3x3 source pixels read start half a pixel before the coordinates and are clamped inside the image.
+ */
+double boxFilter( const Plane& p, double x, double y )
+{
+    x = std::min(std::max(x-0.5, 0.0), p.width-2-1.0/16);
+    y = std::min(std::max(y-0.5, 0.0), p.height-2-1.0/16);
+    const int ix = static_cast<int>(x);
+    const int iy = static_cast<int>(y);
+    const double gx = x-ix;
+    const double gy = y-iy;
+
+    double row[3];
+    for( int r=0; r<3; r++ )
+        row[r] = (p.at(ix,iy+r)*(1.0-gx) + p.at(ix+1,iy+r) + p.at(ix+2,iy+r)*gx)*0.5;
+    return (row[0]*(1.0-gy) + row[1] + row[2]*gy)*0.5;
+}
+
+/*!
+ * \brief Compare the samples of a rectified plane with the reference
+ * \param out the first sample of the rectified plane
+ * \param chroma true to compare the chroma of a pair of YUYV pixels, sampled at the position of the even pixel
+ * \param box true to compare with the interpolation of the box-filtered source
+ * \return the maximum difference of the valid samples
+ */
+double compare( const uint8_t* out, size_t out_step, int out_bpp, const Map& map, const Plane& src, bool chroma,
+                bool box = false )
+{
+    double max_diff = 0.0;
+    int invalid = 0;
+    for( int r=0; r<map.height; r++ )
+    {
+        for( int c=0; c<map.width; c+=(chroma?2:1) )
+        {
+            const float x = map.x[r*map.width+c];
+            const float y = map.y[r*map.width+c];
+            const uint8_t v = out[r*out_step + c*out_bpp];
+
+            if( !isInside(x, y, chroma?src.width*2:src.width, src.height) )
+            {
+                TEST_CHECK_EQUAL(v, chroma?128:0);
+                invalid++;
+                continue;
+            }
+
+            double ref;
+            if( chroma )
+                ref = bilinear(src, std::max(x,0.f)*0.5, y);
+            else
+                ref = box ? boxFilter(src, x, y) : bilinear(src, x, y);
+            max_diff = std::max(max_diff, std::fabs(v-ref));
+        }
+    }
+
+    // The map covers both cases
+    TEST_CHECK(invalid>0);
+    TEST_CHECK(invalid<map.width*map.height/2);
+    return max_diff;
+}
+
+}
+
+static void testGray( WorkerPool* pool )
+{
+    const size_t src_step = SRC_W + 32;
+    const size_t dst_step = DST_W + 16;
+    const std::vector<uint8_t> src = randomImage(src_step, SRC_H, 1);
+    const Plane plane = {src.data(), src_step, 1, SRC_W, SRC_H};
+
+    // With coordinates multiple of 1/16 the fixed-point weights are exact: only the result is rounded
+    const Map map = makeMap(DST_W, DST_H, SRC_W, SRC_H, 1.f/16);
+    Rectifier rect(pool);
+    TEST_CHECK(rect.setMaps(CAM_SENS_POS::LEFT, map.x.data(), map.y.data(), DST_W, DST_H, SRC_W, SRC_H));
+
+    int w, h;
+    rect.getSize(CAM_SENS_POS::LEFT, w, h);
+    TEST_CHECK_EQUAL(w, DST_W);
+    TEST_CHECK_EQUAL(h, DST_H);
+
+    std::vector<uint8_t> dst(dst_step*DST_H);
+    TEST_CHECK(rect.rectify(CAM_SENS_POS::LEFT, RECT_FORMAT::GRAY, src.data(), src_step, dst.data(), dst_step));
+    TEST_CHECK(compare(dst.data(), dst_step, 1, map, plane, false)<=0.5+1e-9);
+}
+
+static void testYuyv( WorkerPool* pool )
+{
+    const size_t src_step = 2*SRC_W + 64;
+    const size_t dst_step = 2*DST_W + 32;
+    const std::vector<uint8_t> src = randomImage(src_step, SRC_H, 2);
+    const Plane luma = {src.data(), src_step, 2, SRC_W, SRC_H};
+    const Plane u = {src.data()+1, src_step, 4, SRC_W/2, SRC_H};
+    const Plane v = {src.data()+3, src_step, 4, SRC_W/2, SRC_H};
+
+    // The chroma is sampled at half the X coordinate: multiples of 1/8 keep the chroma weights exact too
+    const Map map = makeMap(DST_W, DST_H, SRC_W, SRC_H, 1.f/8);
+    Rectifier rect(pool);
+    TEST_CHECK(rect.setMaps(CAM_SENS_POS::RIGHT, map.x.data(), map.y.data(), DST_W, DST_H, SRC_W, SRC_H));
+
+    std::vector<uint8_t> dst(dst_step*DST_H);
+    TEST_CHECK(rect.rectify(CAM_SENS_POS::RIGHT, RECT_FORMAT::YUYV, src.data(), src_step, dst.data(), dst_step));
+    TEST_CHECK(compare(dst.data(), dst_step, 2, map, luma, false)<=0.5+1e-9);
+    TEST_CHECK(compare(dst.data()+1, dst_step, 2, map, u, true)<=0.5+1e-9);
+    TEST_CHECK(compare(dst.data()+3, dst_step, 2, map, v, true)<=0.5+1e-9);
+
+    // The luma of the YUYV_TO_GRAY format is the same of the YUYV format
+    const size_t gray_step = DST_W;
+    std::vector<uint8_t> gray(gray_step*DST_H);
+    TEST_CHECK(rect.rectify(CAM_SENS_POS::RIGHT, RECT_FORMAT::YUYV_TO_GRAY, src.data(), src_step, gray.data(), gray_step));
+    bool same = true;
+    for( int r=0; r<DST_H; r++ )
+        for( int c=0; c<DST_W; c++ )
+            same &= gray[r*gray_step+c]==dst[r*dst_step+2*c];
+    TEST_CHECK(same);
+}
+
+static void testMapGrid()
+{
+    // Undistortion map of a ZED camera at VGA, where the distortion changes the most between two grid nodes
+    const int w = 672;
+    const int h = 376;
+    CameraIntrinsics cam;
+    cam.fx = 350.12;
+    cam.fy = 350.34;
+    cam.cx = 337.5;
+    cam.cy = 185.75;
+    cam.k1 = -0.1736;
+    cam.k2 = 0.0271;
+    cam.p1 = 0.0002;
+    cam.p2 = -0.0001;
+    cam.k3 = -1.2e-3;
+    const double R[9] = {1,0,0, 0,1,0, 0,0,1};
+    const double P[12] = {330,0,336,0, 0,330,188,0, 0,0,1,0};
+    Map map = {w, h, std::vector<float>(static_cast<size_t>(w*h)), std::vector<float>(static_cast<size_t>(w*h))};
+    StereoRectify::computeMap(cam, R, P, w, 0, h, map.x.data(), map.y.data());
+
+    // Smooth source never black, so that black output pixels are the invalid ones. The difference of the interpolated
+    // values of two points is at most sqrt(2)*max_step times their distance.
+    std::vector<uint8_t> src(static_cast<size_t>(w*h));
+    for( int r=0; r<h; r++ )
+        for( int c=0; c<w; c++ )
+            src[r*w+c] = static_cast<uint8_t>(std::lround(128.0 + 100.0*std::sin(c/9.0)*std::cos(r/11.0)));
+    const Plane plane = {src.data(), static_cast<size_t>(w), 1, w, h};
+    int max_step = 0;
+    for( int r=0; r+1<h; r++ )
+        for( int c=0; c+1<w; c++ )
+            max_step = std::max({max_step, std::abs(src[r*w+c+1]-src[r*w+c]), std::abs(src[(r+1)*w+c]-src[r*w+c])});
+
+    float prev_error = 0.f;
+    size_t full_memory = 0;
+    for( int step : {0, 8, 16} )
+    {
+        Rectifier rect;
+        rect.setMapGridStep(step);
+        TEST_CHECK_EQUAL(rect.getMapGridStep(), step);
+        float max_error = -1.f, mean_error = -1.f;
+        TEST_CHECK(!rect.getMapError(CAM_SENS_POS::LEFT, max_error, mean_error));
+        TEST_CHECK(rect.setMaps(CAM_SENS_POS::LEFT, map.x.data(), map.y.data(), w, h, w, h));
+        TEST_CHECK(rect.getMapError(CAM_SENS_POS::LEFT, max_error, mean_error));
+        TEST_CHECK(mean_error>0.f && mean_error<=max_error);
+
+        if( step==0 )
+        {
+            TEST_CHECK(max_error<=std::sqrt(2.f)/32 + 1e-5f); // Half of 1/16 pixel on each axis
+            full_memory = rect.getMapMemory();
+        }
+        else
+        {
+            TEST_CHECK(max_error>prev_error);
+            TEST_CHECK(rect.getMapMemory()*step<full_memory);
+        }
+        TEST_CHECK(max_error<0.2f);
+        prev_error = max_error;
+
+        std::vector<uint8_t> dst(static_cast<size_t>(w*h));
+        TEST_CHECK(rect.rectify(CAM_SENS_POS::LEFT, RECT_FORMAT::GRAY, src.data(), w, dst.data(), w));
+
+        // Pixels valid in only one map are not counted by the map error: they are at the border of the valid area
+        double max_diff = 0.0;
+        int mismatch = 0;
+        for( int i=0; i<w*h; i++ )
+        {
+            const bool inside = isInside(map.x[i], map.y[i], w, h);
+            if( inside!=(dst[i]!=0) )
+                mismatch++;
+            else if( inside )
+                max_diff = std::max(max_diff, std::fabs(dst[i]-bilinear(plane, map.x[i], map.y[i])));
+        }
+        TEST_CHECK(mismatch<w);
+        TEST_CHECK(max_diff<=0.5 + std::sqrt(2.0)*max_step*max_error + 1e-6);
+    }
+
+    // A map rounded to the fixed-point resolution has no error
+    const Map rounded = makeMap(DST_W, DST_H, SRC_W, SRC_H, 1.f/16);
+    Rectifier rect;
+    float max_error, mean_error;
+    TEST_CHECK(rect.setMaps(CAM_SENS_POS::RIGHT, rounded.x.data(), rounded.y.data(), DST_W, DST_H, SRC_W, SRC_H));
+    TEST_CHECK(rect.getMapError(CAM_SENS_POS::RIGHT, max_error, mean_error));
+    TEST_CHECK_EQUAL(max_error, 0.f);
+}
+
+static void testHalfResolution( WorkerPool* pool )
+{
+    const size_t src_step = 2*SRC_W;
+    const std::vector<uint8_t> src = randomImage(src_step, SRC_H, 4);
+    const Map map = makeMap(DST_W, DST_H, SRC_W, SRC_H, 0.f);
+    Rectifier rect(pool);
+    rect.setTileSize(32, 32);
+    TEST_CHECK(rect.setMaps(CAM_SENS_POS::LEFT, map.x.data(), map.y.data(), DST_W, DST_H, SRC_W, SRC_H));
+
+    int w, h;
+    rect.getSize(CAM_SENS_POS::LEFT, w, h, RECT_FORMAT::YUYV_TO_GRAY_HALF);
+    TEST_CHECK_EQUAL(w, DST_W/2);
+    TEST_CHECK_EQUAL(h, DST_H/2);
+
+    std::vector<uint8_t> full(static_cast<size_t>(DST_W*DST_H)), half(static_cast<size_t>(w*h));
+    TEST_CHECK(rect.rectify(CAM_SENS_POS::LEFT, RECT_FORMAT::YUYV_TO_GRAY, src.data(), src_step, full.data(), DST_W));
+    TEST_CHECK(rect.rectify(CAM_SENS_POS::LEFT, RECT_FORMAT::YUYV_TO_GRAY_HALF, src.data(), src_step, half.data(), w));
+
+    // Each pixel is the rounded average of the 2x2 full size pixels
+    bool same = true;
+    for( int r=0; r<h; r++ )
+    {
+        for( int c=0; c<w; c++ )
+        {
+            const uint8_t* p = full.data() + 2*r*DST_W + 2*c;
+            same &= half[r*w+c]==((p[0] + p[1] + p[DST_W] + p[DST_W+1] + 2) >> 2);
+        }
+    }
+    TEST_CHECK(same);
+}
+
+static void testBoxFilter( WorkerPool* pool )
+{
+    // A map downscaling by 2, odd size to include the scalar tail
+    const int w = SRC_W/2 - 3;
+    const int h = SRC_H/2 - 1;
+    const std::vector<uint8_t> gray = randomImage(SRC_W, SRC_H, 5);
+    const std::vector<uint8_t> yuyv = randomImage(2*SRC_W, SRC_H, 6);
+    const Map map = makeMap(w, h, SRC_W, SRC_H, 1.f/16);
+    Rectifier rect(pool);
+    TEST_CHECK(rect.setMaps(CAM_SENS_POS::LEFT, map.x.data(), map.y.data(), w, h, SRC_W, SRC_H));
+
+    // The horizontal sums are rounded to 1/4 before the vertical sum, adding up to 1/8 to the final rounding
+    std::vector<uint8_t> dst(static_cast<size_t>(2*w*h));
+    TEST_CHECK(rect.rectify(CAM_SENS_POS::LEFT, RECT_FORMAT::GRAY, gray.data(), SRC_W, dst.data(), w));
+    TEST_CHECK(compare(dst.data(), w, 1, map, {gray.data(), SRC_W, 1, SRC_W, SRC_H}, false, true)<=0.625+1e-9);
+    TEST_CHECK(rect.rectify(CAM_SENS_POS::LEFT, RECT_FORMAT::YUYV_TO_GRAY, yuyv.data(), 2*SRC_W, dst.data(), w));
+    TEST_CHECK(compare(dst.data(), w, 1, map, {yuyv.data(), 2*SRC_W, 2, SRC_W, SRC_H}, false, true)<=0.625+1e-9);
+
+    // The YUYV format is not filtered
+    TEST_CHECK(rect.rectify(CAM_SENS_POS::LEFT, RECT_FORMAT::YUYV, yuyv.data(), 2*SRC_W, dst.data(), 2*w));
+    TEST_CHECK(compare(dst.data(), 2*w, 2, map, {yuyv.data(), 2*SRC_W, 2, SRC_W, SRC_H}, false)<=0.5+1e-9);
+}
+
+static void testParallelTasks()
+{
+    // A side-by-side frame, with a different map for each side
+    const size_t src_step = 4*SRC_W;
+    const size_t dst_step = 2*DST_W;
+    const std::vector<uint8_t> src = randomImage(src_step, SRC_H, 3);
+    const Map map_left = makeMap(DST_W, DST_H, SRC_W, SRC_H, 0.f);
+    Map map_right = makeMap(DST_W, DST_H, SRC_W, SRC_H, 0.f);
+    for( float& x : map_right.x )
+        x += 0.37f;
+
+    WorkerPool pool(4);
+    Rectifier bands(nullptr), tiles(&pool);
+    tiles.setTileSize(40, 30);
+    for( Rectifier* rect : {&bands, &tiles} )
+    {
+        TEST_CHECK(rect->setMaps(CAM_SENS_POS::LEFT, map_left.x.data(), map_left.y.data(), DST_W, DST_H, SRC_W, SRC_H));
+        TEST_CHECK(rect->setMaps(CAM_SENS_POS::RIGHT, map_right.x.data(), map_right.y.data(), DST_W, DST_H, SRC_W, SRC_H));
+    }
+
+    int tile_w, tile_h;
+    tiles.getTileSize(tile_w, tile_h);
+    TEST_CHECK_EQUAL(tile_w, 48);
+    TEST_CHECK_EQUAL(tile_h, 30);
+
+    for( RECT_FORMAT format : {RECT_FORMAT::GRAY, RECT_FORMAT::YUYV, RECT_FORMAT::YUYV_TO_GRAY} )
+    {
+        const size_t bpp = format==RECT_FORMAT::GRAY ? 1 : 2;
+        std::vector<uint8_t> ref_left(dst_step*DST_H), ref_right(dst_step*DST_H);
+        std::vector<uint8_t> left(dst_step*DST_H), right(dst_step*DST_H);
+
+        // The right image follows the left one in each row of the frame
+        TEST_CHECK(bands.rectify(CAM_SENS_POS::LEFT, format, src.data(), src_step, ref_left.data(), dst_step));
+        TEST_CHECK(bands.rectify(CAM_SENS_POS::RIGHT, format, src.data()+SRC_W*bpp, src_step, ref_right.data(), dst_step));
+
+        TEST_CHECK(tiles.rectifyStereo(format, src.data(), src_step, left.data(), right.data(), dst_step));
+        TEST_CHECK(left==ref_left);
+        TEST_CHECK(right==ref_right);
+    }
+}
+
+int main()
+{
+    WorkerPool pool(3);
+    for( WorkerPool* p : {static_cast<WorkerPool*>(nullptr), &pool} )
+    {
+        testGray(p);
+        testYuyv(p);
+        testHalfResolution(p);
+        testBoxFilter(p);
+    }
+    testParallelTasks();
+    testMapGrid();
+
+    return sl_oc::test::result();
+}
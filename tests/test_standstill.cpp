@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// The standstill detector must estimate the gyroscope bias of a still camera and never report still a camera that
+// the IMU hardware reports moving
+
+#include "sensorcapture.hpp"
+#include "fakemcu.hpp"
+#include "testutils.hpp"
+
+using namespace sl_oc::sensors;
+
+static const float BIAS[3] = {0.5f, -0.3f, 0.2f};
+
+static void testStillCamera()
+{
+    FakeMcuParams params;
+    params.realtime = false;
+    params.packet_count = 4000;
+    for( int i=0; i<3; i++ )
+        params.gyro[i] = BIAS[i];
+
+    FakeMcuTransport* fake = new FakeMcuTransport(params);
+    SensorCapture sens{std::unique_ptr<HidTransport>(fake)};
+    sens.enableStandstillDetection(true, StandstillParams(), true);
+    TEST_CHECK(sens.initializeSensors(params.serial_number));
+
+    TEST_CHECK(sl_oc::test::waitFor([&]{return sens.getPacketStats().received==params.packet_count;}));
+    TEST_CHECK(sens.isCameraStill());
+
+    const data::GyroBias bias = sens.getGyroBias();
+    TEST_CHECK(bias.valid);
+    TEST_CHECK(bias.samples>0);
+    TEST_CHECK_NEAR(bias.bX, BIAS[0], 0.02f);
+    TEST_CHECK_NEAR(bias.bY, BIAS[1], 0.02f);
+    TEST_CHECK_NEAR(bias.bZ, BIAS[2], 0.02f);
+
+    // The estimated bias is subtracted from the published data
+    const data::Imu& imu = sens.getLastIMUData(0);
+    TEST_CHECK(imu.valid!=data::Imu::NOT_PRESENT);
+    TEST_CHECK_NEAR(imu.gX, 0.0f, 0.15f);
+    TEST_CHECK_NEAR(imu.gY, 0.0f, 0.15f);
+    TEST_CHECK_NEAR(imu.gZ, 0.0f, 0.15f);
+
+    sens.enableStandstillDetection(false);
+    TEST_CHECK(!sens.isCameraStill());
+}
+
+static void testMovingCamera()
+{
+    FakeMcuParams params;
+    params.realtime = false;
+    params.packet_count = 2000;
+    for( int i=0; i<3; i++ )
+        params.gyro[i] = BIAS[i];
+
+    // The IMU hardware reports motion for the whole stream
+    FakeMcuInterrupt irq;
+    irq.start = 0;
+    irq.length = params.packet_count;
+    params.interrupts.push_back(irq);
+
+    // A bias saved by a previous session is subtracted even if the camera is never still
+    data::GyroBias saved;
+    saved.valid = true;
+    saved.bX = BIAS[0];
+    saved.bY = BIAS[1];
+    saved.bZ = BIAS[2];
+
+    FakeMcuTransport* fake = new FakeMcuTransport(params);
+    SensorCapture sens{std::unique_ptr<HidTransport>(fake)};
+    sens.setGyroBias(saved);
+    sens.enableStandstillDetection(true, StandstillParams(), true);
+    TEST_CHECK(sens.initializeSensors(params.serial_number));
+
+    TEST_CHECK(sl_oc::test::waitFor([&]{return sens.getPacketStats().received==params.packet_count;}));
+    TEST_CHECK(sens.isCameraMoving());
+    TEST_CHECK(!sens.isCameraStill());
+
+    const data::GyroBias bias = sens.getGyroBias();
+    TEST_CHECK(bias.valid);
+    TEST_CHECK_EQUAL(bias.samples, 0u);
+    TEST_CHECK_EQUAL(bias.bX, BIAS[0]);
+
+    const data::Imu& imu = sens.getLastIMUData(0);
+    TEST_CHECK_NEAR(imu.gX, 0.0f, 0.15f);
+    TEST_CHECK_NEAR(imu.gY, 0.0f, 0.15f);
+    TEST_CHECK_NEAR(imu.gZ, 0.0f, 0.15f);
+}
+
+int main()
+{
+    testStillCamera();
+    testMovingCamera();
+
+    return sl_oc::test::result();
+}
@@ -0,0 +1,239 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+// The calibration file must be parsed for each resolution independently of the C locale, and the binary
+// serialization must be deterministic and reject damaged data
+
+#include "stereocalibration.hpp"
+#include "rectmapcache.hpp"
+#include "testutils.hpp"
+
+#include <algorithm>
+#include <clocale>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <new>
+
+using namespace sl_oc::video;
+
+namespace {
+
+// Calibration values of each resolution, in the order of RESOLUTION
+const struct {const char* suffix; const char* cx; const char* cy; const char* f;} RES_TEXT[] = {
+    {"2K", "1105.5", "618.75", "1400.12"},
+    {"FHD", "961.5", "537.75", "1400.12"},
+    {"HD", "641.5", "357.75", "700.12"},
+    {"VGA", "337.5", "185.75", "350.12"}
+};
+
+/*!
+ * \brief Generate a calibration file with the sections of the resolutions selected by `mask`
+ */
+std::string makeConf( unsigned int mask = 0xF, bool baseline = true )
+{
+    std::string conf;
+    for( const char* side : {"LEFT", "RIGHT"} )
+    {
+        for( int r=0; r<StereoCalibration::RESOLUTION_COUNT; r++ )
+        {
+            if( !(mask & (1u<<r)) )
+                continue;
+            conf += std::string("[") + side + "_CAM_" + RES_TEXT[r].suffix + "]\n";
+            conf += std::string("cx = ") + RES_TEXT[r].cx + "\ncy = " + RES_TEXT[r].cy + "\n";
+            conf += std::string("fx = ") + RES_TEXT[r].f + "\nfy = " + RES_TEXT[r].f + "\n";
+            conf += "k1 = -0.1736\nk2 = 0.0271\np1 = 0.0002\np2 = -0.0001\nk3 = -1.2e-3\n\n";
+        }
+    }
+
+    conf += "[STEREO]\n";
+    if( baseline )
+        conf += "Baseline = 119.907\n";
+    for( int r=0; r<StereoCalibration::RESOLUTION_COUNT; r++ )
+    {
+        const std::string s = RES_TEXT[r].suffix;
+        conf += "TY_" + s + " = 0.05\nTZ_" + s + " = -0.2\nCV_" + s + " = 0.0051\nRX_" + s + " = -0.0012\nRZ_" + s + " = 0.0003\n";
+    }
+    conf += "\n[MISC]\nSensor_ID = 1\n";
+    return conf;
+}
+
+void checkParams( const StereoCalibration& calib )
+{
+    for( int r=0; r<StereoCalibration::RESOLUTION_COUNT; r++ )
+    {
+        const RESOLUTION res = static_cast<RESOLUTION>(r);
+        TEST_CHECK(calib.isValid(res));
+
+        const StereoCameraParams& par = calib.getParams(res);
+        TEST_CHECK_EQUAL(par.width, static_cast<int>(cameraResolution[r].width));
+        TEST_CHECK_EQUAL(par.height, static_cast<int>(cameraResolution[r].height));
+        for( const CameraIntrinsics* cam : {&par.left, &par.right} )
+        {
+            TEST_CHECK_EQUAL(cam->cx, std::strtod(RES_TEXT[r].cx, nullptr));
+            TEST_CHECK_EQUAL(cam->cy, std::strtod(RES_TEXT[r].cy, nullptr));
+            TEST_CHECK_EQUAL(cam->fx, std::strtod(RES_TEXT[r].f, nullptr));
+            TEST_CHECK_EQUAL(cam->fy, std::strtod(RES_TEXT[r].f, nullptr));
+            TEST_CHECK_EQUAL(cam->k1, -0.1736);
+            TEST_CHECK_EQUAL(cam->k2, 0.0271);
+            TEST_CHECK_EQUAL(cam->p1, 0.0002);
+            TEST_CHECK_EQUAL(cam->p2, -0.0001);
+            TEST_CHECK_EQUAL(cam->k3, -1.2e-3);
+        }
+        TEST_CHECK_EQUAL(par.baseline, 119.907);
+        TEST_CHECK_EQUAL(par.ty, 0.05);
+        TEST_CHECK_EQUAL(par.tz, -0.2);
+        TEST_CHECK_EQUAL(par.rx, -0.0012);
+        TEST_CHECK_EQUAL(par.ry, 0.0051);
+        TEST_CHECK_EQUAL(par.rz, 0.0003);
+    }
+}
+
+}
+
+static void testParse()
+{
+    const std::string conf = makeConf();
+
+    StereoCalibration calib;
+    std::string error;
+    TEST_CHECK(calib.parse(conf, &error));
+    TEST_CHECK(error.empty());
+    checkParams(calib);
+
+    // The hash only depends on the file content
+    const char* filename = "test_stereo_calibration.conf";
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file << conf;
+    }
+    StereoCalibration loaded;
+    TEST_CHECK(loaded.load(filename));
+    TEST_CHECK(calib.getHash()!=0);
+    TEST_CHECK_EQUAL(loaded.getHash(), calib.getHash());
+    TEST_CHECK_EQUAL(RectMapCache::hashFile(filename), calib.getHash());
+    std::remove(filename);
+
+    StereoCalibration other;
+    TEST_CHECK(other.parse(conf + "\n"));
+    TEST_CHECK(other.getHash()!=calib.getHash());
+
+    // Numbers are not read with the decimal separator of the C locale
+    if( std::setlocale(LC_NUMERIC, "de_DE.UTF-8") || std::setlocale(LC_NUMERIC, "fr_FR.UTF-8") )
+    {
+        StereoCalibration localized;
+        TEST_CHECK(localized.parse(conf));
+        checkParams(localized);
+        std::setlocale(LC_NUMERIC, "C");
+    }
+}
+
+static void testInvalidResolutions()
+{
+    // Missing resolutions do not stop the others
+    StereoCalibration calib;
+    std::string error;
+    TEST_CHECK(calib.parse(makeConf(0x5), &error));
+    TEST_CHECK(calib.isValid(RESOLUTION::HD2K));
+    TEST_CHECK(!calib.isValid(RESOLUTION::HD1080));
+    TEST_CHECK(calib.isValid(RESOLUTION::HD720));
+    TEST_CHECK(!calib.isValid(RESOLUTION::VGA));
+    TEST_CHECK(error.find("HD1080")!=std::string::npos);
+    TEST_CHECK(error.find("VGA")!=std::string::npos);
+    TEST_CHECK(error.find("HD2K")==std::string::npos);
+    TEST_CHECK(!calib.getParams(RESOLUTION::LAST).valid);
+
+    // A failed parse keeps the previous calibration
+    TEST_CHECK(!calib.parse(makeConf(0xF, false), &error));
+    TEST_CHECK(error.find("missing baseline")!=std::string::npos);
+    TEST_CHECK(calib.isValid(RESOLUTION::HD2K));
+
+    // A file written with a decimal comma has no valid number
+    std::string comma = makeConf();
+    std::replace(comma.begin(), comma.end(), '.', ',');
+    StereoCalibration calib_comma;
+    TEST_CHECK(!calib_comma.parse(comma, &error));
+    TEST_CHECK(!error.empty());
+}
+
+static void testBinary()
+{
+    const std::string conf = makeConf();
+
+    StereoCalibration calib;
+    TEST_CHECK(calib.parse(conf));
+
+    std::vector<uint8_t> buffer;
+    calib.toBinary(buffer);
+    TEST_CHECK(!buffer.empty());
+
+    // The serialization does not depend on the content of the uninitialized memory of the object
+    alignas(StereoCalibration) uint8_t storage[sizeof(StereoCalibration)];
+    std::memset(storage, 0xA5, sizeof(storage));
+    StereoCalibration* dirty = new (storage) StereoCalibration();
+    TEST_CHECK(dirty->parse(conf));
+    std::vector<uint8_t> dirty_buffer;
+    dirty->toBinary(dirty_buffer);
+    TEST_CHECK(dirty_buffer==buffer);
+    dirty->~StereoCalibration();
+
+    // Round trip
+    StereoCalibration restored;
+    TEST_CHECK(restored.fromBinary(buffer.data(), buffer.size()));
+    checkParams(restored);
+    TEST_CHECK_EQUAL(restored.getHash(), calib.getHash());
+    std::vector<uint8_t> restored_buffer;
+    restored.toBinary(restored_buffer);
+    TEST_CHECK(restored_buffer==buffer);
+
+    // Damaged data is rejected and the calibration is not modified
+    StereoCalibration empty;
+    TEST_CHECK(!empty.fromBinary(nullptr, buffer.size()));
+    TEST_CHECK(!empty.fromBinary(buffer.data(), buffer.size()-1));
+    std::vector<uint8_t> longer = buffer;
+    longer.push_back(0);
+    TEST_CHECK(!empty.fromBinary(longer.data(), longer.size()));
+    for( size_t pos : {size_t(0), size_t(8), size_t(12), size_t(16), buffer.size()/2, buffer.size()-1} )
+    {
+        std::vector<uint8_t> damaged = buffer;
+        damaged[pos] ^= 0x01;
+        TEST_CHECK(!empty.fromBinary(damaged.data(), damaged.size()));
+    }
+    TEST_CHECK(!empty.isValid(RESOLUTION::HD2K));
+    TEST_CHECK_EQUAL(empty.getHash(), 0u);
+
+    // File round trip
+    const char* filename = "test_stereo_calibration.bin";
+    TEST_CHECK(calib.saveBinary(filename));
+    StereoCalibration from_file;
+    TEST_CHECK(from_file.loadBinary(filename));
+    checkParams(from_file);
+    std::remove(filename);
+    TEST_CHECK(!from_file.loadBinary(filename));
+}
+
+int main()
+{
+    testParse();
+    testInvalidResolutions();
+    testBinary();
+
+    return sl_oc::test::result();
+}
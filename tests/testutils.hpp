@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2021, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef TESTUTILS_HPP
+#define TESTUTILS_HPP
+
+// Minimal checks shared by the test executables: each test is a plain program registered with `add_test`, that
+// prints the failed checks and returns a non zero exit code if any check failed.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace sl_oc {
+
+namespace test {
+
+inline int& failures()
+{
+    static int count = 0;
+    return count;
+}
+
+inline void fail( const char* file, int line, const std::string& msg )
+{
+    std::cerr << file << ":" << line << ": check failed: " << msg << std::endl;
+    failures()++;
+}
+
+/*!
+ * \brief Wait until a condition is true, polling it every millisecond
+ * \return false if the condition is still false after the timeout
+ */
+inline bool waitFor( const std::function<bool()>& cond, int timeout_msec = 10000 )
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_msec);
+    while( !cond() )
+    {
+        if( std::chrono::steady_clock::now() > deadline )
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+/*!
+ * \brief Exit code of the test
+ */
+inline int result()
+{
+    if( failures()>0 )
+    {
+        std::cerr << failures() << " check(s) failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+}
+
+}
+
+#define TEST_CHECK(cond) \
+    do { if( !(cond) ) sl_oc::test::fail(__FILE__, __LINE__, #cond); } while(0)
+
+#define TEST_CHECK_EQUAL(a, b) \
+    do { if( !((a)==(b)) ) sl_oc::test::fail(__FILE__, __LINE__, \
+        std::string(#a " == " #b " (") + std::to_string(a) + " != " + std::to_string(b) + ")"); } while(0)
+
+#define TEST_CHECK_NEAR(a, b, tol) \
+    do { if( !(std::fabs((a)-(b))<=(tol)) ) sl_oc::test::fail(__FILE__, __LINE__, \
+        std::string(#a " ~= " #b " (") + std::to_string(a) + " vs " + std::to_string(b) + ")"); } while(0)
+
+#endif // TESTUTILS_HPP